@@ -28,13 +28,32 @@
 // Includes
 
 #include "app.h"
+#include "ascii_art.h"
+#include "cam_aec.h"
 #include "cam_ctrl_task.h"
 #include "cam_data_task.h"
+#include "cam_fps.h"
+#include "cam_meta.h"
+#include "cycle_counter.h"
 #include "definitions.h"
+#include "dual_stream.h"
+#include "frame_proto.h"
+#include "frame_stats.h"
+#include "host_cmd.h"
+#include "interlace.h"
+#include "link_baud.h"
+#include "motion_detect.h"
 #include "ov2640_i2c.h"
 #include "ov2640_spi.h"
+#include "tile_stream.h"
+#include "tx_pacer.h"
+#include "uart_mux.h"
+#include "yuv_codec.h"
+#include "yuv_convert.h"
+#include "yuv_tensor.h"
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 // *****************************************************************************
 // Private types and definitions
@@ -47,6 +66,101 @@
 // The camera fifo generates an extra 8 bytes (not sure why)
 #define YUV_BUFFER_SIZE ((IMAGE_WIDTH * IMAGE_HEIGHT * YUV_DEPTH) + 8)
 #define RGB_BUFFER_SIZE (IMAGE_WIDTH * IMAGE_HEIGHT * RGB_DEPTH)
+#define TENSOR_BUFFER_SIZE (IMAGE_WIDTH * IMAGE_HEIGHT * YUV_TENSOR_MAX_CHANNELS)
+#define CODEC_BUFFER_SIZE YUV_CODEC_MAX_OUTPUT(IMAGE_WIDTH, IMAGE_HEIGHT)
+#define TILE_BUFFER_SIZE                                                       \
+    TILE_STREAM_MAX_OUTPUT(IMAGE_WIDTH, IMAGE_HEIGHT, TILE_SIZE)
+
+// Largest message payload accepted from the host
+#define RX_BUFFER_SIZE 512
+
+// Largest frame message payload: compressed, or raw YUYV with its size
+#define RAW_FRAME_PAYLOAD (4 + IMAGE_WIDTH * IMAGE_HEIGHT * YUV_DEPTH)
+#define MAX_FRAME_PAYLOAD                                                      \
+    (CODEC_BUFFER_SIZE > RAW_FRAME_PAYLOAD ? CODEC_BUFFER_SIZE                 \
+                                           : RAW_FRAME_PAYLOAD)
+
+// FRAME_ROI message payload: the region's position and size, then its pixels
+#define ROI_FRAME_PAYLOAD (8 + ROI_WIDTH * ROI_HEIGHT * YUV_DEPTH)
+
+// Console link channel queues (see uart_mux.h).  The bulk queue holds one
+// frame of the largest size.
+#define MUX_CONTROL_QUEUE_SIZE 1024
+#define MUX_TELEMETRY_QUEUE_SIZE 512
+#define MUX_LOG_QUEUE_SIZE 2048
+#define MUX_BULK_QUEUE_SIZE                                                    \
+    (UART_MUX_BULK_COST(MAX_FRAME_PAYLOAD, MUX_FRAGMENT_SIZE) + 1)
+
+// Starting point for the auto exposure loop: roughly mid-range exposure at
+// unity gain.
+#define AEC_INITIAL_EXPOSURE 300
+#define AEC_INITIAL_GAIN CAM_AEC_GAIN_UNITY
+
+// Target frame rate, or 0 to capture as fast as possible.  Use a lower rate
+// to match the frame rate to what downstream processing consumes.  The host
+// can change this and the other settings marked "at startup" at run time
+// (see host_cmd.h).
+#define APP_TARGET_FPS 0
+#define APP_MAX_FPS 60
+
+// Skip RGB conversion, tensor preprocessing and streaming of frames without
+// motion, and send only the tiles that overlap moving blocks.  Telemetry,
+// exposure and frame rate control run on every frame regardless.
+#define APP_MOTION_GATING 1
+
+// Frame format at startup:
+// - APP_FORMAT_RAW: YUYV as captured.
+// - APP_FORMAT_CODEC: compressed losslessly (see yuv_codec.h), coded against
+//   the previous frame except for a key frame every APP_KEY_FRAME_INTERVAL
+//   frames from which a receiver can start decoding.
+// - APP_FORMAT_TILES: an update of the tiles that changed since they were
+//   last sent by more than the compression threshold (see tile_stream.h).
+// - APP_FORMAT_PROGRESSIVE: YUYV with the rows sent coarse to fine (see
+//   interlace.h), so a viewer can show a preview after 1/8 of the frame.
+#define APP_FORMAT APP_FORMAT_CODEC
+#define APP_KEY_FRAME_INTERVAL 32
+#define TILE_SIZE 16
+#define TILE_THRESHOLD 4
+
+// Send each frame to the host as binary messages (see frame_proto.h), in
+// the current format, followed by telemetry.  When the link can't keep up,
+// frames are sent reduced (as APP_SUBSTREAM) or skipped so that no frame
+// waits longer than APP_STREAM_LATENCY_US to be sent (see tx_pacer.h).
+//
+// With APP_DUAL_STREAM, frames are sent reduced by design: a full frame
+// goes at most every DUAL_FULL_INTERVAL frames, and the link is split
+// between full and reduced frames DUAL_FULL_WEIGHT : DUAL_SUB_WEIGHT (see
+// dual_stream.h).  The latency bound still applies.
+//
+// While streaming, the link is shared by priority (see uart_mux.h): link
+// control, then telemetry, then console text, then frames, which are sent
+// in fragments of MUX_FRAGMENT_SIZE bytes and tagged with their frame
+// sequence number.
+#define APP_STREAM_FRAMES 0
+#define APP_STREAM_LATENCY_US 100000
+#define MUX_FRAGMENT_SIZE 256
+#define APP_DUAL_STREAM 0
+#define DUAL_FULL_INTERVAL 10
+#define DUAL_FULL_WEIGHT 1
+#define DUAL_SUB_WEIGHT 3
+
+// Reduced frames:
+// - APP_SUBSTREAM_THUMBNAIL: the frame at half resolution.
+// - APP_SUBSTREAM_ROI: the ROI_WIDTH x ROI_HEIGHT region at ROI_X, ROI_Y,
+//   at full resolution.  ROI_X and ROI_WIDTH must be even.
+#define APP_SUBSTREAM APP_SUBSTREAM_THUMBNAIL
+#define ROI_X 24
+#define ROI_Y 24
+#define ROI_WIDTH 48
+#define ROI_HEIGHT 48
+
+// Render the camera stream as ASCII art on the console.  This replaces the
+// per-frame trace and periodic reports, which would scroll the picture away.
+#define APP_ASCII_ART 0
+
+// Report the cost of RGB conversion and tensor preprocessing every this many
+// frames
+#define CONVERT_REPORT_INTERVAL 32
 
 typedef enum {
     APP_STATE_INIT,
@@ -66,15 +180,89 @@ typedef enum {
     APP_STATE_ERROR,
 } app_state_t;
 
+typedef enum {
+    APP_FORMAT_RAW,
+    APP_FORMAT_CODEC,
+    APP_FORMAT_TILES,
+    APP_FORMAT_PROGRESSIVE,
+    APP_N_FORMATS,
+} app_format_t;
+
+typedef enum {
+    APP_SUBSTREAM_THUMBNAIL,
+    APP_SUBSTREAM_ROI,
+} app_substream_t;
+
+typedef enum {
+    APP_LOG_ERRORS,  // failures only
+    APP_LOG_REPORTS, // and periodic reports
+    APP_LOG_TRACE,   // and the per-frame trace
+    APP_N_LOG_LEVELS,
+} app_log_level_t;
+
+/**
+ * @brief Settings the host can change at run time.
+ */
+typedef struct {
+    uint8_t profile;     // index into s_profiles last applied
+    uint16_t fps;        // target frame rate, 0 = as fast as possible
+    uint8_t format;      // app_format_t
+    uint8_t compression; // tile change threshold
+    uint8_t log_level;   // app_log_level_t
+} app_settings_t;
+
+/**
+ * @brief A preset of settings.
+ */
+typedef struct {
+    uint16_t fps;
+    uint8_t format;
+    uint8_t compression;
+} app_profile_t;
+
 typedef struct {
     app_state_t state;         // current application state
     DRV_HANDLE i2c_drv_handle; // handle for I2C interface
-    uint32_t timestamp_sys;    // for capturing Frames Per Second
+    uint32_t timestamp_sys;    // timestamp of the previous frame
+    uint32_t codec_bytes;      // compressed bytes since the last report
+    uint32_t codec_frames;     // frames compressed since the last report
+    bool key_requested;        // next compressed frame must be a key frame
+    bool mux_ready;            // console text goes through s_mux
+    uint32_t mux_dropped;      // bytes s_mux had dropped at the last frame
+    uint32_t mux_queued;       // bytes s_mux had accepted at the last frame
+    uint32_t clock_count;      // SYS_TIME counter at the last mux_clock()
+    uint32_t clock_us;         // mux_clock() time at clock_count
+    bool settings_changed;     // s_next_settings to apply at the next frame
+    bool snapshot_requested;   // send the next frame in full, raw
+    bool tensor_ready;         // s_tensor initialized: run the model input
 } app_ctx_t;
 
 // *****************************************************************************
 // Private (static) storage
 
+/**
+ * @brief Presets selected with HOST_CMD_PARAM_PROFILE
+ */
+static const app_profile_t s_profiles[] = {
+    // as built
+    {APP_TARGET_FPS, APP_FORMAT, TILE_THRESHOLD},
+    // low bandwidth: only tiles that changed noticeably, at 10 fps
+    {10, APP_FORMAT_TILES, 12},
+    // lossless, as fast as the link allows
+    {0, APP_FORMAT_CODEC, TILE_THRESHOLD},
+    // raw frames, e.g. to check the pipeline
+    {5, APP_FORMAT_RAW, TILE_THRESHOLD},
+    // raw frames a viewer can preview before they have arrived
+    {5, APP_FORMAT_PROGRESSIVE, TILE_THRESHOLD},
+};
+
+/**
+ * @brief Settings in effect, and as set by the host, which take effect
+ * between frames
+ */
+static app_settings_t s_settings;
+static app_settings_t s_next_settings;
+
 /**
  * @buffer to hold YUV data captured from camera
  */
@@ -86,20 +274,257 @@ static uint8_t s_buf_b[YUV_BUFFER_SIZE];
  */
 static uint8_t s_rgb_buf[RGB_BUFFER_SIZE];
 
+/**
+ * @buffer to hold the quantized model input tensor
+ */
+static uint8_t s_tensor_buf[TENSOR_BUFFER_SIZE];
+
+/**
+ * @buffer to hold the Y plane of the current frame and the motion detector's
+ * background
+ */
+static uint8_t s_luma_buf[IMAGE_WIDTH * IMAGE_HEIGHT];
+static uint8_t s_background_buf[IMAGE_WIDTH * IMAGE_HEIGHT];
+
+/**
+ * @buffer to hold the compressed frame, and the previous frame it is coded
+ * against
+ */
+static uint8_t s_codec_buf[CODEC_BUFFER_SIZE];
+static uint8_t s_codec_ref[IMAGE_WIDTH * IMAGE_HEIGHT * YUV_DEPTH];
+
+/**
+ * @buffer to hold a tile update, and the frame as last sent in tiles
+ */
+static uint8_t s_tile_buf[TILE_BUFFER_SIZE];
+static uint8_t s_tile_ref[IMAGE_WIDTH * IMAGE_HEIGHT * YUV_DEPTH];
+
+/**
+ * @buffer to hold the tiles that overlap moving blocks, one byte per tile
+ */
+static uint8_t s_moving_tiles[TILE_STREAM_MAX_TILES];
+
+/**
+ * @buffer to hold the terminal output for one ASCII art frame
+ */
+static char s_ascii_buf[ASCII_ART_MAX_OUTPUT(ASCII_ART_MAX_ROWS,
+                                             ASCII_ART_MAX_COLS)];
+
+/**
+ * @buffer to hold a half resolution frame for a slow link
+ */
+static uint8_t s_reduced_buf[(IMAGE_WIDTH / 2) * (IMAGE_HEIGHT / 2) * YUV_DEPTH];
+
+/**
+ * @buffer to hold the payload of a message from the host
+ */
+static uint8_t s_rx_buf[RX_BUFFER_SIZE];
+
 static app_ctx_t s_app;
 
+/**
+ * @brief Auto exposure / gain controller
+ */
+static cam_aec_t s_aec;
+
+/**
+ * @brief Frame rate controller
+ */
+static cam_fps_t s_fps;
+
+/**
+ * @brief Model input preprocessing
+ */
+static yuv_tensor_t s_tensor;
+
+/**
+ * @brief Motion detector used to skip static frames
+ */
+static motion_detect_t s_motion;
+
+/**
+ * @brief Statistics of the most recent frame, computed by cam_data_task
+ */
+static frame_stats_t s_frame_stats;
+
+/**
+ * @brief Tile change stream
+ */
+static tile_stream_t s_tile_stream;
+
+/**
+ * @brief ASCII art renderer
+ */
+static ascii_art_t s_ascii_art;
+
+/**
+ * @brief Message encoder for the frame stream and replies to the host
+ */
+static frame_proto_encoder_t s_proto;
+
+/**
+ * @brief Message decoder for input from the host
+ */
+static frame_proto_decoder_t s_rx;
+
+/**
+ * @brief Commands from the host
+ */
+static host_cmd_t s_cmd;
+
+/**
+ * @brief Chooses what to stream for each frame
+ */
+static tx_pacer_t s_pacer;
+
+/**
+ * @brief Splits the link between full and reduced frames (APP_DUAL_STREAM)
+ */
+static dual_stream_t s_dual;
+
+/**
+ * @brief Shares the console link between channels while streaming
+ */
+static uart_mux_t s_mux;
+static uint8_t s_mux_control_q[MUX_CONTROL_QUEUE_SIZE];
+static uint8_t s_mux_telemetry_q[MUX_TELEMETRY_QUEUE_SIZE];
+static uint8_t s_mux_log_q[MUX_LOG_QUEUE_SIZE];
+static uint8_t s_mux_bulk_q[MUX_BULK_QUEUE_SIZE];
+
 // *****************************************************************************
 // Private (static, forward) declarations
 
 /**
- * @brief Convert the YUV pixels in s_yuv_buf to RGB pixels in s_rgb_buf.
+ * @brief Convert the YUV pixels in yuv_buf to RGB pixels in s_rgb_buf.
  *
- * Note that this reads four bytes at a time (y0, u, y1, v) and writes six
- * (r0, g0, b0, r1, g1, b1)
+ * Converts IMAGE_WIDTH * IMAGE_HEIGHT pixels: the 8 trailer bytes at the end
+ * of the YUV buffer are not image data.  Returns the number of CPU cycles
+ * taken.
+ */
+static uint32_t convert_yuv_to_rgb(const uint8_t *yuv_buf);
+
+/**
+ * @brief Called by cam_data_task after each frame is read out, before the
+ * next capture is started.
+ */
+static void on_frame(cam_frame_t *frame, uintptr_t context);
+
+/**
+ * @brief Run motion detection on the frame's Y plane.  Returns true if the
+ * frame should be converted and preprocessed, i.e. it has motion or motion
+ * gating is disabled.
+ */
+static bool frame_has_motion(const cam_frame_t *frame);
+
+/**
+ * @brief Mark in s_moving_tiles the tiles of s_tile_stream that overlap a
+ * block moving in the last frame.  Returns s_moving_tiles, or NULL to
+ * compare every tile when motion gating is disabled.
+ */
+static const uint8_t *moving_tiles(void);
+
+/**
+ * @brief Compress the frame into s_codec_buf.  Returns the compressed size.
+ */
+static size_t compress_frame(const cam_frame_t *frame, bool key_frame);
+
+/**
+ * @brief Send the frame in the current format (encoded_len bytes in
+ * s_codec_buf or s_tile_buf, unless raw) and its telemetry to the host.
+ * Only the telemetry is sent for a static frame (changed false): the
+ * receiver's copy is still current.
+ */
+static void stream_frame(const cam_frame_t *frame, size_t encoded_len,
+                         bool key_frame, bool changed, uint32_t interval_us,
+                         uint8_t mean_y);
+
+/**
+ * @brief Send a YUYV frame as a FRAME_PROTO_TYPE_FRAME_YUYV message.
+ */
+static void send_yuyv(frame_proto_encoder_t *enc, const uint8_t *yuyv,
+                      uint16_t width, uint16_t height, uint8_t flags);
+
+/**
+ * @brief Send a YUYV frame as a FRAME_PROTO_TYPE_FRAME_PROGRESSIVE message,
+ * its rows in interlace.h order.
+ */
+static void send_progressive(frame_proto_encoder_t *enc, const uint8_t *yuyv,
+                             uint16_t width, uint16_t height);
+
+/**
+ * @brief Send the region of interest of a frame as a
+ * FRAME_PROTO_TYPE_FRAME_ROI message.
+ */
+static void send_roi(frame_proto_encoder_t *enc, const uint8_t *yuyv);
+
+/**
+ * @brief Set up s_mux and route the link's traffic through it.
+ */
+static void init_mux(void);
+
+/**
+ * @brief uart_mux clock: microseconds from the SYS_TIME counter.
+ */
+static uint32_t mux_clock(void);
+
+/**
+ * @brief frame_proto write function: queue bytes on the console UART.
+ */
+static size_t stream_write(const void *data, size_t n, uintptr_t context);
+
+/**
+ * @brief Feed bytes received from the host to the message decoder.
+ */
+static void poll_rx(void);
+
+/**
+ * @brief Called for each message received from the host.
+ */
+static void on_rx_message(const frame_proto_msg_t *msg, uintptr_t context);
+
+/**
+ * @brief Return true if periodic reports should be printed for this frame.
+ */
+static bool report_due(const cam_frame_t *frame);
+
+/**
+ * @brief Print the sensor registers sampled with the frame (cam_meta.h)
+ * beside the exposure and gain last commanded.
+ */
+static void report_sensor(const cam_frame_t *frame);
+
+/**
+ * @brief host_cmd handler: read or change s_next_settings, or request a
+ * snapshot.  Nothing takes effect until the next frame.
+ */
+static host_cmd_status_t on_command(const host_cmd_request_t *request,
+                                    uint32_t *value, uintptr_t context);
+
+/**
+ * @brief Return the most verbose log level this build allows.
+ */
+static uint8_t max_log_level(void);
+
+/**
+ * @brief Change one of the settings.  Returns HOST_CMD_ERR_VALUE if the
+ * value is out of range, including a log level above max_log_level().
+ */
+static host_cmd_status_t set_setting(app_settings_t *settings, uint8_t param,
+                                     uint32_t value);
+static uint32_t get_setting(const app_settings_t *settings, uint8_t param);
+
+/**
+ * @brief Put s_next_settings into effect.  Called between frames, while the
+ * camera is idle.
+ */
+static void apply_settings(void);
+
+/**
+ * @brief Send the frame in full as raw YUYV, if there is room for it now.
  */
-__attribute__((unused)) static void convert_yuv_to_rgb(uint8_t *yuv_buf);
+static void send_snapshot(const cam_frame_t *frame);
 
-__attribute__((unused)) static uint8_t clamp(float v);
+static uint32_t fps_to_period_us(uint16_t fps);
 
 // *****************************************************************************
 // Public code
@@ -111,7 +536,79 @@ void APP_Initialize(void) {
     s_app.state = APP_STATE_INIT;
     s_app.i2c_drv_handle = DRV_HANDLE_INVALID;
     cam_ctrl_task_init();
+    cam_meta_init();
     cam_data_task_init(s_buf_a, s_buf_b, YUV_BUFFER_SIZE);
+    cam_data_task_set_frame_cb(on_frame, 0);
+    cam_data_task_set_stats(&s_frame_stats, IMAGE_WIDTH * IMAGE_HEIGHT);
+    cam_aec_init(&s_aec, NULL, AEC_INITIAL_EXPOSURE, AEC_INITIAL_GAIN);
+    cam_fps_config_t fps_config;
+    cam_fps_default_config(&fps_config);
+    fps_config.frame_lines = CAM_CTRL_TASK_FRAME_LINES;
+    cam_fps_init(&s_fps, &fps_config);
+    cycle_counter_init();
+    frame_proto_encoder_init(&s_proto, stream_write, 0);
+    frame_proto_decoder_init(&s_rx, s_rx_buf, sizeof(s_rx_buf), on_rx_message,
+                             0);
+    frame_proto_encoder_t *control = &s_proto;
+    if (APP_STREAM_FRAMES) {
+        init_mux();
+        control = uart_mux_encoder(&s_mux, UART_MUX_CONTROL);
+    }
+    link_baud_init(control);
+    host_cmd_init(&s_cmd, control, on_command, 0);
+    yuv_tensor_config_t tensor_config;
+    yuv_tensor_default_config(&tensor_config);
+    s_app.tensor_ready = yuv_tensor_init(&s_tensor, &tensor_config);
+    if (!s_app.tensor_ready) {
+        printf("# Failed to initialize tensor preprocessing\r\n");
+    }
+    motion_detect_config_t motion_config;
+    motion_detect_default_config(&motion_config, IMAGE_WIDTH, IMAGE_HEIGHT);
+    motion_detect_init(&s_motion, &motion_config, s_background_buf);
+    tile_stream_config_t tile_config;
+    tile_stream_default_config(&tile_config, IMAGE_WIDTH, IMAGE_HEIGHT);
+    tile_config.tile_size = TILE_SIZE;
+    tile_config.threshold = TILE_THRESHOLD;
+    tile_stream_init(&s_tile_stream, &tile_config, s_tile_ref);
+    s_settings.fps = APP_TARGET_FPS;
+    s_settings.format = APP_FORMAT;
+    s_settings.compression = TILE_THRESHOLD;
+    s_settings.log_level = max_log_level();
+    if (APP_ASCII_ART) {
+        ascii_art_config_t ascii_config;
+        ascii_art_default_config(&ascii_config, IMAGE_WIDTH, IMAGE_HEIGHT);
+        ascii_art_init(&s_ascii_art, &ascii_config);
+    }
+    if (APP_STREAM_FRAMES) {
+        tx_pacer_config_t pacer_config;
+        tx_pacer_default_config(&pacer_config, LINK_BAUD_BASE);
+        pacer_config.max_latency_us = APP_STREAM_LATENCY_US;
+        tx_pacer_init(&s_pacer, &pacer_config);
+        dual_stream_config_t dual_config;
+        dual_stream_default_config(&dual_config);
+        dual_config.full_interval = DUAL_FULL_INTERVAL;
+        dual_config.full_weight = DUAL_FULL_WEIGHT;
+        dual_config.sub_weight = DUAL_SUB_WEIGHT;
+        dual_stream_init(&s_dual, &dual_config);
+        // the pacer and s_mux keep the queue short, so anything that still
+        // doesn't fit is dropped rather than stalling capture
+        USART1_WriteOverflowSet(USART_WRITE_OVERFLOW_DROP);
+    }
+    cam_data_task_set_trace(s_settings.log_level >= APP_LOG_TRACE);
+    cam_fps_set_target_us(&s_fps, fps_to_period_us(s_settings.fps));
+    s_next_settings = s_settings;
+}
+
+size_t APP_ConsoleWrite(const void *data, size_t n) {
+    if (s_app.mux_ready) {
+        return uart_mux_write_text(&s_mux, data, n);
+    }
+    if (link_baud_busy()) {
+        // Text would keep the transmitter from draining for the rate
+        // change, and garble the trial.  s_mux holds it; here it's dropped.
+        return 0;
+    }
+    return USART1_Write((void *)data, n);
 }
 
 void APP_Tasks(void) {
@@ -120,6 +617,15 @@ void APP_Tasks(void) {
         cam_ctrl_task_step();
         cam_data_task_step();
     }
+    poll_rx();
+    if (s_app.mux_ready) {
+        // Replies to the host reach the UART before link_baud_step() waits
+        // for it to drain
+        uart_mux_hold(&s_mux, link_baud_busy());
+        uart_mux_set_link_rate(&s_mux, link_baud_rate());
+        uart_mux_pump(&s_mux, USART1_WriteCountGet());
+    }
+    link_baud_step();
 
     switch (s_app.state) {
 
@@ -288,37 +794,587 @@ void APP_Tasks(void) {
 // *****************************************************************************
 // Private (static) code
 
-static inline uint8_t clamp(float v) {
-    if (v < 0.0) {
-        return 0;
-    } else if (v > 255.0) {
-        return 255;
+static void on_frame(cam_frame_t *frame, uintptr_t context) {
+    cam_aec_stats_t stats;
+    uint32_t interval_us = 0;
+    size_t encoded_len = 0;
+    bool key_frame = false;
+
+    (void)context;
+    if (s_app.settings_changed) {
+        // the camera is idle, so nothing in flight sees a half-applied change
+        apply_settings();
+    }
+    bool motion = frame_has_motion(frame);
+    bool changed = motion;
+    if (s_settings.format == APP_FORMAT_CODEC) {
+        key_frame = s_app.key_requested ||
+                    frame->seq % APP_KEY_FRAME_INTERVAL == 0;
+        if (motion || key_frame) {
+            // a static frame isn't sent, so the reference stays what the
+            // receiver holds
+            s_app.key_requested = false;
+            encoded_len = compress_frame(frame, key_frame);
+        }
+    } else if (s_settings.format == APP_FORMAT_TILES) {
+        // tiles are read straight from the readout buffer
+        encoded_len = tile_stream_encode_candidates(
+            &s_tile_stream, frame->buf, moving_tiles(), s_tile_buf,
+            sizeof(s_tile_buf));
+        key_frame = (s_tile_buf[2] & TILE_STREAM_FLAG_KEY) != 0;
+        // The encoder's reference now holds any changed tiles, whether or
+        // not the frame has motion (a block too few for motion_detect still
+        // marks its tiles), so any it found must be sent.
+        changed = s_tile_stream.last_tiles > 0;
+        if (report_due(frame)) {
+            printf("# tiles: %d changed, %d bytes\r\n",
+                   s_tile_stream.last_tiles, encoded_len);
+        }
+    }
+    if (APP_ASCII_ART) {
+        // unchanged lines aren't sent, so static scenes cost nothing
+        size_t n = ascii_art_render(&s_ascii_art, frame->buf, s_ascii_buf,
+                                    sizeof(s_ascii_buf));
+        fwrite(s_ascii_buf, 1, n, stdout);
+        fflush(stdout);
+    }
+    if (motion) {
+        uint32_t cycles = convert_yuv_to_rgb(frame->buf);
+        if (report_due(frame)) {
+            uint32_t centi = (cycles * 100) / (IMAGE_WIDTH * IMAGE_HEIGHT);
+            printf("# yuv->rgb: %ld cycles, %ld.%02ld cycles/pixel\r\n",
+                   cycles, centi / 100, centi % 100);
+        }
+
+        // The model input is ready as soon as readout finishes
+        if (s_app.tensor_ready) {
+            uint32_t start = cycle_counter_get();
+            yuv_tensor_run(&s_tensor, frame->buf, s_tensor_buf,
+                           IMAGE_WIDTH * IMAGE_HEIGHT);
+            cycles = cycle_counter_get() - start;
+            if (report_due(frame)) {
+                uint32_t centi = (cycles * 100) / (IMAGE_WIDTH * IMAGE_HEIGHT);
+                printf("# yuv->tensor: %ld cycles, %ld.%02ld cycles/pixel\r\n",
+                       cycles, centi / 100, centi % 100);
+            }
+        }
+    }
+
+    if (frame->stats != NULL) {
+        // reuse the histogram computed at readout
+        cam_aec_stats_from_histogram(&s_aec, frame->stats->histogram,
+                                     frame->stats->n_pixels,
+                                     frame->stats->mean[FRAME_STATS_Y], &stats);
+    } else {
+        cam_aec_compute_stats(&s_aec, frame->buf, IMAGE_WIDTH * IMAGE_HEIGHT,
+                              &stats);
+    }
+    if (frame->stats != NULL && report_due(frame)) {
+        const frame_stats_t *fs = frame->stats;
+        printf("# stats: mean %d/%d/%d, var %d, clip %d/%d permille\r\n",
+               fs->mean[FRAME_STATS_Y], fs->mean[FRAME_STATS_U],
+               fs->mean[FRAME_STATS_V], fs->variance, fs->clip_low_permille,
+               fs->clip_high_permille);
+    }
+    if (report_due(frame)) {
+        // before cam_aec_update(), so the settings compare with those the
+        // frame was captured with
+        report_sensor(frame);
+    }
+    if (cam_aec_update(&s_aec, &stats)) {
+        // The camera is idle between readout and the next capture, so the
+        // writes can't stall readout.
+        if (!cam_ctrl_task_set_exposure(cam_aec_exposure(&s_aec),
+                                        cam_aec_gain_reg(&s_aec))) {
+            printf("# Failed to update exposure\r\n");
+        }
+    }
+
+    if (frame->seq > 0) {
+        interval_us =
+            SYS_TIME_CountToUS(frame->timestamp - s_app.timestamp_sys);
+        if (cam_fps_update(&s_fps, interval_us)) {
+            const cam_fps_timing_t *timing = cam_fps_timing(&s_fps);
+            if (!cam_ctrl_task_set_frame_timing(timing->clk_div,
+                                                timing->dummy_lines)) {
+                printf("# Failed to update frame timing\r\n");
+            }
+        }
+    }
+    s_app.timestamp_sys = frame->timestamp;
+
+    if (APP_STREAM_FRAMES) {
+        // key frames go out regardless so that a receiver can start
+        stream_frame(frame, encoded_len, key_frame, changed || key_frame,
+                     interval_us, stats.mean);
+    } else if (report_due(frame)) {
+        // console output is queued and sent by XDMAC in the background
+        USART_WRITE_STATS tx;
+        USART1_WriteStatsGet(&tx);
+        printf("# tx: %ld queued, %ld dropped, peak %ld of %d bytes\r\n",
+               tx.queued, tx.dropped, tx.peak, USART1_WriteBufferSizeGet());
+        USART1_WriteStatsReset();
+    }
+    if (s_app.snapshot_requested) {
+        send_snapshot(frame);
+    }
+}
+
+static bool frame_has_motion(const cam_frame_t *frame) {
+    if (!APP_MOTION_GATING) {
+        return true;
+    }
+    uint32_t start = cycle_counter_get();
+    yuv_convert_deinterleave(frame->buf, s_luma_buf, NULL, NULL,
+                             IMAGE_WIDTH * IMAGE_HEIGHT);
+    bool motion = motion_detect_update(&s_motion, s_luma_buf);
+    uint32_t cycles = cycle_counter_get() - start;
+    if (report_due(frame)) {
+        printf("# motion: %s, %d blocks, %ld cycles\r\n",
+               motion ? "yes" : "no", s_motion.moving_blocks, cycles);
+    }
+    return motion;
+}
+
+static const uint8_t *moving_tiles(void) {
+    if (!APP_MOTION_GATING) {
+        return NULL;
+    }
+    uint16_t size = s_tile_stream.config.tile_size;
+    uint16_t block = MOTION_DETECT_BLOCK_SIZE;
+    uint8_t *tile = s_moving_tiles;
+    for (uint16_t ty = 0; ty < s_tile_stream.tiles_y; ty++) {
+        for (uint16_t tx = 0; tx < s_tile_stream.tiles_x; tx++) {
+            // the blocks a tile overlaps, which need not be whole
+            uint16_t bx0 = tx * size / block;
+            uint16_t bx1 = ((tx + 1) * size - 1) / block;
+            uint16_t by0 = ty * size / block;
+            uint16_t by1 = ((ty + 1) * size - 1) / block;
+            bool moved = false;
+            for (uint16_t by = by0; by <= by1 && !moved; by++) {
+                for (uint16_t bx = bx0; bx <= bx1 && !moved; bx++) {
+                    moved = motion_detect_block_moved(&s_motion, bx, by);
+                }
+            }
+            *tile++ = moved;
+        }
+    }
+    return s_moving_tiles;
+}
+
+static size_t compress_frame(const cam_frame_t *frame, bool key_frame) {
+    uint32_t start = cycle_counter_get();
+    size_t len = yuv_codec_encode(frame->buf, key_frame ? NULL : s_codec_ref,
+                                  IMAGE_WIDTH, IMAGE_HEIGHT, s_codec_buf,
+                                  sizeof(s_codec_buf));
+    uint32_t cycles = cycle_counter_get() - start;
+    memcpy(s_codec_ref, frame->buf, sizeof(s_codec_ref));
+    s_app.codec_bytes += len;
+    s_app.codec_frames++;
+    if (report_due(frame) && s_app.codec_bytes > 0) {
+        // average over the key frame and the delta frames that followed it
+        uint32_t raw = s_app.codec_frames * sizeof(s_codec_ref);
+        uint32_t centi = ((uint64_t)raw * 100) / s_app.codec_bytes;
+        printf("# codec: %ld bytes/frame (%ld.%02ldx), %ld cycles\r\n",
+               s_app.codec_bytes / s_app.codec_frames, centi / 100,
+               centi % 100, cycles);
+        s_app.codec_bytes = 0;
+        s_app.codec_frames = 0;
+    }
+    return len;
+}
+
+static void stream_frame(const cam_frame_t *frame, size_t encoded_len,
+                         bool key_frame, bool changed, uint32_t interval_us,
+                         uint8_t mean_y) {
+    frame_proto_encoder_t *bulk = uart_mux_encoder(&s_mux, UART_MUX_BULK);
+    bool encoded = s_settings.format == APP_FORMAT_CODEC ||
+                   s_settings.format == APP_FORMAT_TILES;
+    uint32_t full_len = encoded ? encoded_len : RAW_FRAME_PAYLOAD;
+    uint32_t reduced_len = APP_SUBSTREAM == APP_SUBSTREAM_ROI
+                               ? ROI_FRAME_PAYLOAD
+                               : 4 + sizeof(s_reduced_buf);
+    uint8_t telemetry_buf[FRAME_PROTO_TELEMETRY_SIZE];
+    USART_WRITE_STATS tx;
+
+    // Everything s_mux accepted since the last frame, frames and text
+    // alike, feeds the drain rate estimate.  From then on it is pending,
+    // whether s_mux still holds it or has moved it to the USART ring.
+    uint32_t mux_dropped = 0;
+    uint32_t mux_queued = 0;
+    for (int i = 0; i < UART_MUX_N_CHANNELS; i++) {
+        mux_dropped += s_mux.queues[i].stats.dropped;
+        mux_queued += s_mux.queues[i].stats.queued;
+    }
+    USART1_WriteStatsGet(&tx);
+    USART1_WriteStatsReset();
+    tx_pacer_set_link_rate(&s_pacer, link_baud_rate());
+    tx_pacer_sent(&s_pacer, mux_queued - s_app.mux_queued);
+    s_app.mux_queued = mux_queued;
+    tx_pacer_update(&s_pacer, interval_us,
+                    USART1_WriteCountGet() + uart_mux_pending(&s_mux));
+
+    // Only whole messages are queued: a partial one would cost link time
+    // and the receiver would discard it anyway.  No frame is queued while
+    // the link changes rate.
+    uint32_t free =
+        link_baud_busy() ? 0 : uart_mux_free(&s_mux, UART_MUX_BULK);
+    uint32_t full_cost = uart_mux_cost(&s_mux, UART_MUX_BULK, full_len);
+    uint32_t reduced_cost = uart_mux_cost(&s_mux, UART_MUX_BULK, reduced_len);
+    tx_pacer_decision_t decision;
+    if (!changed) {
+        // Nothing to send.  This isn't a skip for want of link time, so
+        // it neither counts against the pacer nor calls for a key frame.
+        decision = TX_PACER_SKIP;
+    } else if (APP_DUAL_STREAM) {
+        // s_dual chooses, and s_pacer may still fall back to less
+        dual_stream_update(&s_dual, interval_us, s_pacer.rate);
+        decision = dual_stream_decide(&s_dual, &s_pacer, full_cost,
+                                      reduced_cost, free);
     } else {
-        return v;
+        decision = tx_pacer_decide(&s_pacer, full_cost, reduced_cost, free);
+    }
+    // Telemetry may overtake the frame, so the host pairs them by tag
+    frame_proto_set_tag(bulk, frame->seq);
+    uint8_t flags = key_frame ? FRAME_PROTO_FLAG_KEY : 0;
+    if (decision == TX_PACER_FULL &&
+        s_settings.format == APP_FORMAT_CODEC) {
+        frame_proto_send(bulk, FRAME_PROTO_TYPE_FRAME_CODEC, flags,
+                         s_codec_buf, encoded_len);
+    } else if (decision == TX_PACER_FULL &&
+               s_settings.format == APP_FORMAT_TILES) {
+        frame_proto_send(bulk, FRAME_PROTO_TYPE_FRAME_TILES, flags,
+                         s_tile_buf, encoded_len);
+    } else if (decision == TX_PACER_FULL &&
+               s_settings.format == APP_FORMAT_PROGRESSIVE) {
+        send_progressive(bulk, frame->buf, IMAGE_WIDTH, IMAGE_HEIGHT);
+    } else if (decision == TX_PACER_FULL) {
+        send_yuyv(bulk, frame->buf, IMAGE_WIDTH, IMAGE_HEIGHT,
+                  FRAME_PROTO_FLAG_KEY);
+    } else if (decision == TX_PACER_DECIMATED &&
+               APP_SUBSTREAM == APP_SUBSTREAM_ROI) {
+        send_roi(bulk, frame->buf);
+    } else if (decision == TX_PACER_DECIMATED) {
+        yuv_convert_decimate(frame->buf, s_reduced_buf, IMAGE_WIDTH,
+                             IMAGE_HEIGHT);
+        send_yuyv(bulk, s_reduced_buf, IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2,
+                  FRAME_PROTO_FLAG_KEY);
+    }
+    if (changed && decision != TX_PACER_FULL) {
+        // later delta frames are useless without this one
+        s_app.key_requested = true;
+        tile_stream_request_key(&s_tile_stream);
+    }
+
+    frame_proto_telemetry_t telemetry = {
+        .frame_seq = frame->seq,
+        .timestamp = frame->timestamp,
+        .interval_us = interval_us,
+        .exposure = cam_aec_exposure(&s_aec),
+        .gain = s_aec.gain,
+        .mean_y = mean_y,
+        .motion = s_motion.moving_blocks > 255 ? 255 : s_motion.moving_blocks,
+        .pacing = decision,
+        .tx_queued = tx.queued,
+        .tx_dropped = tx.dropped + mux_dropped - s_app.mux_dropped,
+        .drain_rate = s_pacer.rate,
+        .sent_full = s_pacer.counts[TX_PACER_FULL],
+        .sent_reduced = s_pacer.counts[TX_PACER_DECIMATED],
+        .skipped = s_pacer.counts[TX_PACER_SKIP],
+    };
+    frame_proto_pack_telemetry(&telemetry, telemetry_buf);
+    frame_proto_send(uart_mux_encoder(&s_mux, UART_MUX_TELEMETRY),
+                     FRAME_PROTO_TYPE_TELEMETRY, 0, telemetry_buf,
+                     sizeof(telemetry_buf));
+    s_app.mux_dropped = mux_dropped;
+    // the link may have run dry while the frame was processed
+    uart_mux_pump(&s_mux, USART1_WriteCountGet());
+
+    if (report_due(frame)) {
+        printf("# pacing: %ld full, %ld decimated, %ld skipped, %ld bytes/s, "
+               "%ld us queued\r\n",
+               s_pacer.counts[TX_PACER_FULL],
+               s_pacer.counts[TX_PACER_DECIMATED],
+               s_pacer.counts[TX_PACER_SKIP], s_pacer.rate,
+               tx_pacer_latency_us(&s_pacer));
+        printf("# mux: worst latency %ld us control, %ld us telemetry, "
+               "%ld us log, %ld us bulk\r\n",
+               s_mux.queues[UART_MUX_CONTROL].stats.max_latency_us,
+               s_mux.queues[UART_MUX_TELEMETRY].stats.max_latency_us,
+               s_mux.queues[UART_MUX_LOG].stats.max_latency_us,
+               s_mux.queues[UART_MUX_BULK].stats.max_latency_us);
+        uart_mux_reset_latency(&s_mux);
+    }
+}
+
+static void send_yuyv(frame_proto_encoder_t *enc, const uint8_t *yuyv,
+                      uint16_t width, uint16_t height, uint8_t flags) {
+    uint8_t size[4] = {width & 0xff, width >> 8, height & 0xff, height >> 8};
+    uint32_t n = (uint32_t)width * height * YUV_DEPTH;
+
+    frame_proto_begin(enc, FRAME_PROTO_TYPE_FRAME_YUYV, flags,
+                      sizeof(size) + n);
+    frame_proto_write(enc, size, sizeof(size));
+    frame_proto_write(enc, yuyv, n);
+    frame_proto_end(enc);
+}
+
+static void send_progressive(frame_proto_encoder_t *enc, const uint8_t *yuyv,
+                             uint16_t width, uint16_t height) {
+    uint8_t size[4] = {width & 0xff, width >> 8, height & 0xff, height >> 8};
+    uint32_t row_bytes = (uint32_t)width * YUV_DEPTH;
+
+    frame_proto_begin(enc, FRAME_PROTO_TYPE_FRAME_PROGRESSIVE,
+                      FRAME_PROTO_FLAG_KEY, sizeof(size) + row_bytes * height);
+    frame_proto_write(enc, size, sizeof(size));
+    // rows go straight from the frame buffer, so nothing is reordered
+    for (uint16_t i = 0; i < height; i++) {
+        frame_proto_write(enc, yuyv + interlace_row(height, i) * row_bytes,
+                          row_bytes);
+    }
+    frame_proto_end(enc);
+}
+
+static void send_roi(frame_proto_encoder_t *enc, const uint8_t *yuyv) {
+    uint8_t region[8] = {ROI_X & 0xff,      ROI_X >> 8,
+                         ROI_Y & 0xff,      ROI_Y >> 8,
+                         ROI_WIDTH & 0xff,  ROI_WIDTH >> 8,
+                         ROI_HEIGHT & 0xff, ROI_HEIGHT >> 8};
+    const uint8_t *row = yuyv + (ROI_Y * IMAGE_WIDTH + ROI_X) * YUV_DEPTH;
+
+    frame_proto_begin(enc, FRAME_PROTO_TYPE_FRAME_ROI, 0, ROI_FRAME_PAYLOAD);
+    frame_proto_write(enc, region, sizeof(region));
+    for (int y = 0; y < ROI_HEIGHT; y++) {
+        frame_proto_write(enc, row, ROI_WIDTH * YUV_DEPTH);
+        row += IMAGE_WIDTH * YUV_DEPTH;
+    }
+    frame_proto_end(enc);
+}
+
+static void init_mux(void) {
+    uart_mux_config_t config;
+    uart_mux_default_config(&config, LINK_BAUD_BASE);
+    config.fragment_size = MUX_FRAGMENT_SIZE;
+    s_app.clock_count = SYS_TIME_CounterGet();
+    uart_mux_init(&s_mux, &config, stream_write, 0, mux_clock);
+    uart_mux_set_queue(&s_mux, UART_MUX_CONTROL, s_mux_control_q,
+                       sizeof(s_mux_control_q));
+    uart_mux_set_queue(&s_mux, UART_MUX_TELEMETRY, s_mux_telemetry_q,
+                       sizeof(s_mux_telemetry_q));
+    uart_mux_set_queue(&s_mux, UART_MUX_LOG, s_mux_log_q,
+                       sizeof(s_mux_log_q));
+    uart_mux_set_queue(&s_mux, UART_MUX_BULK, s_mux_bulk_q,
+                       sizeof(s_mux_bulk_q));
+    s_app.mux_ready = true;
+}
+
+static uint32_t mux_clock(void) {
+    // Whole microseconds are carried forward, and the remainder of the
+    // count with them, so the time neither drifts nor jumps when the
+    // counter wraps
+    uint32_t us = SYS_TIME_CountToUS(SYS_TIME_CounterGet() - s_app.clock_count);
+    s_app.clock_us += us;
+    s_app.clock_count += SYS_TIME_USToCount(us);
+    return s_app.clock_us;
+}
+
+static size_t stream_write(const void *data, size_t n, uintptr_t context) {
+    (void)context;
+    return USART1_Write((void *)data, n);
+}
+
+static void poll_rx(void) {
+    int c;
+    while ((c = USART1_ReadByte()) >= 0) {
+        uint8_t byte = (uint8_t)c;
+        frame_proto_decode(&s_rx, &byte, 1);
+    }
+}
+
+static void on_rx_message(const frame_proto_msg_t *msg, uintptr_t context) {
+    (void)context;
+    if (msg->type == FRAME_PROTO_TYPE_LINK) {
+        link_baud_on_message(msg);
+    } else if (msg->type == FRAME_PROTO_TYPE_COMMAND) {
+        host_cmd_on_message(&s_cmd, msg);
+    }
+}
+
+static bool report_due(const cam_frame_t *frame) {
+    return s_settings.log_level >= APP_LOG_REPORTS &&
+           frame->seq % CONVERT_REPORT_INTERVAL == 0;
+}
+
+static void report_sensor(const cam_frame_t *frame) {
+    cam_meta_stats_t stats;
+    cam_meta_get_stats(&stats);
+    uint8_t gain, aec, reg04, reg45, yavg;
+    if (!cam_meta_lookup(&frame->meta, OV2640_I2C_SENSOR_BANK,
+                         OV2640_I2C_GAIN, &gain) ||
+        !cam_meta_lookup(&frame->meta, OV2640_I2C_SENSOR_BANK,
+                         OV2640_I2C_AEC, &aec) ||
+        !cam_meta_lookup(&frame->meta, OV2640_I2C_SENSOR_BANK,
+                         OV2640_I2C_REG04, &reg04) ||
+        !cam_meta_lookup(&frame->meta, OV2640_I2C_SENSOR_BANK,
+                         OV2640_I2C_REG45, &reg45) ||
+        !cam_meta_lookup(&frame->meta, OV2640_I2C_SENSOR_BANK,
+                         OV2640_I2C_YAVG, &yavg)) {
+        printf("# sensor: no metadata (%ld overruns, %ld errors)\r\n",
+               stats.overruns, stats.errors);
+        return;
+    }
+    // AEC[15:10] in REG45[5:0], AEC[9:2] in AEC, AEC[1:0] in REG04[1:0]
+    unsigned exposure = ((reg45 & 0x3f) << 10) | (aec << 2) | (reg04 & 0x03);
+    printf("# sensor: exposure %u (set %u), gain 0x%02x (set 0x%02x), "
+           "yavg %d, read in %ld us (%ld overruns, %ld errors)\r\n",
+           exposure, cam_aec_exposure(&s_aec), gain, cam_aec_gain_reg(&s_aec),
+           yavg, frame->meta.read_us, stats.overruns, stats.errors);
+}
+
+static host_cmd_status_t on_command(const host_cmd_request_t *request,
+                                    uint32_t *value, uintptr_t context) {
+    (void)context;
+    if (request->op == HOST_CMD_OP_SNAPSHOT) {
+        s_app.snapshot_requested = true;
+        return HOST_CMD_OK;
+    }
+    if (request->op == HOST_CMD_OP_SET) {
+        host_cmd_status_t status =
+            set_setting(&s_next_settings, request->param, request->value);
+        if (status != HOST_CMD_OK) {
+            return status;
+        }
+        s_app.settings_changed = true;
+    }
+    *value = get_setting(&s_next_settings, request->param);
+    return HOST_CMD_OK;
+}
+
+static uint8_t max_log_level(void) {
+    if (APP_ASCII_ART) {
+        // reports would scroll the picture away
+        return APP_LOG_ERRORS;
+    }
+    if (APP_STREAM_FRAMES) {
+        // the hex dump trace would cost more link time than the frames
+        return APP_LOG_REPORTS;
+    }
+    return APP_LOG_TRACE;
+}
+
+static host_cmd_status_t set_setting(app_settings_t *settings, uint8_t param,
+                                     uint32_t value) {
+    switch (param) {
+    case HOST_CMD_PARAM_PROFILE: {
+        if (value >= sizeof(s_profiles) / sizeof(s_profiles[0])) {
+            return HOST_CMD_ERR_VALUE;
+        }
+        const app_profile_t *profile = &s_profiles[value];
+        settings->profile = (uint8_t)value;
+        settings->fps = profile->fps;
+        settings->format = profile->format;
+        settings->compression = profile->compression;
+        return HOST_CMD_OK;
+    }
+    case HOST_CMD_PARAM_FPS:
+        if (value > APP_MAX_FPS) {
+            return HOST_CMD_ERR_VALUE;
+        }
+        settings->fps = (uint16_t)value;
+        return HOST_CMD_OK;
+    case HOST_CMD_PARAM_FORMAT:
+        if (value >= APP_N_FORMATS) {
+            return HOST_CMD_ERR_VALUE;
+        }
+        settings->format = (uint8_t)value;
+        return HOST_CMD_OK;
+    case HOST_CMD_PARAM_COMPRESSION:
+        if (value > UINT8_MAX) {
+            return HOST_CMD_ERR_VALUE;
+        }
+        settings->compression = (uint8_t)value;
+        return HOST_CMD_OK;
+    case HOST_CMD_PARAM_LOG_LEVEL:
+        if (value > max_log_level()) {
+            return HOST_CMD_ERR_VALUE;
+        }
+        settings->log_level = (uint8_t)value;
+        return HOST_CMD_OK;
+    default:
+        return HOST_CMD_ERR_PARAM;
     }
 }
 
-static void convert_yuv_to_rgb(uint8_t *yuv_buf) {
-    uint8_t *yuv = yuv_buf;
-    uint8_t *rgb = s_rgb_buf;
-
-    for (int i=0; i<YUV_BUFFER_SIZE; i+=4) {
-        // read 4 bytes: [y0, u, y1, v]
-        uint8_t y0 = *yuv++;
-        uint8_t u = *yuv++;
-        uint8_t y1 = *yuv++;
-        uint8_t v = *yuv++;
-
-        // emit six bytes: [r0, g0, b0, r1, g1, b1]
-        *rgb++ = clamp(y0 + 1.4075 * (v - 128));
-        *rgb++ = clamp(y0 - 0.3455 * (u - 128) - (0.7169 * (v - 128)));
-        *rgb++ = clamp(y0 + 1.7790 * (u - 128));
-        *rgb++ = clamp(y1 + 1.4075 * (v - 128));
-        *rgb++ = clamp(y1 - 0.3455 * (u - 128) - (0.7169 * (v - 128)));
-        *rgb++ = clamp(y1 + 1.7790 * (u - 128));
+static uint32_t get_setting(const app_settings_t *settings, uint8_t param) {
+    switch (param) {
+    case HOST_CMD_PARAM_PROFILE:
+        return settings->profile;
+    case HOST_CMD_PARAM_FPS:
+        return settings->fps;
+    case HOST_CMD_PARAM_FORMAT:
+        return settings->format;
+    case HOST_CMD_PARAM_COMPRESSION:
+        return settings->compression;
+    case HOST_CMD_PARAM_LOG_LEVEL:
+        return settings->log_level;
+    default:
+        return 0;
     }
 }
 
+static void apply_settings(void) {
+    const app_settings_t *next = &s_next_settings;
+
+    if (next->format != s_settings.format) {
+        // the receiver can only start decoding the new format at a key frame
+        s_app.key_requested = true;
+        tile_stream_request_key(&s_tile_stream);
+        dual_stream_request_full(&s_dual);
+    }
+    if (next->fps != s_settings.fps) {
+        cam_fps_set_target_us(&s_fps, fps_to_period_us(next->fps));
+    }
+    s_tile_stream.config.threshold = next->compression;
+    cam_data_task_set_trace(next->log_level >= APP_LOG_TRACE);
+    s_settings = *next;
+    s_app.settings_changed = false;
+    printf("# settings: profile %d, %d fps, format %d, compression %d, "
+           "log level %d\r\n",
+           s_settings.profile, s_settings.fps, s_settings.format,
+           s_settings.compression, s_settings.log_level);
+}
+
+static void send_snapshot(const cam_frame_t *frame) {
+    frame_proto_encoder_t *enc = &s_proto;
+    uint32_t size = FRAME_PROTO_MESSAGE_SIZE(RAW_FRAME_PAYLOAD);
+    uint32_t free = USART1_WriteFreeBufferCountGet();
+
+    if (s_app.mux_ready) {
+        enc = uart_mux_encoder(&s_mux, UART_MUX_BULK);
+        size = uart_mux_cost(&s_mux, UART_MUX_BULK, RAW_FRAME_PAYLOAD);
+        free = uart_mux_free(&s_mux, UART_MUX_BULK);
+        frame_proto_set_tag(enc, frame->seq);
+    }
+    // Waiting for room would stall capture: try again with the next frame
+    if (link_baud_busy() || free < size) {
+        return;
+    }
+    send_yuyv(enc, frame->buf, IMAGE_WIDTH, IMAGE_HEIGHT,
+              FRAME_PROTO_FLAG_KEY | FRAME_PROTO_FLAG_SNAPSHOT);
+    s_app.snapshot_requested = false;
+}
+
+static uint32_t fps_to_period_us(uint16_t fps) {
+    return fps == 0 ? 0 : 1000000 / fps;
+}
+
+static uint32_t convert_yuv_to_rgb(const uint8_t *yuv_buf) {
+    uint32_t start = cycle_counter_get();
+    yuv_convert(YUV_CONVERT_RGB888, yuv_buf, s_rgb_buf,
+                IMAGE_WIDTH * IMAGE_HEIGHT);
+    return cycle_counter_get() - start;
+}
+
 /*******************************************************************************
  End of File
  */
@@ -34,6 +34,8 @@
 // *****************************************************************************
 // Includes
 
+#include <stddef.h>
+
 // *****************************************************************************
 // C++ compatibility
 
@@ -57,6 +59,13 @@ void APP_Initialize(void);
  */
 void APP_Tasks(void);
 
+/**
+ * @brief Queue console output for the UART.  While frames are streamed it
+ * shares the link with them by priority (see uart_mux.h).  Returns the
+ * number of bytes queued: output that doesn't fit may be dropped.
+ */
+size_t APP_ConsoleWrite(const void *data, size_t n);
+
 // __attribute__((format(printf, 1, 2))) _Noreturn
 // void APP_panic(const char *format, ...);
 
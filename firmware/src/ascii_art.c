@@ -0,0 +1,179 @@
+/**
+ * @file ascii_art.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "ascii_art.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_MAX_COLS 48
+#define DEFAULT_MAX_ROWS 24
+#define DEFAULT_RAMP " .:-=+*#%@"
+
+#define CLEAR_SCREEN "\x1b[2J"
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Compute the characters of one line into line.
+ */
+static void render_line(const ascii_art_t *art, const uint8_t *yuyv,
+                        uint8_t row, char *line);
+
+/**
+ * @brief Return the largest divisor of n that is no greater than limit.
+ */
+static uint16_t largest_divisor(uint16_t n, uint16_t limit);
+
+// *****************************************************************************
+// Public code
+
+void ascii_art_default_config(ascii_art_config_t *config, uint16_t width,
+                              uint16_t height) {
+    config->width = width;
+    config->height = height;
+    config->cols = largest_divisor(width, DEFAULT_MAX_COLS);
+    // characters are about twice as tall as wide
+    config->rows = largest_divisor(height, (config->cols * height) / width / 2);
+    if (config->rows > DEFAULT_MAX_ROWS) {
+        config->rows = largest_divisor(height, DEFAULT_MAX_ROWS);
+    }
+    config->ramp = DEFAULT_RAMP;
+}
+
+bool ascii_art_init(ascii_art_t *art, const ascii_art_config_t *config) {
+    size_t ramp_len = config->ramp == NULL ? 0 : strlen(config->ramp);
+
+    if (config->cols == 0 || config->rows == 0 ||
+        config->cols > ASCII_ART_MAX_COLS ||
+        config->rows > ASCII_ART_MAX_ROWS ||
+        config->width % config->cols != 0 ||
+        config->height % config->rows != 0 || ramp_len == 0) {
+        return false;
+    }
+    art->config = *config;
+    art->block_w = config->width / config->cols;
+    art->block_h = config->height / config->rows;
+    for (int i = 0; i < 256; i++) {
+        art->lut[i] = config->ramp[(i * ramp_len) / 256];
+    }
+    art->drawn = false;
+    return true;
+}
+
+size_t ascii_art_render(ascii_art_t *art, const uint8_t *yuyv, char *out,
+                        size_t out_size) {
+    size_t n = 0;
+    bool redraw = !art->drawn;
+    char line[ASCII_ART_MAX_COLS];
+
+    if (redraw) {
+        if (out_size < sizeof(CLEAR_SCREEN) - 1) {
+            return 0;
+        }
+        memcpy(out, CLEAR_SCREEN, sizeof(CLEAR_SCREEN) - 1);
+        n += sizeof(CLEAR_SCREEN) - 1;
+        art->drawn = true;
+    }
+
+    for (uint8_t row = 0; row < art->config.rows; row++) {
+        char *prev = art->screen[row];
+        render_line(art, yuyv, row, line);
+        if (!redraw && memcmp(line, prev, art->config.cols) == 0) {
+            continue;
+        }
+        // terminal rows and columns count from 1
+        char cursor[12];
+        int len = snprintf(cursor, sizeof(cursor), "\x1b[%d;1H", row + 1);
+        if (n + len + art->config.cols > out_size) {
+            // out of room: force the rest to be redrawn next frame
+            memset(prev, 0, art->config.cols);
+            continue;
+        }
+        memcpy(&out[n], cursor, len);
+        n += len;
+        memcpy(&out[n], line, art->config.cols);
+        n += art->config.cols;
+        memcpy(prev, line, art->config.cols);
+    }
+    return n;
+}
+
+void ascii_art_invalidate(ascii_art_t *art) {
+    art->drawn = false;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void render_line(const ascii_art_t *art, const uint8_t *yuyv,
+                        uint8_t row, char *line) {
+    uint32_t sums[ASCII_ART_MAX_COLS];
+    uint32_t block_pixels = art->block_w * art->block_h;
+    size_t stride = art->config.width * 2;
+    const uint8_t *src = yuyv + row * art->block_h * stride;
+
+    // sum each block's luma: Y samples are at even byte offsets
+    memset(sums, 0, art->config.cols * sizeof(sums[0]));
+    for (uint16_t y = 0; y < art->block_h; y++) {
+        const uint8_t *p = src;
+        for (uint8_t col = 0; col < art->config.cols; col++) {
+            uint32_t sum = 0;
+            for (uint16_t x = 0; x < art->block_w; x++) {
+                sum += p[x * 2];
+            }
+            sums[col] += sum;
+            p += art->block_w * 2;
+        }
+        src += stride;
+    }
+    for (uint8_t col = 0; col < art->config.cols; col++) {
+        // one divide per character, not per pixel
+        line[col] = art->lut[sums[col] / block_pixels];
+    }
+}
+
+static uint16_t largest_divisor(uint16_t n, uint16_t limit) {
+    for (uint16_t d = limit; d > 1; d--) {
+        if (n % d == 0) {
+            return d;
+        }
+    }
+    return 1;
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,132 @@
+/**
+ * @file ascii_art.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Render camera frames as ASCII art for a serial terminal.
+ *
+ * The luma of each frame is averaged over blocks of pixels, one block per
+ * character cell, and each average is mapped through a lookup table built
+ * from a ramp of characters ordered from dark to light.
+ *
+ * Only the lines that changed since the previous frame are emitted, each
+ * preceded by an ANSI cursor positioning sequence, so a static scene costs
+ * nothing on the link and a typical frame costs a fraction of a full
+ * redraw.  The first frame (and the first after ascii_art_invalidate())
+ * clears the screen and draws every line.
+ *
+ * Terminal characters are roughly twice as tall as they are wide, so the
+ * default grid uses blocks twice as tall as they are wide to keep the
+ * aspect ratio.
+ */
+
+#ifndef _ASCII_ART_H_
+#define _ASCII_ART_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define ASCII_ART_MAX_COLS 96
+#define ASCII_ART_MAX_ROWS 48
+
+// Bytes of output for one frame in the worst case: the screen clear, then a
+// cursor positioning sequence ("\x1b[rr;1H") and the text of every line.
+#define ASCII_ART_MAX_OUTPUT(rows, cols) (4 + (rows) * (8 + (cols)))
+
+typedef struct {
+    uint16_t width;   // source image width in pixels
+    uint16_t height;  // source image height in pixels
+    uint8_t cols;     // characters per line, dividing width
+    uint8_t rows;     // lines, dividing height
+    const char *ramp; // characters from dark to light, at least one
+} ascii_art_config_t;
+
+typedef struct {
+    ascii_art_config_t config;
+    uint16_t block_w; // pixels per character, horizontally
+    uint16_t block_h; // pixels per character, vertically
+    bool drawn;       // screen holds the previous frame
+    char lut[256];    // average luma -> character
+    char screen[ASCII_ART_MAX_ROWS][ASCII_ART_MAX_COLS]; // previous frame
+} ascii_art_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in a config structure with defaults for a width x height
+ * image: a grid of at most 48 x 24 characters and a ten level ramp.
+ */
+void ascii_art_default_config(ascii_art_config_t *config, uint16_t width,
+                              uint16_t height);
+
+/**
+ * @brief Initialize a renderer.
+ *
+ * @return false if the grid exceeds the maximum, doesn't divide the image
+ * evenly, or the ramp is empty.
+ */
+bool ascii_art_init(ascii_art_t *art, const ascii_art_config_t *config);
+
+/**
+ * @brief Render a packed YUYV frame.
+ *
+ * @param yuyv Frame data, width * height * 2 bytes.
+ * @param out Receives the terminal output.
+ * @param out_size Size of out: ASCII_ART_MAX_OUTPUT(rows, cols) always
+ *   suffices.  Lines that don't fit are left for the next frame.
+ * @return Number of bytes written to out, 0 if nothing changed.
+ */
+size_t ascii_art_render(ascii_art_t *art, const uint8_t *yuyv, char *out,
+                        size_t out_size);
+
+/**
+ * @brief Force the next frame to clear the screen and redraw every line,
+ * e.g. after other output has been written to the terminal.
+ */
+void ascii_art_invalidate(ascii_art_t *art);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ASCII_ART_H_ */
@@ -0,0 +1,291 @@
+/**
+ * @file cam_aec.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_aec.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_TARGET_MEAN 110
+#define DEFAULT_DEADBAND 12
+#define DEFAULT_HIGHLIGHT_PCT 98
+#define DEFAULT_HIGHLIGHT_LIMIT 250
+#define DEFAULT_SHADOW_PCT 2
+#define DEFAULT_SHADOW_LIMIT 4
+#define DEFAULT_UPDATE_INTERVAL 2 // new exposure takes effect a frame later
+#define DEFAULT_MIN_EXPOSURE 1
+#define DEFAULT_MAX_EXPOSURE 1200 // about one frame time at CLKRC = 0
+
+// Ratios are Q8: 256 = 1.0
+#define RATIO_ONE 256
+#define RATIO_MIN (RATIO_ONE / 2)
+#define RATIO_MAX (RATIO_ONE * 2)
+
+// Ratio applied when highlights clip but the mean is on target or low
+#define RATIO_CLIPPED ((RATIO_ONE * 7) / 8)
+
+// Raises smaller than this are not worth a register write
+#define RATIO_HOLD (RATIO_ONE / 32)
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the luma value at which the cumulative histogram reaches
+ * pct percent of total.
+ */
+static uint8_t percentile(const uint32_t *histogram, uint32_t total,
+                          uint8_t pct);
+
+/**
+ * @brief Split exposure_value (lines * Q4 gain) into exposure and gain,
+ * using exposure first.
+ */
+static void apply_exposure_value(cam_aec_t *aec, uint32_t exposure_value);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint32_t s_histogram[256];
+
+// *****************************************************************************
+// Public code
+
+void cam_aec_default_config(cam_aec_config_t *config) {
+    config->target_mean = DEFAULT_TARGET_MEAN;
+    config->deadband = DEFAULT_DEADBAND;
+    config->highlight_pct = DEFAULT_HIGHLIGHT_PCT;
+    config->highlight_limit = DEFAULT_HIGHLIGHT_LIMIT;
+    config->shadow_pct = DEFAULT_SHADOW_PCT;
+    config->shadow_limit = DEFAULT_SHADOW_LIMIT;
+    config->update_interval = DEFAULT_UPDATE_INTERVAL;
+    config->min_exposure = DEFAULT_MIN_EXPOSURE;
+    config->max_exposure = DEFAULT_MAX_EXPOSURE;
+    config->max_gain = CAM_AEC_GAIN_MAX;
+}
+
+void cam_aec_init(cam_aec_t *aec, const cam_aec_config_t *config,
+                  uint16_t exposure, uint16_t gain) {
+    if (config == NULL) {
+        cam_aec_default_config(&aec->config);
+    } else {
+        aec->config = *config;
+    }
+    aec->holdoff = 0;
+    aec->converged = false;
+    aec->adjustments = 0;
+    apply_exposure_value(aec, (uint32_t)exposure * gain);
+}
+
+void cam_aec_compute_stats(const cam_aec_t *aec, const uint8_t *yuyv,
+                           size_t n_pixels, cam_aec_stats_t *stats) {
+    uint32_t sum = 0;
+
+    memset(s_histogram, 0, sizeof(s_histogram));
+    // Y samples are at even byte offsets: [y0, u, y1, v]
+    for (size_t i = 0; i < n_pixels; i++) {
+        uint8_t y = yuyv[i * 2];
+        s_histogram[y]++;
+        sum += y;
+    }
+    if (n_pixels == 0) {
+        memset(stats, 0, sizeof(cam_aec_stats_t));
+        return;
+    }
+    stats->mean = sum / n_pixels;
+    stats->shadow =
+        percentile(s_histogram, n_pixels, aec->config.shadow_pct);
+    stats->highlight =
+        percentile(s_histogram, n_pixels, aec->config.highlight_pct);
+}
+
+void cam_aec_stats_from_histogram(const cam_aec_t *aec,
+                                  const uint32_t *histogram, size_t n_pixels,
+                                  uint8_t mean, cam_aec_stats_t *stats) {
+    if (n_pixels == 0) {
+        memset(stats, 0, sizeof(cam_aec_stats_t));
+        return;
+    }
+    stats->mean = mean;
+    stats->shadow = percentile(histogram, n_pixels, aec->config.shadow_pct);
+    stats->highlight =
+        percentile(histogram, n_pixels, aec->config.highlight_pct);
+}
+
+bool cam_aec_update(cam_aec_t *aec, const cam_aec_stats_t *stats) {
+    const cam_aec_config_t *cfg = &aec->config;
+    bool clipped = stats->highlight >= cfg->highlight_limit;
+    bool crushed = stats->shadow <= cfg->shadow_limit;
+    int error = (int)stats->mean - (int)cfg->target_mean;
+    uint32_t ratio;
+
+    if (aec->holdoff > 0) {
+        // previous adjustment may not have taken effect yet
+        aec->holdoff--;
+        return false;
+    }
+
+    if (clipped && (error <= 0)) {
+        // on target (or dark) on average, but blowing out highlights
+        ratio = RATIO_CLIPPED;
+    } else if (crushed && !clipped && (error < 0)) {
+        // crushing shadows with headroom above: the lower half of the
+        // deadband doesn't count as converged
+        ratio = ((uint32_t)cfg->target_mean * RATIO_ONE) /
+                (stats->mean > 0 ? stats->mean : 1);
+    } else if ((error >= -(int)cfg->deadband) &&
+               (error <= (int)cfg->deadband)) {
+        aec->converged = true;
+        return false;
+    } else {
+        ratio = ((uint32_t)cfg->target_mean * RATIO_ONE) /
+                (stats->mean > 0 ? stats->mean : 1);
+    }
+
+    if (ratio > RATIO_ONE) {
+        // Don't raise the exposure into clipping, or the clipped case above
+        // lowers it again and the loop hunts between the two.  Luma grows
+        // at most in proportion to the exposure, so this is conservative.
+        uint32_t headroom = ((uint32_t)(cfg->highlight_limit - 1) * RATIO_ONE) /
+                            (stats->highlight > 0 ? stats->highlight : 1);
+        if (ratio > headroom) {
+            ratio = headroom;
+        }
+        if (ratio < RATIO_ONE + RATIO_HOLD) {
+            // as bright as the highlights allow
+            aec->converged = true;
+            return false;
+        }
+    }
+    aec->converged = false;
+
+    // rate limit to a factor of two per adjustment
+    if (ratio < RATIO_MIN) {
+        ratio = RATIO_MIN;
+    } else if (ratio > RATIO_MAX) {
+        ratio = RATIO_MAX;
+    }
+
+    uint16_t prev_exposure = aec->exposure;
+    uint16_t prev_gain = aec->gain;
+    uint32_t exposure_value = (uint32_t)aec->exposure * aec->gain;
+    // 64-bit intermediate: exposure_value can use up to 25 bits
+    apply_exposure_value(aec,
+                         (uint32_t)(((uint64_t)exposure_value * ratio) >> 8));
+
+    if ((aec->exposure == prev_exposure) && (aec->gain == prev_gain)) {
+        // pinned at a limit, or the step is finer than the settings allow at
+        // short exposures: nothing to write.  Within the deadband that is as
+        // close as the loop can get.
+        aec->converged = (error >= -(int)cfg->deadband) &&
+                         (error <= (int)cfg->deadband);
+        return false;
+    }
+    aec->holdoff = cfg->update_interval > 0 ? cfg->update_interval - 1 : 0;
+    aec->adjustments++;
+    return true;
+}
+
+uint16_t cam_aec_exposure(const cam_aec_t *aec) { return aec->exposure; }
+
+uint8_t cam_aec_gain_reg(const cam_aec_t *aec) {
+    uint32_t gain = aec->gain;
+    uint8_t reg = 0;
+
+    // Each of GAIN[7:4] doubles the gain.  Use them while the remaining gain
+    // is 2x or more, then encode the remainder in 1/16ths in GAIN[3:0].
+    for (int bit = 4; bit < 8; bit++) {
+        if (gain >= 2 * CAM_AEC_GAIN_UNITY) {
+            reg |= (1 << bit);
+            gain >>= 1;
+        }
+    }
+    if (gain >= 2 * CAM_AEC_GAIN_UNITY) {
+        gain = 2 * CAM_AEC_GAIN_UNITY - 1;
+    }
+    reg |= (gain - CAM_AEC_GAIN_UNITY) & 0x0f;
+    return reg;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint8_t percentile(const uint32_t *histogram, uint32_t total,
+                          uint8_t pct) {
+    uint32_t threshold = ((uint64_t)total * pct) / 100;
+    uint32_t cumulative = 0;
+
+    for (int i = 0; i < 256; i++) {
+        cumulative += histogram[i];
+        if (cumulative > threshold) {
+            return i;
+        }
+    }
+    return 255;
+}
+
+static void apply_exposure_value(cam_aec_t *aec, uint32_t exposure_value) {
+    const cam_aec_config_t *cfg = &aec->config;
+    uint32_t min_value = (uint32_t)cfg->min_exposure * CAM_AEC_GAIN_UNITY;
+    uint32_t max_value = (uint32_t)cfg->max_exposure * cfg->max_gain;
+    uint32_t exposure;
+    uint32_t gain;
+
+    if (exposure_value < min_value) {
+        exposure_value = min_value;
+    } else if (exposure_value > max_value) {
+        exposure_value = max_value;
+    }
+
+    // exposure first, at unity gain...
+    exposure = exposure_value / CAM_AEC_GAIN_UNITY;
+    if (exposure > cfg->max_exposure) {
+        exposure = cfg->max_exposure;
+    }
+    if (exposure < 1) {
+        exposure = 1;
+    }
+    // ... then make up the remainder with gain
+    gain = exposure_value / exposure;
+    if (gain < CAM_AEC_GAIN_UNITY) {
+        gain = CAM_AEC_GAIN_UNITY;
+    } else if (gain > cfg->max_gain) {
+        gain = cfg->max_gain;
+    }
+    aec->exposure = exposure;
+    aec->gain = gain;
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,195 @@
+/**
+ * @file cam_aec.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Closed-loop auto exposure / gain control driven by frame luma.
+ *
+ * The OV2640's built-in AEC/AGC meters over a window that doesn't match our
+ * 96 x 96 crop, so frames swing between blown out and dark.  This module
+ * meters the Y channel of each captured frame instead and computes new
+ * exposure (line count) and analog gain settings for the sensor.
+ *
+ * cam_aec has no hardware dependencies: the caller feeds it frames and applies
+ * the resulting settings (see cam_ctrl_task_set_exposure()).  This makes it
+ * possible to run it on a host against recorded frames.
+ *
+ * Control law:
+ * - The error is the ratio target_mean / measured mean.  If highlights clip
+ *   (the high percentile reaches highlight_limit) the frame is treated as
+ *   over-exposed regardless of the mean.
+ * - No change is made while the mean is within +/- deadband of target_mean
+ *   (hysteresis), so the loop doesn't hunt around the set point.
+ * - Each adjustment is limited to a factor of two, and adjustments are made at
+ *   most once every update_interval frames, giving the sensor time to apply
+ *   the previous setting before it is metered again.
+ * - Exposure is used before gain: gain is only raised above 1x once the
+ *   exposure reaches max_exposure.
+ * - The exposure is never raised by more than the headroom above the
+ *   highlights allows, so a scene with both clipped highlights and a dark
+ *   mean or crushed shadows settles as bright as it can without clipping,
+ *   rather than alternating between the two corrections.
+ *
+ * Since the sensor response (after gamma) is compressive, a full-ratio
+ * correction never overshoots, so the loop converges monotonically.  Moving
+ * between the extremes of the exposure range takes at most
+ * CAM_AEC_MAX_STEPS adjustments, i.e. CAM_AEC_MAX_STEPS * update_interval
+ * frames.
+ */
+
+#ifndef _CAM_AEC_H_
+#define _CAM_AEC_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// Gain is expressed in Q4 fixed point: 16 = 1x, 32 = 2x, etc.
+#define CAM_AEC_GAIN_UNITY 16
+
+// OV2640 analog gain tops out a little under 32x
+#define CAM_AEC_GAIN_MAX (31 * CAM_AEC_GAIN_UNITY)
+
+// Largest exposure (in lines) the OV2640 accepts in the 16-bit AEC field.
+#define CAM_AEC_EXPOSURE_MAX 0xffff
+
+// Upper bound on the number of adjustments needed to traverse the full
+// exposure * gain range (2^16 lines * 2^5 gain) at 2x per adjustment.
+#define CAM_AEC_MAX_STEPS 21
+
+typedef struct {
+    uint8_t target_mean;     // desired mean luma
+    uint8_t deadband;        // no change while |mean - target_mean| <= deadband
+    uint8_t highlight_pct;   // percentile checked for clipping (e.g. 98)
+    uint8_t highlight_limit; // luma at or above which highlight_pct is clipped
+    uint8_t shadow_pct;      // percentile checked for crushed shadows (e.g. 2)
+    uint8_t shadow_limit;    // luma at or below which shadow_pct is crushed
+    uint8_t update_interval; // minimum number of frames between adjustments
+    uint16_t min_exposure;   // exposure lower bound, in lines
+    uint16_t max_exposure;   // exposure upper bound, in lines
+    uint16_t max_gain;       // gain upper bound, Q4
+} cam_aec_config_t;
+
+/**
+ * @brief Luma statistics for one frame.
+ */
+typedef struct {
+    uint8_t mean;      // mean luma
+    uint8_t shadow;    // luma at config.shadow_pct percentile
+    uint8_t highlight; // luma at config.highlight_pct percentile
+} cam_aec_stats_t;
+
+typedef struct {
+    cam_aec_config_t config;
+    uint16_t exposure;    // current exposure in lines
+    uint16_t gain;        // current gain, Q4
+    uint8_t holdoff;      // frames remaining before next adjustment allowed
+    bool converged;       // true when the last metered frame was on target
+    uint32_t adjustments; // number of adjustments made (telemetry)
+} cam_aec_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in a config structure with sensible defaults.
+ */
+void cam_aec_default_config(cam_aec_config_t *config);
+
+/**
+ * @brief Initialize an AEC controller.
+ *
+ * @param config Configuration to use, or NULL for defaults.
+ * @param exposure Starting exposure in lines.
+ * @param gain Starting gain, Q4.
+ */
+void cam_aec_init(cam_aec_t *aec, const cam_aec_config_t *config,
+                  uint16_t exposure, uint16_t gain);
+
+/**
+ * @brief Compute luma statistics from a packed YUYV (YUV422) frame.
+ *
+ * @param yuyv Frame data, n_pixels * 2 bytes.
+ * @param n_pixels Number of pixels (not bytes) in the frame.
+ */
+void cam_aec_compute_stats(const cam_aec_t *aec, const uint8_t *yuyv,
+                           size_t n_pixels, cam_aec_stats_t *stats);
+
+/**
+ * @brief Compute luma statistics from a precomputed Y histogram, e.g. the
+ * one in frame_stats_t.
+ *
+ * @param histogram 256 bin Y histogram.
+ * @param n_pixels Number of pixels counted in the histogram.
+ * @param mean Mean luma.
+ */
+void cam_aec_stats_from_histogram(const cam_aec_t *aec,
+                                  const uint32_t *histogram, size_t n_pixels,
+                                  uint8_t mean, cam_aec_stats_t *stats);
+
+/**
+ * @brief Run one step of the controller using the stats for the most recent
+ * frame.  Call once per frame.
+ *
+ * @return true if the exposure or gain changed and must be written to the
+ * sensor.
+ */
+bool cam_aec_update(cam_aec_t *aec, const cam_aec_stats_t *stats);
+
+/**
+ * @brief Return the current exposure in lines.
+ */
+uint16_t cam_aec_exposure(const cam_aec_t *aec);
+
+/**
+ * @brief Return the current gain, encoded for the OV2640 GAIN register.
+ *
+ * GAIN[7:4] each double the gain, GAIN[3:0] adds 1/16ths:
+ *   gain = (GAIN[7]+1) * (GAIN[6]+1) * (GAIN[5]+1) * (GAIN[4]+1) *
+ *          (1 + GAIN[3:0] / 16)
+ */
+uint8_t cam_aec_gain_reg(const cam_aec_t *aec);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _CAM_AEC_H_ */
@@ -49,6 +49,25 @@
 #define CAM_CTRL_TASK_DEV_CTRL_REG_COM7 0x12
 #define CAM_CTRL_TASK_DEV_CTRL_REG_COM10 0x15
 
+// COM8 bits that hand exposure and gain control to the sensor
+#define COM8_AEC_AUTO 0x01
+#define COM8_AGC_AUTO 0x04
+
+// Exposure is split across three sensor bank registers:
+// REG45[5:0] = AEC[15:10], AEC[7:0] = AEC[9:2], REG04[1:0] = AEC[1:0]
+#define REG45_AEC_MASK 0x3f
+#define REG04_AEC_MASK 0x03
+
+// bank select + REG45, AEC, REG04, GAIN
+#define EXPOSURE_PAIRS_COUNT 5
+
+// CLKRC[5:0] = clock divider - 1.  CLKRC[7] (clock doubler) is left off, as
+// in the format tables.
+#define CLKRC_DIV_MASK 0x3f
+
+// bank select + CLKRC, ADDVSL, ADDVSH
+#define TIMING_PAIRS_COUNT 4
+
 /**
  * @brief cam_ctrl_task states.
  */
@@ -71,6 +90,24 @@ typedef struct {
     cam_ctrl_task_state_t state; // current state
     SYS_TIME_HANDLE delay;       // general delay timer
     int retry_count;             // retry chip id
+    bool manual_exposure;        // true once AEC/AGC have been disabled
+    uint8_t com8;                // cached COM8 with AEC/AGC disabled
+    uint8_t reg04;               // cached REG04 (bits other than AEC[1:0])
+    uint8_t reg45;               // cached REG45 (bits other than AEC[15:10])
+    // queued exposure writes
+    ov2640_i2c_pair_t exposure_pairs[EXPOSURE_PAIRS_COUNT];
+    volatile bool exposure_busy;     // exposure_pairs is queued in the driver
+    volatile bool exposure_pending;  // newer settings wait for exposure_busy
+    uint16_t pending_exposure;
+    uint8_t pending_gain;
+    volatile uint32_t exposure_errors; // failed queued exposure writes
+    // queued frame timing writes
+    ov2640_i2c_pair_t timing_pairs[TIMING_PAIRS_COUNT];
+    volatile bool timing_busy;     // timing_pairs is queued in the driver
+    volatile bool timing_pending;  // newer settings wait for timing_busy
+    uint8_t pending_clk_div;
+    uint16_t pending_dummy_lines;
+    volatile uint32_t timing_errors; // failed queued timing writes
 } cam_ctrl_task_ctx_t;
 
 // *****************************************************************************
@@ -360,11 +397,53 @@ static void set_holdoff(uint32_t ms);
  */
 static void await_holdoff(cam_ctrl_task_state_t next_state);
 
+/**
+ * @brief Read COM8, REG04 and REG45, then disable the sensor's automatic
+ * exposure and gain control.  The registers are cached so that subsequent
+ * exposure changes need only write.
+ */
+static bool enter_manual_exposure(void);
+
+/**
+ * @brief Fill exposure_pairs and queue them.  Call with interrupts disabled
+ * or from the I2C completion callback.
+ *
+ * Returns false only if the write could not be queued.  Once it is queued,
+ * exposure_write_cb alone counts a failure, even one to start the transfer.
+ */
+static bool queue_exposure_write(uint16_t exposure, uint8_t gain);
+
+/**
+ * @brief Completion callback for queue_exposure_write (interrupt context).
+ */
+static void exposure_write_cb(bool success, uintptr_t context);
+
+/**
+ * @brief Fill timing_pairs and queue them.  Call with interrupts disabled
+ * or from the I2C completion callback.
+ *
+ * Returns false only if the write could not be queued.  Once it is queued,
+ * timing_write_cb alone counts a failure, even one to start the transfer.
+ */
+static bool queue_timing_write(uint8_t clk_div, uint16_t dummy_lines);
+
+/**
+ * @brief Completion callback for queue_timing_write (interrupt context).
+ */
+static void timing_write_cb(bool success, uintptr_t context);
+
 // *****************************************************************************
 // Public code
 
 void cam_ctrl_task_init(void) {
     s_cam_ctrl_task.state = CAM_CTRL_TASK_STATE_INIT;
+    s_cam_ctrl_task.manual_exposure = false;
+    s_cam_ctrl_task.exposure_busy = false;
+    s_cam_ctrl_task.exposure_pending = false;
+    s_cam_ctrl_task.exposure_errors = 0;
+    s_cam_ctrl_task.timing_busy = false;
+    s_cam_ctrl_task.timing_pending = false;
+    s_cam_ctrl_task.timing_errors = 0;
 }
 
 bool cam_ctrl_reset_camera(void) {
@@ -379,10 +458,55 @@ bool cam_ctrl_task_probe_i2c(void) {
 }
 
 bool cam_ctrl_task_setup_camera(void) {
+    // format load restores automatic exposure
+    s_cam_ctrl_task.manual_exposure = false;
     s_cam_ctrl_task.state = CAM_CTRL_TASK_STATE_START_FORMAT_RESET;
     return true;
 }
 
+bool cam_ctrl_task_set_exposure(uint16_t exposure, uint8_t gain) {
+    if (!s_cam_ctrl_task.manual_exposure) {
+        // one-time, blocking: read back the registers that share bits with
+        // the exposure value and turn off AEC/AGC
+        if (!ov2640_i2c_select_bank(OV2640_I2C_SENSOR_BANK) ||
+            !enter_manual_exposure()) {
+            return false;
+        }
+    }
+
+    bool success = true;
+    bool int_state = SYS_INT_Disable();
+    if (s_cam_ctrl_task.exposure_busy) {
+        // previous write still on the bus: keep only the latest settings
+        s_cam_ctrl_task.pending_exposure = exposure;
+        s_cam_ctrl_task.pending_gain = gain;
+        s_cam_ctrl_task.exposure_pending = true;
+    } else {
+        success = queue_exposure_write(exposure, gain);
+    }
+    SYS_INT_Restore(int_state);
+    return success;
+}
+
+bool cam_ctrl_task_set_frame_timing(uint8_t clk_div, uint16_t dummy_lines) {
+    if (clk_div < 1 || clk_div > CLKRC_DIV_MASK + 1) {
+        return false;
+    }
+
+    bool success = true;
+    bool int_state = SYS_INT_Disable();
+    if (s_cam_ctrl_task.timing_busy) {
+        // previous write still on the bus: keep only the latest settings
+        s_cam_ctrl_task.pending_clk_div = clk_div;
+        s_cam_ctrl_task.pending_dummy_lines = dummy_lines;
+        s_cam_ctrl_task.timing_pending = true;
+    } else {
+        success = queue_timing_write(clk_div, dummy_lines);
+    }
+    SYS_INT_Restore(int_state);
+    return success;
+}
+
 bool cam_ctrl_task_succeeded(void) {
     return s_cam_ctrl_task.state == CAM_CTRL_TASK_STATE_SUCCESS;
 }
@@ -506,10 +630,21 @@ void cam_ctrl_task_step(void) {
         // Load YUV program into camera
         const ov2640_i2c_pair_t *pairs = CAM_CTRL_TASK_YUV_96x96;
         size_t count = CAM_CTRL_TASK_YUV_96x96_count;
+#if TWIHS0_ISR_STATS
+        TWIHS_ISR_STATS isr_stats;
+        TWIHS0_IsrStatsReset();
+#endif
         if (!ov2640_i2c_write_pairs(pairs, count)) {
             printf("# Failed to load camera format\r\n");
             s_cam_ctrl_task.state = CAM_CTRL_TASK_STATE_ERROR;
         } else {
+#if TWIHS0_ISR_STATS
+            TWIHS0_IsrStatsGet(&isr_stats);
+            printf("# format load: %d registers, %ld interrupts, %ld cycles "
+                   "in ISR (max %ld)\r\n",
+                   count, isr_stats.count, isr_stats.cycles,
+                   isr_stats.maxCycles);
+#endif
             set_holdoff(I2C_OP_HOLDOFF_MS);
             s_cam_ctrl_task.state = CAM_CTRL_TASK_STATE_SUCCESS;
         }
@@ -544,5 +679,102 @@ static void await_holdoff(cam_ctrl_task_state_t next_state) {
     } // else remain in current state...
 }
 
+static bool enter_manual_exposure(void) {
+    uint8_t com8, reg04, reg45;
+
+    // assumes sensor bank is already selected
+    if (!ov2640_i2c_read_byte(OV2640_I2C_COM8, &com8) ||
+        !ov2640_i2c_read_byte(OV2640_I2C_REG04, &reg04) ||
+        !ov2640_i2c_read_byte(OV2640_I2C_REG45, &reg45)) {
+        printf("# Failed to read exposure registers\r\n");
+        return false;
+    }
+    s_cam_ctrl_task.com8 = com8 & ~(COM8_AEC_AUTO | COM8_AGC_AUTO);
+    s_cam_ctrl_task.reg04 = reg04 & ~REG04_AEC_MASK;
+    s_cam_ctrl_task.reg45 = reg45 & ~REG45_AEC_MASK;
+    if (!ov2640_i2c_write_byte(OV2640_I2C_COM8, s_cam_ctrl_task.com8)) {
+        printf("# Failed to disable AEC/AGC\r\n");
+        return false;
+    }
+    s_cam_ctrl_task.manual_exposure = true;
+    return true;
+}
+
+static bool queue_exposure_write(uint16_t exposure, uint8_t gain) {
+    ov2640_i2c_pair_t *pairs = s_cam_ctrl_task.exposure_pairs;
+
+    pairs[0].addr = 0xff; // select sensor bank
+    pairs[0].data = 0x01;
+    pairs[1].addr = OV2640_I2C_REG45;
+    pairs[1].data = s_cam_ctrl_task.reg45 | ((exposure >> 10) & REG45_AEC_MASK);
+    pairs[2].addr = OV2640_I2C_AEC;
+    pairs[2].data = (exposure >> 2) & 0xff;
+    pairs[3].addr = OV2640_I2C_REG04;
+    pairs[3].data = s_cam_ctrl_task.reg04 | (exposure & REG04_AEC_MASK);
+    pairs[4].addr = OV2640_I2C_GAIN;
+    pairs[4].data = gain;
+
+    s_cam_ctrl_task.exposure_busy = true;
+    if (!ov2640_i2c_write_pairs_async(pairs, EXPOSURE_PAIRS_COUNT,
+                                      exposure_write_cb, 0)) {
+        s_cam_ctrl_task.exposure_busy = false;
+        return false;
+    }
+    return true;
+}
+
+static void exposure_write_cb(bool success, uintptr_t context) {
+    (void)context;
+    if (!success) {
+        s_cam_ctrl_task.exposure_errors++;
+    }
+    s_cam_ctrl_task.exposure_busy = false;
+    if (s_cam_ctrl_task.exposure_pending) {
+        s_cam_ctrl_task.exposure_pending = false;
+        if (!queue_exposure_write(s_cam_ctrl_task.pending_exposure,
+                                  s_cam_ctrl_task.pending_gain)) {
+            // never queued, so no callback will count it
+            s_cam_ctrl_task.exposure_errors++;
+        }
+    }
+}
+
+static bool queue_timing_write(uint8_t clk_div, uint16_t dummy_lines) {
+    ov2640_i2c_pair_t *pairs = s_cam_ctrl_task.timing_pairs;
+
+    pairs[0].addr = 0xff; // select sensor bank
+    pairs[0].data = 0x01;
+    pairs[1].addr = OV2640_I2C_CLKRC;
+    pairs[1].data = (clk_div - 1) & CLKRC_DIV_MASK;
+    pairs[2].addr = OV2640_I2C_ADDVSL;
+    pairs[2].data = dummy_lines & 0xff;
+    pairs[3].addr = OV2640_I2C_ADDVSH;
+    pairs[3].data = dummy_lines >> 8;
+
+    s_cam_ctrl_task.timing_busy = true;
+    if (!ov2640_i2c_write_pairs_async(pairs, TIMING_PAIRS_COUNT,
+                                      timing_write_cb, 0)) {
+        s_cam_ctrl_task.timing_busy = false;
+        return false;
+    }
+    return true;
+}
+
+static void timing_write_cb(bool success, uintptr_t context) {
+    (void)context;
+    if (!success) {
+        s_cam_ctrl_task.timing_errors++;
+    }
+    s_cam_ctrl_task.timing_busy = false;
+    if (s_cam_ctrl_task.timing_pending) {
+        s_cam_ctrl_task.timing_pending = false;
+        if (!queue_timing_write(s_cam_ctrl_task.pending_clk_div,
+                                s_cam_ctrl_task.pending_dummy_lines)) {
+            // never queued, so no callback will count it
+            s_cam_ctrl_task.timing_errors++;
+        }
+    }
+}
+
 // *****************************************************************************
 // End of file
@@ -35,6 +35,7 @@
 // Includes
 
 #include <stdbool.h>
+#include <stdint.h>
 
 // *****************************************************************************
 // C++ compatibility
@@ -46,6 +47,12 @@ extern "C" {
 // *****************************************************************************
 // Public types and definitions
 
+// Sensor lines per frame, including blanking.  The format table runs the
+// sensor in UXGA mode (COM7 = 0x04) and the DSP scales the 1200 active lines
+// down to the output size, so the frame timing is UXGA's whatever the image
+// size.  Pass this to cam_fps as frame_lines.
+#define CAM_CTRL_TASK_FRAME_LINES 1248
+
 // *****************************************************************************
 // Public declarations
 
@@ -82,6 +89,37 @@ bool cam_ctrl_task_probe_i2c(void);
  */
 bool cam_ctrl_task_setup_camera(void);
 
+/**
+ * @brief Switch the sensor to manual exposure / gain and apply the given
+ * settings.
+ *
+ * The first call blocks while AEC/AGC are switched off.  After that the
+ * register writes are queued on the I2C driver and this returns at once; if
+ * a previous write is still in progress only the most recent settings are
+ * kept and written when it finishes.  Call between captures (e.g. from the
+ * cam_data_task frame callback) so the writes do not overlap FIFO readout.
+ *
+ * @param exposure Exposure time in lines (16 bits, AEC[15:0]).
+ * @param gain Analog gain encoded as for the OV2640 GAIN register.
+ * @return true if the writes were queued.
+ */
+bool cam_ctrl_task_set_exposure(uint16_t exposure, uint8_t gain);
+
+/**
+ * @brief Set the sensor frame timing: the CLKRC clock divider and the number
+ * of dummy lines added to each frame (ADDVSL / ADDVSH).
+ *
+ * The writes are queued and coalesced as for cam_ctrl_task_set_exposure().
+ * A format load (cam_ctrl_task_setup_camera()) restores full clock.  Note
+ * that exposure is counted in lines, so dividing the clock lengthens the
+ * exposure by the same factor.
+ *
+ * @param clk_div Clock divider, 1 (full clock) to 64.
+ * @param dummy_lines Blank lines added to each frame.
+ * @return true if the writes were queued.
+ */
+bool cam_ctrl_task_set_frame_timing(uint8_t clk_div, uint16_t dummy_lines);
+
 bool cam_ctrl_task_succeeded(void);
 bool cam_ctrl_task_had_error(void);
 
@@ -31,6 +31,7 @@
 
 #include "definitions.h"
 #include "ov2640_spi.h"
+#include "yuv_convert.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -48,6 +49,11 @@
 
 #define MAX_CAPTURE_WAIT_COUNT 15000
 
+// Longest wait for the sensor metadata reads (cam_meta.h) after readout
+// before the frame is handed over without them.  The default batch takes
+// well under a millisecond at 400 kHz.
+#define META_TIMEOUT_TICS 2
+
 // MSB in byte 0 signifies a write operation
 #define ARDUCHIP_WRITE_OP 0x80
 
@@ -93,6 +99,7 @@ typedef enum {
     CAM_DATA_TASK_STATE_PROBE_SPI,
     CAM_DATA_TASK_STATE_RETRY_WAIT,
     CAM_DATA_TASK_STATE_AWAIT_CAPTURE,
+    CAM_DATA_TASK_STATE_AWAIT_META,
     CAM_DATA_TASK_STATE_START_CAPTURE,
     CAM_DATA_TASK_STATE_SUCCESS,
     CAM_DATA_TASK_STATE_ERROR,
@@ -110,6 +117,14 @@ typedef struct {
     uint32_t started_at;         // sys tics when capture started
     uint32_t timestamp_sys;      // for telemetry
     uint32_t frame_count;        // frame count
+    cam_frame_t frame;           // descriptor for get_buf
+    uint8_t *gray_buf;           // Y plane output in grayscale mode, or NULL
+    size_t gray_pixels;          // pixels in gray_buf
+    frame_stats_t *stats;        // per-frame statistics, or NULL
+    size_t stats_pixels;         // pixels measured for stats
+    bool trace;                  // print a per-frame trace
+    cam_data_task_frame_cb_t frame_cb; // called as each frame is read out
+    uintptr_t frame_cb_context;  // passed to frame_cb
 } cam_data_task_ctx_t;
 
 // *****************************************************************************
@@ -178,6 +193,10 @@ void cam_data_task_init(uint8_t *yuv_buf_a, uint8_t *yuv_buf_b, size_t buflen) {
     swap_buffers();  // prepare first buffer for writing
     s_cam_data_task.state = CAM_DATA_TASK_STATE_INIT;
     s_cam_data_task.frame_count = 0;
+    s_cam_data_task.frame_cb = NULL;
+    s_cam_data_task.gray_buf = NULL;
+    s_cam_data_task.stats = NULL;
+    s_cam_data_task.trace = true;
 }
 
 void cam_data_task_step(void) {
@@ -281,13 +300,58 @@ void cam_data_task_step(void) {
         }
 
         swap_buffers();
-        // simulate user processing of get_buf
-        dump_image(s_cam_data_task.get_buf, s_cam_data_task.buflen);
-
         uint32_t now_sys = SYS_TIME_CounterGet();
-        uint32_t tics = now_sys - s_cam_data_task.timestamp_sys;
-        s_cam_data_task.timestamp_sys = now_sys;
-        printf("tics: %ld, FPS: %f\n", tics, 1000000.0 / SYS_TIME_CountToUS(tics));
+        cam_frame_t *frame = &s_cam_data_task.frame;
+        frame->stats = s_cam_data_task.stats;
+        if (frame->stats != NULL) {
+            frame_stats_compute(s_cam_data_task.get_buf,
+                                s_cam_data_task.stats_pixels,
+                                s_cam_data_task.stats);
+        }
+        if (s_cam_data_task.gray_buf != NULL) {
+            yuv_convert_deinterleave(s_cam_data_task.get_buf,
+                                     s_cam_data_task.gray_buf, NULL, NULL,
+                                     s_cam_data_task.gray_pixels);
+            frame->buf = s_cam_data_task.gray_buf;
+            frame->buflen = s_cam_data_task.gray_pixels;
+            frame->format = CAM_FRAME_FORMAT_GRAY8;
+        } else {
+            frame->buf = s_cam_data_task.get_buf;
+            frame->buflen = s_cam_data_task.buflen;
+            frame->format = CAM_FRAME_FORMAT_YUYV;
+        }
+        frame->seq = s_cam_data_task.frame_count++;
+        frame->timestamp = now_sys;
+        // Sample the sensor registers for this frame before handing it to
+        // the user, so the reads are queued ahead of any control writes the
+        // frame callback makes.
+        cam_meta_window_open();
+        s_cam_data_task.state = CAM_DATA_TASK_STATE_AWAIT_META;
+        // FALL THROUGH to wait for the reads
+        // === v === fall through! === v ===
+    }
+
+    case CAM_DATA_TASK_STATE_AWAIT_META: {
+        cam_frame_t *frame = &s_cam_data_task.frame;
+        uint32_t dt = SYS_TIME_CounterGet() - frame->timestamp;
+        if (cam_meta_window_pending() && dt <= META_TIMEOUT_TICS) {
+            // yield to other tasks while the reads complete
+            break;
+        }
+        cam_meta_window_close(&frame->meta);
+        if (s_cam_data_task.frame_cb != NULL) {
+            // Camera is idle until the next capture starts: let the user
+            // process the frame and schedule any camera control writes.
+            s_cam_data_task.frame_cb(frame, s_cam_data_task.frame_cb_context);
+        }
+        uint32_t tics = frame->timestamp - s_cam_data_task.timestamp_sys;
+        s_cam_data_task.timestamp_sys = frame->timestamp;
+        if (s_cam_data_task.trace) {
+            // simulate user processing of get_buf
+            dump_image(s_cam_data_task.get_buf, s_cam_data_task.buflen);
+            printf("tics: %ld, FPS: %f\n", tics,
+                   1000000.0 / SYS_TIME_CountToUS(tics));
+        }
         LED0__Toggle();
         // FALL THROUGH to immediately start a new capture
         // === v === fall through! === v ===
@@ -309,8 +373,7 @@ void cam_data_task_step(void) {
             break;
         }
 
-        // Capture has started.  Set software watchdog and start polling for
-        // completion bit
+        // Set software watchdog and start polling for completion bit
         s_cam_data_task.started_at = SYS_TIME_CounterGet();
         s_cam_data_task.state = CAM_DATA_TASK_STATE_AWAIT_CAPTURE;
         break;
@@ -348,6 +411,25 @@ bool cam_data_task_start_capture(void) {
     return true;
 }
 
+void cam_data_task_set_frame_cb(cam_data_task_frame_cb_t cb, uintptr_t context) {
+    s_cam_data_task.frame_cb = cb;
+    s_cam_data_task.frame_cb_context = context;
+}
+
+void cam_data_task_set_gray_mode(uint8_t *gray_buf, size_t n_pixels) {
+    s_cam_data_task.gray_buf = gray_buf;
+    s_cam_data_task.gray_pixels = n_pixels;
+}
+
+void cam_data_task_set_stats(frame_stats_t *stats, size_t n_pixels) {
+    s_cam_data_task.stats = stats;
+    s_cam_data_task.stats_pixels = n_pixels;
+}
+
+void cam_data_task_set_trace(bool enable) {
+    s_cam_data_task.trace = enable;
+}
+
 bool cam_data_task_succeeded(void) {
     return s_cam_data_task.state == CAM_DATA_TASK_STATE_SUCCESS;
 }
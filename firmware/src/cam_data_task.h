@@ -34,6 +34,8 @@
 // *****************************************************************************
 // Includes
 
+#include "cam_meta.h"
+#include "frame_stats.h"
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -48,6 +50,41 @@ extern "C" {
 // *****************************************************************************
 // Public types and definitions
 
+/**
+ * @brief Pixel layout of a captured frame.
+ */
+typedef enum {
+    CAM_FRAME_FORMAT_YUYV,  // packed YUV422, as read from the camera
+    CAM_FRAME_FORMAT_GRAY8, // luma only (see cam_data_task_set_gray_mode())
+} cam_frame_format_t;
+
+/**
+ * @brief Descriptor for a captured frame.
+ */
+typedef struct {
+    uint8_t *buf;               // image data
+    size_t buflen;              // length of buf in bytes
+    cam_frame_format_t format;  // layout of buf
+    uint32_t seq;               // frame sequence number, starting at 0
+    uint32_t timestamp;         // SYS_TIME counter when readout completed
+    cam_meta_t meta;            // sensor registers sampled at readout
+    const frame_stats_t *stats; // image statistics, or NULL if not enabled
+} cam_frame_t;
+
+/**
+ * @brief Signature of the function called when a frame has been read out.
+ *
+ * The callback runs after the FIFO has been read and before the next capture
+ * is started, i.e. while the camera is idle.  This is the window in which to
+ * issue camera control writes without stalling readout.  Time spent in the
+ * callback delays the start of the next capture.
+ *
+ * The sensor registers (see cam_meta.h) are read between readout and the
+ * callback, so frame->meta reflects the settings the frame was captured
+ * with, not the control writes the callback issues.
+ */
+typedef void (*cam_data_task_frame_cb_t)(cam_frame_t *frame, uintptr_t context);
+
 // *****************************************************************************
 // Public declarations
 
@@ -91,6 +128,38 @@ bool cam_data_task_setup_camera(void);
  */
 bool cam_data_task_start_capture(void);
 
+/**
+ * @brief Register a function to be called as each frame is read out.  Pass
+ * NULL to remove a previously registered callback.
+ */
+void cam_data_task_set_frame_cb(cam_data_task_frame_cb_t cb, uintptr_t context);
+
+/**
+ * @brief Select grayscale-only capture.
+ *
+ * When gray_buf is non-NULL, the Y plane of each frame (n_pixels bytes) is
+ * extracted into gray_buf as soon as it has been read out, and the frame is
+ * delivered to the frame callback as CAM_FRAME_FORMAT_GRAY8.  Pass NULL to
+ * return to YUYV frames.
+ */
+void cam_data_task_set_gray_mode(uint8_t *gray_buf, size_t n_pixels);
+
+/**
+ * @brief Enable per-frame image statistics.
+ *
+ * When stats is non-NULL, the statistics of the first n_pixels pixels of
+ * each frame (see frame_stats.h) are computed into stats as soon as it has
+ * been read out, and the frame descriptor points to them.  Pass NULL to
+ * disable.
+ */
+void cam_data_task_set_stats(frame_stats_t *stats, size_t n_pixels);
+
+/**
+ * @brief Enable or disable the per-frame console trace (a sample of the
+ * image bytes and the frame rate).  Enabled by default.
+ */
+void cam_data_task_set_trace(bool enable);
+
 /**
  * @brief Following any async operation above, call cam_data_task_succeeded()
  * and cam_data_task_had_error() until either of them returns true.  Otherwise
@@ -0,0 +1,187 @@
+/**
+ * @file cam_fps.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_fps.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_FRAME_LINES 1248 // UXGA: 1200 active lines + 48 blanking
+#define DEFAULT_MAX_CLK_DIV CAM_FPS_CLK_DIV_MAX
+#define DEFAULT_AVERAGE_FRAMES 4
+#define DEFAULT_TOLERANCE_PCT 5
+#define DEFAULT_SETTLE_FRAMES 2 // the capture in flight uses the old timing
+
+// Scale factors are Q16: 65536 = 1.0
+#define SCALE_ONE 65536
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return period(timing) / base as Q16, per the model in cam_fps.h.
+ */
+static uint64_t timing_scale(const cam_fps_t *fps,
+                             const cam_fps_timing_t *timing);
+
+/**
+ * @brief Choose the timing whose modeled period is closest to the target.
+ */
+static void choose_timing(const cam_fps_t *fps, cam_fps_timing_t *timing);
+
+// *****************************************************************************
+// Public code
+
+void cam_fps_default_config(cam_fps_config_t *config) {
+    config->frame_lines = DEFAULT_FRAME_LINES;
+    config->max_clk_div = DEFAULT_MAX_CLK_DIV;
+    config->average_frames = DEFAULT_AVERAGE_FRAMES;
+    config->tolerance_pct = DEFAULT_TOLERANCE_PCT;
+    config->settle_frames = DEFAULT_SETTLE_FRAMES;
+}
+
+void cam_fps_init(cam_fps_t *fps, const cam_fps_config_t *config) {
+    memset(fps, 0, sizeof(cam_fps_t));
+    if (config == NULL) {
+        cam_fps_default_config(&fps->config);
+    } else {
+        fps->config = *config;
+    }
+    if (fps->config.average_frames == 0) {
+        fps->config.average_frames = 1;
+    }
+    fps->timing.clk_div = 1;
+    fps->timing.dummy_lines = 0;
+}
+
+void cam_fps_set_target_us(cam_fps_t *fps, uint32_t period_us) {
+    fps->target_us = period_us;
+    fps->locked = false;
+    // start a fresh measurement
+    fps->sum_us = 0;
+    fps->n_samples = 0;
+}
+
+bool cam_fps_update(cam_fps_t *fps, uint32_t interval_us) {
+    if (fps->holdoff > 0) {
+        // the sensor may not have applied the last change yet
+        fps->holdoff -= 1;
+        return false;
+    }
+    fps->sum_us += interval_us;
+    if (++fps->n_samples < fps->config.average_frames) {
+        return false;
+    }
+    fps->measured_us = fps->sum_us / fps->n_samples;
+    fps->sum_us = 0;
+    fps->n_samples = 0;
+
+    // Re-estimate the full-clock period from what the current timing
+    // actually achieved.  This folds readout and processing overhead into
+    // the model.
+    fps->base_us =
+        ((uint64_t)fps->measured_us * SCALE_ONE) / timing_scale(fps, &fps->timing);
+
+    if (fps->target_us != 0) {
+        uint32_t error = (fps->measured_us > fps->target_us)
+                             ? fps->measured_us - fps->target_us
+                             : fps->target_us - fps->measured_us;
+        fps->locked =
+            (uint64_t)error * 100 <= (uint64_t)fps->target_us * fps->config.tolerance_pct;
+        if (fps->locked) {
+            return false;
+        }
+    }
+
+    cam_fps_timing_t timing;
+    choose_timing(fps, &timing);
+    if (timing.clk_div == fps->timing.clk_div &&
+        timing.dummy_lines == fps->timing.dummy_lines) {
+        // already as close as the settings allow (e.g. target too fast)
+        return false;
+    }
+    fps->timing = timing;
+    fps->holdoff = fps->config.settle_frames;
+    fps->adjustments += 1;
+    return true;
+}
+
+const cam_fps_timing_t *cam_fps_timing(const cam_fps_t *fps) {
+    return &fps->timing;
+}
+
+bool cam_fps_is_locked(const cam_fps_t *fps) { return fps->locked; }
+
+// *****************************************************************************
+// Private (static) code
+
+static uint64_t timing_scale(const cam_fps_t *fps,
+                             const cam_fps_timing_t *timing) {
+    uint32_t lines = fps->config.frame_lines;
+    return ((uint64_t)timing->clk_div * (lines + timing->dummy_lines) *
+            SCALE_ONE) / lines;
+}
+
+static void choose_timing(const cam_fps_t *fps, cam_fps_timing_t *timing) {
+    timing->clk_div = 1;
+    timing->dummy_lines = 0;
+
+    if (fps->target_us == 0 || fps->base_us == 0) {
+        return;
+    }
+    uint64_t scale = ((uint64_t)fps->target_us * SCALE_ONE) / fps->base_us;
+    if (scale <= SCALE_ONE) {
+        // target is at or beyond what the sensor can do
+        return;
+    }
+
+    // Divide the clock as far as possible, then stretch the frame with dummy
+    // lines to make up the remaining (< 2x) factor.
+    uint64_t div = scale / SCALE_ONE;
+    if (div > fps->config.max_clk_div) {
+        div = fps->config.max_clk_div;
+    }
+    uint64_t remainder = scale / div; // Q16, >= 1.0
+    uint64_t dummy_lines =
+        ((remainder - SCALE_ONE) * fps->config.frame_lines + SCALE_ONE / 2) /
+        SCALE_ONE;
+    if (dummy_lines > CAM_FPS_DUMMY_LINES_MAX) {
+        dummy_lines = CAM_FPS_DUMMY_LINES_MAX;
+    }
+    timing->clk_div = div;
+    timing->dummy_lines = dummy_lines;
+}
+
+// *****************************************************************************
+// End of file
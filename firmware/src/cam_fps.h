@@ -0,0 +1,156 @@
+/**
+ * @file cam_fps.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Closed-loop frame rate control.
+ *
+ * The OV2640 frame period is set by its pixel clock and frame size:
+ *
+ *   period = base * div * (frame_lines + dummy_lines) / frame_lines
+ *
+ * where base is the period at full clock (CLKRC divider of 1) with no dummy
+ * lines, div is the CLKRC divider (1..64) and dummy_lines are blank lines
+ * added to each frame (ADDVSL / ADDVSH).  Slowing the clock saves sensor
+ * power and is preferred.  Dummy lines make up the rest.
+ *
+ * The measured interval between captured frames also includes readout and
+ * processing time, so the model is only a starting point.  Each measurement
+ * (averaged over average_frames frames) re-estimates base from the current
+ * settings, and new settings are chosen from the re-estimated base.  The loop
+ * stops adjusting once the measured period is within tolerance_pct of the
+ * target.
+ *
+ * Like cam_aec, cam_fps has no hardware dependencies: the caller feeds it
+ * frame intervals and applies the resulting timing (see
+ * cam_ctrl_task_set_frame_timing()).
+ */
+
+#ifndef _CAM_FPS_H_
+#define _CAM_FPS_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// CLKRC[5:0] holds the divider minus one
+#define CAM_FPS_CLK_DIV_MAX 64
+
+#define CAM_FPS_DUMMY_LINES_MAX 0xffff
+
+typedef struct {
+    uint16_t frame_lines;   // sensor lines per frame, including blanking
+    uint8_t max_clk_div;    // largest CLKRC divider to use
+    uint8_t average_frames; // frame intervals averaged per measurement
+    uint8_t tolerance_pct;  // no change while within this % of target
+    uint8_t settle_frames;  // frames ignored after a change
+} cam_fps_config_t;
+
+/**
+ * @brief Sensor frame timing.
+ */
+typedef struct {
+    uint8_t clk_div;      // CLKRC divider, 1..CAM_FPS_CLK_DIV_MAX
+    uint16_t dummy_lines; // blank lines added per frame
+} cam_fps_timing_t;
+
+typedef struct {
+    cam_fps_config_t config;
+    cam_fps_timing_t timing; // current timing
+    uint32_t target_us;      // target frame period, 0 = as fast as possible
+    uint32_t base_us;        // estimated period at full clock, no dummy lines
+    uint32_t measured_us;    // most recent measured frame period
+    uint32_t sum_us;         // accumulates frame intervals
+    uint8_t n_samples;       // number of intervals in sum_us
+    uint8_t holdoff;         // frames remaining before measuring resumes
+    bool locked;             // true when measured_us is within tolerance
+    uint32_t adjustments;    // number of timing changes (telemetry)
+} cam_fps_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in a config structure with defaults for the OV2640 UXGA mode
+ * (1248 lines per frame).  frame_lines counts the lines the sensor reads
+ * out, not the output image height: set it to match the sensor mode in use
+ * (see CAM_CTRL_TASK_FRAME_LINES).
+ */
+void cam_fps_default_config(cam_fps_config_t *config);
+
+/**
+ * @brief Initialize a frame rate controller.  Timing starts at full clock
+ * with no dummy lines, which matches the format tables.
+ *
+ * @param config Configuration to use, or NULL for defaults.
+ */
+void cam_fps_init(cam_fps_t *fps, const cam_fps_config_t *config);
+
+/**
+ * @brief Request a target frame period in microseconds, or 0 to run as fast
+ * as the sensor allows.  Takes effect at the next measurement.
+ */
+void cam_fps_set_target_us(cam_fps_t *fps, uint32_t period_us);
+
+/**
+ * @brief Feed the interval between two consecutive frames.  Call once per
+ * frame.
+ *
+ * @return true if the timing changed and must be written to the sensor.
+ */
+bool cam_fps_update(cam_fps_t *fps, uint32_t interval_us);
+
+/**
+ * @brief Return the current sensor timing.
+ */
+const cam_fps_timing_t *cam_fps_timing(const cam_fps_t *fps);
+
+/**
+ * @brief Return true if the measured frame period is within tolerance of
+ * the target.
+ */
+bool cam_fps_is_locked(const cam_fps_t *fps);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _CAM_FPS_H_ */
@@ -0,0 +1,250 @@
+/**
+ * @file cam_meta.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_meta.h"
+
+#include "definitions.h"
+#include "ov2640_i2c.h"
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+typedef struct {
+    cam_meta_reg_t regs[CAM_META_MAX_REGS]; // registers to sample
+    uint8_t n_regs;                         // number of entries in regs
+    uint8_t raw[CAM_META_MAX_REGS];         // written as each read completes
+    volatile uint8_t outstanding;           // transfers queued, not complete
+    volatile bool failed;                   // a transfer in the batch failed
+    volatile uint32_t completed_at;         // sys tics when batch completed
+    uint32_t opened_at;                     // sys tics when window opened
+    bool window_open;                       // between open and close
+    cam_meta_stats_t stats;                 // telemetry
+} cam_meta_ctx_t;
+
+// *****************************************************************************
+// Private (static) storage
+
+/**
+ * @brief Singleton cam_meta context.
+ */
+static cam_meta_ctx_t s_cam_meta;
+
+static const cam_meta_reg_t s_default_regs[] = {
+    {OV2640_I2C_SENSOR_BANK, OV2640_I2C_GAIN},
+    {OV2640_I2C_SENSOR_BANK, OV2640_I2C_AEC},
+    {OV2640_I2C_SENSOR_BANK, OV2640_I2C_REG04},
+    {OV2640_I2C_SENSOR_BANK, OV2640_I2C_REG45},
+    {OV2640_I2C_SENSOR_BANK, OV2640_I2C_YAVG},
+};
+
+// Bank select writes, indexed by ov2640_i2c_bank_t
+static const ov2640_i2c_pair_t s_bank_select[] = {
+    [OV2640_I2C_DSP_BANK] = {0xff, 0x00},
+    [OV2640_I2C_SENSOR_BANK] = {0xff, 0x01},
+};
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the number of transfers needed to read the given registers,
+ * counting a bank switch before each group of registers.
+ */
+static size_t count_transfers(const cam_meta_reg_t *regs, size_t count);
+
+/**
+ * @brief Queue the reads for the current register list.  Call with
+ * interrupts disabled.  Returns the number of transfers queued.
+ */
+static size_t queue_reads(void);
+
+/**
+ * @brief ov2640_i2c completion callback for each transfer in a batch.  Runs
+ * in interrupt context.
+ */
+static void transfer_cb(bool success, uintptr_t context);
+
+// *****************************************************************************
+// Public code
+
+void cam_meta_init(void) {
+    memset(&s_cam_meta, 0, sizeof(s_cam_meta));
+    cam_meta_set_registers(s_default_regs,
+                           sizeof(s_default_regs) / sizeof(s_default_regs[0]));
+}
+
+bool cam_meta_set_registers(const cam_meta_reg_t *regs, size_t count) {
+    if (count > CAM_META_MAX_REGS ||
+        count_transfers(regs, count) > CAM_META_MAX_TRANSFERS) {
+        return false;
+    }
+    if (s_cam_meta.window_open || s_cam_meta.outstanding != 0) {
+        // don't pull the register addresses out from under queued reads
+        return false;
+    }
+    memcpy(s_cam_meta.regs, regs, count * sizeof(cam_meta_reg_t));
+    s_cam_meta.n_regs = count;
+    return true;
+}
+
+bool cam_meta_window_open(void) {
+    if (s_cam_meta.n_regs == 0 || s_cam_meta.window_open) {
+        return false;
+    }
+    if (s_cam_meta.outstanding != 0) {
+        // Reads from an earlier window are still in flight (already counted
+        // as an overrun).  Skip this window rather than pile up more.
+        return false;
+    }
+
+    s_cam_meta.failed = false;
+    s_cam_meta.opened_at = SYS_TIME_CounterGet();
+    s_cam_meta.completed_at = s_cam_meta.opened_at;
+
+    // Queue the whole batch with interrupts disabled so the count of
+    // outstanding transfers can't reach zero before the last one is queued.
+    bool int_state = SYS_INT_Disable();
+    size_t queued = queue_reads();
+    SYS_INT_Restore(int_state);
+
+    if (queued == 0) {
+        s_cam_meta.stats.errors += 1;
+        return false;
+    }
+    s_cam_meta.window_open = true;
+    s_cam_meta.stats.batches += 1;
+    return true;
+}
+
+bool cam_meta_window_pending(void) {
+    return s_cam_meta.window_open && s_cam_meta.outstanding != 0;
+}
+
+bool cam_meta_window_close(cam_meta_t *meta) {
+    meta->valid = false;
+    meta->count = 0;
+    meta->read_us = 0;
+
+    if (!s_cam_meta.window_open) {
+        return false;
+    }
+    s_cam_meta.window_open = false;
+
+    if (s_cam_meta.outstanding != 0) {
+        s_cam_meta.stats.overruns += 1;
+        return false;
+    }
+    if (s_cam_meta.failed) {
+        s_cam_meta.stats.errors += 1;
+        return false;
+    }
+
+    meta->count = s_cam_meta.n_regs;
+    memcpy(meta->values, s_cam_meta.raw, s_cam_meta.n_regs);
+    meta->read_us =
+        SYS_TIME_CountToUS(s_cam_meta.completed_at - s_cam_meta.opened_at);
+    if (meta->read_us > s_cam_meta.stats.max_us) {
+        s_cam_meta.stats.max_us = meta->read_us;
+    }
+    meta->valid = true;
+    return true;
+}
+
+bool cam_meta_lookup(const cam_meta_t *meta, ov2640_i2c_bank_t bank,
+                     uint8_t addr, uint8_t *value) {
+    if (!meta->valid) {
+        return false;
+    }
+    for (int i = 0; i < meta->count && i < s_cam_meta.n_regs; i++) {
+        if (s_cam_meta.regs[i].bank == bank && s_cam_meta.regs[i].addr == addr) {
+            *value = meta->values[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void cam_meta_get_stats(cam_meta_stats_t *stats) {
+    *stats = s_cam_meta.stats;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t count_transfers(const cam_meta_reg_t *regs, size_t count) {
+    size_t transfers = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i == 0 || regs[i].bank != regs[i - 1].bank) {
+            transfers += 1; // bank switch
+        }
+        transfers += 1;
+    }
+    return transfers;
+}
+
+static size_t queue_reads(void) {
+    size_t queued = 0;
+
+    for (int i = 0; i < s_cam_meta.n_regs; i++) {
+        const cam_meta_reg_t *reg = &s_cam_meta.regs[i];
+        // The bank in effect isn't known at the start of a batch, so always
+        // select it for the first group.
+        if (i == 0 || reg->bank != s_cam_meta.regs[i - 1].bank) {
+            if (!ov2640_i2c_write_pairs_async(&s_bank_select[reg->bank], 1,
+                                              transfer_cb, 0)) {
+                s_cam_meta.failed = true;
+                break;
+            }
+            s_cam_meta.outstanding += 1;
+            queued += 1;
+        }
+        if (!ov2640_i2c_read_byte_async(&reg->addr, &s_cam_meta.raw[i],
+                                        transfer_cb, 0)) {
+            s_cam_meta.failed = true;
+            break;
+        }
+        s_cam_meta.outstanding += 1;
+        queued += 1;
+    }
+    return queued;
+}
+
+static void transfer_cb(bool success, uintptr_t context) {
+    (void)context;
+    if (!success) {
+        s_cam_meta.failed = true;
+    }
+    if (--s_cam_meta.outstanding == 0) {
+        s_cam_meta.completed_at = SYS_TIME_CounterGet();
+    }
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,167 @@
+/**
+ * @file cam_meta.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Per-frame sensor metadata, read from the OV2640 between frames.
+ *
+ * When a frame has been read out, cam_data_task opens a window by calling
+ * cam_meta_window_open(), which queues I2C reads of a configurable list of
+ * sensor registers (gain, exposure, average luma...) as one batch of
+ * asynchronous transfers, and returns at once.  The camera is idle until the
+ * next capture starts, so cam_data_task yields to the other tasks while the
+ * reads complete (cam_meta_window_pending()), then closes the window with
+ * cam_meta_window_close() and attaches the values to the frame's descriptor
+ * (cam_frame_t.meta) before handing it to the frame callback.
+ *
+ * The wait is bounded: if the reads haven't all completed when cam_data_task
+ * gives up on them, the window is closed anyway, the metadata is marked
+ * invalid and the overrun is counted in cam_meta_stats_t.overruns.
+ *
+ * The reads are queued before the frame callback runs, ahead of any control
+ * writes it makes, so the values describe the settings the frame was
+ * captured with.
+ */
+
+#ifndef _CAM_META_H_
+#define _CAM_META_H_
+
+// *****************************************************************************
+// Includes
+
+#include "ov2640_i2c.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// Maximum number of registers sampled per frame
+#define CAM_META_MAX_REGS 6
+
+// Maximum number of I2C transfers (register reads plus bank switches) queued
+// per frame.  Leaves room in the driver queue for control writes.
+#define CAM_META_MAX_TRANSFERS (DRV_I2C_QUEUE_SIZE_IDX0 - 2)
+
+/**
+ * @brief A register to sample.
+ */
+typedef struct {
+    ov2640_i2c_bank_t bank; // register bank
+    uint8_t addr;           // register address within bank
+} cam_meta_reg_t;
+
+/**
+ * @brief Sampled register values for one frame.
+ */
+typedef struct {
+    bool valid;                        // true if all reads completed in time
+    uint8_t count;                     // number of entries in values
+    uint8_t values[CAM_META_MAX_REGS]; // in the order of the register list
+    uint32_t read_us;                  // time taken by the batch of reads
+} cam_meta_t;
+
+/**
+ * @brief Sampler telemetry.
+ */
+typedef struct {
+    uint32_t batches;  // number of windows opened with reads queued
+    uint32_t overruns; // windows closed with reads still outstanding
+    uint32_t errors;   // reads that failed or could not be queued
+    uint32_t max_us;   // longest batch completion time
+} cam_meta_stats_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief One-time initialization.  Selects the default register list:
+ * GAIN, AEC, REG04, REG45 (exposure) and YAVG (average luma).
+ */
+void cam_meta_init(void);
+
+/**
+ * @brief Replace the list of registers sampled each frame.  Takes effect at
+ * the next window.  Pass count = 0 to disable sampling.
+ *
+ * Returns false (and leaves the list unchanged) if the list has more than
+ * CAM_META_MAX_REGS entries or would need more than CAM_META_MAX_TRANSFERS
+ * transfers.  Group registers by bank to minimize bank switches.
+ */
+bool cam_meta_set_registers(const cam_meta_reg_t *regs, size_t count);
+
+/**
+ * @brief Queue the reads for the current register list.  Returns at once.
+ *
+ * Returns false if no reads were queued: sampling is disabled, the previous
+ * batch is still outstanding, or the driver queue is full.
+ */
+bool cam_meta_window_open(void);
+
+/**
+ * @brief Return true while a window is open and any of its reads are still
+ * outstanding.
+ */
+bool cam_meta_window_pending(void);
+
+/**
+ * @brief Close the window opened by cam_meta_window_open() and copy the
+ * results into meta.
+ *
+ * Returns meta->valid: true if every read completed successfully before the
+ * window closed.  If no window is open, meta is marked invalid.
+ */
+bool cam_meta_window_close(cam_meta_t *meta);
+
+/**
+ * @brief Look up the value of a register in sampled metadata.
+ *
+ * Returns false if meta is invalid or the register isn't in the current
+ * register list.
+ */
+bool cam_meta_lookup(const cam_meta_t *meta, ov2640_i2c_bank_t bank,
+                     uint8_t addr, uint8_t *value);
+
+/**
+ * @brief Return sampler telemetry.
+ */
+void cam_meta_get_stats(cam_meta_stats_t *stats);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _CAM_META_H_ */
@@ -899,6 +899,60 @@ void DRV_I2C_WriteReadTransferAdd (
     DRV_I2C_TRANSFER_HANDLE * const transferHandle
 );
 
+// *****************************************************************************
+/* Function:
+    void DRV_I2C_WritePairsTransferAdd(
+        const DRV_HANDLE handle,
+        const uint16_t address,
+        void * const pairs,
+        const size_t count,
+        DRV_I2C_TRANSFER_HANDLE * const transferHandle
+    )
+
+  Summary:
+    Queues a write of a list of register/value pairs.
+
+  Description:
+    This is the non-blocking counterpart of DRV_I2C_WritePairsTransfer.  The
+    count {register, value} byte pairs are written as one queued transfer, each
+    pair as its own START, address, register, value, STOP sequence.  The
+    client's event handler is called once, when the last pair has been written
+    or on the first error.
+
+  Precondition:
+    DRV_I2C_Open must have been called to obtain a valid opened device handle.
+
+  Parameters:
+    handle - Handle of the communication channel as returned by the
+    DRV_I2C_Open function.
+
+    address - 7-bit Slave Address
+
+    pairs - Source buffer of 2 * count bytes. Must remain valid until the
+    transfer completes.
+
+    count - Number of register/value pairs to be written.
+
+    transferHandle - Pointer to an argument that will contain the return
+    transfer handle. This will be DRV_I2C_TRANSFER_HANDLE_INVALID if the
+    request was not queued.
+
+  Returns:
+    None.
+
+  Remarks:
+    This function can be called from within the I2C Driver Transfer Event
+    Handler that is registered by the client.
+*/
+
+void DRV_I2C_WritePairsTransferAdd(
+    const DRV_HANDLE handle,
+    const uint16_t address,
+    void * const pairs,
+    const size_t count,
+    DRV_I2C_TRANSFER_HANDLE * const transferHandle
+);
+
 // *****************************************************************************
 /* Function:
     void DRV_I2C_TransferEventHandlerSet
@@ -1057,6 +1111,13 @@ DRV_I2C_TRANSFER_EVENT DRV_I2C_TransferStatusGet( const DRV_I2C_TRANSFER_HANDLE
 // *****************************************************************************
 // *****************************************************************************
 
+/* A blocking transfer takes a slot in the transfer queue, behind the
+   transfers already queued, and the caller then waits for that transfer
+   alone.  Transfers queued meanwhile, including from event handlers, go
+   behind it, so the wait is bounded by the queue ahead of it.  The blocking
+   functions also fail when the queue is full.
+*/
+
 // *****************************************************************************
 /* Function:
     bool DRV_I2C_WriteTransfer(
@@ -1075,6 +1136,7 @@ DRV_I2C_TRANSFER_EVENT DRV_I2C_TransferStatusGet( const DRV_I2C_TRANSFER_HANDLE
     return false to report failure. The failure will occur for the following
     reasons:
     - Invalid input parameters
+    - Transfer queue full
 
   Precondition:
     DRV_I2C_Open must have been called to obtain a valid opened device handle.
@@ -1143,6 +1205,7 @@ bool DRV_I2C_WriteTransfer(
     return false to report failure. The failure will occur for the following
     reasons:
     - Invalid input parameters
+    - Transfer queue full
 
   Precondition:
     DRV_I2C_Open must have been called to obtain a valid opened device handle.
@@ -1207,6 +1270,7 @@ bool DRV_I2C_ForcedWriteTransfer(
     return false to report failure. The failure will occur for the following
     reasons:
     - Invalid input parameters
+    - Transfer queue full
     - Hardware error
 
     Precondition:
@@ -1270,6 +1334,7 @@ bool DRV_I2C_ReadTransfer(
     return false to report failure. The failure will occur for the following
     reasons:
     - Invalid input parameters
+    - Transfer queue full
     - Hardware error
 
   Precondition:
@@ -1320,6 +1385,54 @@ bool DRV_I2C_WriteReadTransfer (
     const size_t readSize
 );
 
+// *****************************************************************************
+/* Function:
+    bool DRV_I2C_WritePairsTransfer(
+        const DRV_HANDLE handle,
+        uint16_t address,
+        void* const pairs,
+        const size_t count
+    )
+
+  Summary:
+    This is a blocking function that writes a list of register/value pairs.
+
+  Description:
+    This function writes count {register, value} byte pairs to the slave, each
+    as its own START, address, register, value, STOP sequence, as expected by
+    SCCB style camera sensors.  The whole list is handed to the PLIB as one
+    transfer: the PLIB chains the pairs from its interrupt handler, so the
+    calling thread blocks once for the list rather than once per register.
+
+  Precondition:
+    DRV_I2C_Open must have been called to obtain a valid opened device handle.
+
+  Parameters:
+    handle - A valid open-instance handle, returned from the driver's open routine
+    DRV_I2C_Open function.
+
+    address - 7-bit Slave Address
+
+    pairs - Source buffer of 2 * count bytes: register, value, register, ...
+
+    count - Number of register/value pairs to be written.
+
+  Returns:
+    true - all pairs were written
+    false - error has occurred
+
+  Remarks:
+    This function should not be called from an interrupt context.
+    This function is available only in the synchronous mode.
+*/
+
+bool DRV_I2C_WritePairsTransfer(
+    const DRV_HANDLE handle,
+    uint16_t address,
+    void* const pairs,
+    const size_t count
+);
+
 // *****************************************************************************
 /* Function:
     void DRV_I2C_QueuePurge(const DRV_HANDLE handle)
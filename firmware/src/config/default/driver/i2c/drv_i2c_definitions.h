@@ -127,6 +127,8 @@ typedef bool (* DRV_I2C_PLIB_WRITE)( uint16_t address, uint8_t *pdata, uint32_t
 
 typedef bool (* DRV_I2C_PLIB_WRITE_READ)( uint16_t address, uint8_t *wdata, uint32_t wlength, uint8_t *rdata, uint32_t rlength );
 
+typedef bool (* DRV_I2C_PLIB_WRITE_PAIRS)( uint16_t address, uint8_t *pairs, uint32_t count );
+
 typedef void (* DRV_I2C_PLIB_TRANSFER_ABORT) (void);
 
 typedef DRV_I2C_ERROR (* DRV_I2C_PLIB_ERROR_GET)( void );
@@ -182,7 +184,10 @@ typedef struct
 
     /* I2C PLib writeRead API */
     DRV_I2C_PLIB_WRITE_READ                     writeRead;
-    
+
+    /* I2C PLib register pairs write API */
+    DRV_I2C_PLIB_WRITE_PAIRS                    writePairs;
+
     /* I2C PLib transfer Abort API */
     DRV_I2C_PLIB_TRANSFER_ABORT                 transferAbort;
 
@@ -225,6 +230,12 @@ typedef struct
     /* Number of clients */
     uint32_t                                numClients;
 
+    /* Memory Pool for Transfer Objects (DRV_I2C_TRANSFER_OBJ) */
+    uintptr_t                               transferObjPool;
+
+    /* Number of transfer objects, i.e. the depth of the transfer queue */
+    uint32_t                                transferObjPoolSize;
+
     /* peripheral clock speed */
     uint32_t                                clockSpeed;
 
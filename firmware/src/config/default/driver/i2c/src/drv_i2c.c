@@ -48,6 +48,7 @@
 #include "configuration.h"
 #include "driver/i2c/drv_i2c.h"
 #include "system/debug/sys_debug.h"
+#include "system/int/sys_int.h"
 
 // *****************************************************************************
 // *****************************************************************************
@@ -113,27 +114,311 @@ static DRV_I2C_CLIENT_OBJ* lDRV_I2C_DriverHandleValidate(DRV_HANDLE handle)
     return(client);
 }
 
-static void lDRV_I2C_PLibCallbackHandler( uintptr_t contextHandle )
+static bool lDRV_I2C_PLibTransferStart(
+    DRV_I2C_OBJ* dObj,
+    DRV_I2C_CLIENT_OBJ* clientObj,
+    uint16_t address,
+    void* const writeBuffer,
+    const size_t writeSize,
+    void* const readBuffer,
+    const size_t readSize,
+    DRV_I2C_TRANSFER_OBJ_FLAGS transferFlags
+)
 {
-    DRV_I2C_OBJ* dObj = (DRV_I2C_OBJ *)contextHandle;
-    DRV_I2C_CLIENT_OBJ* clientObj = (DRV_I2C_CLIENT_OBJ*)NULL;
+    bool isReqAccepted = false;
 
-    clientObj = (DRV_I2C_CLIENT_OBJ*)dObj->activeClient;
+    /* Errors if any, will be saved in the activeClient in the driver callback */
+    dObj->activeClient = (uintptr_t)clientObj;
 
-    /* Update error into the client object*/
-    clientObj->errors = dObj->i2cPlib->errorGet();
+    /* Check if the transfer setup for this client is different than the current transfer setup */
+    if (dObj->currentTransferSetup.clockSpeed != clientObj->transferSetup.clockSpeed)
+    {
+        /* Set the new transfer setup */
+        (void) dObj->i2cPlib->transferSetup(&clientObj->transferSetup, 0);
+
+        dObj->currentTransferSetup.clockSpeed = clientObj->transferSetup.clockSpeed;
+    }
 
-    if(clientObj->errors == DRV_I2C_ERROR_NONE)
+    switch(transferFlags)
     {
-        dObj->transferStatus = DRV_I2C_TRANSFER_STATUS_COMPLETE;
+        case DRV_I2C_TRANSFER_OBJ_FLAG_RD:
+            if (dObj->i2cPlib->read_t(address, readBuffer, readSize) == true)
+            {
+                isReqAccepted = true;
+            }
+            break;
+
+        case DRV_I2C_TRANSFER_OBJ_FLAG_WR:
+            if (dObj->i2cPlib->write_t(address, writeBuffer, writeSize) == true)
+            {
+                isReqAccepted = true;
+            }
+            break;
+
+
+        case DRV_I2C_TRANSFER_OBJ_FLAG_WR_RD:
+            if (dObj->i2cPlib->writeRead(address, writeBuffer, writeSize, readBuffer, readSize) == true)
+            {
+                isReqAccepted = true;
+            }
+            break;
+
+        case DRV_I2C_TRANSFER_OBJ_FLAG_WR_PAIRS:
+            if (dObj->i2cPlib->writePairs(address, writeBuffer, writeSize) == true)
+            {
+                isReqAccepted = true;
+            }
+            break;
+
+        default:
+                 /* Nothing to do */
+            break;
+    }
+
+    return isReqAccepted;
+}
+
+static void lDRV_I2C_AsyncTransferRetire( DRV_I2C_OBJ* dObj, DRV_I2C_TRANSFER_OBJ* transferObj, DRV_I2C_TRANSFER_EVENT event )
+{
+    DRV_I2C_CLIENT_OBJ* clientObj = (DRV_I2C_CLIENT_OBJ*)transferObj->clientObj;
+    DRV_I2C_TRANSFER_HANDLE transferHandle = transferObj->transferHandle;
+
+    /* Remove the transfer from the head of the queue */
+    dObj->queueHead = transferObj->next;
+    if (dObj->queueHead == NULL)
+    {
+        dObj->queueTail = NULL;
+    }
+
+    transferObj->event = event;
+
+    /* A blocking caller is polling event and frees the object itself */
+    if (transferObj->isSync == true)
+    {
+        return;
+    }
+
+    /* Release the object before notifying the client so that the event
+     * handler can queue a follow-up transfer */
+    transferObj->inUse = false;
+
+    if (clientObj->eventHandler != NULL)
+    {
+        clientObj->eventHandler(event, transferHandle, clientObj->context);
+    }
+}
+
+/* Must be called with interrupts disabled or from the PLIB interrupt */
+static void lDRV_I2C_AsyncTransferStart( DRV_I2C_OBJ* dObj )
+{
+    DRV_I2C_TRANSFER_OBJ* transferObj;
+    DRV_I2C_CLIENT_OBJ* clientObj;
+
+    /* Start queued transfers until one is accepted by the PLIB */
+    while ((dObj->asyncActive == false) && (dObj->queueHead != NULL))
+    {
+        transferObj = dObj->queueHead;
+        clientObj = (DRV_I2C_CLIENT_OBJ*)transferObj->clientObj;
+        clientObj->errors = DRV_I2C_ERROR_NONE;
+
+        /* Set before starting: the PLIB may complete the transfer at once */
+        dObj->asyncActive = true;
+
+        if (lDRV_I2C_PLibTransferStart(dObj, clientObj, transferObj->address,
+                transferObj->writeBuffer, transferObj->writeSize,
+                transferObj->readBuffer, transferObj->readSize,
+                transferObj->flag) == false)
+        {
+            dObj->asyncActive = false;
+            clientObj->errors = dObj->i2cPlib->errorGet();
+            lDRV_I2C_AsyncTransferRetire(dObj, transferObj, DRV_I2C_TRANSFER_EVENT_ERROR);
+        }
+    }
+}
+
+static void lDRV_I2C_QueuePurgeClient( DRV_I2C_OBJ* dObj, DRV_I2C_CLIENT_OBJ* clientObj )
+{
+    DRV_I2C_TRANSFER_OBJ* prev = NULL;
+    DRV_I2C_TRANSFER_OBJ* transferObj;
+    DRV_I2C_TRANSFER_OBJ* next;
+    bool interruptState = SYS_INT_Disable();
+
+    transferObj = dObj->queueHead;
+
+    while (transferObj != NULL)
+    {
+        next = transferObj->next;
+
+        /* The transfer in progress cannot be recalled, nor can one that a
+         * blocking call is waiting for */
+        if ((transferObj->clientObj == (uintptr_t)clientObj) &&
+            (transferObj->isSync == false) &&
+            ((transferObj != dObj->queueHead) || (dObj->asyncActive == false)))
+        {
+            if (prev == NULL)
+            {
+                dObj->queueHead = next;
+            }
+            else
+            {
+                prev->next = next;
+            }
+            if (dObj->queueTail == transferObj)
+            {
+                dObj->queueTail = prev;
+            }
+            transferObj->event = DRV_I2C_TRANSFER_EVENT_HANDLE_EXPIRED;
+            transferObj->inUse = false;
+        }
+        else
+        {
+            prev = transferObj;
+        }
+
+        transferObj = next;
+    }
+
+    SYS_INT_Restore(interruptState);
+}
+
+/* Must be called with interrupts disabled. Returns NULL if the queue is full. */
+static DRV_I2C_TRANSFER_OBJ* lDRV_I2C_TransferQueue(
+    DRV_I2C_OBJ* dObj,
+    DRV_I2C_CLIENT_OBJ* clientObj,
+    uint16_t address,
+    void* const writeBuffer,
+    const size_t writeSize,
+    void* const readBuffer,
+    const size_t readSize,
+    DRV_I2C_TRANSFER_OBJ_FLAGS transferFlags,
+    bool isSync,
+    DRV_I2C_TRANSFER_HANDLE* const transferHandle
+)
+{
+    DRV_I2C_TRANSFER_OBJ* transferObj = (DRV_I2C_TRANSFER_OBJ*)NULL;
+    size_t iEntry;
+
+    /* Allocate a transfer object */
+    for (iEntry = 0U; iEntry < dObj->transferObjPoolSize; iEntry++)
+    {
+        if (dObj->transferObjPool[iEntry].inUse == false)
+        {
+            transferObj = &dObj->transferObjPool[iEntry];
+            break;
+        }
+    }
+
+    if (transferObj == NULL)
+    {
+        /* Queue is full */
+        return NULL;
+    }
+
+    transferObj->inUse          = true;
+    transferObj->isSync         = isSync;
+    transferObj->address        = address;
+    transferObj->writeBuffer    = writeBuffer;
+    transferObj->writeSize      = writeSize;
+    transferObj->readBuffer     = readBuffer;
+    transferObj->readSize       = readSize;
+    transferObj->flag           = transferFlags;
+    transferObj->event          = DRV_I2C_TRANSFER_EVENT_PENDING;
+    transferObj->clientObj      = (uintptr_t)clientObj;
+    transferObj->next           = NULL;
+    transferObj->transferHandle = lDRV_I2C_MAKE_HANDLE(dObj->transferTokenCount,
+                                    (uint8_t)(dObj - gDrvI2CObj), (uint8_t)iEntry);
+    dObj->transferTokenCount = lDRV_I2C_UPDATE_TOKEN(dObj->transferTokenCount);
+
+    if (transferHandle != NULL)
+    {
+        *transferHandle = transferObj->transferHandle;
+    }
+
+    /* Append to the queue */
+    if (dObj->queueTail == NULL)
+    {
+        dObj->queueHead = transferObj;
     }
     else
     {
-        dObj->transferStatus = DRV_I2C_TRANSFER_STATUS_ERROR;
+        dObj->queueTail->next = transferObj;
     }
+    dObj->queueTail = transferObj;
+
+    /* Start it now if the bus is idle, otherwise the PLIB callback will */
+    lDRV_I2C_AsyncTransferStart(dObj);
 
-    /* Unblock the application thread */
-    (void) OSAL_SEM_PostISR( &dObj->transferDone);
+    return transferObj;
+}
+
+static void lDRV_I2C_TransferAdd(
+    const DRV_HANDLE handle,
+    uint16_t address,
+    void* const writeBuffer,
+    const size_t writeSize,
+    void* const readBuffer,
+    const size_t readSize,
+    DRV_I2C_TRANSFER_OBJ_FLAGS transferFlags,
+    DRV_I2C_TRANSFER_HANDLE* const transferHandle
+)
+{
+    DRV_I2C_CLIENT_OBJ* clientObj = (DRV_I2C_CLIENT_OBJ *)NULL;
+    DRV_I2C_OBJ* dObj = (DRV_I2C_OBJ*)NULL;
+    bool interruptState;
+
+    if (transferHandle == NULL)
+    {
+        return;
+    }
+
+    *transferHandle = DRV_I2C_TRANSFER_HANDLE_INVALID;
+
+    /* Validate the driver handle */
+    clientObj = lDRV_I2C_DriverHandleValidate(handle);
+
+    if (clientObj == NULL)
+    {
+        return;
+    }
+
+    if ((transferFlags == DRV_I2C_TRANSFER_OBJ_FLAG_RD) || (transferFlags == DRV_I2C_TRANSFER_OBJ_FLAG_WR_RD))
+    {
+        if((readSize == 0U) || (readBuffer == NULL))
+        {
+            return;
+        }
+    }
+    if (transferFlags != DRV_I2C_TRANSFER_OBJ_FLAG_RD)
+    {
+        if((writeSize == 0U) || (writeBuffer == NULL))
+        {
+            return;
+        }
+    }
+
+    dObj = clientObj->hDriver;
+
+    interruptState = SYS_INT_Disable();
+    (void) lDRV_I2C_TransferQueue(dObj, clientObj, address, writeBuffer, writeSize,
+        readBuffer, readSize, transferFlags, false, transferHandle);
+    SYS_INT_Restore(interruptState);
+}
+
+static void lDRV_I2C_PLibCallbackHandler( uintptr_t contextHandle )
+{
+    DRV_I2C_OBJ* dObj = (DRV_I2C_OBJ *)contextHandle;
+    DRV_I2C_CLIENT_OBJ* clientObj = (DRV_I2C_CLIENT_OBJ*)NULL;
+
+    clientObj = (DRV_I2C_CLIENT_OBJ*)dObj->activeClient;
+
+    /* Update error into the client object*/
+    clientObj->errors = dObj->i2cPlib->errorGet();
+
+    /* Retire the transfer and start the next one */
+    dObj->asyncActive = false;
+    lDRV_I2C_AsyncTransferRetire(dObj, dObj->queueHead,
+        (clientObj->errors == DRV_I2C_ERROR_NONE) ? DRV_I2C_TRANSFER_EVENT_COMPLETE : DRV_I2C_TRANSFER_EVENT_ERROR);
+    lDRV_I2C_AsyncTransferStart(dObj);
 }
 /* MISRA C-2012 Rule 11.3, 11.8 deviated below.
    Deviation record ID -  H3_MISRAC_2012_R_11_3_DR_1 & H3_MISRAC_2012_R_11_8_DR_1*/
@@ -144,6 +429,7 @@ SYS_MODULE_OBJ DRV_I2C_Initialize( const SYS_MODULE_INDEX drvIndex, const SYS_MO
 
 
      DRV_I2C_INIT* i2cInit = (DRV_I2C_INIT*)init;
+     size_t iEntry;
 
 
     /* Validate the request */
@@ -173,26 +459,25 @@ SYS_MODULE_OBJ DRV_I2C_Initialize( const SYS_MODULE_INDEX drvIndex, const SYS_MO
     dObj->isExclusive                       = false;
     dObj->initI2CClockSpeed                 = i2cInit->clockSpeed;
     dObj->currentTransferSetup.clockSpeed   = i2cInit->clockSpeed;
-
-    if (OSAL_MUTEX_Create(&dObj->clientMutex) == OSAL_RESULT_FAIL)
+    dObj->transferObjPool                   = (DRV_I2C_TRANSFER_OBJ*)i2cInit->transferObjPool;
+    dObj->transferObjPoolSize               = i2cInit->transferObjPoolSize;
+    dObj->queueHead                         = NULL;
+    dObj->queueTail                         = NULL;
+    dObj->asyncActive                       = false;
+    dObj->transferTokenCount                = 1;
+
+    for (iEntry = 0U; iEntry < dObj->transferObjPoolSize; iEntry++)
     {
-        /*  If the mutex was not created because the memory required to
-            hold the mutex could not be allocated then NULL is returned. */
-        return SYS_MODULE_OBJ_INVALID;
+        dObj->transferObjPool[iEntry].inUse = false;
     }
 
-    if (OSAL_MUTEX_Create(&dObj->transferMutex) == OSAL_RESULT_FAIL)
+    if (OSAL_MUTEX_Create(&dObj->clientMutex) == OSAL_RESULT_FAIL)
     {
         /*  If the mutex was not created because the memory required to
             hold the mutex could not be allocated then NULL is returned. */
         return SYS_MODULE_OBJ_INVALID;
     }
-    if (OSAL_SEM_Create(&dObj->transferDone,OSAL_SEM_TYPE_BINARY, 0, 0) == OSAL_RESULT_FAIL)
-    {
-        /* There was insufficient heap memory available for the semaphore to
-        be created successfully. */
-        return SYS_MODULE_OBJ_INVALID;
-    }
+
 
     /* Register a callback with PLIB.
      * dObj as a context parameter will be used to distinguish the events
@@ -325,6 +610,10 @@ DRV_HANDLE DRV_I2C_Open( const SYS_MODULE_INDEX drvIndex, const DRV_IO_INTENT io
 
             clientObj->transferSetup.clockSpeed = dObj->initI2CClockSpeed;
 
+            clientObj->eventHandler = NULL;
+
+            clientObj->context      = 0U;
+
             if(((uint32_t)ioIntent & (uint32_t)DRV_IO_INTENT_EXCLUSIVE) != 0U)
             {
                 /* Set the driver exclusive flag */
@@ -367,6 +656,11 @@ void DRV_I2C_Close( const DRV_HANDLE handle )
     {
         dObj = (DRV_I2C_OBJ*)clientObj->hDriver;
 
+        /* Drop any transfers the client still has queued.  One already on
+         * the bus finishes, but without notifying the closed client. */
+        lDRV_I2C_QueuePurgeClient(dObj, clientObj);
+        clientObj->eventHandler = NULL;
+
         /* Acquire the instance specific mutex to protect the instance specific
          * client pool
          */
@@ -399,8 +693,10 @@ static bool lDRV_I2C_WriteReadTransfer (
 {
     DRV_I2C_CLIENT_OBJ* clientObj = (DRV_I2C_CLIENT_OBJ *)NULL;
     DRV_I2C_OBJ* hDriver = (DRV_I2C_OBJ*)NULL;
+    DRV_I2C_TRANSFER_OBJ* transferObj = (DRV_I2C_TRANSFER_OBJ*)NULL;
+    DRV_I2C_TRANSFER_EVENT event;
     bool isSuccess = false;
-    bool isReqAccepted = false;
+    bool interruptState;
 
     /* Validate the driver handle */
     clientObj = lDRV_I2C_DriverHandleValidate(handle);
@@ -417,7 +713,8 @@ static bool lDRV_I2C_WriteReadTransfer (
             return isSuccess;
         }
     }
-    else if ((transferFlags == DRV_I2C_TRANSFER_OBJ_FLAG_WR) || (transferFlags == DRV_I2C_TRANSFER_OBJ_FLAG_WR_FRCD))
+    else if ((transferFlags == DRV_I2C_TRANSFER_OBJ_FLAG_WR) || (transferFlags == DRV_I2C_TRANSFER_OBJ_FLAG_WR_FRCD) ||
+             (transferFlags == DRV_I2C_TRANSFER_OBJ_FLAG_WR_PAIRS))
     {
         if((writeSize == 0U) || (writeBuffer == NULL))
         {
@@ -434,84 +731,36 @@ static bool lDRV_I2C_WriteReadTransfer (
 
     hDriver = clientObj->hDriver;
 
+    /* Queue behind the transfers already pending; transfers queued from now
+     * on, including from event handlers, go behind this one */
+    interruptState = SYS_INT_Disable();
+    transferObj = lDRV_I2C_TransferQueue(hDriver, clientObj, address, writeBuffer, writeSize,
+                    readBuffer, readSize, transferFlags, true, NULL);
+    SYS_INT_Restore(interruptState);
 
-    /* Block other threads from accessing the PLIB */
-    if (OSAL_MUTEX_Lock(&hDriver->transferMutex, OSAL_WAIT_FOREVER ) == OSAL_RESULT_SUCCESS)
+    if (transferObj == NULL)
     {
-        /* Error is cleared for every new transfer */
-        clientObj->errors = DRV_I2C_ERROR_NONE;
-
-        /* Errors if any, will be saved in the activeClient in the driver callback */
-        hDriver->activeClient = (uintptr_t)clientObj;
-
-        /* Check if the transfer setup for this client is different than the current transfer setup */
-        if (hDriver->currentTransferSetup.clockSpeed != clientObj->transferSetup.clockSpeed)
-        {
-            /* Set the new transfer setup */
-            (void) hDriver->i2cPlib->transferSetup(&clientObj->transferSetup, 0);
-
-            hDriver->currentTransferSetup.clockSpeed = clientObj->transferSetup.clockSpeed;
-        }
-
-        switch(transferFlags)
-        {
-            case DRV_I2C_TRANSFER_OBJ_FLAG_RD:
-                if (hDriver->i2cPlib->read_t(address, readBuffer, readSize) == true)
-                {
-                    isReqAccepted = true;
-                }
-                break;
-
-            case DRV_I2C_TRANSFER_OBJ_FLAG_WR:
-                if (hDriver->i2cPlib->write_t(address, writeBuffer, writeSize) == true)
-                {
-                    isReqAccepted = true;
-                }
-                break;
-
-
-            case DRV_I2C_TRANSFER_OBJ_FLAG_WR_RD:
-                if (hDriver->i2cPlib->writeRead(address, writeBuffer, writeSize, readBuffer, readSize) == true)
-                {
-                    isReqAccepted = true;
-                }
-                break;
-
-            default:
-                     /* Nothing to do */
-                break;
-        }
-
-        if (isReqAccepted == true)
-        {
-            /* Wait till transfer completes. This semaphore is released from ISR */
-            if (OSAL_SEM_Pend( &hDriver->transferDone, OSAL_WAIT_FOREVER ) == OSAL_RESULT_SUCCESS)
-            {
-                if (hDriver->transferStatus == DRV_I2C_TRANSFER_STATUS_COMPLETE)
-                {
-                    isSuccess = true;
-                }
-            }
-        }
-        else
-        {
-            /* Update error into the client object*/
-            clientObj->errors = hDriver->i2cPlib->errorGet();
+        /* Queue is full */
+        return isSuccess;
+    }
 
-            if(clientObj->errors == DRV_I2C_ERROR_NONE)
-            {
-                hDriver->transferStatus = DRV_I2C_TRANSFER_STATUS_COMPLETE;
-            }
-            else
-            {
-                hDriver->transferStatus = DRV_I2C_TRANSFER_STATUS_ERROR;
-            }
-        }
+    /* Wait for this transfer alone. The PLIB interrupt sets the event;
+     * host builds deliver it from SYS_INT_Restore(). */
+    do
+    {
+        interruptState = SYS_INT_Disable();
+        event = transferObj->event;
+        SYS_INT_Restore(interruptState);
+    } while (event == DRV_I2C_TRANSFER_EVENT_PENDING);
 
-        /* Release the mutex to allow other threads to access the PLIB */
-        (void) OSAL_MUTEX_Unlock(&hDriver->transferMutex);
+    if (event == DRV_I2C_TRANSFER_EVENT_COMPLETE)
+    {
+        isSuccess = true;
     }
 
+    /* Retire left the object allocated for us */
+    transferObj->inUse = false;
+
     return isSuccess;
 }
 
@@ -571,6 +820,135 @@ bool DRV_I2C_WriteReadTransfer (
         DRV_I2C_TRANSFER_OBJ_FLAG_WR_RD
     );
 }
+
+bool DRV_I2C_WritePairsTransfer(
+    const DRV_HANDLE handle,
+    uint16_t address,
+    void* const pairs,
+    const size_t count
+)
+{
+    return lDRV_I2C_WriteReadTransfer(
+        handle,
+        address,
+        pairs,
+        count,
+        NULL,
+        0,
+        DRV_I2C_TRANSFER_OBJ_FLAG_WR_PAIRS
+    );
+}
+
+void DRV_I2C_ReadTransferAdd(
+    const DRV_HANDLE handle,
+    const uint16_t address,
+    void * const buffer,
+    const size_t size,
+    DRV_I2C_TRANSFER_HANDLE * const transferHandle
+)
+{
+    lDRV_I2C_TransferAdd(handle, address, NULL, 0, buffer, size,
+        DRV_I2C_TRANSFER_OBJ_FLAG_RD, transferHandle);
+}
+
+void DRV_I2C_WriteTransferAdd(
+    const DRV_HANDLE handle,
+    const uint16_t address,
+    void * const buffer,
+    const size_t size,
+    DRV_I2C_TRANSFER_HANDLE * const transferHandle
+)
+{
+    lDRV_I2C_TransferAdd(handle, address, buffer, size, NULL, 0,
+        DRV_I2C_TRANSFER_OBJ_FLAG_WR, transferHandle);
+}
+
+void DRV_I2C_WriteReadTransferAdd (
+    const DRV_HANDLE handle,
+    const uint16_t address,
+    void * const writeBuffer,
+    const size_t writeSize,
+    void * const readBuffer,
+    const size_t readSize,
+    DRV_I2C_TRANSFER_HANDLE * const transferHandle
+)
+{
+    lDRV_I2C_TransferAdd(handle, address, writeBuffer, writeSize, readBuffer, readSize,
+        DRV_I2C_TRANSFER_OBJ_FLAG_WR_RD, transferHandle);
+}
+
+void DRV_I2C_WritePairsTransferAdd(
+    const DRV_HANDLE handle,
+    const uint16_t address,
+    void * const pairs,
+    const size_t count,
+    DRV_I2C_TRANSFER_HANDLE * const transferHandle
+)
+{
+    lDRV_I2C_TransferAdd(handle, address, pairs, count, NULL, 0,
+        DRV_I2C_TRANSFER_OBJ_FLAG_WR_PAIRS, transferHandle);
+}
+
+void DRV_I2C_TransferEventHandlerSet(
+    const DRV_HANDLE handle,
+    const DRV_I2C_TRANSFER_EVENT_HANDLER eventHandler,
+    const uintptr_t context
+)
+{
+    DRV_I2C_CLIENT_OBJ* clientObj = lDRV_I2C_DriverHandleValidate(handle);
+
+    if (clientObj != NULL)
+    {
+        clientObj->eventHandler = eventHandler;
+
+        clientObj->context = context;
+    }
+}
+
+DRV_I2C_TRANSFER_EVENT DRV_I2C_TransferStatusGet( const DRV_I2C_TRANSFER_HANDLE transferHandle )
+{
+    uint32_t drvInstance;
+    uint32_t iEntry;
+    DRV_I2C_OBJ* dObj;
+
+    if ((transferHandle == DRV_I2C_TRANSFER_HANDLE_INVALID) || (transferHandle == 0U))
+    {
+        return DRV_I2C_TRANSFER_EVENT_HANDLE_INVALID;
+    }
+
+    drvInstance = ((transferHandle & DRV_I2C_INSTANCE_INDEX_MASK) >> 8);
+    iEntry = (transferHandle & DRV_I2C_CLIENT_INDEX_MASK);
+
+    if (drvInstance >= DRV_I2C_INSTANCES_NUMBER)
+    {
+        return DRV_I2C_TRANSFER_EVENT_HANDLE_INVALID;
+    }
+
+    dObj = &gDrvI2CObj[drvInstance];
+
+    if (iEntry >= dObj->transferObjPoolSize)
+    {
+        return DRV_I2C_TRANSFER_EVENT_HANDLE_INVALID;
+    }
+
+    /* The object keeps the final status until it is reused */
+    if (dObj->transferObjPool[iEntry].transferHandle != transferHandle)
+    {
+        return DRV_I2C_TRANSFER_EVENT_HANDLE_EXPIRED;
+    }
+
+    return dObj->transferObjPool[iEntry].event;
+}
+
+void DRV_I2C_QueuePurge( const DRV_HANDLE handle )
+{
+    DRV_I2C_CLIENT_OBJ* clientObj = lDRV_I2C_DriverHandleValidate(handle);
+
+    if (clientObj != NULL)
+    {
+        lDRV_I2C_QueuePurgeClient(clientObj->hDriver, clientObj);
+    }
+}
 /*******************************************************************************
  End of File
 */
@@ -105,6 +105,9 @@ typedef enum
     /* Indicates this buffer was submitted by a force write function */
     DRV_I2C_TRANSFER_OBJ_FLAG_WR_FRCD = 1 << 3,
 
+    /* Indicates this buffer was submitted by the register pairs write function */
+    DRV_I2C_TRANSFER_OBJ_FLAG_WR_PAIRS = 1 << 4,
+
 } DRV_I2C_TRANSFER_OBJ_FLAGS;
 
 // *****************************************************************************
@@ -130,6 +133,59 @@ typedef enum
 
 } DRV_I2C_TRANSFER_STATUS;
 
+// *****************************************************************************
+/* I2C Driver Transfer Object
+
+  Summary:
+    Object used to keep track of a queued transfer request, asynchronous or
+    blocking.
+
+  Description:
+    Transfer objects are allocated from the instance's transfer object pool
+    by the DRV_I2C_xxxTransferAdd functions and the blocking transfer
+    functions, and linked into the instance queue.  The head of the queue is
+    the transfer in progress.
+
+  Remarks:
+    None.
+*/
+
+typedef struct DRV_I2C_TRANSFER_OBJ_STRUCT
+{
+    /* Slave address */
+    uint16_t                        address;
+
+    /* Transmit buffer and size (pair count for register pair writes) */
+    void*                           writeBuffer;
+    size_t                          writeSize;
+
+    /* Receive buffer and size */
+    void*                           readBuffer;
+    size_t                          readSize;
+
+    /* Kind of transfer */
+    DRV_I2C_TRANSFER_OBJ_FLAGS      flag;
+
+    /* Transfer status, PENDING until the transfer is retired */
+    volatile DRV_I2C_TRANSFER_EVENT event;
+
+    /* Handle returned to the client */
+    DRV_I2C_TRANSFER_HANDLE         transferHandle;
+
+    /* Client that queued the transfer */
+    uintptr_t                       clientObj;
+
+    /* True while the object is allocated */
+    bool                            inUse;
+
+    /* Queued by a blocking call, which waits on event and frees the object */
+    bool                            isSync;
+
+    /* Next transfer in the queue */
+    struct DRV_I2C_TRANSFER_OBJ_STRUCT* next;
+
+} DRV_I2C_TRANSFER_OBJ;
+
 // *****************************************************************************
 /* I2C Driver Instance Object
 
@@ -180,17 +236,24 @@ typedef struct
     /* The client of the active transfer on this driver instance */
     uintptr_t                       activeClient;
 
-    /* Status of the active transfer */
-    volatile DRV_I2C_TRANSFER_STATUS transferStatus;
-
-    /* Mutex to protect access to the peripheral */
-    OSAL_MUTEX_DECLARE(transferMutex);
-
     /* Mutex to protect access to the client object pool */
     OSAL_MUTEX_DECLARE(clientMutex);
 
-    /* Semaphore to wait for transfer to complete. This is released from ISR*/
-    OSAL_SEM_DECLARE(transferDone);
+    /* Memory pool for Transfer Objects */
+    DRV_I2C_TRANSFER_OBJ*           transferObjPool;
+
+    /* Number of transfer objects in the pool */
+    size_t                          transferObjPoolSize;
+
+    /* Queued transfers. The head is the transfer in progress. */
+    DRV_I2C_TRANSFER_OBJ* volatile  queueHead;
+    DRV_I2C_TRANSFER_OBJ* volatile  queueTail;
+
+    /* True while the PLIB is running the transfer at queueHead */
+    volatile bool                   asyncActive;
+
+    /* Token counter used to generate unique transfer handles */
+    uint16_t                        transferTokenCount;
 
 } DRV_I2C_OBJ;
 
@@ -229,6 +292,12 @@ typedef struct
     /* Client specific transfer setup */
     DRV_I2C_TRANSFER_SETUP          transferSetup;
 
+    /* Event handler for queued transfers */
+    DRV_I2C_TRANSFER_EVENT_HANDLER  eventHandler;
+
+    /* Client context passed to eventHandler */
+    uintptr_t                       context;
+
 } DRV_I2C_CLIENT_OBJ;
 
 #endif //#ifndef DRV_I2C_LOCAL_H
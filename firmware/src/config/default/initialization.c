@@ -74,6 +74,9 @@
 /* I2C Client Objects Pool */
 static DRV_I2C_CLIENT_OBJ drvI2C0ClientObjPool[DRV_I2C_CLIENTS_NUMBER_IDX0];
 
+/* I2C Transfer Objects Pool */
+static DRV_I2C_TRANSFER_OBJ drvI2C0TransferObjPool[DRV_I2C_QUEUE_SIZE_IDX0];
+
 /* I2C PLib Interface Initialization */
 static const DRV_I2C_PLIB_INTERFACE drvI2C0PLibAPI = {
 
@@ -87,6 +90,9 @@ static const DRV_I2C_PLIB_INTERFACE drvI2C0PLibAPI = {
     /* I2C PLib Transfer Write Read Add function */
     .writeRead = (DRV_I2C_PLIB_WRITE_READ)TWIHS0_WriteRead,
 
+    /* I2C PLib Transfer Write Pairs function */
+    .writePairs = (DRV_I2C_PLIB_WRITE_PAIRS)TWIHS0_WritePairs,
+
     /*I2C PLib Transfer Abort function */
     .transferAbort = (DRV_I2C_PLIB_TRANSFER_ABORT)TWIHS0_TransferAbort,
 
@@ -113,6 +119,12 @@ static const DRV_I2C_INIT drvI2C0InitData =
     /* I2C Client Objects Pool */
     .clientObjPool = (uintptr_t)&drvI2C0ClientObjPool[0],
 
+    /* I2C Transfer Objects Pool */
+    .transferObjPool = (uintptr_t)&drvI2C0TransferObjPool[0],
+
+    /* I2C Transfer Objects Pool Size */
+    .transferObjPoolSize = DRV_I2C_QUEUE_SIZE_IDX0,
+
     /* I2C Clock Speed */
     .clockSpeed = DRV_I2C_CLOCK_SPEED_IDX0,
 };
@@ -227,6 +239,8 @@ void SYS_Initialize ( void* data )
 
 	SPI0_Initialize();
 
+	XDMAC_Initialize();
+
 	TWIHS0_Initialize();
 
     USART1_Initialize();
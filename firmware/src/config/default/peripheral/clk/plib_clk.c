@@ -105,4 +105,5 @@ void CLOCK_Initialize( void )
 
     /* Enable Peripheral Clock */
     PMC_REGS->PMC_PCER0=0x2b5c00U;
+    PMC_REGS->PMC_PCER1=0x4000000U;
 }
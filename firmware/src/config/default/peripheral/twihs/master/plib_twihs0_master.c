@@ -59,6 +59,10 @@
 
 volatile static TWIHS_OBJ twihs0Obj;
 
+#if TWIHS0_ISR_STATS
+volatile static TWIHS_ISR_STATS twihs0IsrStats;
+#endif
+
 // *****************************************************************************
 // *****************************************************************************
 // TWIHS0 PLib Interface Routines
@@ -93,6 +97,36 @@ void TWIHS0_Initialize( void )
     twihs0Obj.state = TWIHS_STATE_IDLE;
 }
 
+#if TWIHS0_ISR_STATS
+static void TWIHS0_IsrStatsUpdate( uint32_t startCycles )
+{
+    uint32_t elapsed = DWT->CYCCNT - startCycles;
+
+    twihs0IsrStats.count++;
+    twihs0IsrStats.cycles += elapsed;
+    if (elapsed > twihs0IsrStats.maxCycles)
+    {
+        twihs0IsrStats.maxCycles = elapsed;
+    }
+}
+#endif
+
+static void TWIHS0_WriteNextPair( void )
+{
+    size_t writeCount = twihs0Obj.writeCount;
+
+    // Register address goes out as the one byte internal address, so each
+    // pair is a single byte write: load data, issue STOP, wait for TXCOMP
+    TWIHS0_REGS->TWIHS_MMR = TWIHS_MMR_DADR(twihs0Obj.address) | TWIHS_MMR_IADRSZ(1);
+    TWIHS0_REGS->TWIHS_IADR = TWIHS_IADR_IADR(twihs0Obj.writeBuffer[writeCount]);
+    TWIHS0_REGS->TWIHS_THR = TWIHS_THR_TXDATA(twihs0Obj.writeBuffer[writeCount + 1U]);
+    TWIHS0_REGS->TWIHS_CR = TWIHS_CR_STOP_Msk;
+
+    twihs0Obj.writeCount = writeCount + 2U;
+
+    TWIHS0_REGS->TWIHS_IER = TWIHS_IER_TXCOMP_Msk;
+}
+
 static void TWIHS0_InitiateRead( void )
 {
     twihs0Obj.state = TWIHS_STATE_TRANSFER_READ;
@@ -309,6 +343,41 @@ bool TWIHS0_WriteRead( uint16_t address, uint8_t *wdata, size_t wlength, uint8_t
     return TWIHS0_InitiateTransfer(address, false);
 }
 
+bool TWIHS0_WritePairs( uint16_t address, uint8_t *pairs, size_t count )
+{
+    // Check for ongoing transfer
+    if( twihs0Obj.state != TWIHS_STATE_IDLE )
+    {
+        return false;
+    }
+    if ((TWIHS0_REGS->TWIHS_SR & (TWIHS_SR_SDA_Msk | TWIHS_SR_SCL_Msk)) != (TWIHS_SR_SDA_Msk | TWIHS_SR_SCL_Msk))
+    {
+        twihs0Obj.error = TWIHS_BUS_ERROR;
+        return false;
+    }
+    // Internal address mode is 7-bit only
+    if(( count == 0U ) || ( address > 0x007FU ))
+    {
+        return false;
+    }
+
+    // pairs holds count {register, value} byte pairs, each sent as its own
+    // START, address, register, value, STOP sequence
+    twihs0Obj.address = address;
+    twihs0Obj.readBuffer = NULL;
+    twihs0Obj.readSize = 0;
+    twihs0Obj.writeBuffer = pairs;
+    twihs0Obj.writeSize = count * 2U;
+    twihs0Obj.writeCount = 0;
+    twihs0Obj.readCount = 0;
+    twihs0Obj.error = TWIHS_ERROR_NONE;
+    twihs0Obj.state = TWIHS_STATE_TRANSFER_WRITE_PAIRS;
+
+    TWIHS0_WriteNextPair();
+
+    return true;
+}
+
 TWIHS_ERROR TWIHS0_ErrorGet( void )
 {
     TWIHS_ERROR error = TWIHS_ERROR_NONE;
@@ -320,6 +389,26 @@ TWIHS_ERROR TWIHS0_ErrorGet( void )
     return error;
 }
 
+#if TWIHS0_ISR_STATS
+void TWIHS0_IsrStatsGet( TWIHS_ISR_STATS *stats )
+{
+    __disable_irq();
+    stats->count = twihs0IsrStats.count;
+    stats->cycles = twihs0IsrStats.cycles;
+    stats->maxCycles = twihs0IsrStats.maxCycles;
+    __enable_irq();
+}
+
+void TWIHS0_IsrStatsReset( void )
+{
+    __disable_irq();
+    twihs0IsrStats.count = 0U;
+    twihs0IsrStats.cycles = 0U;
+    twihs0IsrStats.maxCycles = 0U;
+    __enable_irq();
+}
+#endif
+
 bool TWIHS0_TransferSetup( TWIHS_TRANSFER_SETUP* setup, uint32_t srcClkFreq )
 {
     uint32_t i2cClkSpeed;
@@ -373,6 +462,9 @@ void __attribute__((used)) TWIHS0_InterruptHandler( void )
 {
     uint32_t status;
     uintptr_t context = twihs0Obj.context;
+#if TWIHS0_ISR_STATS
+    uint32_t isrStart = DWT->CYCCNT;
+#endif
 
     // Read the peripheral status
     status = TWIHS0_REGS->TWIHS_SR;
@@ -384,7 +476,8 @@ void __attribute__((used)) TWIHS0_InterruptHandler( void )
         twihs0Obj.error = TWIHS_ERROR_NACK;
     }
 
-    if(( status & TWIHS_SR_TXCOMP_Msk ) != 0U)
+    /* Register pairs chain from one TXCOMP to the next without a master reset */
+    if((( status & TWIHS_SR_TXCOMP_Msk ) != 0U) && (twihs0Obj.state != TWIHS_STATE_TRANSFER_WRITE_PAIRS))
     {
         /* Disable and Enable I2C Master */
         TWIHS0_REGS->TWIHS_CR = TWIHS_CR_MSDIS_Msk;
@@ -400,7 +493,15 @@ void __attribute__((used)) TWIHS0_InterruptHandler( void )
         /* Re-initiate the transfer if arbitration is lost in
          * between of the transfer
          */
-        twihs0Obj.state = TWIHS_STATE_ADDR_SEND;
+        if (twihs0Obj.state == TWIHS_STATE_TRANSFER_WRITE_PAIRS)
+        {
+            /* Resend the current pair */
+            twihs0Obj.writeCount -= 2U;
+        }
+        else
+        {
+            twihs0Obj.state = TWIHS_STATE_ADDR_SEND;
+        }
     }
 
     if( twihs0Obj.error == TWIHS_ERROR_NONE)
@@ -519,6 +620,22 @@ void __attribute__((used)) TWIHS0_InterruptHandler( void )
                 break;
             }
 
+            case TWIHS_STATE_TRANSFER_WRITE_PAIRS:
+            {
+                if(( status & TWIHS_SR_TXCOMP_Msk ) != 0U)
+                {
+                    if (twihs0Obj.writeCount < twihs0Obj.writeSize)
+                    {
+                        TWIHS0_WriteNextPair();
+                    }
+                    else
+                    {
+                        twihs0Obj.state = TWIHS_STATE_TRANSFER_DONE;
+                    }
+                }
+                break;
+            }
+
             case TWIHS_STATE_WAIT_FOR_TXCOMP:
             {
                 if(( status & TWIHS_SR_TXCOMP_Msk ) != 0U)
@@ -569,5 +686,9 @@ void __attribute__((used)) TWIHS0_InterruptHandler( void )
         }
     }
 
+#if TWIHS0_ISR_STATS
+    TWIHS0_IsrStatsUpdate(isrStart);
+#endif
+
     return;
 }
\ No newline at end of file
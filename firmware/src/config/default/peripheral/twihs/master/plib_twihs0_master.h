@@ -55,6 +55,13 @@
 
 #include "plib_twihs_master_common.h"
 
+/* Set to 1 to count the TWIHS0 interrupts and the core cycles spent in them
+   (TWIHS0_IsrStatsGet()).  Timing uses the DWT cycle counter, which the
+   application enables with cycle_counter_init(). */
+#ifndef TWIHS0_ISR_STATS
+#define TWIHS0_ISR_STATS 0
+#endif
+
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -81,12 +88,20 @@ bool TWIHS0_Write( uint16_t address, uint8_t *pdata, size_t length );
 
 bool TWIHS0_WriteRead( uint16_t address, uint8_t *wdata, size_t wlength, uint8_t *rdata, size_t rlength );
 
+bool TWIHS0_WritePairs( uint16_t address, uint8_t *pairs, size_t count );
+
 TWIHS_ERROR TWIHS0_ErrorGet( void );
 
 bool TWIHS0_TransferSetup( TWIHS_TRANSFER_SETUP* setup, uint32_t srcClkFreq );
 
 void TWIHS0_TransferAbort( void );
 
+#if TWIHS0_ISR_STATS
+void TWIHS0_IsrStatsGet( TWIHS_ISR_STATS *stats );
+
+void TWIHS0_IsrStatsReset( void );
+#endif
+
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -132,6 +132,9 @@ typedef enum
     /* TWIHS PLib Task Transfer Done State */
     TWIHS_STATE_TRANSFER_DONE,
 
+    /* TWIHS PLib Task Register Pairs Write State */
+    TWIHS_STATE_TRANSFER_WRITE_PAIRS,
+
 } TWIHS_STATE;
 
 // *****************************************************************************
@@ -153,6 +156,33 @@ typedef void (*TWIHS_CALLBACK)
     uintptr_t contextHandle
 );
 
+// *****************************************************************************
+/* TWIHS Interrupt Statistics
+
+  Summary:
+    CPU time spent servicing a TWIHS instance.
+
+  Description:
+    Counts interrupt handler invocations and the core clock cycles spent in
+    them, as measured by the DWT cycle counter.
+
+  Remarks:
+    None.
+*/
+
+typedef struct
+{
+    /* Number of handler invocations */
+    uint32_t count;
+
+    /* Total core cycles spent in the handlers */
+    uint32_t cycles;
+
+    /* Longest single invocation, in core cycles */
+    uint32_t maxCycles;
+
+} TWIHS_ISR_STATS;
+
 // *****************************************************************************
 /* TWIHS PLib Instance Object
 
@@ -38,10 +38,177 @@
 * THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
 *******************************************************************************/
 
+#include <string.h>
 #include "device.h"
 #include "plib_usart1.h"
+#include "peripheral/xdmac/plib_xdmac.h"
 #include "interrupts.h"
 
+// *****************************************************************************
+// *****************************************************************************
+// Section: USART1 Transmit Ring Buffer
+// *****************************************************************************
+// *****************************************************************************
+
+/* Writes are copied into this ring buffer and return at once. XDMAC channel
+   1 feeds US_THR from the ring, one contiguous block at a time, so a block
+   costs one interrupt however long it is. One slot is kept empty to tell a
+   full ring from an empty one. Sized to hold a whole uncompressed 96x96
+   YUYV frame message when the application streams frames. */
+#define USART1_WRITE_BUFFER_SIZE    32768U
+
+static uint8_t CACHE_ALIGN USART1_WriteBuffer[USART1_WRITE_BUFFER_SIZE];
+
+static USART_DMA_WRITE_OBJECT usart1WriteObj;
+
+static void USART1_DmaCallback( XDMAC_TRANSFER_EVENT event, uintptr_t contextHandle );
+
+/* Start sending the next contiguous block of the ring, if any. Called with
+   interrupts disabled, or from the XDMAC callback. */
+static void USART1_WriteDmaStart( void )
+{
+    uint32_t inIndex = usart1WriteObj.wrInIndex;
+    uint32_t outIndex = usart1WriteObj.wrOutIndex;
+    uint32_t size;
+
+    if ((usart1WriteObj.wrDmaSize != 0U) || (inIndex == outIndex))
+    {
+        return;
+    }
+
+    /* Up to the write index, or to the end of the buffer if it wrapped */
+    size = (inIndex > outIndex) ? (inIndex - outIndex) : (usart1WriteObj.wrBufferSize - outIndex);
+
+    // Source is in cacheable SRAM
+    DCACHE_CLEAN_BY_ADDR((uint32_t *)&usart1WriteObj.wrBuffer[outIndex], (int32_t)size);
+
+    if (XDMAC_ChannelTransfer(XDMAC_CHANNEL_0, &usart1WriteObj.wrBuffer[outIndex],
+                              (const void *)&USART1_REGS->US_THR, size) == true)
+    {
+        usart1WriteObj.wrDmaSize = size;
+    }
+}
+
+static void USART1_DmaCallback( XDMAC_TRANSFER_EVENT event, uintptr_t contextHandle )
+{
+    (void) contextHandle;
+    (void) event;
+
+    /* On a bus error the block is lost either way: move past it so the ring
+       keeps draining */
+    usart1WriteObj.wrOutIndex = (usart1WriteObj.wrOutIndex + usart1WriteObj.wrDmaSize) % usart1WriteObj.wrBufferSize;
+    usart1WriteObj.wrDmaSize = 0U;
+    USART1_WriteDmaStart();
+}
+
+static uint32_t USART1_WritePendingGet( void )
+{
+    uint32_t inIndex = usart1WriteObj.wrInIndex;
+    uint32_t outIndex = usart1WriteObj.wrOutIndex;
+
+    return (inIndex >= outIndex) ? (inIndex - outIndex) : (usart1WriteObj.wrBufferSize - outIndex + inIndex);
+}
+
+/* Copy up to size bytes into the ring and start XDMAC. Returns the number of
+   bytes copied. */
+static size_t USART1_WriteQueue( const uint8_t *pData, size_t size )
+{
+    uint32_t pending = USART1_WritePendingGet();
+    uint32_t freeSize = usart1WriteObj.wrBufferSize - 1U - pending;
+    uint32_t inIndex = usart1WriteObj.wrInIndex;
+    size_t count = (size < freeSize) ? size : freeSize;
+    size_t firstPart;
+
+    if (count == 0U)
+    {
+        return 0U;
+    }
+
+    firstPart = usart1WriteObj.wrBufferSize - inIndex;
+    if (firstPart > count)
+    {
+        firstPart = count;
+    }
+    (void) memcpy(&usart1WriteObj.wrBuffer[inIndex], pData, firstPart);
+    (void) memcpy(usart1WriteObj.wrBuffer, &pData[firstPart], count - firstPart);
+
+    /* Data must be in place before the callback can see the new index */
+    __DMB();
+    usart1WriteObj.wrInIndex = (inIndex + count) % usart1WriteObj.wrBufferSize;
+
+    pending += count;
+    if (pending > usart1WriteObj.wrStats.peak)
+    {
+        usart1WriteObj.wrStats.peak = pending;
+    }
+    usart1WriteObj.wrStats.queued += count;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    USART1_WriteDmaStart();
+    if (primask == 0U)
+    {
+        __enable_irq();
+    }
+
+    return count;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: USART1 Receive Ring Buffer
+// *****************************************************************************
+// *****************************************************************************
+
+/* The USART has a single holding register, so received bytes are moved into
+   this ring by the RXRDY interrupt and read out at leisure. */
+#define USART1_READ_BUFFER_SIZE     1024U
+
+static uint8_t USART1_ReadBuffer[USART1_READ_BUFFER_SIZE];
+
+static USART_INT_READ_OBJECT usart1ReadObj;
+
+static uint32_t USART1_ReadPendingGet( void )
+{
+    uint32_t inIndex = usart1ReadObj.rdInIndex;
+    uint32_t outIndex = usart1ReadObj.rdOutIndex;
+
+    return (inIndex >= outIndex) ? (inIndex - outIndex) : (usart1ReadObj.rdBufferSize - outIndex + inIndex);
+}
+
+void USART1_InterruptHandler( void )
+{
+    uint32_t status = USART1_REGS->US_CSR;
+    uint32_t data;
+
+    if ((status & (US_CSR_USART_OVRE_Msk | US_CSR_USART_PARE_Msk | US_CSR_USART_FRAME_Msk)) != 0U)
+    {
+        /* Drop the damaged byte and count it */
+        USART1_REGS->US_CR = US_CR_USART_RSTSTA_Msk;
+        data = USART1_REGS->US_RHR;
+        usart1ReadObj.rdErrorCount++;
+        (void)data;
+        return;
+    }
+
+    if ((status & US_CSR_USART_RXRDY_Msk) != 0U)
+    {
+        uint32_t inIndex = usart1ReadObj.rdInIndex;
+        uint32_t nextIndex = (inIndex + 1U) % usart1ReadObj.rdBufferSize;
+
+        data = USART1_REGS->US_RHR & US_RHR_RXCHR_Msk;
+        if (nextIndex == usart1ReadObj.rdOutIndex)
+        {
+            usart1ReadObj.rdErrorCount++;
+        }
+        else
+        {
+            usart1ReadObj.rdBuffer[inIndex] = (uint8_t)data;
+            usart1ReadObj.rdInIndex = nextIndex;
+        }
+    }
+}
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: USART1 Implementation
@@ -82,6 +249,25 @@ void USART1_Initialize( void )
 
     /* Configure USART1 Baud Rate */
     USART1_REGS->US_BRGR = US_BRGR_CD(10U);
+
+    usart1WriteObj.wrBuffer = USART1_WriteBuffer;
+    usart1WriteObj.wrBufferSize = USART1_WRITE_BUFFER_SIZE;
+    usart1WriteObj.wrInIndex = 0U;
+    usart1WriteObj.wrOutIndex = 0U;
+    usart1WriteObj.wrDmaSize = 0U;
+    usart1WriteObj.wrOverflow = USART_WRITE_OVERFLOW_BLOCK;
+    USART1_WriteStatsReset();
+
+    XDMAC_ChannelCallbackRegister(XDMAC_CHANNEL_0, USART1_DmaCallback, 0U);
+
+    usart1ReadObj.rdBuffer = USART1_ReadBuffer;
+    usart1ReadObj.rdBufferSize = USART1_READ_BUFFER_SIZE;
+    usart1ReadObj.rdInIndex = 0U;
+    usart1ReadObj.rdOutIndex = 0U;
+    usart1ReadObj.rdErrorCount = 0U;
+
+    /* Receive into the ring from the interrupt */
+    USART1_REGS->US_IER = (US_IER_USART_RXRDY_Msk | US_IER_USART_OVRE_Msk | US_IER_USART_FRAME_Msk | US_IER_USART_PARE_Msk);
 }
 
 USART_ERROR USART1_ErrorGet( void )
@@ -154,97 +340,133 @@ bool USART1_SerialSetup( USART_SERIAL_SETUP *setup, uint32_t srcClkFreq )
 
 bool USART1_Read( void *buffer, const size_t size )
 {
-    bool status = false;
-    uint32_t errorStatus = 0;
-    size_t processedSize = 0;
-    if(buffer != NULL)
+    uint8_t *pu8Data = (uint8_t *)buffer;
+    size_t processedSize = 0U;
+
+    if (buffer == NULL)
     {
-        uint8_t* pu8Data = (uint8_t *)buffer;
-        uint16_t* pu16Data = (uint16_t*)buffer;
-        /* Clear errors that may have got generated when there was no active read request pending */
-        USART1_ErrorClear();
+        return false;
+    }
 
-        while( size > processedSize )
+    /* 8 bit data only: waits for size bytes to arrive in the ring */
+    while (size > processedSize)
+    {
+        int data = USART1_ReadByte();
+        if (data >= 0)
         {
-            while ((USART1_REGS->US_CSR & US_CSR_USART_RXRDY_Msk) == 0U)
-            {
-                /* Wait for RXRDY flag */
-            }
-
-            /* Read error status */
-            errorStatus = (USART1_REGS->US_CSR & (US_CSR_USART_OVRE_Msk | US_CSR_USART_FRAME_Msk | US_CSR_USART_PARE_Msk));
-            if(errorStatus != 0U)
-            {
-                break;
-            }
-
-            if ((USART1_REGS->US_MR & US_MR_USART_MODE9_Msk) != 0U)
-            {
-                *pu16Data = (uint16_t)(USART1_REGS->US_RHR & US_RHR_RXCHR_Msk);
-                pu16Data++;
-            }
-            else
-            {
-                *pu8Data = (uint8_t)(USART1_REGS->US_RHR & US_RHR_RXCHR_Msk);
-                pu8Data++;
-            }
-
+            pu8Data[processedSize] = (uint8_t)data;
             processedSize++;
         }
+    }
 
-        if(size == processedSize)
-        {
-            status = true;
-        }
+    return true;
+}
+
+size_t USART1_ReadCountGet( void )
+{
+    return USART1_ReadPendingGet();
+}
+
+uint32_t USART1_ReadErrorCountGet( void )
+{
+    return usart1ReadObj.rdErrorCount;
+}
+
+bool USART1_BaudDivisorSet( uint32_t cd, uint32_t fp, bool over8 )
+{
+    if ((cd == 0U) || (cd > 65535U) || (fp > 7U))
+    {
+        return false;
     }
 
-    return status;
+    USART1_REGS->US_MR = (USART1_REGS->US_MR & ~US_MR_USART_OVER_Msk) | US_MR_USART_OVER(over8 ? 1U : 0U);
+    USART1_REGS->US_BRGR = US_BRGR_CD(cd) | US_BRGR_FP(fp);
+
+    return true;
 }
 
-bool USART1_Write( void *buffer, const size_t size )
+size_t USART1_Write( void *buffer, const size_t size )
 {
-    bool status = false;
-    size_t processedSize = 0;
-    if(NULL != buffer)
+    const uint8_t *pu8Data = (const uint8_t *)buffer;
+    size_t processedSize = 0U;
+    bool canWait;
+
+    if ((NULL == buffer) || (size == 0U))
     {
-        uint8_t* pu8Data = (uint8_t *)buffer;
-        uint16_t* pu16Data = (uint16_t*)buffer;
-        while( size > processedSize )
-        {
-            while ((USART1_REGS->US_CSR & US_CSR_USART_TXRDY_Msk) == 0U)
-            {
-                /*Wait for TXRDY */
-            }
-
-            if ((USART1_REGS->US_MR & US_MR_USART_MODE9_Msk) != 0U)
-            {
-                USART1_REGS->US_THR = pu16Data[processedSize] & US_THR_TXCHR_Msk;
-            }
-            else
-            {
-                USART1_REGS->US_THR = pu8Data[processedSize] & US_THR_TXCHR_Msk;
-            }
-            processedSize++;
-        }
+        return 0U;
+    }
 
-        status = true;
+    /* The ring only drains from the XDMAC interrupt */
+    canWait = (usart1WriteObj.wrOverflow == USART_WRITE_OVERFLOW_BLOCK) &&
+              (__get_IPSR() == 0U) && (__get_PRIMASK() == 0U);
+
+    if ((canWait == false) && (size > (usart1WriteObj.wrBufferSize - 1U - USART1_WritePendingGet())))
+    {
+        usart1WriteObj.wrStats.dropped += size;
+        return 0U;
     }
-    return status;
+
+    while (processedSize < size)
+    {
+        processedSize += USART1_WriteQueue(&pu8Data[processedSize], size - processedSize);
+    }
+
+    return processedSize;
 }
 
-int USART1_ReadByte( void )
+size_t USART1_WriteCountGet( void )
 {
-    uint32_t data = USART1_REGS->US_RHR & US_RHR_RXCHR_Msk;
-    return (int)data;
+    return USART1_WritePendingGet();
 }
 
-void USART1_WriteByte( int data )
+size_t USART1_WriteFreeBufferCountGet( void )
+{
+    return usart1WriteObj.wrBufferSize - 1U - USART1_WritePendingGet();
+}
+
+size_t USART1_WriteBufferSizeGet( void )
+{
+    return usart1WriteObj.wrBufferSize - 1U;
+}
+
+void USART1_WriteOverflowSet( USART_WRITE_OVERFLOW overflow )
 {
-    while ((USART1_REGS->US_CSR & US_CSR_USART_TXRDY_Msk) == 0U)
+    usart1WriteObj.wrOverflow = overflow;
+}
+
+void USART1_WriteStatsGet( USART_WRITE_STATS *stats )
+{
+    *stats = usart1WriteObj.wrStats;
+}
+
+void USART1_WriteStatsReset( void )
+{
+    usart1WriteObj.wrStats.queued = 0U;
+    usart1WriteObj.wrStats.dropped = 0U;
+    usart1WriteObj.wrStats.peak = USART1_WritePendingGet();
+}
+
+int USART1_ReadByte( void )
+{
+    uint32_t outIndex = usart1ReadObj.rdOutIndex;
+    int data;
+
+    if (outIndex == usart1ReadObj.rdInIndex)
     {
-        /* Wait for TXRDY flag */
+        return -1;
     }
-    USART1_REGS->US_THR = US_THR_TXCHR(data);
+
+    data = (int)usart1ReadObj.rdBuffer[outIndex];
+    usart1ReadObj.rdOutIndex = (outIndex + 1U) % usart1ReadObj.rdBufferSize;
+    return data;
+}
+
+void USART1_WriteByte( int data )
+{
+    uint8_t byte = (uint8_t)data;
+
+    /* Queue behind any buffered data to keep the output in order */
+    (void) USART1_Write(&byte, 1U);
 }
 
 bool USART1_TransmitterIsReady( void )
@@ -254,12 +476,13 @@ bool USART1_TransmitterIsReady( void )
 
 bool USART1_ReceiverIsReady( void )
 {
-    return ((USART1_REGS->US_CSR & US_CSR_USART_RXRDY_Msk) != 0U);
+    return (USART1_ReadPendingGet() != 0U);
 }
 
 bool USART1_TransmitComplete( void )
 {
-    return((USART1_REGS->US_CSR & US_CSR_USART_TXEMPTY_Msk) != 0U);
+    return (USART1_WritePendingGet() == 0U) &&
+           ((USART1_REGS->US_CSR & US_CSR_USART_TXEMPTY_Msk) != 0U);
 
 }
 
@@ -67,12 +67,43 @@ USART_ERROR USART1_ErrorGet( void );
 
 bool USART1_SerialSetup( USART_SERIAL_SETUP *setup, uint32_t srcClkFreq );
 
-bool USART1_Write( void *buffer, const size_t size );
+/* Queue size bytes for transmission by XDMAC and return without waiting for
+   them to be sent. Returns the number of bytes queued: size, or 0 if the
+   write was dropped (see USART1_WriteOverflowSet). 8 bit data only. */
+size_t USART1_Write( void *buffer, const size_t size );
 
+/* Bytes waiting to be sent */
+size_t USART1_WriteCountGet( void );
+
+size_t USART1_WriteFreeBufferCountGet( void );
+
+size_t USART1_WriteBufferSizeGet( void );
+
+/* Select what USART1_Write does when the ring buffer is full */
+void USART1_WriteOverflowSet( USART_WRITE_OVERFLOW overflow );
+
+void USART1_WriteStatsGet( USART_WRITE_STATS *stats );
+
+void USART1_WriteStatsReset( void );
+
+/* Received bytes are buffered by the RXRDY interrupt. USART1_Read() waits
+   for size bytes. 8 bit data only. */
 bool USART1_Read( void *buffer, const size_t size );
 
+/* Next received byte, or -1 if none is waiting */
 int USART1_ReadByte( void );
 
+/* Bytes waiting to be read */
+size_t USART1_ReadCountGet( void );
+
+/* Received bytes lost to line errors or a full buffer since startup */
+uint32_t USART1_ReadErrorCountGet( void );
+
+/* Set the baud rate generator directly:
+     baud = MCK / ((over8 ? 8 : 16) * (cd + fp / 8))
+   Wait for USART1_TransmitComplete() first, or bytes in flight are lost. */
+bool USART1_BaudDivisorSet( uint32_t cd, uint32_t fp, bool over8 );
+
 void USART1_WriteByte( int data );
 
 bool USART1_TransmitterIsReady( void );
@@ -115,6 +115,31 @@ typedef struct
 
 typedef void (* USART_CALLBACK)( uintptr_t context );
 
+/* What a DMA ring buffer write does when the data doesn't fit */
+typedef enum
+{
+    /* Wait for the transmitter to free enough space (the default). Writes
+       from interrupt context or with interrupts disabled can't wait and are
+       dropped instead. */
+    USART_WRITE_OVERFLOW_BLOCK = 0,
+
+    /* Drop the whole write, so that no partial message is ever sent */
+    USART_WRITE_OVERFLOW_DROP,
+} USART_WRITE_OVERFLOW;
+
+/* DMA ring buffer transmit statistics */
+typedef struct
+{
+    /* Bytes accepted into the ring buffer */
+    uint32_t queued;
+
+    /* Bytes dropped because the ring buffer was full */
+    uint32_t dropped;
+
+    /* Highest number of bytes waiting in the ring buffer */
+    uint32_t peak;
+} USART_WRITE_STATS;
+
 
 // *****************************************************************************
 // *****************************************************************************
@@ -204,6 +229,44 @@ typedef struct
 
 } USART_RING_BUFFER_OBJECT;
 
+typedef struct
+{
+    uint8_t *                                           wrBuffer;
+
+    uint32_t                                            wrBufferSize;
+
+    /* Written by the application only */
+    volatile uint32_t                                   wrInIndex;
+
+    /* Written by the XDMAC completion callback only */
+    volatile uint32_t                                   wrOutIndex;
+
+    /* Length of the block being sent by XDMAC, 0 when idle */
+    volatile uint32_t                                   wrDmaSize;
+
+    USART_WRITE_OVERFLOW                                wrOverflow;
+
+    USART_WRITE_STATS                                   wrStats;
+
+} USART_DMA_WRITE_OBJECT;
+
+typedef struct
+{
+    uint8_t *                                           rdBuffer;
+
+    uint32_t                                            rdBufferSize;
+
+    /* Written by the RXRDY interrupt only */
+    volatile uint32_t                                   rdInIndex;
+
+    /* Written by the application only */
+    volatile uint32_t                                   rdOutIndex;
+
+    /* Bytes lost to framing, parity or overrun errors or a full ring */
+    volatile uint32_t                                   rdErrorCount;
+
+} USART_INT_READ_OBJECT;
+
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
 
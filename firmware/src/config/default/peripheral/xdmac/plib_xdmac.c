@@ -0,0 +1,195 @@
+/*******************************************************************************
+  XDMAC Peripheral Library Source File
+
+  Company
+    Microchip Technology Inc.
+
+  File Name
+    plib_xdmac.c
+
+  Summary
+    XDMAC peripheral library interface.
+
+  Description
+
+  Remarks:
+
+*******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2018 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include "device.h"
+#include "plib_xdmac.h"
+#include "interrupts.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Global Data
+// *****************************************************************************
+// *****************************************************************************
+
+volatile static XDMAC_CH_OBJECT xdmacChannelObj[XDMAC_CHANNELS_NUMBER];
+
+// *****************************************************************************
+// *****************************************************************************
+// XDMAC PLib Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+void XDMAC_Initialize( void )
+{
+    uint32_t channel;
+
+    /* Disable all channels before reconfiguring them */
+    XDMAC_REGS->XDMAC_GD = XDMAC_GD_DI_Msk;
+
+    /* Channel 0: memory to USART1 US_THR, one byte per TXRDY request */
+    XDMAC_REGS->XDMAC_CHID[XDMAC_CHANNEL_0].XDMAC_CC = XDMAC_CC_TYPE_PER_TRAN |
+                                                      XDMAC_CC_MBSIZE_SINGLE |
+                                                      XDMAC_CC_DSYNC_MEM2PER |
+                                                      XDMAC_CC_SWREQ_HWR_CONNECTED |
+                                                      XDMAC_CC_MEMSET_NORMAL_MODE |
+                                                      XDMAC_CC_CSIZE_CHK_1 |
+                                                      XDMAC_CC_DWIDTH_BYTE |
+                                                      XDMAC_CC_SIF_AHB_IF0 |
+                                                      XDMAC_CC_DIF_AHB_IF1 |
+                                                      XDMAC_CC_SAM_INCREMENTED_AM |
+                                                      XDMAC_CC_DAM_FIXED_AM |
+                                                      XDMAC_CC_PERID_USART1_TX;
+
+    for (channel = 0U; channel < (uint32_t)XDMAC_CHANNELS_NUMBER; channel++)
+    {
+        /* Single block, no linked list */
+        XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CNDC = 0U;
+        XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CBC = 0U;
+        XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CDS_MSP = 0U;
+        XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CSUS = 0U;
+        XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CDUS = 0U;
+
+        /* Interrupt on end of block and on any bus error */
+        XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CIE = XDMAC_CIE_BIE_Msk |
+                                                    XDMAC_CIE_RBIE_Msk |
+                                                    XDMAC_CIE_WBIE_Msk |
+                                                    XDMAC_CIE_ROIE_Msk;
+        XDMAC_REGS->XDMAC_GIE = (XDMAC_GIE_IE0_Msk << channel);
+
+        xdmacChannelObj[channel].busyStatus = false;
+        xdmacChannelObj[channel].callback = NULL;
+        xdmacChannelObj[channel].context = 0U;
+    }
+}
+
+void XDMAC_ChannelCallbackRegister( XDMAC_CHANNEL channel, const XDMAC_CHANNEL_CALLBACK eventHandler, const uintptr_t contextHandle )
+{
+    xdmacChannelObj[channel].callback = eventHandler;
+
+    xdmacChannelObj[channel].context = contextHandle;
+}
+
+bool XDMAC_ChannelTransfer( XDMAC_CHANNEL channel, const void *srcAddr, const void *destAddr, size_t blockSize )
+{
+    if (xdmacChannelObj[channel].busyStatus == true)
+    {
+        return false;
+    }
+
+    xdmacChannelObj[channel].busyStatus = true;
+
+    /* Clear any stale channel status before loading the new block */
+    (void) XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CIS;
+
+    XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CSA = (uint32_t)srcAddr;
+    XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CDA = (uint32_t)destAddr;
+    XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CUBC = XDMAC_CUBC_UBLEN(blockSize);
+
+    /* Make sure all memory writes have completed before enabling the channel */
+    __DMB();
+
+    XDMAC_REGS->XDMAC_GE = (XDMAC_GE_EN0_Msk << (uint32_t)channel);
+
+    return true;
+}
+
+bool XDMAC_ChannelIsBusy( XDMAC_CHANNEL channel )
+{
+    return xdmacChannelObj[channel].busyStatus;
+}
+
+void XDMAC_ChannelDisable( XDMAC_CHANNEL channel )
+{
+    XDMAC_REGS->XDMAC_GD = (XDMAC_GD_DI0_Msk << (uint32_t)channel);
+
+    while ((XDMAC_REGS->XDMAC_GS & (XDMAC_GS_ST0_Msk << (uint32_t)channel)) != 0U)
+    {
+        /* Wait for the channel to stop */
+    }
+
+    xdmacChannelObj[channel].busyStatus = false;
+}
+
+void __attribute__((used)) XDMAC_InterruptHandler( void )
+{
+    uint32_t channel;
+    uint32_t status;
+    XDMAC_TRANSFER_EVENT event;
+    uint32_t pending = XDMAC_REGS->XDMAC_GIS;
+
+    for (channel = 0U; channel < (uint32_t)XDMAC_CHANNELS_NUMBER; channel++)
+    {
+        if ((pending & (XDMAC_GIS_IS0_Msk << channel)) == 0U)
+        {
+            continue;
+        }
+
+        /* Reading CIS clears the channel interrupt */
+        status = XDMAC_REGS->XDMAC_CHID[channel].XDMAC_CIS;
+
+        if ((status & (XDMAC_CIS_RBEIS_Msk | XDMAC_CIS_WBEIS_Msk | XDMAC_CIS_ROIS_Msk)) != 0U)
+        {
+            xdmacChannelObj[channel].busyStatus = false;
+            event = XDMAC_TRANSFER_ERROR;
+        }
+        else if ((status & XDMAC_CIS_BIS_Msk) != 0U)
+        {
+            xdmacChannelObj[channel].busyStatus = false;
+            event = XDMAC_TRANSFER_COMPLETE;
+        }
+        else
+        {
+            event = XDMAC_TRANSFER_NONE;
+        }
+
+        if ((event != XDMAC_TRANSFER_NONE) && (xdmacChannelObj[channel].callback != NULL))
+        {
+            xdmacChannelObj[channel].callback(event, xdmacChannelObj[channel].context);
+        }
+    }
+}
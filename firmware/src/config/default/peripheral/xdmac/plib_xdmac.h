@@ -0,0 +1,189 @@
+/*******************************************************************************
+  XDMAC Peripheral Library Interface Header File
+
+  Company
+    Microchip Technology Inc.
+
+  File Name
+    plib_xdmac.h
+
+  Summary
+    XDMAC peripheral library interface.
+
+  Description
+    This file defines the interface to the XDMAC peripheral library.  This
+    library provides access to and control of the associated peripheral
+    instance.
+
+  Remarks:
+
+*******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2018 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+#ifndef PLIB_XDMAC_H
+#define PLIB_XDMAC_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+    extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* XDMAC Channels
+
+  Summary:
+    Channels configured in this instance of the XDMAC PLib.
+
+  Description:
+    Each channel is bound to one peripheral request line in XDMAC_Initialize.
+
+  Remarks:
+    None.
+*/
+
+typedef enum
+{
+    /* USART1 transmit (memory to US_THR) */
+    XDMAC_CHANNEL_0,
+
+    XDMAC_CHANNELS_NUMBER
+
+} XDMAC_CHANNEL;
+
+// *****************************************************************************
+/* XDMAC Transfer Events
+
+  Summary:
+    Events reported to the channel callback.
+
+  Description:
+    None.
+
+  Remarks:
+    None.
+*/
+
+typedef enum
+{
+    /* No event */
+    XDMAC_TRANSFER_NONE = 0,
+
+    /* Block transfer has completed */
+    XDMAC_TRANSFER_COMPLETE = 1,
+
+    /* Bus error or request overflow during the transfer */
+    XDMAC_TRANSFER_ERROR = 2
+
+} XDMAC_TRANSFER_EVENT;
+
+// *****************************************************************************
+/* XDMAC Channel Callback
+
+  Summary:
+    XDMAC Channel Callback Function Pointer.
+
+  Description:
+    Called from XDMAC_InterruptHandler when a channel finishes a block.
+
+  Remarks:
+    None.
+*/
+
+typedef void (*XDMAC_CHANNEL_CALLBACK)
+(
+    XDMAC_TRANSFER_EVENT event,
+
+    /* Transfer context */
+    uintptr_t contextHandle
+);
+
+// *****************************************************************************
+/* XDMAC Channel Object
+
+  Summary:
+    XDMAC PLib channel object.
+
+  Description:
+    None.
+
+  Remarks:
+    None.
+*/
+
+typedef struct
+{
+    bool busyStatus;
+
+    XDMAC_CHANNEL_CALLBACK callback;
+
+    uintptr_t context;
+
+} XDMAC_CH_OBJECT;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+void XDMAC_Initialize( void );
+
+void XDMAC_ChannelCallbackRegister( XDMAC_CHANNEL channel, const XDMAC_CHANNEL_CALLBACK eventHandler, const uintptr_t contextHandle );
+
+bool XDMAC_ChannelTransfer( XDMAC_CHANNEL channel, const void *srcAddr, const void *destAddr, size_t blockSize );
+
+bool XDMAC_ChannelIsBusy( XDMAC_CHANNEL channel );
+
+void XDMAC_ChannelDisable( XDMAC_CHANNEL channel );
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+    }
+
+#endif
+// DOM-IGNORE-END
+
+#endif //PLIB_XDMAC_H
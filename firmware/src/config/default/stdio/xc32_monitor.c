@@ -61,13 +61,12 @@ int read(int handle, void *buffer, unsigned int len)
 
 int write(int handle, void * buffer, size_t count)
 {
-   bool success = false;
+   /* Queued by the application for USART1 to send in the background. A
+      write that is dropped is still reported as written, so that stdio
+      doesn't retry it. */
    if (handle == 1)
    {
-       do
-       {
-           success = USART1_Write(buffer, count);
-       }while( !success);
+       (void)APP_ConsoleWrite(buffer, count);
    }
    return (int)count;
 }
\ No newline at end of file
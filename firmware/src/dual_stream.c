@@ -0,0 +1,153 @@
+/**
+ * @file dual_stream.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "dual_stream.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_FULL_WEIGHT 1
+#define DEFAULT_SUB_WEIGHT 3
+#define DEFAULT_FULL_INTERVAL 10
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Add n bytes to a credit, up to max, and return what didn't fit.
+ */
+static uint32_t add_credit(int32_t *credit, uint32_t n, uint32_t max);
+
+// *****************************************************************************
+// Public code
+
+void dual_stream_default_config(dual_stream_config_t *config) {
+    config->full_weight = DEFAULT_FULL_WEIGHT;
+    config->sub_weight = DEFAULT_SUB_WEIGHT;
+    config->full_interval = DEFAULT_FULL_INTERVAL;
+}
+
+void dual_stream_init(dual_stream_t *ds, const dual_stream_config_t *config) {
+    memset(ds, 0, sizeof(*ds));
+    ds->config = *config;
+    ds->need_full = true;
+}
+
+void dual_stream_update(dual_stream_t *ds, uint32_t elapsed_us,
+                        uint32_t rate) {
+    uint32_t weights = ds->config.full_weight + ds->config.sub_weight;
+    if (weights == 0) {
+        return;
+    }
+    uint32_t budget = (uint32_t)(((uint64_t)rate * elapsed_us) / 1000000);
+    uint32_t full = (uint32_t)(((uint64_t)budget * ds->config.full_weight) /
+                               weights);
+
+    // A stream never needs more than the credit for one frame: the rest is
+    // lent to the other, and what neither can use is lost
+    uint32_t spare = add_credit(&ds->full_credit, full, ds->full_cost);
+    spare = add_credit(&ds->sub_credit, budget - full + spare, ds->sub_cost);
+    add_credit(&ds->full_credit, spare, ds->full_cost);
+}
+
+tx_pacer_decision_t dual_stream_choose(dual_stream_t *ds, uint32_t full_cost,
+                                       uint32_t sub_cost) {
+    ds->full_cost = full_cost;
+    ds->sub_cost = sub_cost;
+    if (ds->need_full ||
+        (ds->since_full + 1 >= ds->config.full_interval &&
+         ds->full_credit >= (int32_t)full_cost)) {
+        return TX_PACER_FULL;
+    }
+    // The substream may overdraw by a frame, and pays it back by skipping
+    return ds->sub_credit >= 0 ? TX_PACER_DECIMATED : TX_PACER_SKIP;
+}
+
+void dual_stream_sent(dual_stream_t *ds, tx_pacer_decision_t sent,
+                      uint32_t cost) {
+    if (sent == TX_PACER_FULL) {
+        ds->full_credit -= (int32_t)cost;
+        ds->since_full = 0;
+        ds->need_full = false;
+        return;
+    }
+    if (sent == TX_PACER_DECIMATED) {
+        ds->sub_credit -= (int32_t)cost;
+    }
+    if (ds->since_full < UINT16_MAX) {
+        ds->since_full++;
+    }
+}
+
+void dual_stream_request_full(dual_stream_t *ds) { ds->need_full = true; }
+
+tx_pacer_decision_t dual_stream_decide(dual_stream_t *ds, tx_pacer_t *pacer,
+                                       uint32_t full_cost, uint32_t sub_cost,
+                                       uint32_t free) {
+    tx_pacer_decision_t wanted = dual_stream_choose(ds, full_cost, sub_cost);
+    // A full frame that doesn't fit yet is waited for, rather than replaced
+    // by a substream frame, unless it will never fit
+    bool wait_full =
+        wanted == TX_PACER_FULL && tx_pacer_fits(pacer, full_cost);
+    tx_pacer_decision_t decision = tx_pacer_decide(
+        pacer, wanted == TX_PACER_FULL ? full_cost : 0,
+        wanted == TX_PACER_SKIP || wait_full ? 0 : sub_cost, free);
+    dual_stream_sent(ds, decision,
+                     decision == TX_PACER_FULL        ? full_cost
+                     : decision == TX_PACER_DECIMATED ? sub_cost
+                                                      : 0);
+    if (wanted == TX_PACER_FULL && decision != TX_PACER_FULL) {
+        // still owed, whatever the credit by then
+        dual_stream_request_full(ds);
+    }
+    return decision;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint32_t add_credit(int32_t *credit, uint32_t n, uint32_t max) {
+    if (*credit >= (int32_t)max) {
+        return n;
+    }
+    uint32_t room = (uint32_t)((int32_t)max - *credit);
+    if (n <= room) {
+        *credit += (int32_t)n;
+        return 0;
+    }
+    *credit = (int32_t)max;
+    return n - room;
+}
+
+// *****************************************************************************
+// End of file
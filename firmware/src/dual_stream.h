@@ -0,0 +1,145 @@
+/**
+ * @file dual_stream.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Scheduler for two streams sharing the link: occasional full frames
+ * and a substream (a thumbnail or a region of interest) of every other
+ * frame.
+ *
+ * Each frame carries one or the other: a full frame includes everything
+ * the substream would.  The link's drain rate is split between the two
+ * streams by weight, as byte credits that accrue every frame.  A full frame
+ * is sent once its stream has the credit for it and at least full_interval
+ * frames have passed since the last, so the two streams never take more
+ * than their share of the link between them.  Credit a stream can't use
+ * goes to the other, so a stream that is idle doesn't waste its share.
+ *
+ * The decision is a tx_pacer_decision_t (TX_PACER_DECIMATED for the
+ * substream) so that tx_pacer.h can still veto anything that would exceed
+ * its latency bound.  dual_stream_decide() does the whole exchange for a
+ * frame; dual_stream_choose() and dual_stream_sent() are its steps.
+ *
+ * The module has no hardware dependencies: the caller supplies the link
+ * rate and timing.
+ */
+
+#ifndef _DUAL_STREAM_H_
+#define _DUAL_STREAM_H_
+
+// *****************************************************************************
+// Includes
+
+#include "tx_pacer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+typedef struct {
+    uint8_t full_weight;    // share of the link for full frames
+    uint8_t sub_weight;     // share of the link for the substream
+    uint16_t full_interval; // fewest frames from one full frame to the next
+} dual_stream_config_t;
+
+typedef struct {
+    dual_stream_config_t config;
+    int32_t full_credit;    // bytes each stream may still send
+    int32_t sub_credit;
+    uint16_t since_full;    // frames since the last full frame
+    bool need_full;         // send a full frame as soon as possible
+    uint32_t full_cost;     // bytes of the last frame of each stream, the
+    uint32_t sub_cost;      // most credit worth keeping
+} dual_stream_t;
+
+// *****************************************************************************
+// Public declarations
+
+void dual_stream_default_config(dual_stream_config_t *config);
+
+/**
+ * @brief Initialize the scheduler.  The first frame sent is a full frame.
+ */
+void dual_stream_init(dual_stream_t *ds, const dual_stream_config_t *config);
+
+/**
+ * @brief Give the streams their share of what the link drained over
+ * elapsed_us at rate bytes/s (e.g. the tx_pacer.h estimate).
+ */
+void dual_stream_update(dual_stream_t *ds, uint32_t elapsed_us,
+                        uint32_t rate);
+
+/**
+ * @brief Choose what to send for a frame: TX_PACER_FULL, TX_PACER_DECIMATED
+ * for the substream, or TX_PACER_SKIP if the substream has overspent.
+ *
+ * @param full_cost, sub_cost Bytes each would queue.
+ */
+tx_pacer_decision_t dual_stream_choose(dual_stream_t *ds, uint32_t full_cost,
+                                       uint32_t sub_cost);
+
+/**
+ * @brief Charge what was sent for the frame, cost bytes, to its stream.
+ */
+void dual_stream_sent(dual_stream_t *ds, tx_pacer_decision_t sent,
+                      uint32_t cost);
+
+/**
+ * @brief Send a full frame as soon as possible, e.g. when the receiver has
+ * lost the last one.
+ */
+void dual_stream_request_full(dual_stream_t *ds);
+
+/**
+ * @brief Decide what to send for a frame, with pacer's veto, and charge it.
+ *
+ * A full frame the pacer vetoes is still owed, and goes as soon as the
+ * pacer allows.  Until then no substream frame is sent in its place if the
+ * full frame is within the pacer's latency bound, as it would keep the
+ * queue from draining enough for it.
+ *
+ * @param full_cost, sub_cost Bytes each would queue.
+ * @param free Bytes the queue can take now (see tx_pacer_decide()).
+ */
+tx_pacer_decision_t dual_stream_decide(dual_stream_t *ds, tx_pacer_t *pacer,
+                                       uint32_t full_cost, uint32_t sub_cost,
+                                       uint32_t free);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _DUAL_STREAM_H_ */
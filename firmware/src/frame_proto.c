@@ -0,0 +1,603 @@
+/**
+ * @file frame_proto.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define CRC32_POLY 0xedb88320u // IEEE 802.3, reflected
+
+// Header field offsets
+#define OFFSET_TYPE 2
+#define OFFSET_FLAGS 3
+#define OFFSET_SEQ 4
+#define OFFSET_LENGTH 6
+#define OFFSET_CHECK 10
+
+// Fragment header field offsets, in the payload
+#define FRAGMENT_TYPE 0
+#define FRAGMENT_FLAGS 1
+#define FRAGMENT_TAG 4
+#define FRAGMENT_TOTAL 8
+#define FRAGMENT_OFFSET 12
+
+static uint32_t s_crc_table[256];
+static bool s_crc_table_ready;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static void crc_table_init(void);
+
+static void put_u16(uint8_t *p, uint16_t v);
+static void put_u32(uint8_t *p, uint32_t v);
+static uint16_t get_u16(const uint8_t *p);
+static uint32_t get_u32(const uint8_t *p);
+
+/**
+ * @brief Compute the check of the header's bytes 2..9.
+ */
+static uint16_t header_check(const uint8_t *header);
+
+/**
+ * @brief Send bytes through the encoder's write function.
+ */
+static bool emit(frame_proto_encoder_t *enc, const void *data, size_t n);
+
+/**
+ * @brief Send the header of a message and start its CRC.
+ */
+static bool begin_message(frame_proto_encoder_t *enc, uint8_t type,
+                          uint8_t flags, uint32_t length);
+
+/**
+ * @brief Send the CRC that ends a message.
+ */
+static bool end_message(frame_proto_encoder_t *enc);
+
+/**
+ * @brief Start the next fragment of a fragmented message.
+ */
+static bool begin_fragment(frame_proto_encoder_t *enc);
+
+/**
+ * @brief Send payload bytes, closing and starting fragments as they fill.
+ * Bytes that aren't valid (padding) are left out of the CRC.
+ */
+static bool put_payload(frame_proto_encoder_t *enc, const void *data,
+                        uint32_t n, bool valid);
+
+/**
+ * @brief Advance the decoder by one byte.
+ */
+static void decode_byte(frame_proto_decoder_t *dec, uint8_t byte);
+
+/**
+ * @brief Act on a complete header.
+ */
+static void header_complete(frame_proto_decoder_t *dec);
+
+/**
+ * @brief Act on a complete message: check the CRC and deliver it.
+ */
+static void message_complete(frame_proto_decoder_t *dec);
+
+/**
+ * @brief Add a fragment to the message being reassembled, and deliver the
+ * message if it is complete.
+ */
+static void reassemble(frame_proto_decoder_t *dec, uint16_t seq);
+
+// *****************************************************************************
+// Public code
+
+uint32_t frame_proto_crc32(uint32_t crc, const void *data, size_t n) {
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc_table_init();
+    crc = ~crc;
+    while (n--) {
+        crc = s_crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void frame_proto_encoder_init(frame_proto_encoder_t *enc,
+                              frame_proto_write_fn_t write, uintptr_t context) {
+    crc_table_init();
+    enc->write = write;
+    enc->context = context;
+    enc->seq = 0;
+    enc->crc = 0;
+    enc->remaining = 0;
+    enc->fragment_size = 0;
+    enc->tag = 0;
+    enc->frag_left = 0;
+}
+
+void frame_proto_set_fragment_size(frame_proto_encoder_t *enc, uint32_t size) {
+    enc->fragment_size = size;
+}
+
+void frame_proto_set_tag(frame_proto_encoder_t *enc, uint32_t tag) {
+    enc->tag = tag;
+}
+
+uint32_t frame_proto_wire_size(const frame_proto_encoder_t *enc,
+                               uint32_t length) {
+    if (enc->fragment_size == 0) {
+        return FRAME_PROTO_MESSAGE_SIZE(length);
+    }
+    return FRAME_PROTO_FRAGMENTED_SIZE(length, enc->fragment_size);
+}
+
+uint32_t frame_proto_message_size(const uint8_t *header) {
+    return FRAME_PROTO_MESSAGE_SIZE(get_u32(&header[OFFSET_LENGTH]));
+}
+
+void frame_proto_set_seq(uint8_t *header, uint16_t seq) {
+    put_u16(&header[OFFSET_SEQ], seq);
+    put_u16(&header[OFFSET_CHECK], header_check(header));
+}
+
+bool frame_proto_send(frame_proto_encoder_t *enc, uint8_t type, uint8_t flags,
+                      const void *payload, uint32_t length) {
+    bool ok = frame_proto_begin(enc, type, flags, length);
+    ok = frame_proto_write(enc, payload, length) && ok;
+    return frame_proto_end(enc) && ok;
+}
+
+bool frame_proto_begin(frame_proto_encoder_t *enc, uint8_t type,
+                       uint8_t flags, uint32_t length) {
+    enc->remaining = length;
+    if (enc->fragment_size == 0) {
+        return begin_message(enc, type, flags, length);
+    }
+    enc->frag_type = type;
+    enc->frag_flags = flags;
+    enc->frag_total = length;
+    enc->frag_offset = 0;
+    return begin_fragment(enc);
+}
+
+bool frame_proto_write(frame_proto_encoder_t *enc, const void *data,
+                       uint32_t n) {
+    if (n > enc->remaining) {
+        // Never send more than the header announced
+        n = enc->remaining;
+    }
+    return put_payload(enc, data, n, true);
+}
+
+bool frame_proto_end(frame_proto_encoder_t *enc) {
+    bool ok = true;
+
+    // Pad a short payload so the receiver stays in step: its CRC check will
+    // then reject the message.
+    while (enc->remaining > 0) {
+        static const uint8_t pad[16];
+        uint32_t n = enc->remaining < sizeof(pad) ? enc->remaining : sizeof(pad);
+        put_payload(enc, pad, n, false);
+        ok = false;
+    }
+    return end_message(enc) && ok;
+}
+
+void frame_proto_pack_telemetry(const frame_proto_telemetry_t *telemetry,
+                                uint8_t *buf) {
+    put_u32(&buf[0], telemetry->frame_seq);
+    put_u32(&buf[4], telemetry->timestamp);
+    put_u32(&buf[8], telemetry->interval_us);
+    put_u16(&buf[12], telemetry->exposure);
+    put_u16(&buf[14], telemetry->gain);
+    buf[16] = telemetry->mean_y;
+    buf[17] = telemetry->motion;
+    buf[18] = telemetry->pacing;
+    buf[19] = telemetry->reserved;
+    put_u32(&buf[20], telemetry->tx_queued);
+    put_u32(&buf[24], telemetry->tx_dropped);
+    put_u32(&buf[28], telemetry->drain_rate);
+    put_u32(&buf[32], telemetry->sent_full);
+    put_u32(&buf[36], telemetry->sent_reduced);
+    put_u32(&buf[40], telemetry->skipped);
+}
+
+bool frame_proto_unpack_telemetry(const uint8_t *buf, size_t length,
+                                  frame_proto_telemetry_t *telemetry) {
+    if (length < FRAME_PROTO_TELEMETRY_SIZE) {
+        return false;
+    }
+    telemetry->frame_seq = get_u32(&buf[0]);
+    telemetry->timestamp = get_u32(&buf[4]);
+    telemetry->interval_us = get_u32(&buf[8]);
+    telemetry->exposure = get_u16(&buf[12]);
+    telemetry->gain = get_u16(&buf[14]);
+    telemetry->mean_y = buf[16];
+    telemetry->motion = buf[17];
+    telemetry->pacing = buf[18];
+    telemetry->reserved = buf[19];
+    telemetry->tx_queued = get_u32(&buf[20]);
+    telemetry->tx_dropped = get_u32(&buf[24]);
+    telemetry->drain_rate = get_u32(&buf[28]);
+    telemetry->sent_full = get_u32(&buf[32]);
+    telemetry->sent_reduced = get_u32(&buf[36]);
+    telemetry->skipped = get_u32(&buf[40]);
+    return true;
+}
+
+void frame_proto_decoder_init(frame_proto_decoder_t *dec, uint8_t *buf,
+                              size_t buf_size, frame_proto_msg_cb_t cb,
+                              uintptr_t context) {
+    crc_table_init();
+    memset(dec, 0, sizeof(*dec));
+    dec->buf = buf;
+    dec->buf_size = buf_size;
+    dec->cb = cb;
+    dec->context = context;
+    dec->state = FRAME_PROTO_STATE_HUNT;
+}
+
+void frame_proto_decoder_set_reassembly(frame_proto_decoder_t *dec,
+                                        uint8_t *buf, size_t buf_size) {
+    dec->reasm_buf = buf;
+    dec->reasm_size = buf_size;
+    dec->reasm_active = false;
+}
+
+void frame_proto_decode(frame_proto_decoder_t *dec, const uint8_t *data,
+                        size_t n) {
+    while (n > 0) {
+        if (dec->state == FRAME_PROTO_STATE_PAYLOAD) {
+            // Bulk copy: the payload is most of the traffic
+            uint32_t take = dec->length - dec->pos;
+            if (take > n) {
+                take = (uint32_t)n;
+            }
+            memcpy(&dec->buf[dec->pos], data, take);
+            dec->crc = frame_proto_crc32(dec->crc, data, take);
+            dec->pos += take;
+            data += take;
+            n -= take;
+            if (dec->pos == dec->length) {
+                dec->state = FRAME_PROTO_STATE_CRC;
+                dec->pos = 0;
+            }
+        } else {
+            decode_byte(dec, *data++);
+            n--;
+        }
+    }
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void crc_table_init(void) {
+    if (s_crc_table_ready) {
+        return;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? (c >> 1) ^ CRC32_POLY : c >> 1;
+        }
+        s_crc_table[i] = c;
+    }
+    s_crc_table_ready = true;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static uint16_t header_check(const uint8_t *header) {
+    return (uint16_t)frame_proto_crc32(0, &header[OFFSET_TYPE],
+                                       OFFSET_CHECK - OFFSET_TYPE);
+}
+
+static bool emit(frame_proto_encoder_t *enc, const void *data, size_t n) {
+    if (n == 0) {
+        return true;
+    }
+    return enc->write(data, n, enc->context) == n;
+}
+
+static bool begin_message(frame_proto_encoder_t *enc, uint8_t type,
+                          uint8_t flags, uint32_t length) {
+    uint8_t header[FRAME_PROTO_HEADER_SIZE];
+
+    header[0] = FRAME_PROTO_SYNC_0;
+    header[1] = FRAME_PROTO_SYNC_1;
+    header[OFFSET_TYPE] = type;
+    header[OFFSET_FLAGS] = flags;
+    put_u16(&header[OFFSET_SEQ], enc->seq);
+    put_u32(&header[OFFSET_LENGTH], length);
+    put_u16(&header[OFFSET_CHECK], header_check(header));
+
+    enc->seq++;
+    enc->crc = 0;
+    return emit(enc, header, sizeof(header));
+}
+
+static bool end_message(frame_proto_encoder_t *enc) {
+    uint8_t trailer[FRAME_PROTO_TRAILER_SIZE];
+
+    put_u32(trailer, enc->crc);
+    return emit(enc, trailer, sizeof(trailer));
+}
+
+static bool begin_fragment(frame_proto_encoder_t *enc) {
+    uint8_t header[FRAME_PROTO_FRAGMENT_HEADER_SIZE] = {0};
+    uint32_t n = enc->remaining < enc->fragment_size ? enc->remaining
+                                                     : enc->fragment_size;
+
+    header[FRAGMENT_TYPE] = enc->frag_type;
+    header[FRAGMENT_FLAGS] = enc->frag_flags;
+    put_u32(&header[FRAGMENT_TAG], enc->tag);
+    put_u32(&header[FRAGMENT_TOTAL], enc->frag_total);
+    put_u32(&header[FRAGMENT_OFFSET], enc->frag_offset);
+
+    enc->frag_left = n;
+    bool ok = begin_message(enc, FRAME_PROTO_TYPE_FRAGMENT, 0,
+                            sizeof(header) + n);
+    enc->crc = frame_proto_crc32(0, header, sizeof(header));
+    return emit(enc, header, sizeof(header)) && ok;
+}
+
+static bool put_payload(frame_proto_encoder_t *enc, const void *data,
+                        uint32_t n, bool valid) {
+    const uint8_t *p = (const uint8_t *)data;
+    bool ok = true;
+
+    while (n > 0) {
+        uint32_t take = n;
+        if (enc->fragment_size > 0) {
+            if (enc->frag_left == 0) {
+                // The fragment is full: the last one is ended by
+                // frame_proto_end()
+                ok = end_message(enc) && ok;
+                ok = begin_fragment(enc) && ok;
+            }
+            if (take > enc->frag_left) {
+                take = enc->frag_left;
+            }
+            enc->frag_left -= take;
+            enc->frag_offset += take;
+        }
+        if (valid) {
+            enc->crc = frame_proto_crc32(enc->crc, p, take);
+        }
+        ok = emit(enc, p, take) && ok;
+        enc->remaining -= take;
+        p += take;
+        n -= take;
+    }
+    return ok;
+}
+
+static void decode_byte(frame_proto_decoder_t *dec, uint8_t byte) {
+    switch (dec->state) {
+    case FRAME_PROTO_STATE_HUNT:
+        if (dec->pos == 0) {
+            if (byte == FRAME_PROTO_SYNC_0) {
+                dec->pos = 1;
+            } else {
+                dec->stats.skipped++;
+            }
+        } else if (byte == FRAME_PROTO_SYNC_1) {
+            dec->header[0] = FRAME_PROTO_SYNC_0;
+            dec->header[1] = FRAME_PROTO_SYNC_1;
+            dec->pos = 2;
+            dec->state = FRAME_PROTO_STATE_HEADER;
+        } else if (byte != FRAME_PROTO_SYNC_0) {
+            // A repeated SYNC_0 may still start the sync word
+            dec->stats.skipped += 2;
+            dec->pos = 0;
+        } else {
+            dec->stats.skipped++;
+        }
+        break;
+
+    case FRAME_PROTO_STATE_HEADER:
+        dec->header[dec->pos++] = byte;
+        if (dec->pos == FRAME_PROTO_HEADER_SIZE) {
+            header_complete(dec);
+        }
+        break;
+
+    case FRAME_PROTO_STATE_PAYLOAD:
+        // Handled in bulk by frame_proto_decode()
+        break;
+
+    case FRAME_PROTO_STATE_SKIP:
+        if (++dec->pos == dec->length) {
+            dec->state = FRAME_PROTO_STATE_CRC;
+            dec->pos = 0;
+        }
+        break;
+
+    case FRAME_PROTO_STATE_CRC:
+        dec->crc_bytes[dec->pos++] = byte;
+        if (dec->pos == FRAME_PROTO_TRAILER_SIZE) {
+            message_complete(dec);
+        }
+        break;
+    }
+}
+
+static void header_complete(frame_proto_decoder_t *dec) {
+    if (get_u16(&dec->header[OFFSET_CHECK]) != header_check(dec->header)) {
+        // The sync word was payload data or the header is corrupt.  The
+        // next message may start inside the bytes just collected, so rescan
+        // them.  They are one byte short of a header, so this can't recurse.
+        uint8_t rescan[FRAME_PROTO_HEADER_SIZE - 1];
+        memcpy(rescan, &dec->header[1], sizeof(rescan));
+        dec->stats.header_errors++;
+        dec->state = FRAME_PROTO_STATE_HUNT;
+        dec->pos = 0;
+        for (size_t i = 0; i < sizeof(rescan); i++) {
+            decode_byte(dec, rescan[i]);
+        }
+        return;
+    }
+
+    dec->length = get_u32(&dec->header[OFFSET_LENGTH]);
+    dec->crc = 0;
+    dec->pos = 0;
+    if (dec->length > dec->buf_size) {
+        dec->stats.oversize++;
+        dec->state = FRAME_PROTO_STATE_SKIP;
+    } else if (dec->length == 0) {
+        dec->state = FRAME_PROTO_STATE_CRC;
+    } else {
+        dec->state = FRAME_PROTO_STATE_PAYLOAD;
+    }
+}
+
+static void message_complete(frame_proto_decoder_t *dec) {
+    bool skipped = dec->length > dec->buf_size;
+    uint16_t seq = get_u16(&dec->header[OFFSET_SEQ]);
+
+    dec->state = FRAME_PROTO_STATE_HUNT;
+    dec->pos = 0;
+
+    if (dec->synced) {
+        dec->stats.lost += (uint16_t)(seq - dec->next_seq);
+    }
+    dec->synced = true;
+    dec->next_seq = seq + 1;
+
+    if (skipped) {
+        return;
+    }
+    if (get_u32(dec->crc_bytes) != dec->crc) {
+        dec->stats.crc_errors++;
+        return;
+    }
+    dec->stats.messages++;
+    if (dec->header[OFFSET_TYPE] == FRAME_PROTO_TYPE_FRAGMENT &&
+        dec->reasm_buf != NULL) {
+        reassemble(dec, seq);
+        return;
+    }
+    if (dec->cb != NULL) {
+        frame_proto_msg_t msg = {
+            .type = dec->header[OFFSET_TYPE],
+            .flags = dec->header[OFFSET_FLAGS],
+            .seq = seq,
+            .payload = dec->buf,
+            .length = dec->length,
+        };
+        dec->cb(&msg, dec->context);
+    }
+}
+
+static void reassemble(frame_proto_decoder_t *dec, uint16_t seq) {
+    const uint8_t *header = dec->buf;
+
+    if (dec->length < FRAME_PROTO_FRAGMENT_HEADER_SIZE) {
+        dec->stats.fragment_errors += dec->reasm_active;
+        dec->reasm_active = false;
+        return;
+    }
+    uint32_t n = dec->length - FRAME_PROTO_FRAGMENT_HEADER_SIZE;
+    uint32_t tag = get_u32(&header[FRAGMENT_TAG]);
+    uint32_t total = get_u32(&header[FRAGMENT_TOTAL]);
+    uint32_t offset = get_u32(&header[FRAGMENT_OFFSET]);
+
+    if (offset == 0) {
+        // A new message: one still incomplete has lost its tail
+        dec->stats.fragment_errors += dec->reasm_active;
+        dec->reasm_active = false;
+        if (total > dec->reasm_size) {
+            dec->stats.oversize++;
+            return;
+        }
+        dec->reasm_active = true;
+        dec->reasm_type = header[FRAGMENT_TYPE];
+        dec->reasm_flags = header[FRAGMENT_FLAGS];
+        dec->reasm_tag = tag;
+        dec->reasm_total = total;
+        dec->reasm_got = 0;
+    } else if (!dec->reasm_active || offset != dec->reasm_got ||
+               tag != dec->reasm_tag || total != dec->reasm_total) {
+        // Not the next fragment of the current message
+        dec->stats.fragment_errors += dec->reasm_active;
+        dec->reasm_active = false;
+        return;
+    }
+    if (n > dec->reasm_total - dec->reasm_got) {
+        dec->stats.fragment_errors++;
+        dec->reasm_active = false;
+        return;
+    }
+    memcpy(&dec->reasm_buf[dec->reasm_got],
+           &header[FRAME_PROTO_FRAGMENT_HEADER_SIZE], n);
+    dec->reasm_got += n;
+    if (dec->reasm_got < dec->reasm_total) {
+        return;
+    }
+
+    dec->reasm_active = false;
+    if (dec->cb != NULL) {
+        frame_proto_msg_t msg = {
+            .type = dec->reasm_type,
+            .flags = dec->reasm_flags,
+            .seq = seq,
+            .payload = dec->reasm_buf,
+            .length = dec->reasm_total,
+            .fragmented = true,
+            .tag = tag,
+        };
+        dec->cb(&msg, dec->context);
+    }
+}
@@ -0,0 +1,342 @@
+/**
+ * @file frame_proto.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Binary message framing for the camera stream.
+ *
+ * Every message is a 12 byte header, the payload and a CRC32 of the
+ * payload.  All fields are little endian.
+ *   [0..1]   sync: FRAME_PROTO_SYNC_0, FRAME_PROTO_SYNC_1
+ *   [2]      type (frame_proto_type_t)
+ *   [3]      flags, type specific
+ *   [4..5]   sequence number, incremented for every message sent
+ *   [6..9]   payload length
+ *   [10..11] header check: low 16 bits of the CRC32 of bytes 2..9
+ *   payload
+ *   CRC32 of the payload (IEEE 802.3, the same as zlib's crc32())
+ *
+ * The header check lets a receiver reject a corrupted length before it
+ * consumes the payload, so after an error it resynchronizes on the next
+ * sync word instead of losing the messages that follow.  Gaps in the
+ * sequence numbers tell the receiver how many messages were lost.
+ *
+ * Console text is sent in LOG messages (see uart_mux_write_text()).  Bytes
+ * between messages (e.g. console output before the stream starts) are
+ * skipped by the decoder.
+ *
+ * An encoder can be set to send its messages in FRAGMENT messages of a
+ * bounded size (see frame_proto_set_fragment_size()), so that a long
+ * message doesn't hold up other messages sent between its fragments.  Each
+ * fragment's payload starts with FRAME_PROTO_FRAGMENT_HEADER_SIZE bytes:
+ *   [0]      type of the whole message
+ *   [1]      flags of the whole message
+ *   [2..3]   zero
+ *   [4..7]   tag: identifies the message to the receiver
+ *   [8..11]  payload length of the whole message
+ *   [12..15] offset of this fragment's data in the whole payload
+ * A decoder given a reassembly buffer delivers the whole message once all
+ * of its fragments have arrived in order, and discards it otherwise.
+ *
+ * The module has no hardware dependencies: the encoder writes through a
+ * caller supplied function and the decoder is fed bytes, so both run on the
+ * host (see tools/frame_proto_fuzz.c).
+ */
+
+#ifndef _FRAME_PROTO_H_
+#define _FRAME_PROTO_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define FRAME_PROTO_SYNC_0 0xa5
+#define FRAME_PROTO_SYNC_1 0x5a
+
+#define FRAME_PROTO_HEADER_SIZE 12
+#define FRAME_PROTO_TRAILER_SIZE 4
+
+// Bytes on the wire for a message with a payload of n bytes
+#define FRAME_PROTO_MESSAGE_SIZE(n)                                            \
+    (FRAME_PROTO_HEADER_SIZE + (n) + FRAME_PROTO_TRAILER_SIZE)
+
+typedef enum {
+    FRAME_PROTO_TYPE_LOG = 1,        // console text
+    FRAME_PROTO_TYPE_TELEMETRY = 2,  // frame_proto_telemetry_t, packed
+    FRAME_PROTO_TYPE_FRAME_YUYV = 3, // width, height (u16), YUYV data
+    FRAME_PROTO_TYPE_FRAME_CODEC = 4, // yuv_codec.h encoded frame
+    FRAME_PROTO_TYPE_FRAME_TILES = 5, // tile_stream.h update
+    FRAME_PROTO_TYPE_LINK = 6,        // link rate negotiation (link_baud.h)
+    FRAME_PROTO_TYPE_FRAGMENT = 7,    // part of a longer message (see above)
+    FRAME_PROTO_TYPE_COMMAND = 8,     // from the host (host_cmd.h)
+    FRAME_PROTO_TYPE_REPLY = 9,       // to a COMMAND
+    FRAME_PROTO_TYPE_FRAME_PROGRESSIVE = 10, // as FRAME_YUYV, rows in
+                                             // interlace.h order
+    FRAME_PROTO_TYPE_FRAME_ROI = 11, // x, y, width, height (u16), YUYV data
+                                     // of that region of the frame
+} frame_proto_type_t;
+
+// Flag for frame messages that can be decoded without earlier frames
+#define FRAME_PROTO_FLAG_KEY 0x01
+
+// Flag for a frame sent on request (host_cmd.h) rather than as the stream
+#define FRAME_PROTO_FLAG_SNAPSHOT 0x02
+
+#define FRAME_PROTO_FRAGMENT_HEADER_SIZE 16
+
+// Fragments for a payload of n bytes sent in fragments of up to f bytes,
+// and the bytes on the wire for them
+#define FRAME_PROTO_FRAGMENTS(n, f) ((n) == 0 ? 1 : ((n) + (f) - 1) / (f))
+#define FRAME_PROTO_FRAGMENTED_SIZE(n, f)                                      \
+    ((n) + FRAME_PROTO_FRAGMENTS(n, f) *                                       \
+               FRAME_PROTO_MESSAGE_SIZE(FRAME_PROTO_FRAGMENT_HEADER_SIZE))
+
+/**
+ * @brief Per-frame telemetry, sent as FRAME_PROTO_TELEMETRY_SIZE bytes.
+ */
+typedef struct {
+    uint32_t frame_seq;   // camera frame sequence number
+    uint32_t timestamp;   // SYS_TIME counter at readout
+    uint32_t interval_us; // time since the previous frame
+    uint16_t exposure;    // exposure in lines
+    uint16_t gain;        // gain, Q4
+    uint8_t mean_y;       // mean luma
+    uint8_t motion;       // moving blocks, saturated at 255
+    uint8_t pacing;       // what was sent for this frame (tx_pacer.h)
+    uint8_t reserved;     // zero
+    uint32_t tx_queued;   // console bytes queued since the last telemetry
+    uint32_t tx_dropped;  // console bytes dropped since the last telemetry
+    uint32_t drain_rate;  // estimated link drain rate, bytes/s
+    uint32_t sent_full;   // frames sent in full since startup
+    uint32_t sent_reduced; // frames sent decimated since startup
+    uint32_t skipped;     // frames not sent since startup
+} frame_proto_telemetry_t;
+
+#define FRAME_PROTO_TELEMETRY_SIZE 44
+
+/**
+ * @brief Function used by the encoder to send bytes.  Returns the number of
+ * bytes accepted.
+ */
+typedef size_t (*frame_proto_write_fn_t)(const void *data, size_t n,
+                                         uintptr_t context);
+
+typedef struct {
+    frame_proto_write_fn_t write; // sends encoded bytes
+    uintptr_t context;            // passed to write
+    uint16_t seq;                 // sequence number of the next message
+    uint32_t crc;                 // running CRC of the current payload
+    uint32_t remaining;           // payload bytes still to be written
+    uint32_t fragment_size;       // largest fragment, 0 to send messages whole
+    uint32_t tag;                 // tag of the fragmented messages
+    uint8_t frag_type;            // type of the fragmented message
+    uint8_t frag_flags;           // flags of the fragmented message
+    uint32_t frag_total;          // payload length of the fragmented message
+    uint32_t frag_offset;         // payload bytes written so far
+    uint32_t frag_left;           // bytes left in the current fragment
+} frame_proto_encoder_t;
+
+/**
+ * @brief A decoded message.  payload is valid until the decoder is next
+ * fed.
+ */
+typedef struct {
+    uint8_t type;           // frame_proto_type_t
+    uint8_t flags;          // type specific
+    uint16_t seq;           // sequence number (of the last fragment)
+    const uint8_t *payload; // payload bytes
+    uint32_t length;        // payload length
+    bool fragmented;        // reassembled from fragments
+    uint32_t tag;           // the fragments' tag, if fragmented
+} frame_proto_msg_t;
+
+typedef void (*frame_proto_msg_cb_t)(const frame_proto_msg_t *msg,
+                                     uintptr_t context);
+
+/**
+ * @brief Decoder statistics.
+ */
+typedef struct {
+    uint32_t messages;      // messages delivered
+    uint32_t header_errors; // headers failing the header check
+    uint32_t crc_errors;    // payloads failing the CRC
+    uint32_t oversize;      // messages too large for the buffer, skipped
+    uint32_t lost;          // messages missing from the sequence
+    uint32_t skipped;       // bytes outside any message
+    uint32_t fragment_errors; // fragmented messages discarded incomplete
+} frame_proto_stats_t;
+
+typedef enum {
+    FRAME_PROTO_STATE_HUNT,    // looking for the sync word
+    FRAME_PROTO_STATE_HEADER,  // collecting the header
+    FRAME_PROTO_STATE_PAYLOAD, // collecting the payload
+    FRAME_PROTO_STATE_SKIP,    // discarding an oversize payload
+    FRAME_PROTO_STATE_CRC,     // collecting the payload CRC
+} frame_proto_state_t;
+
+typedef struct {
+    uint8_t *buf;             // payload buffer, owned by the caller
+    size_t buf_size;          // capacity of buf
+    frame_proto_msg_cb_t cb;  // called for each valid message
+    uintptr_t context;        // passed to cb
+    frame_proto_state_t state;
+    uint8_t header[FRAME_PROTO_HEADER_SIZE];
+    uint32_t pos;             // bytes collected in the current state
+    uint32_t length;          // payload length of the current message
+    uint32_t crc;             // running CRC of the payload
+    uint8_t crc_bytes[FRAME_PROTO_TRAILER_SIZE];
+    bool synced;              // a message has been received
+    uint16_t next_seq;        // expected sequence number
+    uint8_t *reasm_buf;       // reassembly buffer, or NULL
+    size_t reasm_size;        // capacity of reasm_buf
+    bool reasm_active;        // a fragmented message is being reassembled
+    uint8_t reasm_type;       // its type, flags and tag
+    uint8_t reasm_flags;
+    uint32_t reasm_tag;
+    uint32_t reasm_total;     // its payload length
+    uint32_t reasm_got;       // payload bytes reassembled so far
+    frame_proto_stats_t stats;
+} frame_proto_decoder_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Update a CRC32 (IEEE 802.3) with n bytes.  Start with 0.
+ */
+uint32_t frame_proto_crc32(uint32_t crc, const void *data, size_t n);
+
+void frame_proto_encoder_init(frame_proto_encoder_t *enc,
+                              frame_proto_write_fn_t write, uintptr_t context);
+
+/**
+ * @brief Send every following message as FRAGMENT messages carrying up to
+ * size payload bytes each, or whole if size is 0.  Call between messages.
+ *
+ * Even a short message is sent as one fragment, so that it carries the tag.
+ */
+void frame_proto_set_fragment_size(frame_proto_encoder_t *enc, uint32_t size);
+
+/**
+ * @brief Set the tag carried by the fragments of the following messages,
+ * e.g. the camera frame a message belongs to.
+ */
+void frame_proto_set_tag(frame_proto_encoder_t *enc, uint32_t tag);
+
+/**
+ * @brief Return the bytes on the wire for a message with a payload of length
+ * bytes, fragmented or not.
+ */
+uint32_t frame_proto_wire_size(const frame_proto_encoder_t *enc,
+                               uint32_t length);
+
+/**
+ * @brief Return the bytes on the wire for the message an encoded header
+ * starts.
+ */
+uint32_t frame_proto_message_size(const uint8_t *header);
+
+/**
+ * @brief Rewrite the sequence number of an encoded header, and its check.
+ * For a sender that orders messages from several encoders.
+ */
+void frame_proto_set_seq(uint8_t *header, uint16_t seq);
+
+/**
+ * @brief Send a complete message.
+ *
+ * @return false if the write function didn't accept every byte.
+ */
+bool frame_proto_send(frame_proto_encoder_t *enc, uint8_t type, uint8_t flags,
+                      const void *payload, uint32_t length);
+
+/**
+ * @brief Send a message in pieces: frame_proto_begin(), then
+ * frame_proto_write() until exactly length bytes have been written, then
+ * frame_proto_end().  Useful to send a payload from several buffers without
+ * copying.
+ *
+ * Each returns false if the write function didn't accept every byte.
+ */
+bool frame_proto_begin(frame_proto_encoder_t *enc, uint8_t type,
+                       uint8_t flags, uint32_t length);
+bool frame_proto_write(frame_proto_encoder_t *enc, const void *data,
+                       uint32_t n);
+bool frame_proto_end(frame_proto_encoder_t *enc);
+
+/**
+ * @brief Serialize / deserialize telemetry.  buf holds
+ * FRAME_PROTO_TELEMETRY_SIZE bytes.
+ */
+void frame_proto_pack_telemetry(const frame_proto_telemetry_t *telemetry,
+                                uint8_t *buf);
+bool frame_proto_unpack_telemetry(const uint8_t *buf, size_t length,
+                                  frame_proto_telemetry_t *telemetry);
+
+/**
+ * @brief Initialize a decoder.
+ *
+ * @param buf Payload buffer: messages with longer payloads are skipped.
+ * @param cb Called for each message that passes both checks.
+ */
+void frame_proto_decoder_init(frame_proto_decoder_t *dec, uint8_t *buf,
+                              size_t buf_size, frame_proto_msg_cb_t cb,
+                              uintptr_t context);
+
+/**
+ * @brief Reassemble fragmented messages in buf, and deliver them whole.
+ * Messages with longer payloads are skipped as oversize.  Without a
+ * reassembly buffer, FRAGMENT messages are delivered as they are.
+ */
+void frame_proto_decoder_set_reassembly(frame_proto_decoder_t *dec,
+                                        uint8_t *buf, size_t buf_size);
+
+/**
+ * @brief Feed received bytes to the decoder.
+ */
+void frame_proto_decode(frame_proto_decoder_t *dec, const uint8_t *data,
+                        size_t n);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _FRAME_PROTO_H_ */
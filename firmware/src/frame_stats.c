@@ -0,0 +1,225 @@
+/**
+ * @file frame_stats.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "frame_stats.h"
+
+#include "definitions.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// The chroma sums are accumulated in 16 bit lanes, which overflow after 257
+// samples of 255: flush them to the 32 bit sums every CHUNK_WORDS words.
+#define CHUNK_WORDS 256
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Accumulate n_words [Y0 U Y1 V] words, n_words <= CHUNK_WORDS,
+ * starting at an even word of the frame.
+ */
+static void push_chunk(frame_stats_acc_t *acc, const uint8_t *yuyv,
+                       size_t n_words);
+
+/**
+ * @brief Accumulate one word that is odd within the frame, into the
+ * sub-histograms for odd words.
+ */
+static void push_odd_word(frame_stats_acc_t *acc, const uint8_t *yuyv);
+
+// *****************************************************************************
+// Private (static) storage
+
+static frame_stats_acc_t s_acc;
+
+// *****************************************************************************
+// Public code
+
+void frame_stats_begin(frame_stats_acc_t *acc) {
+    memset(acc->sub, 0, sizeof(acc->sub));
+    acc->sum_u = 0;
+    acc->sum_v = 0;
+    acc->lane_min = 0xffffffff;
+    acc->lane_max = 0;
+    acc->n_pixels = 0;
+}
+
+void frame_stats_push(frame_stats_acc_t *acc, const uint8_t *yuyv,
+                      size_t n_pixels) {
+    size_t n_words = n_pixels / 2;
+
+    // Each word's Y samples go to the sub-histograms for its position in
+    // the frame, not in this push, so that each gets a quarter of them.
+    if (n_words > 0 && (acc->n_pixels / 2) % 2 != 0) {
+        push_odd_word(acc, yuyv);
+        yuyv += 4;
+        n_words--;
+        acc->n_pixels += 2;
+    }
+    acc->n_pixels += n_words * 2;
+    while (n_words > 0) {
+        size_t chunk = n_words < CHUNK_WORDS ? n_words : CHUNK_WORDS;
+        push_chunk(acc, yuyv, chunk);
+        yuyv += chunk * 4;
+        n_words -= chunk;
+    }
+}
+
+void frame_stats_end(const frame_stats_acc_t *acc, frame_stats_t *stats) {
+    uint32_t n = acc->n_pixels;
+    uint32_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint32_t clip_low = 0;
+    uint32_t clip_high = 0;
+    int min = -1;
+    int max = 0;
+
+    memset(stats, 0, sizeof(frame_stats_t));
+    if (n == 0) {
+        return;
+    }
+    stats->n_pixels = n;
+    for (int i = 0; i < 256; i++) {
+        uint32_t count = acc->sub[0][i] + acc->sub[1][i] + acc->sub[2][i] +
+                         acc->sub[3][i];
+        stats->histogram[i] = count;
+        if (count == 0) {
+            continue;
+        }
+        if (min < 0) {
+            min = i;
+        }
+        max = i;
+        sum += count * i;
+        sum_sq += (uint64_t)count * (i * i);
+        if (i <= FRAME_STATS_CLIP_LOW) {
+            clip_low += count;
+        } else if (i >= FRAME_STATS_CLIP_HIGH) {
+            clip_high += count;
+        }
+    }
+
+    // variance = E[y^2] - E[y]^2, scaled by n^2 to stay in integers
+    uint64_t scaled = (uint64_t)n * sum_sq - (uint64_t)sum * sum;
+    stats->variance = scaled / ((uint64_t)n * n);
+    stats->clip_low_permille = (clip_low * 1000ULL) / n;
+    stats->clip_high_permille = (clip_high * 1000ULL) / n;
+
+    stats->mean[FRAME_STATS_Y] = sum / n;
+    stats->mean[FRAME_STATS_U] = acc->sum_u / (n / 2);
+    stats->mean[FRAME_STATS_V] = acc->sum_v / (n / 2);
+    stats->min[FRAME_STATS_Y] = min;
+    stats->min[FRAME_STATS_U] = acc->lane_min >> 8;
+    stats->min[FRAME_STATS_V] = acc->lane_min >> 24;
+    stats->max[FRAME_STATS_Y] = max;
+    stats->max[FRAME_STATS_U] = acc->lane_max >> 8;
+    stats->max[FRAME_STATS_V] = acc->lane_max >> 24;
+}
+
+void frame_stats_compute(const uint8_t *yuyv, size_t n_pixels,
+                         frame_stats_t *stats) {
+    frame_stats_begin(&s_acc);
+    frame_stats_push(&s_acc, yuyv, n_pixels);
+    frame_stats_end(&s_acc, stats);
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void push_chunk(frame_stats_acc_t *acc, const uint8_t *yuyv,
+                       size_t n_words) {
+    uint16_t *h0 = acc->sub[0];
+    uint16_t *h1 = acc->sub[1];
+    uint16_t *h2 = acc->sub[2];
+    uint16_t *h3 = acc->sub[3];
+    uint32_t lane_min = acc->lane_min;
+    uint32_t lane_max = acc->lane_max;
+    uint32_t uv = 0; // U in the low half word, V in the high
+
+    for (size_t i = 0; i + 1 < n_words; i += 2) {
+        uint32_t w0 = __UNALIGNED_UINT32_READ(yuyv);
+        uint32_t w1 = __UNALIGNED_UINT32_READ(yuyv + 4);
+        yuyv += 8;
+
+        h0[w0 & 0xff]++;
+        h1[(w0 >> 16) & 0xff]++;
+        h2[w1 & 0xff]++;
+        h3[(w1 >> 16) & 0xff]++;
+
+        uv = __UXTAB16(uv, __ROR(w0, 8));
+        uv = __UXTAB16(uv, __ROR(w1, 8));
+
+        // __USUB8 sets a GE flag for each byte where the first operand is
+        // greater or equal, __SEL then picks bytes accordingly
+        __USUB8(w0, lane_max);
+        lane_max = __SEL(w0, lane_max);
+        __USUB8(w1, lane_max);
+        lane_max = __SEL(w1, lane_max);
+        __USUB8(w0, lane_min);
+        lane_min = __SEL(lane_min, w0);
+        __USUB8(w1, lane_min);
+        lane_min = __SEL(lane_min, w1);
+    }
+    if (n_words & 1) {
+        uint32_t w0 = __UNALIGNED_UINT32_READ(yuyv);
+
+        h0[w0 & 0xff]++;
+        h1[(w0 >> 16) & 0xff]++;
+        uv = __UXTAB16(uv, __ROR(w0, 8));
+        __USUB8(w0, lane_max);
+        lane_max = __SEL(w0, lane_max);
+        __USUB8(w0, lane_min);
+        lane_min = __SEL(lane_min, w0);
+    }
+
+    acc->sum_u += uv & 0xffff;
+    acc->sum_v += uv >> 16;
+    acc->lane_min = lane_min;
+    acc->lane_max = lane_max;
+}
+
+static void push_odd_word(frame_stats_acc_t *acc, const uint8_t *yuyv) {
+    uint32_t w1 = __UNALIGNED_UINT32_READ(yuyv);
+
+    acc->sub[2][w1 & 0xff]++;
+    acc->sub[3][(w1 >> 16) & 0xff]++;
+    acc->sum_u += (w1 >> 8) & 0xff;
+    acc->sum_v += w1 >> 24;
+    __USUB8(w1, acc->lane_max);
+    acc->lane_max = __SEL(w1, acc->lane_max);
+    __USUB8(w1, acc->lane_min);
+    acc->lane_min = __SEL(acc->lane_min, w1);
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,147 @@
+/**
+ * @file frame_stats.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Per-frame image statistics computed in a single pass over a packed
+ * YUYV frame.
+ *
+ * One pass yields the Y histogram, per-channel mean, minimum and maximum for
+ * Y, U and V, the Y variance and the fraction of clipped Y samples.  The mean,
+ * variance, min / max and clipping of Y are derived from the histogram when
+ * the frame is finished, so the per-pixel work is only the histogram update
+ * and a few SIMD instructions for the chroma sums and min / max.
+ *
+ * The histogram is split into four interleaved sub-histograms, one per Y
+ * sample within each pair of words.  Consecutive pixels of similar brightness
+ * then increment different counters, so an increment doesn't have to wait for
+ * the store of the previous one to the same bin.
+ *
+ * Statistics can be accumulated a row (or any number of pixel pairs) at a
+ * time with frame_stats_begin() / frame_stats_push() / frame_stats_end(), or
+ * for a whole frame with frame_stats_compute().
+ */
+
+#ifndef _FRAME_STATS_H_
+#define _FRAME_STATS_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// Sub-histogram counters are 16 bits, and each receives a quarter of the Y
+// samples.
+#define FRAME_STATS_MAX_PIXELS (4 * 65535UL)
+
+// Y at or below FRAME_STATS_CLIP_LOW counts as crushed, at or above
+// FRAME_STATS_CLIP_HIGH as blown out.
+#define FRAME_STATS_CLIP_LOW 4
+#define FRAME_STATS_CLIP_HIGH 250
+
+typedef enum {
+    FRAME_STATS_Y,
+    FRAME_STATS_U,
+    FRAME_STATS_V,
+    FRAME_STATS_CHANNELS,
+} frame_stats_channel_t;
+
+/**
+ * @brief Statistics for one frame.
+ */
+typedef struct {
+    uint32_t n_pixels;                   // pixels measured
+    uint8_t mean[FRAME_STATS_CHANNELS];  // mean per channel, rounded down
+    uint8_t min[FRAME_STATS_CHANNELS];   // minimum per channel
+    uint8_t max[FRAME_STATS_CHANNELS];   // maximum per channel
+    uint16_t variance;                   // Y variance
+    uint16_t clip_low_permille;          // Y <= FRAME_STATS_CLIP_LOW, 1/1000s
+    uint16_t clip_high_permille;         // Y >= FRAME_STATS_CLIP_HIGH, 1/1000s
+    uint32_t histogram[256];             // Y histogram
+} frame_stats_t;
+
+/**
+ * @brief Running state while a frame is accumulated.
+ */
+typedef struct {
+    uint16_t sub[4][256]; // interleaved Y sub-histograms
+    uint32_t sum_u;       // sum of U samples
+    uint32_t sum_v;       // sum of V samples
+    uint32_t lane_min;    // bytewise minimum of [Y0 U Y1 V] words
+    uint32_t lane_max;    // bytewise maximum of [Y0 U Y1 V] words
+    uint32_t n_pixels;    // pixels pushed so far
+} frame_stats_acc_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Start accumulating a new frame.
+ */
+void frame_stats_begin(frame_stats_acc_t *acc);
+
+/**
+ * @brief Add pixels to the frame.
+ *
+ * @param yuyv Packed YUYV data, n_pixels * 2 bytes.  Need not be word
+ *   aligned.
+ * @param n_pixels Number of pixels, even.  The total for the frame must not
+ *   exceed FRAME_STATS_MAX_PIXELS.
+ */
+void frame_stats_push(frame_stats_acc_t *acc, const uint8_t *yuyv,
+                      size_t n_pixels);
+
+/**
+ * @brief Finish the frame and compute the statistics.
+ */
+void frame_stats_end(const frame_stats_acc_t *acc, frame_stats_t *stats);
+
+/**
+ * @brief Compute the statistics of a whole frame in one call.
+ *
+ * Uses an internal accumulator, so it is not reentrant.
+ */
+void frame_stats_compute(const uint8_t *yuyv, size_t n_pixels,
+                         frame_stats_t *stats);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _FRAME_STATS_H_ */
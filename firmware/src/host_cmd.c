@@ -0,0 +1,138 @@
+/**
+ * @file host_cmd.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Runtime control of the application by the host.  See host_cmd.h.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "host_cmd.h"
+
+#include "frame_proto.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Check a command's op and parameter.
+ */
+static host_cmd_status_t validate(const host_cmd_request_t *request,
+                                  uint32_t length);
+
+static void reply(host_cmd_t *cmd, const host_cmd_request_t *request,
+                  host_cmd_status_t status, uint32_t value);
+
+static void put_u32(uint8_t *p, uint32_t v);
+static uint32_t get_u32(const uint8_t *p);
+
+// *****************************************************************************
+// Public code
+
+void host_cmd_init(host_cmd_t *cmd, frame_proto_encoder_t *enc,
+                   host_cmd_handler_t handler, uintptr_t context) {
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->enc = enc;
+    cmd->handler = handler;
+    cmd->context = context;
+}
+
+void host_cmd_on_message(host_cmd_t *cmd, const frame_proto_msg_t *msg) {
+    host_cmd_request_t request = {0};
+    uint32_t value = 0;
+
+    if (msg->length < HOST_CMD_MIN_COMMAND_SIZE) {
+        cmd->errors++;
+        return;
+    }
+    request.op = msg->payload[0];
+    request.id = msg->payload[1];
+    request.param = msg->payload[2];
+    if (msg->length >= HOST_CMD_COMMAND_SIZE) {
+        request.value = get_u32(&msg->payload[3]);
+    }
+
+    host_cmd_status_t status = validate(&request, msg->length);
+    if (status == HOST_CMD_OK) {
+        status = cmd->handler(&request, &value, cmd->context);
+    }
+    if (status == HOST_CMD_OK) {
+        cmd->commands++;
+    } else {
+        cmd->errors++;
+    }
+    reply(cmd, &request, status, value);
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static host_cmd_status_t validate(const host_cmd_request_t *request,
+                                  uint32_t length) {
+    switch (request->op) {
+    case HOST_CMD_OP_GET:
+        break;
+    case HOST_CMD_OP_SET:
+        // a SET without its value would apply zero
+        if (length < HOST_CMD_COMMAND_SIZE) {
+            return HOST_CMD_ERR_VALUE;
+        }
+        break;
+    case HOST_CMD_OP_SNAPSHOT:
+        return HOST_CMD_OK;
+    default:
+        return HOST_CMD_ERR_OP;
+    }
+    if (request->param == HOST_CMD_PARAM_NONE ||
+        request->param >= HOST_CMD_N_PARAMS) {
+        return HOST_CMD_ERR_PARAM;
+    }
+    return HOST_CMD_OK;
+}
+
+static void reply(host_cmd_t *cmd, const host_cmd_request_t *request,
+                  host_cmd_status_t status, uint32_t value) {
+    uint8_t buf[HOST_CMD_REPLY_SIZE] = {request->op, request->id,
+                                        request->param, status};
+    put_u32(&buf[4], value);
+    frame_proto_send(cmd->enc, FRAME_PROTO_TYPE_REPLY, 0, buf, sizeof(buf));
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
@@ -0,0 +1,147 @@
+/**
+ * @file host_cmd.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Runtime control of the application by the host.
+ *
+ * The host sends FRAME_PROTO_TYPE_COMMAND messages (see frame_proto.h) and
+ * the firmware answers each with a FRAME_PROTO_TYPE_REPLY message:
+ *
+ *   COMMAND  [0] op  [1] id  [2] param  [3..6] value (u32, SET only)
+ *   REPLY    [0] op  [1] id  [2] param  [3] status  [4..7] value (u32)
+ *
+ * The id is chosen by the host and echoed, so it can match replies to
+ * commands.  GET and SET reply with the parameter's value (for SET, as
+ * applied); SNAPSHOT replies once the snapshot has been requested, and the
+ * frame follows as a FRAME_PROTO_TYPE_FRAME_YUYV message flagged
+ * FRAME_PROTO_FLAG_SNAPSHOT.  All little endian.
+ *
+ * Commands are decoded from the receive ring, which the UART interrupt
+ * fills, and handled from the superloop.  The module only parses, validates
+ * and replies: what the parameters mean is up to the handler, which should
+ * latch new values rather than act on them, so that the camera is only
+ * touched between frames.
+ *
+ * tools/cam_cmd.py implements the host side.
+ */
+
+#ifndef _HOST_CMD_H_
+#define _HOST_CMD_H_
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define HOST_CMD_COMMAND_SIZE 7
+#define HOST_CMD_REPLY_SIZE 8
+
+// GET and SNAPSHOT may omit the value
+#define HOST_CMD_MIN_COMMAND_SIZE 3
+
+typedef enum {
+    HOST_CMD_OP_GET = 1,
+    HOST_CMD_OP_SET = 2,
+    HOST_CMD_OP_SNAPSHOT = 3,
+} host_cmd_op_t;
+
+typedef enum {
+    HOST_CMD_PARAM_NONE = 0,        // SNAPSHOT
+    HOST_CMD_PARAM_PROFILE = 1,     // preset of the parameters below
+    HOST_CMD_PARAM_FPS = 2,         // target frame rate, 0 = fastest
+    HOST_CMD_PARAM_FORMAT = 3,      // streamed frame format
+    HOST_CMD_PARAM_COMPRESSION = 4, // tile change threshold
+    HOST_CMD_PARAM_LOG_LEVEL = 5,   // console verbosity
+    HOST_CMD_N_PARAMS,
+} host_cmd_param_t;
+
+typedef enum {
+    HOST_CMD_OK = 0,
+    HOST_CMD_ERR_OP = 1,    // unknown op
+    HOST_CMD_ERR_PARAM = 2, // unknown parameter
+    HOST_CMD_ERR_VALUE = 3, // value out of range
+    HOST_CMD_ERR_BUSY = 4,  // can't be done now, try again
+} host_cmd_status_t;
+
+/**
+ * @brief A decoded command.
+ */
+typedef struct {
+    uint8_t op;     // host_cmd_op_t
+    uint8_t id;     // echoed in the reply
+    uint8_t param;  // host_cmd_param_t
+    uint32_t value; // SET only
+} host_cmd_request_t;
+
+/**
+ * @brief Signature of the command handler.  Set *value to the value to
+ * reply with.  Called only for commands with a known op and parameter.
+ */
+typedef host_cmd_status_t (*host_cmd_handler_t)(
+    const host_cmd_request_t *request, uint32_t *value, uintptr_t context);
+
+typedef struct {
+    frame_proto_encoder_t *enc; // for replies
+    host_cmd_handler_t handler;
+    uintptr_t context;          // passed to handler
+    uint32_t commands;          // commands handled
+    uint32_t errors;            // commands refused
+} host_cmd_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Initialize a command interface replying through enc.
+ */
+void host_cmd_init(host_cmd_t *cmd, frame_proto_encoder_t *enc,
+                   host_cmd_handler_t handler, uintptr_t context);
+
+/**
+ * @brief Handle a FRAME_PROTO_TYPE_COMMAND message from the host, and reply.
+ */
+void host_cmd_on_message(host_cmd_t *cmd, const frame_proto_msg_t *msg);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _HOST_CMD_H_ */
@@ -0,0 +1,129 @@
+/**
+ * @file interlace.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "interlace.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// First row and row step of each pass
+static const uint8_t s_first[INTERLACE_PASSES] = {0, 4, 2, 1};
+static const uint8_t s_step[INTERLACE_PASSES] = {8, 8, 4, 2};
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the number of rows in a pass.
+ */
+static uint16_t pass_rows(uint16_t height, uint8_t pass);
+
+/**
+ * @brief Return the pass that sends a row.
+ */
+static uint8_t row_pass(uint16_t row);
+
+// *****************************************************************************
+// Public code
+
+uint16_t interlace_row(uint16_t height, uint16_t i) {
+    for (uint8_t pass = 0; pass < INTERLACE_PASSES - 1; pass++) {
+        uint16_t n = pass_rows(height, pass);
+        if (i < n) {
+            return s_first[pass] + i * s_step[pass];
+        }
+        i -= n;
+    }
+    return s_first[INTERLACE_PASSES - 1] + i * s_step[INTERLACE_PASSES - 1];
+}
+
+uint16_t interlace_position(uint16_t height, uint16_t row) {
+    uint8_t pass = row_pass(row);
+    return interlace_pass_start(height, pass) +
+           (row - s_first[pass]) / s_step[pass];
+}
+
+uint16_t interlace_pass_start(uint16_t height, uint8_t pass) {
+    uint16_t start = 0;
+    for (uint8_t p = 0; p < pass && p < INTERLACE_PASSES; p++) {
+        start += pass_rows(height, p);
+    }
+    return start;
+}
+
+bool interlace_restore(const uint8_t *src, uint16_t n_rows, uint8_t *dst,
+                       uint16_t height, size_t row_bytes) {
+    bool preview = n_rows >= interlace_pass_start(height, 1);
+
+    for (uint16_t row = 0; row < height; row++) {
+        // The row itself, else the nearest row above it from an earlier
+        // pass: row & ~1, row & ~3, then row & ~7, which the first pass sent
+        uint16_t from = row;
+        uint16_t position = interlace_position(height, from);
+        for (uint16_t mask = 1; position >= n_rows && mask < 8;
+             mask = mask << 1 | 1) {
+            from = row & ~mask;
+            position = interlace_position(height, from);
+        }
+        if (position < n_rows && (preview || from == row)) {
+            memcpy(dst + (size_t)row * row_bytes,
+                   src + (size_t)position * row_bytes, row_bytes);
+        }
+    }
+    return preview;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint16_t pass_rows(uint16_t height, uint8_t pass) {
+    if (height <= s_first[pass]) {
+        return 0;
+    }
+    return (height - s_first[pass] + s_step[pass] - 1) / s_step[pass];
+}
+
+static uint8_t row_pass(uint16_t row) {
+    if (row % 8 == 0) {
+        return 0;
+    } else if (row % 8 == 4) {
+        return 1;
+    } else if (row % 4 == 2) {
+        return 2;
+    }
+    return 3;
+}
+
+// *****************************************************************************
+// End of file
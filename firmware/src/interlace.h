@@ -0,0 +1,104 @@
+/**
+ * @file interlace.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Progressive row order for frames sent over a slow link.
+ *
+ * The rows of a frame are sent in INTERLACE_PASSES passes, coarse to fine:
+ *   pass 0: rows 0, 8, 16, ...
+ *   pass 1: rows 4, 12, 20, ...
+ *   pass 2: rows 2, 6, 10, ...
+ *   pass 3: rows 1, 3, 5, ...
+ * After the first pass, 1/8 of the bytes, a receiver can show the whole
+ * frame by repeating each row it has into the rows below it, and each
+ * further pass halves the rows repeated.  The bytes sent are the same as in
+ * row order; only the order changes.
+ *
+ * Rows are numbered, so the sender reads them straight from the frame
+ * buffer, one row at a time, without reordering the frame first.
+ */
+
+#ifndef _INTERLACE_H_
+#define _INTERLACE_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define INTERLACE_PASSES 4
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Return the frame row sent in position i (0 <= i < height).
+ */
+uint16_t interlace_row(uint16_t height, uint16_t i);
+
+/**
+ * @brief Return the position in which a frame row is sent.
+ */
+uint16_t interlace_position(uint16_t height, uint16_t row);
+
+/**
+ * @brief Return the number of rows sent before a pass starts.  For
+ * INTERLACE_PASSES, that is all of them.
+ */
+uint16_t interlace_pass_start(uint16_t height, uint8_t pass);
+
+/**
+ * @brief Put rows received in progressive order back in row order.
+ *
+ * @param src The first n_rows rows as sent.
+ * @param dst The frame, height rows of row_bytes.
+ * @return false if there were too few rows for a preview: rows not yet
+ *   received are then left as they were.  With the first pass complete,
+ *   each missing row is a copy of the nearest received row above it.
+ */
+bool interlace_restore(const uint8_t *src, uint16_t n_rows, uint8_t *dst,
+                       uint16_t height, size_t row_bytes);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _INTERLACE_H_ */
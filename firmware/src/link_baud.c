@@ -0,0 +1,357 @@
+/**
+ * @file link_baud.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "link_baud.h"
+
+#include "definitions.h"
+#include "frame_proto.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// Abandon a trial if the transmitter hasn't drained by the time the host
+// gives up on it
+#define DRAIN_TIMEOUT_MS LINK_BAUD_TRIAL_MS
+
+// Fall back if no keepalive arrives for this long
+#define KEEPALIVE_TIMEOUT_MS (4 * LINK_BAUD_KEEPALIVE_MS)
+
+#define ACCEPT_SIZE 13
+
+// 8x oversampling samples each bit more coarsely, costing roughly 1/16 bit
+// of timing margin over a 10 bit character.  Only use it when it's more
+// accurate than 16x by more than that.
+#define OVER8_PENALTY_PPM 6000
+
+typedef enum {
+    LINK_BAUD_STATE_IDLE,  // running at the current rate
+    LINK_BAUD_STATE_DRAIN, // waiting for the transmitter before switching
+    LINK_BAUD_STATE_TRIAL, // trying a proposed rate
+} link_baud_state_t;
+
+typedef struct {
+    frame_proto_encoder_t *enc;   // for messages to the host
+    link_baud_state_t state;      // current state
+    link_baud_state_t next_state; // state after the switch
+    link_baud_divisor_t current;  // setting in use
+    link_baud_divisor_t previous; // setting to return to if the trial fails
+    link_baud_divisor_t pending;  // setting to switch to once drained
+    uint32_t started_at;          // when the current state was entered
+    bool pattern_ok;              // trial pattern received intact
+    uint32_t keepalive_at;        // when the last keepalive arrived
+    uint32_t window_at;           // start of the error window
+    uint32_t window_errors;       // errors reported by the host in the window
+    uint32_t rx_errors;           // receive error count at the window start
+} link_baud_ctx_t;
+
+// *****************************************************************************
+// Private (static) storage
+
+static link_baud_ctx_t s_link_baud;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return true if at least ms milliseconds have passed since then.
+ */
+static bool elapsed(uint32_t then, uint32_t ms);
+
+/**
+ * @brief Switch to div once the transmitter has drained, then enter
+ * next_state.
+ */
+static void start_switch(const link_baud_divisor_t *div,
+                         link_baud_state_t next_state);
+
+/**
+ * @brief Tell the host and return to the base rate.
+ */
+static void fall_back(const char *reason);
+
+/**
+ * @brief Send an op followed by a u32.
+ */
+static void send_op(link_baud_op_t op, uint32_t value);
+
+static void reset_error_window(void);
+
+static void put_u32(uint8_t *p, uint32_t v);
+static uint32_t get_u32(const uint8_t *p);
+
+// *****************************************************************************
+// Public code
+
+bool link_baud_divisor(uint32_t baud, uint32_t mck, link_baud_divisor_t *div) {
+    static const uint8_t oversampling[] = {16, 8};
+    uint32_t best_score = UINT32_MAX;
+    uint32_t best_error = UINT32_MAX;
+
+    if (baud == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(oversampling); i++) {
+        // Divisor in eighths, rounded to nearest
+        uint64_t num = (uint64_t)mck * 8;
+        uint64_t den = (uint64_t)oversampling[i] * baud;
+        uint64_t d8 = (num + den / 2) / den;
+        if (d8 < 8 || d8 / 8 > 65535) {
+            continue;
+        }
+        uint32_t actual = (uint32_t)(num / (oversampling[i] * d8));
+        uint32_t diff = actual > baud ? actual - baud : baud - actual;
+        uint32_t error = (uint32_t)(((uint64_t)diff * 1000000) / baud);
+        uint32_t score = error + (oversampling[i] == 8 ? OVER8_PENALTY_PPM : 0);
+        if (score < best_score) {
+            best_score = score;
+            best_error = error;
+            div->baud = baud;
+            div->actual = actual;
+            div->cd = (uint16_t)(d8 / 8);
+            div->fp = (uint8_t)(d8 % 8);
+            div->over8 = oversampling[i] == 8;
+        }
+    }
+    return best_error <= LINK_BAUD_MAX_ERROR_PPM;
+}
+
+void link_baud_pattern(uint8_t *buf) {
+    for (size_t i = 0; i < LINK_BAUD_PATTERN_SIZE; i++) {
+        if (i < 256) {
+            buf[i] = (uint8_t)i;
+        } else if (i < 320) {
+            buf[i] = (i & 1) ? 0xaa : 0x55;
+        } else if (i < 352) {
+            buf[i] = 0x00;
+        } else {
+            buf[i] = 0xff;
+        }
+    }
+}
+
+void link_baud_init(frame_proto_encoder_t *enc) {
+    link_baud_divisor_t base;
+
+    memset(&s_link_baud, 0, sizeof(s_link_baud));
+    s_link_baud.enc = enc;
+    link_baud_divisor(LINK_BAUD_BASE, USART1_FrequencyGet(), &base);
+    s_link_baud.current = base;
+    start_switch(&base, LINK_BAUD_STATE_IDLE);
+}
+
+void link_baud_step(void) {
+    link_baud_ctx_t *ctx = &s_link_baud;
+
+    switch (ctx->state) {
+
+    case LINK_BAUD_STATE_DRAIN: {
+        if (!USART1_TransmitComplete()) {
+            // The divisor must not change mid-byte.  A trial can be given
+            // up at the current rate, which the host returns to when the
+            // trial times out; a return to a previous rate has to wait.
+            if (ctx->next_state == LINK_BAUD_STATE_TRIAL &&
+                elapsed(ctx->started_at, DRAIN_TIMEOUT_MS)) {
+                ctx->state = LINK_BAUD_STATE_IDLE;
+                printf("# link: transmitter busy, %ld baud trial "
+                       "abandoned\r\n",
+                       ctx->pending.baud);
+            }
+            break;
+        }
+        const link_baud_divisor_t *div = &ctx->pending;
+        USART1_BaudDivisorSet(div->cd, div->fp, div->over8);
+        ctx->current = *div;
+        ctx->state = ctx->next_state;
+        ctx->started_at = SYS_TIME_CounterGet();
+        ctx->pattern_ok = false;
+        ctx->keepalive_at = ctx->started_at;
+        reset_error_window();
+    } break;
+
+    case LINK_BAUD_STATE_TRIAL: {
+        if (elapsed(ctx->started_at, LINK_BAUD_TRIAL_MS)) {
+            // The host gives up at the same time
+            start_switch(&ctx->previous, LINK_BAUD_STATE_IDLE);
+        }
+    } break;
+
+    case LINK_BAUD_STATE_IDLE: {
+        if (ctx->current.baud == LINK_BAUD_BASE) {
+            // Nothing slower to fall back to
+            break;
+        }
+        if (elapsed(ctx->keepalive_at, KEEPALIVE_TIMEOUT_MS)) {
+            fall_back("no keepalive");
+        } else if (elapsed(ctx->window_at, LINK_BAUD_ERROR_WINDOW_MS)) {
+            uint32_t errors = ctx->window_errors +
+                              (USART1_ReadErrorCountGet() - ctx->rx_errors);
+            if (errors >= LINK_BAUD_ERROR_BURST) {
+                fall_back("error burst");
+            } else {
+                reset_error_window();
+            }
+        }
+    } break;
+    }
+}
+
+void link_baud_on_message(const frame_proto_msg_t *msg) {
+    link_baud_ctx_t *ctx = &s_link_baud;
+    const uint8_t *p = msg->payload;
+
+    if (msg->type != FRAME_PROTO_TYPE_LINK || msg->length < 1) {
+        return;
+    }
+
+    switch (p[0]) {
+
+    case LINK_BAUD_OP_PROPOSE: {
+        link_baud_divisor_t div;
+        if (msg->length < 5) {
+            break;
+        }
+        uint32_t baud = get_u32(&p[1]);
+        if (ctx->state != LINK_BAUD_STATE_IDLE ||
+            !link_baud_divisor(baud, USART1_FrequencyGet(), &div)) {
+            send_op(LINK_BAUD_OP_REJECT, baud);
+            break;
+        }
+        uint8_t accept[ACCEPT_SIZE];
+        accept[0] = LINK_BAUD_OP_ACCEPT;
+        put_u32(&accept[1], div.baud);
+        put_u32(&accept[5], div.actual);
+        accept[9] = (uint8_t)div.cd;
+        accept[10] = (uint8_t)(div.cd >> 8);
+        accept[11] = div.fp;
+        accept[12] = div.over8 ? 8 : 16;
+        frame_proto_send(ctx->enc, FRAME_PROTO_TYPE_LINK, 0, accept,
+                         sizeof(accept));
+        ctx->previous = ctx->current;
+        start_switch(&div, LINK_BAUD_STATE_TRIAL);
+    } break;
+
+    case LINK_BAUD_OP_PATTERN: {
+        uint8_t pattern[LINK_BAUD_PATTERN_SIZE];
+        if (ctx->state != LINK_BAUD_STATE_TRIAL ||
+            msg->length != 1 + LINK_BAUD_PATTERN_SIZE) {
+            break;
+        }
+        link_baud_pattern(pattern);
+        if (memcmp(&p[1], pattern, sizeof(pattern)) == 0) {
+            ctx->pattern_ok = true;
+            frame_proto_send(ctx->enc, FRAME_PROTO_TYPE_LINK, 0, p,
+                             msg->length);
+        }
+    } break;
+
+    case LINK_BAUD_OP_COMMIT: {
+        if (ctx->state != LINK_BAUD_STATE_TRIAL || !ctx->pattern_ok) {
+            break;
+        }
+        ctx->state = LINK_BAUD_STATE_IDLE;
+        ctx->keepalive_at = SYS_TIME_CounterGet();
+        reset_error_window();
+        send_op(LINK_BAUD_OP_LOCKED, ctx->current.baud);
+        printf("# link: %ld baud (CD %d, FP %d, %dx)\r\n", ctx->current.actual,
+               ctx->current.cd, ctx->current.fp, ctx->current.over8 ? 8 : 16);
+    } break;
+
+    case LINK_BAUD_OP_KEEPALIVE: {
+        if (msg->length < 5) {
+            break;
+        }
+        ctx->keepalive_at = SYS_TIME_CounterGet();
+        ctx->window_errors += get_u32(&p[1]);
+    } break;
+
+    default:
+        break;
+    }
+}
+
+bool link_baud_busy(void) {
+    return s_link_baud.state != LINK_BAUD_STATE_IDLE;
+}
+
+uint32_t link_baud_rate(void) { return s_link_baud.current.baud; }
+
+// *****************************************************************************
+// Private (static) code
+
+static bool elapsed(uint32_t then, uint32_t ms) {
+    return SYS_TIME_CounterGet() - then >= SYS_TIME_MSToCount(ms);
+}
+
+static void start_switch(const link_baud_divisor_t *div,
+                         link_baud_state_t next_state) {
+    s_link_baud.pending = *div;
+    s_link_baud.next_state = next_state;
+    s_link_baud.state = LINK_BAUD_STATE_DRAIN;
+    s_link_baud.started_at = SYS_TIME_CounterGet();
+}
+
+static void fall_back(const char *reason) {
+    link_baud_divisor_t base;
+
+    printf("# link: %s at %ld baud, falling back\r\n", reason,
+           s_link_baud.current.baud);
+    send_op(LINK_BAUD_OP_FALLBACK, LINK_BAUD_BASE);
+    link_baud_divisor(LINK_BAUD_BASE, USART1_FrequencyGet(), &base);
+    start_switch(&base, LINK_BAUD_STATE_IDLE);
+}
+
+static void send_op(link_baud_op_t op, uint32_t value) {
+    uint8_t payload[5];
+    payload[0] = (uint8_t)op;
+    put_u32(&payload[1], value);
+    frame_proto_send(s_link_baud.enc, FRAME_PROTO_TYPE_LINK, 0, payload,
+                     sizeof(payload));
+}
+
+static void reset_error_window(void) {
+    s_link_baud.window_at = SYS_TIME_CounterGet();
+    s_link_baud.window_errors = 0;
+    s_link_baud.rx_errors = USART1_ReadErrorCountGet();
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
@@ -0,0 +1,175 @@
+/**
+ * @file link_baud.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Negotiate the fastest console baud rate that the host's USB-serial
+ * adapter handles reliably.
+ *
+ * The link starts at, and falls back to, LINK_BAUD_BASE.  The host drives
+ * the negotiation with FRAME_PROTO_TYPE_LINK messages (see frame_proto.h),
+ * trying the rates its adapter supports, fastest first:
+ *
+ *   host                          firmware
+ *   PROPOSE baud           ->
+ *                          <-     ACCEPT baud, divisor (or REJECT baud)
+ *   both sides switch to the proposed rate once the ACCEPT has been sent
+ *   PATTERN                ->
+ *                          <-     PATTERN (echoed)
+ *   COMMIT                 ->
+ *                          <-     LOCKED baud
+ *
+ * If the trial doesn't complete within LINK_BAUD_TRIAL_MS, both sides
+ * return to the previous rate and the host proposes its next candidate.
+ *
+ * While locked above the base rate, the host sends KEEPALIVE every
+ * LINK_BAUD_KEEPALIVE_MS with the number of errors it saw since the last
+ * one.  The firmware sends FALLBACK and returns to the base rate if the
+ * keepalives stop, or if either side sees LINK_BAUD_ERROR_BURST errors
+ * within LINK_BAUD_ERROR_WINDOW_MS.  The host then renegotiates, starting
+ * below the rate that failed.
+ *
+ * Payloads start with a link_baud_op_t byte.  PROPOSE, REJECT, LOCKED and
+ * FALLBACK are followed by the baud rate (u32), KEEPALIVE by the error count
+ * (u32), PATTERN by the LINK_BAUD_PATTERN_SIZE byte test pattern and ACCEPT
+ * by the baud rate, the rate actually generated (u32), CD (u16), FP (u8) and
+ * the oversampling (u8, 8 or 16).  All little endian.
+ *
+ * tools/link_baud.py implements the host side.
+ */
+
+#ifndef _LINK_BAUD_H_
+#define _LINK_BAUD_H_
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// Rate at startup and after a fallback (CD = 10 at 150 MHz)
+#define LINK_BAUD_BASE 937500
+
+// Largest accepted difference between the proposed and generated rates
+#define LINK_BAUD_MAX_ERROR_PPM 10000
+
+#define LINK_BAUD_TRIAL_MS 500
+#define LINK_BAUD_KEEPALIVE_MS 500
+#define LINK_BAUD_ERROR_WINDOW_MS 1000
+#define LINK_BAUD_ERROR_BURST 16
+
+#define LINK_BAUD_PATTERN_SIZE 384
+
+typedef enum {
+    LINK_BAUD_OP_PROPOSE = 1,
+    LINK_BAUD_OP_ACCEPT = 2,
+    LINK_BAUD_OP_REJECT = 3,
+    LINK_BAUD_OP_PATTERN = 4,
+    LINK_BAUD_OP_COMMIT = 5,
+    LINK_BAUD_OP_LOCKED = 6,
+    LINK_BAUD_OP_KEEPALIVE = 7,
+    LINK_BAUD_OP_FALLBACK = 8,
+} link_baud_op_t;
+
+/**
+ * @brief Baud rate generator setting:
+ *   actual = mck / (oversampling * (cd + fp / 8))
+ */
+typedef struct {
+    uint32_t baud;   // requested rate
+    uint32_t actual; // rate generated
+    uint16_t cd;     // clock divisor
+    uint8_t fp;      // fractional part, eighths
+    bool over8;      // 8x rather than 16x oversampling
+} link_baud_divisor_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Find the baud rate generator setting closest to baud.
+ *
+ * 16x oversampling is preferred, as it tolerates more timing error; 8x is
+ * used where it gets much closer to the requested rate.
+ *
+ * @return false if no setting is within LINK_BAUD_MAX_ERROR_PPM.
+ */
+bool link_baud_divisor(uint32_t baud, uint32_t mck, link_baud_divisor_t *div);
+
+/**
+ * @brief Fill buf with the LINK_BAUD_PATTERN_SIZE byte test pattern: every
+ * byte value, then alternating bits, then runs of zeros and ones.
+ */
+void link_baud_pattern(uint8_t *buf);
+
+/**
+ * @brief One-time initialization, to be called at startup.  Messages are
+ * sent through enc.
+ */
+void link_baud_init(frame_proto_encoder_t *enc);
+
+/**
+ * @brief Run the rate switching and fallback timers.  Call repeatedly from
+ * the main superloop.
+ */
+void link_baud_step(void);
+
+/**
+ * @brief Handle a FRAME_PROTO_TYPE_LINK message from the host.
+ */
+void link_baud_on_message(const frame_proto_msg_t *msg);
+
+/**
+ * @brief Return true while a rate change is in progress.  Hold all output
+ * but link control and replies meanwhile: the switch waits for the
+ * transmitter to drain, and the divisor is never changed mid-byte.  A trial
+ * whose switch can't drain in time is abandoned at the current rate.
+ */
+bool link_baud_busy(void);
+
+/**
+ * @brief Return the current baud rate as requested by the host.
+ */
+uint32_t link_baud_rate(void);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _LINK_BAUD_H_ */
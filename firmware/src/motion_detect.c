@@ -0,0 +1,171 @@
+/**
+ * @file motion_detect.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "motion_detect.h"
+
+#include "definitions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_THRESHOLD 12   // mean |difference| per pixel
+#define DEFAULT_MIN_BLOCKS 2   // ignore single-block noise
+#define DEFAULT_UPDATE_SHIFT 3 // background time constant of ~8 frames
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the SAD of one block against the background.
+ */
+static uint32_t block_sad(const motion_detect_t *md, const uint8_t *y_plane,
+                          uint16_t bx, uint16_t by);
+
+/**
+ * @brief Move the background toward the frame.
+ */
+static void update_background(motion_detect_t *md, const uint8_t *y_plane);
+
+// *****************************************************************************
+// Public code
+
+void motion_detect_default_config(motion_detect_config_t *config,
+                                  uint16_t width, uint16_t height) {
+    config->width = width;
+    config->height = height;
+    config->threshold = DEFAULT_THRESHOLD;
+    config->min_blocks = DEFAULT_MIN_BLOCKS;
+    config->update_shift = DEFAULT_UPDATE_SHIFT;
+}
+
+bool motion_detect_init(motion_detect_t *md,
+                        const motion_detect_config_t *config,
+                        uint8_t *background) {
+    if (config->width == 0 || config->height == 0 ||
+        config->width % MOTION_DETECT_BLOCK_SIZE != 0 ||
+        config->height % MOTION_DETECT_BLOCK_SIZE != 0 ||
+        config->width > MOTION_DETECT_MAX_WIDTH ||
+        config->height > MOTION_DETECT_MAX_HEIGHT) {
+        return false;
+    }
+    md->config = *config;
+    md->background = background;
+    md->primed = false;
+    md->blocks_x = config->width / MOTION_DETECT_BLOCK_SIZE;
+    md->blocks_y = config->height / MOTION_DETECT_BLOCK_SIZE;
+    md->moving_blocks = 0;
+    md->motion = false;
+    memset(md->bitmap, 0, sizeof(md->bitmap));
+    return true;
+}
+
+bool motion_detect_update(motion_detect_t *md, const uint8_t *y_plane) {
+    size_t n_pixels = md->config.width * md->config.height;
+
+    if (!md->primed) {
+        // nothing to compare against: seed the background, report motion
+        memcpy(md->background, y_plane, n_pixels);
+        md->primed = true;
+        memset(md->bitmap, 0xff, sizeof(md->bitmap));
+        md->moving_blocks = md->blocks_x * md->blocks_y;
+        md->motion = true;
+        return true;
+    }
+
+    uint32_t limit = (uint32_t)md->config.threshold * MOTION_DETECT_BLOCK_SIZE *
+                     MOTION_DETECT_BLOCK_SIZE;
+    uint16_t moving = 0;
+    memset(md->bitmap, 0, sizeof(md->bitmap));
+    for (uint16_t by = 0; by < md->blocks_y; by++) {
+        for (uint16_t bx = 0; bx < md->blocks_x; bx++) {
+            if (block_sad(md, y_plane, bx, by) > limit) {
+                uint32_t bit = by * md->blocks_x + bx;
+                md->bitmap[bit / 32] |= 1UL << (bit % 32);
+                moving++;
+            }
+        }
+    }
+    md->moving_blocks = moving;
+    md->motion = moving >= md->config.min_blocks;
+
+    update_background(md, y_plane);
+    return md->motion;
+}
+
+bool motion_detect_block_moved(const motion_detect_t *md, uint16_t bx,
+                               uint16_t by) {
+    uint32_t bit = by * md->blocks_x + bx;
+    return (md->bitmap[bit / 32] & (1UL << (bit % 32))) != 0;
+}
+
+const uint32_t *motion_detect_bitmap(const motion_detect_t *md) {
+    return md->bitmap;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint32_t block_sad(const motion_detect_t *md, const uint8_t *y_plane,
+                          uint16_t bx, uint16_t by) {
+    size_t stride = md->config.width;
+    size_t offset = (by * stride + bx) * MOTION_DETECT_BLOCK_SIZE;
+    const uint8_t *cur = y_plane + offset;
+    const uint8_t *ref = md->background + offset;
+    uint32_t sad = 0;
+
+    for (int row = 0; row < MOTION_DETECT_BLOCK_SIZE; row++) {
+        // 8 pixels per row: two words, four absolute differences each
+        sad = __USADA8(__UNALIGNED_UINT32_READ(cur),
+                       __UNALIGNED_UINT32_READ(ref), sad);
+        sad = __USADA8(__UNALIGNED_UINT32_READ(cur + 4),
+                       __UNALIGNED_UINT32_READ(ref + 4), sad);
+        cur += stride;
+        ref += stride;
+    }
+    return sad;
+}
+
+static void update_background(motion_detect_t *md, const uint8_t *y_plane) {
+    size_t n_pixels = md->config.width * md->config.height;
+    int32_t divisor = 1 << md->config.update_shift;
+    uint8_t *bg = md->background;
+
+    for (size_t i = 0; i < n_pixels; i++) {
+        // division truncates toward zero, so the background settles within
+        // divisor - 1 of a static scene instead of creeping in one direction
+        bg[i] += ((int32_t)y_plane[i] - bg[i]) / divisor;
+    }
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,143 @@
+/**
+ * @file motion_detect.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Block-based motion detection on the luma plane.
+ *
+ * Each frame's Y plane is divided into MOTION_DETECT_BLOCK_SIZE square
+ * blocks.  The sum of absolute differences (SAD) of each block against a
+ * background image is computed with __USADA8, four pixels per instruction.
+ * A block whose mean absolute difference exceeds the threshold is marked as
+ * moving in a per-frame bitmap, and the frame as a whole has motion when at
+ * least min_blocks blocks are moving.
+ *
+ * The background is a running average of past frames:
+ *   background += (frame - background) / 2^update_shift
+ * so lighting drift and objects that stop moving are absorbed over roughly
+ * 2^update_shift frames.  The first frame seeds the background and is
+ * reported as motion so that it is always processed.
+ *
+ * Callers use the result to skip conversion, inference or transmission of
+ * static frames, or to process only the moving blocks.
+ */
+
+#ifndef _MOTION_DETECT_H_
+#define _MOTION_DETECT_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define MOTION_DETECT_BLOCK_SIZE 8
+#define MOTION_DETECT_MAX_WIDTH 224
+#define MOTION_DETECT_MAX_HEIGHT 224
+#define MOTION_DETECT_MAX_BLOCKS                                               \
+    ((MOTION_DETECT_MAX_WIDTH / MOTION_DETECT_BLOCK_SIZE) *                    \
+     (MOTION_DETECT_MAX_HEIGHT / MOTION_DETECT_BLOCK_SIZE))
+
+typedef struct {
+    uint16_t width;       // image width, a multiple of the block size
+    uint16_t height;      // image height, a multiple of the block size
+    uint8_t threshold;    // mean absolute difference that marks a block
+    uint16_t min_blocks;  // moving blocks needed to flag the frame
+    uint8_t update_shift; // background adapts at 1 / 2^update_shift
+} motion_detect_config_t;
+
+typedef struct {
+    motion_detect_config_t config;
+    uint8_t *background;    // width * height bytes, owned by the caller
+    bool primed;            // background holds a frame
+    uint16_t blocks_x;      // blocks per row
+    uint16_t blocks_y;      // blocks per column
+    uint16_t moving_blocks; // number of bits set in bitmap
+    bool motion;            // moving_blocks >= min_blocks
+    // bit (by * blocks_x + bx) set for each moving block
+    uint32_t bitmap[(MOTION_DETECT_MAX_BLOCKS + 31) / 32];
+} motion_detect_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in a config structure with defaults for a width x height
+ * image.
+ */
+void motion_detect_default_config(motion_detect_config_t *config,
+                                  uint16_t width, uint16_t height);
+
+/**
+ * @brief Initialize a motion detector.
+ *
+ * @param background Buffer of width * height bytes for the background.
+ * @return false if the size isn't a multiple of the block size or exceeds
+ * the maximum.
+ */
+bool motion_detect_init(motion_detect_t *md,
+                        const motion_detect_config_t *config,
+                        uint8_t *background);
+
+/**
+ * @brief Compare a frame's Y plane against the background, update the
+ * motion bitmap and then the background.
+ *
+ * @param y_plane width * height luma bytes.  Need not be word aligned.
+ * @return true if the frame has motion.
+ */
+bool motion_detect_update(motion_detect_t *md, const uint8_t *y_plane);
+
+/**
+ * @brief Return true if block (bx, by) moved in the last frame.
+ */
+bool motion_detect_block_moved(const motion_detect_t *md, uint16_t bx,
+                               uint16_t by);
+
+/**
+ * @brief Return the motion bitmap of the last frame: bit (by * blocks_x +
+ * bx) is set for each moving block.
+ */
+const uint32_t *motion_detect_bitmap(const motion_detect_t *md);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _MOTION_DETECT_H_ */
@@ -37,19 +37,60 @@
 
 #define OV2640_I2C_ADDR (0x60 >> 1)
 
+// One slot per transfer the driver can hold in its queue
+#define OV2640_I2C_MAX_PENDING DRV_I2C_QUEUE_SIZE_IDX0
+
+/**
+ * @brief Maps a queued driver transfer to its completion callback.
+ */
+typedef struct {
+    DRV_I2C_TRANSFER_HANDLE handle; // DRV_I2C_TRANSFER_HANDLE_INVALID if free
+    ov2640_i2c_cb_t cb;
+    uintptr_t context;
+    bool adding;  // the driver call that queues this transfer has not returned
+    bool retired; // the driver retired the transfer during that call
+} ov2640_i2c_pending_t;
+
 // *****************************************************************************
 // Private (static, forward) declarations
 
+/**
+ * @brief Claim a free pending slot.  Call with interrupts disabled.
+ */
+static ov2640_i2c_pending_t *alloc_pending(ov2640_i2c_cb_t cb, uintptr_t context);
+
+/**
+ * @brief Finish the driver call that queued a pending transfer and report
+ * whether the driver accepted it.  A transfer the driver retired at once
+ * (because the PLIB would not start it) was accepted: its callback has
+ * already reported the failure.  Call with interrupts disabled.
+ */
+static bool pending_queued(ov2640_i2c_pending_t *pending);
+
+/**
+ * @brief DRV_I2C event handler: dispatch to the per-transfer callback.
+ */
+static void transfer_event_handler(DRV_I2C_TRANSFER_EVENT event,
+                                   DRV_I2C_TRANSFER_HANDLE handle,
+                                   uintptr_t context);
+
 // *****************************************************************************
 // Private (static) storage
 
 static DRV_HANDLE s_i2c_handle;
 
+static ov2640_i2c_pending_t s_pending[OV2640_I2C_MAX_PENDING];
+
 // *****************************************************************************
 // Public code
 
 void ov2640_i2c_init(DRV_HANDLE i2c_handle) {
 	s_i2c_handle = i2c_handle;
+    for (int i = 0; i < OV2640_I2C_MAX_PENDING; i++) {
+        s_pending[i].handle = DRV_I2C_TRANSFER_HANDLE_INVALID;
+        s_pending[i].adding = false;
+    }
+    DRV_I2C_TransferEventHandlerSet(s_i2c_handle, transfer_event_handler, 0);
 }
 
 bool ov2640_i2c_read_byte(uint8_t addr, uint8_t *data) {
@@ -69,13 +110,12 @@ bool ov2640_i2c_write_byte(uint8_t addr, uint8_t data) {
 }
 
 bool ov2640_i2c_write_pairs(const ov2640_i2c_pair_t *pairs, size_t count) {
-	for (int i=0; i<count; i++) {
-		const ov2640_i2c_pair_t *pair = &pairs[i];
-		if (!ov2640_i2c_write_byte(pair->addr, pair->data)) {
-			return false;
-		}
-	}
-    return true;
+    // ov2640_i2c_pair_t is laid out as {addr, data} bytes, which is the form
+    // the TWIHS0 PLIB expects.  The whole list goes out as one driver transfer
+    // with the PLIB chaining pairs from its interrupt handler.
+    bool success = DRV_I2C_WritePairsTransfer(s_i2c_handle, OV2640_I2C_ADDR,
+                                              (void *)pairs, count);
+    return success;
 }
 
 bool ov2640_i2c_select_bank(ov2640_i2c_bank_t bank) {
@@ -84,9 +124,83 @@ bool ov2640_i2c_select_bank(ov2640_i2c_bank_t bank) {
 	return ov2640_i2c_write_byte(0xff, (bank == OV2640_I2C_DSP_BANK ? 0 : 1));
 }
 
+bool ov2640_i2c_write_pairs_async(const ov2640_i2c_pair_t *pairs, size_t count,
+                                  ov2640_i2c_cb_t cb, uintptr_t context) {
+    bool int_state = SYS_INT_Disable();
+    ov2640_i2c_pending_t *pending = alloc_pending(cb, context);
+    if (pending != NULL) {
+        // The handle is stored before the driver can complete the transfer
+        DRV_I2C_WritePairsTransferAdd(s_i2c_handle, OV2640_I2C_ADDR,
+                                      (void *)pairs, count, &pending->handle);
+    }
+    bool queued = pending_queued(pending);
+    SYS_INT_Restore(int_state);
+    return queued;
+}
+
+bool ov2640_i2c_read_byte_async(const uint8_t *addr, uint8_t *data,
+                                ov2640_i2c_cb_t cb, uintptr_t context) {
+    bool int_state = SYS_INT_Disable();
+    ov2640_i2c_pending_t *pending = alloc_pending(cb, context);
+    if (pending != NULL) {
+        DRV_I2C_WriteReadTransferAdd(s_i2c_handle, OV2640_I2C_ADDR,
+                                     (void *)addr, sizeof(uint8_t),
+                                     (void *)data, sizeof(uint8_t),
+                                     &pending->handle);
+    }
+    bool queued = pending_queued(pending);
+    SYS_INT_Restore(int_state);
+    return queued;
+}
+
 // *****************************************************************************
 // Private (static) code
 
+static ov2640_i2c_pending_t *alloc_pending(ov2640_i2c_cb_t cb, uintptr_t context) {
+    for (int i = 0; i < OV2640_I2C_MAX_PENDING; i++) {
+        ov2640_i2c_pending_t *pending = &s_pending[i];
+        // a slot whose callback is queueing a follow-up is not free yet
+        if (pending->handle == DRV_I2C_TRANSFER_HANDLE_INVALID &&
+            !pending->adding) {
+            pending->cb = cb;
+            pending->context = context;
+            pending->adding = true;
+            pending->retired = false;
+            return pending;
+        }
+    }
+    return NULL;
+}
+
+static bool pending_queued(ov2640_i2c_pending_t *pending) {
+    if (pending == NULL) {
+        return false;
+    }
+    pending->adding = false;
+    return (pending->handle != DRV_I2C_TRANSFER_HANDLE_INVALID) ||
+           pending->retired;
+}
+
+static void transfer_event_handler(DRV_I2C_TRANSFER_EVENT event,
+                                   DRV_I2C_TRANSFER_HANDLE handle,
+                                   uintptr_t context) {
+    (void)context;
+    for (int i = 0; i < OV2640_I2C_MAX_PENDING; i++) {
+        ov2640_i2c_pending_t *pending = &s_pending[i];
+        if (pending->handle == handle) {
+            ov2640_i2c_cb_t cb = pending->cb;
+            uintptr_t cb_context = pending->context;
+            // free the slot first so the callback can queue a follow-up
+            pending->handle = DRV_I2C_TRANSFER_HANDLE_INVALID;
+            pending->retired = pending->adding;
+            if (cb != NULL) {
+                cb(event == DRV_I2C_TRANSFER_EVENT_COMPLETE, cb_context);
+            }
+            return;
+        }
+    }
+}
+
 // *****************************************************************************
 // End of file
 
@@ -38,8 +38,8 @@
  * or write operation.
  */
 
-#ifndef _OV2640_SPI_H_
-#define _OV2640_SPI_H_
+#ifndef _OV2640_I2C_H_
+#define _OV2640_I2C_H_
 
 // *****************************************************************************
 // Includes
@@ -69,6 +69,14 @@ typedef enum {
 	OV2640_I2C_SENSOR_BANK
 } ov2640_i2c_bank_t;
 
+/**
+ * @brief Signature of the function called when a queued transfer finishes.
+ *
+ * Runs in interrupt context (from the TWIHS0 ISR).  It may queue further
+ * transfers but must not block or call the synchronous functions.
+ */
+typedef void (*ov2640_i2c_cb_t)(bool success, uintptr_t context);
+
 // Currently unused, but these macros define which bank the register is in.
 #define OV2640_I2C_DSP_BANK(reg) (reg)
 #define OV2640_I2C_SENSOR_BANK(reg) (reg)
@@ -174,6 +182,28 @@ bool ov2640_i2c_write_pairs(const ov2640_i2c_pair_t *pairs, size_t count);
 
 bool ov2640_i2c_select_bank(ov2640_i2c_bank_t bank);
 
+/**
+ * @brief Queue a write of the given register pairs and return at once.
+ *
+ * cb (may be NULL) is called when the last pair has been written or on the
+ * first error.  pairs must remain valid until then.  Returns false if the
+ * transfer could not be queued, in which case cb is never called.  Once the
+ * transfer is queued, failures (including one to start it) are reported
+ * only through cb, which may run before this returns.
+ */
+bool ov2640_i2c_write_pairs_async(const ov2640_i2c_pair_t *pairs, size_t count,
+                                  ov2640_i2c_cb_t cb, uintptr_t context);
+
+/**
+ * @brief Queue a read of one register and return at once.
+ *
+ * *addr and *data must remain valid until cb (may be NULL) is called.
+ * Returns false if the transfer could not be queued; failures after that are
+ * reported only through cb, as for ov2640_i2c_write_pairs_async().
+ */
+bool ov2640_i2c_read_byte_async(const uint8_t *addr, uint8_t *data,
+                                ov2640_i2c_cb_t cb, uintptr_t context);
+
 // *****************************************************************************
 // End of file
 
@@ -181,4 +211,4 @@ bool ov2640_i2c_select_bank(ov2640_i2c_bank_t bank);
 }
 #endif
 
-#endif /* #ifndef _OV2640_SPI_H_ */
+#endif /* #ifndef _OV2640_I2C_H_ */
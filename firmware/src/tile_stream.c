@@ -0,0 +1,230 @@
+/**
+ * @file tile_stream.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "tile_stream.h"
+
+#include "definitions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAGIC_0 'T'
+#define MAGIC_1 'S'
+
+#define DEFAULT_TILE_SIZE 16
+#define DEFAULT_THRESHOLD 4
+#define DEFAULT_KEY_INTERVAL 64
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the sum of absolute differences between a tile of the frame
+ * and the reference.
+ */
+static uint32_t tile_sad(const tile_stream_t *ts, const uint8_t *yuyv,
+                         size_t offset);
+
+/**
+ * @brief Copy a tile between two frames, or between a frame and a packed
+ * tile when one stride is the tile's row size.
+ */
+static void copy_tile(uint8_t *dst, size_t dst_stride, const uint8_t *src,
+                      size_t src_stride, size_t row_bytes, uint8_t rows);
+
+// *****************************************************************************
+// Public code
+
+void tile_stream_default_config(tile_stream_config_t *config, uint16_t width,
+                                uint16_t height) {
+    config->width = width;
+    config->height = height;
+    config->tile_size = DEFAULT_TILE_SIZE;
+    config->threshold = DEFAULT_THRESHOLD;
+    config->key_interval = DEFAULT_KEY_INTERVAL;
+}
+
+bool tile_stream_init(tile_stream_t *ts, const tile_stream_config_t *config,
+                      uint8_t *reference) {
+    if (config->tile_size == 0 || config->tile_size % 4 != 0 ||
+        config->width % config->tile_size != 0 ||
+        config->height % config->tile_size != 0) {
+        return false;
+    }
+    uint32_t tiles_x = config->width / config->tile_size;
+    uint32_t tiles_y = config->height / config->tile_size;
+    if (tiles_x * tiles_y == 0 || tiles_x * tiles_y > TILE_STREAM_MAX_TILES) {
+        return false;
+    }
+    ts->config = *config;
+    ts->reference = reference;
+    ts->tiles_x = tiles_x;
+    ts->tiles_y = tiles_y;
+    ts->since_key = 0;
+    ts->key_requested = true;
+    ts->last_tiles = 0;
+    return true;
+}
+
+size_t tile_stream_encode(tile_stream_t *ts, const uint8_t *yuyv,
+                          uint8_t *out, size_t out_size) {
+    return tile_stream_encode_candidates(ts, yuyv, NULL, out, out_size);
+}
+
+size_t tile_stream_encode_candidates(tile_stream_t *ts, const uint8_t *yuyv,
+                                     const uint8_t *candidates, uint8_t *out,
+                                     size_t out_size) {
+    const tile_stream_config_t *cfg = &ts->config;
+    size_t stride = (size_t)cfg->width * 2;
+    size_t row_bytes = (size_t)cfg->tile_size * 2;
+    size_t tile_bytes = row_bytes * cfg->tile_size;
+    uint32_t limit = (uint32_t)cfg->threshold * tile_bytes;
+    uint16_t count = 0;
+    size_t n = TILE_STREAM_HEADER_SIZE;
+
+    if (out_size < (size_t)TILE_STREAM_MAX_OUTPUT(cfg->width, cfg->height,
+                                                   cfg->tile_size)) {
+        return 0;
+    }
+
+    bool key = ts->key_requested ||
+               (cfg->key_interval != 0 && ts->since_key >= cfg->key_interval);
+    if (key) {
+        ts->key_requested = false;
+        ts->since_key = 0;
+    }
+    ts->since_key++;
+
+    for (uint8_t ty = 0; ty < ts->tiles_y; ty++) {
+        for (uint8_t tx = 0; tx < ts->tiles_x; tx++) {
+            size_t offset = ty * cfg->tile_size * stride + tx * row_bytes;
+            if (!key && candidates != NULL &&
+                candidates[ty * ts->tiles_x + tx] == 0) {
+                continue;
+            }
+            if (!key && tile_sad(ts, yuyv, offset) <= limit) {
+                continue;
+            }
+            out[n++] = ty * ts->tiles_x + tx;
+            copy_tile(&out[n], row_bytes, &yuyv[offset], stride, row_bytes,
+                      cfg->tile_size);
+            n += tile_bytes;
+            // the receiver now holds this version of the tile
+            copy_tile(&ts->reference[offset], stride, &yuyv[offset], stride,
+                      row_bytes, cfg->tile_size);
+            count++;
+        }
+    }
+
+    out[0] = MAGIC_0;
+    out[1] = MAGIC_1;
+    out[2] = key ? TILE_STREAM_FLAG_KEY : 0;
+    out[3] = cfg->tile_size;
+    out[4] = ts->tiles_x;
+    out[5] = ts->tiles_y;
+    out[6] = count & 0xff;
+    out[7] = count >> 8;
+    ts->last_tiles = count;
+    return n;
+}
+
+void tile_stream_request_key(tile_stream_t *ts) {
+    ts->key_requested = true;
+}
+
+bool tile_stream_apply(const uint8_t *in, size_t in_len, uint8_t *frame,
+                       size_t frame_size) {
+    if (in_len < TILE_STREAM_HEADER_SIZE || in[0] != MAGIC_0 ||
+        in[1] != MAGIC_1 || in[3] == 0) {
+        return false;
+    }
+    uint8_t tile_size = in[3];
+    uint8_t tiles_x = in[4];
+    uint8_t tiles_y = in[5];
+    uint16_t count = in[6] | (in[7] << 8);
+    size_t row_bytes = (size_t)tile_size * 2;
+    size_t stride = row_bytes * tiles_x;
+    size_t tile_bytes = row_bytes * tile_size;
+
+    if (stride * tile_size * tiles_y > frame_size ||
+        in_len != TILE_STREAM_HEADER_SIZE + count * (1 + tile_bytes)) {
+        return false;
+    }
+    in += TILE_STREAM_HEADER_SIZE;
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t index = *in++;
+        if (index >= tiles_x * tiles_y) {
+            return false;
+        }
+        size_t offset = (index / tiles_x) * tile_size * stride +
+                        (index % tiles_x) * row_bytes;
+        copy_tile(&frame[offset], stride, in, row_bytes, row_bytes, tile_size);
+        in += tile_bytes;
+    }
+    return true;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint32_t tile_sad(const tile_stream_t *ts, const uint8_t *yuyv,
+                         size_t offset) {
+    size_t stride = (size_t)ts->config.width * 2;
+    size_t row_bytes = (size_t)ts->config.tile_size * 2;
+    const uint8_t *cur = &yuyv[offset];
+    const uint8_t *ref = &ts->reference[offset];
+    uint32_t sad = 0;
+
+    for (uint8_t y = 0; y < ts->config.tile_size; y++) {
+        // row_bytes is a multiple of 8
+        for (size_t x = 0; x < row_bytes; x += 4) {
+            sad = __USADA8(__UNALIGNED_UINT32_READ(&cur[x]),
+                           __UNALIGNED_UINT32_READ(&ref[x]), sad);
+        }
+        cur += stride;
+        ref += stride;
+    }
+    return sad;
+}
+
+static void copy_tile(uint8_t *dst, size_t dst_stride, const uint8_t *src,
+                      size_t src_stride, size_t row_bytes, uint8_t rows) {
+    for (uint8_t y = 0; y < rows; y++) {
+        memcpy(dst, src, row_bytes);
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+// *****************************************************************************
+// End of file
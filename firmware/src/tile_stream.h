@@ -0,0 +1,170 @@
+/**
+ * @file tile_stream.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Tile-based change streaming of YUYV frames.
+ *
+ * Each frame is split into square tiles.  A tile is sent only if it differs
+ * from the version last sent by more than a threshold, measured as the mean
+ * absolute difference over its bytes (computed with __USADA8).  The
+ * threshold keeps sensor noise from marking every tile as changed; since the
+ * comparison is always against what the receiver holds, the error in any
+ * tile never exceeds the threshold.  Every key_interval frames (and on
+ * request) all tiles are sent so that a receiver can start or resynchronize.
+ *
+ * Tiles are read straight from the captured frame buffer, so only the sent
+ * tiles are copied, into the output and into the reference.
+ *
+ * Update format: an 8 byte header followed by the changed tiles.
+ *   [0..1] magic 'T' 'S'
+ *   [2]    flags: TILE_STREAM_FLAG_KEY for a key frame
+ *   [3]    tile size in pixels
+ *   [4]    tiles per row
+ *   [5]    tiles per column
+ *   [6..7] number of tiles that follow, little endian
+ * Each tile is its index (row major, 1 byte) followed by its rows of
+ * tile_size * 2 YUYV bytes.
+ */
+
+#ifndef _TILE_STREAM_H_
+#define _TILE_STREAM_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define TILE_STREAM_HEADER_SIZE 8
+#define TILE_STREAM_MAX_TILES 256 // tile index is one byte
+
+#define TILE_STREAM_FLAG_KEY 0x01
+
+// Largest update: every tile plus its index.
+#define TILE_STREAM_MAX_OUTPUT(width, height, tile_size)                       \
+    (TILE_STREAM_HEADER_SIZE +                                                 \
+     ((width) / (tile_size)) * ((height) / (tile_size)) *                      \
+         (1 + (tile_size) * (tile_size) * 2))
+
+typedef struct {
+    uint16_t width;        // frame width in pixels, a multiple of tile_size
+    uint16_t height;       // frame height in pixels, a multiple of tile_size
+    uint8_t tile_size;     // tile width and height in pixels, a multiple of 4
+    uint8_t threshold;     // mean absolute difference that marks a change
+    uint16_t key_interval; // frames between key frames, 0 for never
+} tile_stream_config_t;
+
+typedef struct {
+    tile_stream_config_t config;
+    uint8_t *reference;   // the frame as last sent, width * height * 2 bytes
+    uint8_t tiles_x;      // tiles per row
+    uint8_t tiles_y;      // tiles per column
+    uint16_t since_key;   // frames since the last key frame
+    bool key_requested;   // send a key frame next
+    uint16_t last_tiles;  // tiles in the last update (telemetry)
+} tile_stream_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in a config structure with defaults for a width x height
+ * frame: 16 x 16 tiles, a threshold of 4 and a key frame every 64 frames.
+ */
+void tile_stream_default_config(tile_stream_config_t *config, uint16_t width,
+                                uint16_t height);
+
+/**
+ * @brief Initialize a tile stream.  The first update is a key frame.
+ *
+ * @param reference Buffer of width * height * 2 bytes, owned by the caller.
+ * @return false if the configuration is invalid.
+ */
+bool tile_stream_init(tile_stream_t *ts, const tile_stream_config_t *config,
+                      uint8_t *reference);
+
+/**
+ * @brief Encode the tiles of a frame that changed since they were last sent.
+ *
+ * @param yuyv Frame data, width * height * 2 bytes.  Need not be word
+ *   aligned.
+ * @param out Receives the update.
+ * @param out_size Size of out, at least TILE_STREAM_MAX_OUTPUT().
+ * @return Number of bytes written to out (just the header if nothing
+ *   changed), or 0 if out_size is too small.
+ */
+size_t tile_stream_encode(tile_stream_t *ts, const uint8_t *yuyv,
+                          uint8_t *out, size_t out_size);
+
+/**
+ * @brief tile_stream_encode() limited to the tiles a caller knows may have
+ * changed, e.g. those overlapping moving blocks (see motion_detect.h).
+ * Other tiles are not compared or sent unless the update is a key frame, so
+ * a tile left out may drift from the receiver's copy until the next key
+ * frame.
+ *
+ * @param candidates One byte per tile, row major, nonzero if the tile may
+ *   have changed.  NULL to compare every tile.
+ */
+size_t tile_stream_encode_candidates(tile_stream_t *ts, const uint8_t *yuyv,
+                                     const uint8_t *candidates, uint8_t *out,
+                                     size_t out_size);
+
+/**
+ * @brief Make the next update a key frame, e.g. when a receiver has lost
+ * updates.
+ */
+void tile_stream_request_key(tile_stream_t *ts);
+
+/**
+ * @brief Apply an update to a frame held by the receiver.
+ *
+ * @param frame The receiver's frame, width * height * 2 bytes as given in
+ *   the header.
+ * @return false if the update is malformed or doesn't fit frame_size.
+ */
+bool tile_stream_apply(const uint8_t *in, size_t in_len, uint8_t *frame,
+                       size_t frame_size);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _TILE_STREAM_H_ */
@@ -0,0 +1,148 @@
+/**
+ * @file tx_pacer.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "tx_pacer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_MAX_LATENCY_US 100000
+
+// Start, stop and 8 data bits per byte
+#define BITS_PER_BYTE 10
+
+// Each measurement moves the estimate 1/2^RATE_SHIFT of the way
+#define RATE_SHIFT 2
+
+// The estimate never drops below this fraction of the link rate, so that a
+// bad measurement can't stop the stream for long
+#define MIN_RATE_DIVISOR 16
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the time for the queue to drain n bytes, in us.
+ */
+static uint32_t drain_us(const tx_pacer_t *pacer, uint32_t n);
+
+// *****************************************************************************
+// Public code
+
+void tx_pacer_default_config(tx_pacer_config_t *config, uint32_t baud) {
+    config->max_latency_us = DEFAULT_MAX_LATENCY_US;
+    config->link_rate = baud / BITS_PER_BYTE;
+}
+
+void tx_pacer_init(tx_pacer_t *pacer, const tx_pacer_config_t *config) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->config = *config;
+    pacer->rate = config->link_rate;
+    pacer->last = TX_PACER_SKIP;
+}
+
+void tx_pacer_set_link_rate(tx_pacer_t *pacer, uint32_t baud) {
+    uint32_t link_rate = baud / BITS_PER_BYTE;
+    if (link_rate != pacer->config.link_rate) {
+        pacer->config.link_rate = link_rate;
+        pacer->rate = link_rate;
+    }
+}
+
+void tx_pacer_update(tx_pacer_t *pacer, uint32_t elapsed_us, uint32_t pending) {
+    uint32_t offered = pacer->pending + pacer->written;
+
+    // Only a queue that never ran dry measures the link: otherwise the link
+    // was idle for part of the interval.
+    if (elapsed_us > 0 && pending > 0 && offered >= pending) {
+        uint64_t drained = offered - pending;
+        uint32_t sample = (uint32_t)((drained * 1000000) / elapsed_us);
+        uint32_t min_rate = pacer->config.link_rate / MIN_RATE_DIVISOR;
+        int32_t step = ((int32_t)sample - (int32_t)pacer->rate) >> RATE_SHIFT;
+        pacer->rate += step;
+        if (pacer->rate > pacer->config.link_rate) {
+            pacer->rate = pacer->config.link_rate;
+        } else if (pacer->rate < min_rate) {
+            pacer->rate = min_rate;
+        }
+    }
+    pacer->pending = pending;
+    pacer->written = 0;
+}
+
+tx_pacer_decision_t tx_pacer_decide(tx_pacer_t *pacer, uint32_t full_size,
+                                    uint32_t decimated_size, uint32_t free) {
+    uint32_t sizes[TX_PACER_SKIP] = {
+        [TX_PACER_FULL] = full_size,
+        [TX_PACER_DECIMATED] = decimated_size,
+    };
+    uint32_t queued = pacer->pending + pacer->written;
+    tx_pacer_decision_t decision = TX_PACER_SKIP;
+
+    for (int i = 0; i < TX_PACER_SKIP; i++) {
+        if (sizes[i] != 0 && sizes[i] <= free &&
+            drain_us(pacer, queued + sizes[i]) <=
+                pacer->config.max_latency_us) {
+            decision = (tx_pacer_decision_t)i;
+            break;
+        }
+    }
+    pacer->counts[decision]++;
+    pacer->last = decision;
+    return decision;
+}
+
+void tx_pacer_sent(tx_pacer_t *pacer, uint32_t n) { pacer->written += n; }
+
+uint32_t tx_pacer_latency_us(const tx_pacer_t *pacer) {
+    return drain_us(pacer, pacer->pending + pacer->written);
+}
+
+bool tx_pacer_fits(const tx_pacer_t *pacer, uint32_t n) {
+    return drain_us(pacer, n) <= pacer->config.max_latency_us;
+}
+
+void tx_pacer_reset_counts(tx_pacer_t *pacer) {
+    memset(pacer->counts, 0, sizeof(pacer->counts));
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint32_t drain_us(const tx_pacer_t *pacer, uint32_t n) {
+    if (pacer->rate == 0) {
+        return UINT32_MAX;
+    }
+    uint64_t us = ((uint64_t)n * 1000000) / pacer->rate;
+    return us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+}
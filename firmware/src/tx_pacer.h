@@ -0,0 +1,145 @@
+/**
+ * @file tx_pacer.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Per-frame choice of what to send over a link slower than the
+ * camera.
+ *
+ * The pacer estimates the rate at which the transmit queue drains from the
+ * queue depth it is shown each frame, and picks the best representation of
+ * the frame that will be delivered within max_latency_us of being queued:
+ * the full frame, a decimated one, or nothing.  Capture never has to wait
+ * for the link, and the queue never holds more than max_latency_us of data,
+ * which bounds the delay from capture to display.
+ *
+ * The module has no hardware dependencies: the caller supplies the queue
+ * depth and timing.
+ */
+
+#ifndef _TX_PACER_H_
+#define _TX_PACER_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+/**
+ * @brief What to send for a frame, best first.
+ */
+typedef enum {
+    TX_PACER_FULL,      // the full frame
+    TX_PACER_DECIMATED, // a reduced frame
+    TX_PACER_SKIP,      // nothing
+    TX_PACER_N_DECISIONS,
+} tx_pacer_decision_t;
+
+typedef struct {
+    uint32_t max_latency_us; // longest time a frame may wait in the queue
+    uint32_t link_rate;      // link capacity, bytes/s
+} tx_pacer_config_t;
+
+typedef struct {
+    tx_pacer_config_t config;
+    uint32_t rate;          // estimated drain rate, bytes/s
+    uint32_t pending;       // queue depth at the last update
+    uint32_t written;       // bytes queued since the last update
+    uint32_t counts[TX_PACER_N_DECISIONS]; // decisions since reset
+    tx_pacer_decision_t last; // most recent decision
+} tx_pacer_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in the defaults for a link of baud bits/s (8N1).
+ */
+void tx_pacer_default_config(tx_pacer_config_t *config, uint32_t baud);
+
+void tx_pacer_init(tx_pacer_t *pacer, const tx_pacer_config_t *config);
+
+/**
+ * @brief Change the link capacity, e.g. after the baud rate changes.  The
+ * drain rate estimate restarts from the new capacity.
+ */
+void tx_pacer_set_link_rate(tx_pacer_t *pacer, uint32_t baud);
+
+/**
+ * @brief Update the drain rate estimate.
+ *
+ * @param elapsed_us Time since the previous update (0 to skip the rate
+ *   measurement, e.g. on the first frame).
+ * @param pending Bytes now waiting in the transmit queue.
+ */
+void tx_pacer_update(tx_pacer_t *pacer, uint32_t elapsed_us, uint32_t pending);
+
+/**
+ * @brief Choose what to send for a frame.
+ *
+ * @param full_size, decimated_size Bytes each choice would queue, or 0 if
+ *   it isn't available.
+ * @param free Space in the transmit queue.
+ */
+tx_pacer_decision_t tx_pacer_decide(tx_pacer_t *pacer, uint32_t full_size,
+                                    uint32_t decimated_size, uint32_t free);
+
+/**
+ * @brief Account for n bytes queued, whether frame data or anything else.
+ */
+void tx_pacer_sent(tx_pacer_t *pacer, uint32_t n);
+
+/**
+ * @brief Return the queueing delay of the current queue, in us.
+ */
+uint32_t tx_pacer_latency_us(const tx_pacer_t *pacer);
+
+/**
+ * @brief Return true if n bytes would be sent within max_latency_us of an
+ * empty queue.  If not, waiting for the queue to drain won't make room.
+ */
+bool tx_pacer_fits(const tx_pacer_t *pacer, uint32_t n);
+
+void tx_pacer_reset_counts(tx_pacer_t *pacer);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _TX_PACER_H_ */
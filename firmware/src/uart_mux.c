@@ -0,0 +1,371 @@
+/**
+ * @file uart_mux.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "uart_mux.h"
+
+#include "frame_proto.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// Enough to cover a pass of the superloop that processes a frame
+#define DEFAULT_WINDOW_US 5000
+
+// 256 bytes take 2.7 ms at the base rate of 937500 baud
+#define DEFAULT_FRAGMENT_SIZE 256
+
+// Start, stop and 8 data bits per byte
+#define BITS_PER_BYTE 10
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief frame_proto write function: queue bytes on a channel.  Each
+ * message starts with its header, which gives its size.
+ */
+static size_t queue_write(const void *data, size_t n, uintptr_t context);
+
+/**
+ * @brief Start a record of size bytes, or start dropping it if it doesn't
+ * fit.
+ */
+static void begin_record(uart_mux_queue_t *q, uint32_t size);
+
+/**
+ * @brief Add bytes to the open record.  Returns the number accepted.
+ */
+static size_t append(uart_mux_queue_t *q, const void *data, size_t n);
+
+/**
+ * @brief Copy n bytes into or out of the ring at index at, wrapping.
+ */
+static void ring_put(uart_mux_queue_t *q, uint32_t at, const void *data,
+                     uint32_t n);
+static void ring_get(const uart_mux_queue_t *q, uint32_t at, void *data,
+                     uint32_t n);
+
+static uint32_t ring_used(const uart_mux_queue_t *q);
+static uint32_t ring_free(const uart_mux_queue_t *q);
+
+/**
+ * @brief Return the highest priority queue with a complete record to send,
+ * or NULL.
+ */
+static uart_mux_queue_t *next_queue(uart_mux_t *mux, uint32_t pending);
+
+/**
+ * @brief Hand the oldest record of a queue to the sink.  Returns its size.
+ */
+static uint32_t send_record(uart_mux_t *mux, uart_mux_queue_t *q);
+
+/**
+ * @brief Write n bytes from the ring at index at to the sink.
+ */
+static void sink_from_ring(uart_mux_t *mux, const uart_mux_queue_t *q,
+                           uint32_t at, uint32_t n);
+
+/**
+ * @brief Account for the messages the sink has finished sending.
+ */
+static void retire(uart_mux_t *mux, uint32_t sent, uint32_t now);
+
+static void put_u32(uint8_t *p, uint32_t v);
+static uint32_t get_u32(const uint8_t *p);
+
+// *****************************************************************************
+// Public code
+
+void uart_mux_default_config(uart_mux_config_t *config, uint32_t baud) {
+    config->window_us = DEFAULT_WINDOW_US;
+    config->fragment_size = DEFAULT_FRAGMENT_SIZE;
+    config->link_rate = baud / BITS_PER_BYTE;
+}
+
+void uart_mux_init(uart_mux_t *mux, const uart_mux_config_t *config,
+                   frame_proto_write_fn_t write, uintptr_t context,
+                   uart_mux_clock_fn_t clock) {
+    memset(mux, 0, sizeof(*mux));
+    mux->config = *config;
+    mux->write = write;
+    mux->context = context;
+    mux->clock = clock;
+    for (int i = 0; i < UART_MUX_N_CHANNELS; i++) {
+        uart_mux_queue_t *q = &mux->queues[i];
+        q->mux = mux;
+        frame_proto_encoder_init(&q->enc, queue_write, (uintptr_t)q);
+    }
+    frame_proto_set_fragment_size(&mux->queues[UART_MUX_BULK].enc,
+                                  config->fragment_size);
+}
+
+void uart_mux_set_queue(uart_mux_t *mux, uart_mux_channel_t channel,
+                        uint8_t *buf, uint32_t size) {
+    uart_mux_queue_t *q = &mux->queues[channel];
+    q->buf = buf;
+    q->size = size;
+    q->in = 0;
+    q->committed = 0;
+    q->out = 0;
+    q->open = 0;
+    q->waiting = 0;
+}
+
+frame_proto_encoder_t *uart_mux_encoder(uart_mux_t *mux,
+                                        uart_mux_channel_t channel) {
+    return &mux->queues[channel].enc;
+}
+
+size_t uart_mux_write_text(uart_mux_t *mux, const void *text, size_t n) {
+    frame_proto_encoder_t *enc = &mux->queues[UART_MUX_LOG].enc;
+    if (n == 0) {
+        return 0;
+    }
+    return frame_proto_send(enc, FRAME_PROTO_TYPE_LOG, 0, text, (uint32_t)n)
+               ? n
+               : 0;
+}
+
+void uart_mux_pump(uart_mux_t *mux, uint32_t pending) {
+    retire(mux, mux->written - pending, mux->clock());
+
+    uart_mux_queue_t *q;
+    while ((q = next_queue(mux, pending)) != NULL) {
+        pending += send_record(mux, q);
+    }
+}
+
+void uart_mux_hold(uart_mux_t *mux, bool hold) { mux->hold = hold; }
+
+void uart_mux_set_link_rate(uart_mux_t *mux, uint32_t baud) {
+    mux->config.link_rate = baud / BITS_PER_BYTE;
+}
+
+uint32_t uart_mux_cost(const uart_mux_t *mux, uart_mux_channel_t channel,
+                       uint32_t length) {
+    const frame_proto_encoder_t *enc = &mux->queues[channel].enc;
+    if (enc->fragment_size == 0) {
+        return frame_proto_wire_size(enc, length) + UART_MUX_RECORD_OVERHEAD;
+    }
+    return UART_MUX_BULK_COST(length, enc->fragment_size);
+}
+
+uint32_t uart_mux_free(const uart_mux_t *mux, uart_mux_channel_t channel) {
+    return ring_free(&mux->queues[channel]);
+}
+
+uint32_t uart_mux_pending(const uart_mux_t *mux) {
+    uint32_t n = 0;
+    for (int i = 0; i < UART_MUX_N_CHANNELS; i++) {
+        n += mux->queues[i].waiting;
+    }
+    return n;
+}
+
+void uart_mux_reset_latency(uart_mux_t *mux) {
+    for (int i = 0; i < UART_MUX_N_CHANNELS; i++) {
+        uart_mux_stats_t *stats = &mux->queues[i].stats;
+        stats->measured = 0;
+        stats->latency_sum_us = 0;
+        stats->max_latency_us = 0;
+    }
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t queue_write(const void *data, size_t n, uintptr_t context) {
+    uart_mux_queue_t *q = (uart_mux_queue_t *)context;
+
+    if (q->open == 0) {
+        if (n < FRAME_PROTO_HEADER_SIZE) {
+            return 0;
+        }
+        begin_record(q, frame_proto_message_size((const uint8_t *)data));
+    }
+    return append(q, data, n);
+}
+
+static void begin_record(uart_mux_queue_t *q, uint32_t size) {
+    uint8_t header[UART_MUX_RECORD_OVERHEAD];
+
+    q->open = size;
+    q->dropping = ring_free(q) < size + UART_MUX_RECORD_OVERHEAD;
+    if (q->dropping) {
+        q->stats.dropped += size;
+        return;
+    }
+    put_u32(&header[0], q->mux->clock());
+    put_u32(&header[4], size);
+    ring_put(q, q->in, header, sizeof(header));
+    q->in = (q->in + sizeof(header)) % q->size;
+    q->waiting += size;
+    q->stats.queued += size;
+}
+
+static size_t append(uart_mux_queue_t *q, const void *data, size_t n) {
+    if (n > q->open) {
+        n = q->open;
+    }
+    q->open -= (uint32_t)n;
+    if (q->dropping) {
+        return 0;
+    }
+    ring_put(q, q->in, data, (uint32_t)n);
+    q->in = (q->in + (uint32_t)n) % q->size;
+    if (q->open == 0) {
+        // Only complete records are sent
+        q->committed = q->in;
+    }
+    return n;
+}
+
+static void ring_put(uart_mux_queue_t *q, uint32_t at, const void *data,
+                     uint32_t n) {
+    uint32_t first = q->size - at < n ? q->size - at : n;
+    memcpy(&q->buf[at], data, first);
+    memcpy(q->buf, (const uint8_t *)data + first, n - first);
+}
+
+static void ring_get(const uart_mux_queue_t *q, uint32_t at, void *data,
+                     uint32_t n) {
+    uint32_t first = q->size - at < n ? q->size - at : n;
+    memcpy(data, &q->buf[at], first);
+    memcpy((uint8_t *)data + first, q->buf, n - first);
+}
+
+static uint32_t ring_used(const uart_mux_queue_t *q) {
+    return q->in >= q->out ? q->in - q->out : q->size - q->out + q->in;
+}
+
+static uint32_t ring_free(const uart_mux_queue_t *q) {
+    // one byte is kept free to tell a full ring from an empty one
+    return q->size == 0 ? 0 : q->size - 1 - ring_used(q);
+}
+
+static uart_mux_queue_t *next_queue(uart_mux_t *mux, uint32_t pending) {
+    uint32_t window =
+        (uint32_t)(((uint64_t)mux->config.link_rate * mux->config.window_us) /
+                   1000000);
+
+    for (int i = 0; i < UART_MUX_N_CHANNELS; i++) {
+        uart_mux_queue_t *q = &mux->queues[i];
+        if (q->out == q->committed) {
+            continue;
+        }
+        if (i == UART_MUX_CONTROL) {
+            return q;
+        }
+        if (mux->hold || pending >= window ||
+            mux->in_flight_count == UART_MUX_IN_FLIGHT) {
+            return NULL;
+        }
+        return q;
+    }
+    return NULL;
+}
+
+static uint32_t send_record(uart_mux_t *mux, uart_mux_queue_t *q) {
+    uint8_t record[UART_MUX_RECORD_OVERHEAD];
+    uint32_t at = (q->out + sizeof(record)) % q->size;
+
+    ring_get(q, q->out, record, sizeof(record));
+    uint32_t queued_us = get_u32(&record[0]);
+    uint32_t size = get_u32(&record[4]);
+    uart_mux_channel_t channel = (uart_mux_channel_t)(q - mux->queues);
+
+    // Number the message in the order it goes out
+    uint8_t header[FRAME_PROTO_HEADER_SIZE];
+    ring_get(q, at, header, sizeof(header));
+    frame_proto_set_seq(header, mux->seq++);
+    mux->write(header, sizeof(header), mux->context);
+    sink_from_ring(mux, q, (at + sizeof(header)) % q->size,
+                   size - sizeof(header));
+    q->out = (at + size) % q->size;
+    q->waiting -= size;
+    mux->written += size;
+    q->stats.sent++;
+
+    // Control messages skip the limit, and then aren't measured
+    if (mux->in_flight_count < UART_MUX_IN_FLIGHT) {
+        uint8_t i = (mux->in_flight_first + mux->in_flight_count) %
+                    UART_MUX_IN_FLIGHT;
+        mux->in_flight[i].channel = (uint8_t)channel;
+        mux->in_flight[i].end = mux->written;
+        mux->in_flight[i].queued_us = queued_us;
+        mux->in_flight_count++;
+    }
+    return size;
+}
+
+static void sink_from_ring(uart_mux_t *mux, const uart_mux_queue_t *q,
+                           uint32_t at, uint32_t n) {
+    uint32_t first = q->size - at < n ? q->size - at : n;
+    if (first > 0) {
+        mux->write(&q->buf[at], first, mux->context);
+    }
+    if (n > first) {
+        mux->write(q->buf, n - first, mux->context);
+    }
+}
+
+static void retire(uart_mux_t *mux, uint32_t sent, uint32_t now) {
+    while (mux->in_flight_count > 0) {
+        uart_mux_in_flight_t *f = &mux->in_flight[mux->in_flight_first];
+        // sent runs behind written, and both wrap
+        if ((int32_t)(sent - f->end) < 0) {
+            break;
+        }
+        uart_mux_stats_t *stats = &mux->queues[f->channel].stats;
+        uint32_t latency = now - f->queued_us;
+        stats->measured++;
+        stats->latency_sum_us += latency;
+        if (latency > stats->max_latency_us) {
+            stats->max_latency_us = latency;
+        }
+        mux->in_flight_first = (mux->in_flight_first + 1) % UART_MUX_IN_FLIGHT;
+        mux->in_flight_count--;
+    }
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
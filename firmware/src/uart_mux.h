@@ -0,0 +1,242 @@
+/**
+ * @file uart_mux.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Priority multiplexing of the console link.
+ *
+ * Link control, telemetry, console text and frame data share one UART.
+ * Each is queued on its own channel, and the multiplexer hands whole
+ * messages to the transmit ring (the sink) highest priority channel first,
+ * keeping no more than window_us of data in the sink.  Frame data is sent in
+ * fragments (see frame_proto.h), so a message on a higher priority channel
+ * waits at most for the data already in the sink and one fragment, however
+ * long the frame being sent.  Control messages go to the sink as soon as
+ * they are pumped, so a reply is on its way before the caller acts on it
+ * (e.g. changes the baud rate).
+ *
+ * Messages are numbered as they are handed to the sink, so the receiver
+ * sees a single sequence to count losses in.
+ *
+ * The latency of each message, from being queued until the sink has sent
+ * it, is measured per channel to the resolution of the uart_mux_pump()
+ * calls.
+ *
+ * The module has no hardware dependencies: the sink is a write function,
+ * its depth is passed to uart_mux_pump(), and time is read from a clock
+ * function.  It isn't reentrant: queue and pump from the same context.
+ */
+
+#ifndef _UART_MUX_H_
+#define _UART_MUX_H_
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+/**
+ * @brief The channels, highest priority first.
+ */
+typedef enum {
+    UART_MUX_CONTROL,   // link negotiation (link_baud.h)
+    UART_MUX_TELEMETRY, // per-frame telemetry
+    UART_MUX_LOG,       // console text, in LOG messages
+    UART_MUX_BULK,      // frame data, fragmented
+    UART_MUX_N_CHANNELS,
+} uart_mux_channel_t;
+
+// Queue space taken by each message besides its bytes on the wire
+#define UART_MUX_RECORD_OVERHEAD 8
+
+// Queue space taken by a bulk message with a payload of n bytes, sent in
+// fragments of up to f bytes
+#define UART_MUX_BULK_COST(n, f)                                               \
+    (FRAME_PROTO_FRAGMENTED_SIZE(n, f) +                                       \
+     FRAME_PROTO_FRAGMENTS(n, f) * UART_MUX_RECORD_OVERHEAD)
+
+// Messages in the sink whose latency is still to be measured
+#define UART_MUX_IN_FLIGHT 16
+
+/**
+ * @brief Function returning the time in microseconds.  It may wrap.
+ */
+typedef uint32_t (*uart_mux_clock_fn_t)(void);
+
+typedef struct {
+    uint32_t window_us;     // most data kept in the sink
+    uint32_t fragment_size; // largest fragment of a bulk message
+    uint32_t link_rate;     // link capacity, bytes/s
+} uart_mux_config_t;
+
+/**
+ * @brief Per-channel statistics.  Byte and message counts are cumulative
+ * and wrap; latencies are since uart_mux_reset_latency().
+ */
+typedef struct {
+    uint32_t queued;         // bytes accepted
+    uint32_t dropped;        // bytes refused for lack of queue space
+    uint32_t sent;           // messages handed to the sink
+    uint32_t measured;       // messages whose latency was measured
+    uint64_t latency_sum_us; // total of the measured latencies
+    uint32_t max_latency_us; // longest measured latency
+} uart_mux_stats_t;
+
+struct uart_mux_s;
+
+typedef struct {
+    struct uart_mux_s *mux;   // owner
+    uint8_t *buf;             // ring of records: time, size, bytes
+    uint32_t size;            // capacity of buf
+    uint32_t in;              // where the next byte is written
+    uint32_t committed;       // end of the last complete record
+    uint32_t out;             // start of the oldest record
+    uint32_t open;            // bytes of the record being written to come
+    uint32_t waiting;         // bytes of the messages in buf, on the wire
+    bool dropping;            // the record being written didn't fit
+    frame_proto_encoder_t enc; // messages for this channel
+    uart_mux_stats_t stats;
+} uart_mux_queue_t;
+
+typedef struct {
+    uint8_t channel;    // channel the message came from
+    uint32_t end;       // value of written once it has been sent
+    uint32_t queued_us; // when it was queued
+} uart_mux_in_flight_t;
+
+typedef struct uart_mux_s {
+    uart_mux_config_t config;
+    uart_mux_queue_t queues[UART_MUX_N_CHANNELS];
+    frame_proto_write_fn_t write; // writes to the sink
+    uintptr_t context;            // passed to write
+    uart_mux_clock_fn_t clock;
+    uint16_t seq;                 // sequence number of the next message
+    uint32_t written;             // bytes handed to the sink, wrapping
+    bool hold;                    // only control messages are sent
+    uart_mux_in_flight_t in_flight[UART_MUX_IN_FLIGHT];
+    uint8_t in_flight_first;      // oldest entry of in_flight
+    uint8_t in_flight_count;      // entries in use
+} uart_mux_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in the defaults for a link of baud bits/s (8N1).
+ */
+void uart_mux_default_config(uart_mux_config_t *config, uint32_t baud);
+
+/**
+ * @brief Initialize a multiplexer writing to a sink through write.  The
+ * queues are empty until given storage with uart_mux_set_queue().
+ */
+void uart_mux_init(uart_mux_t *mux, const uart_mux_config_t *config,
+                   frame_proto_write_fn_t write, uintptr_t context,
+                   uart_mux_clock_fn_t clock);
+
+/**
+ * @brief Give a channel size bytes of queue storage.  Each message takes
+ * its bytes on the wire plus UART_MUX_RECORD_OVERHEAD.
+ */
+void uart_mux_set_queue(uart_mux_t *mux, uart_mux_channel_t channel,
+                        uint8_t *buf, uint32_t size);
+
+/**
+ * @brief Return the encoder that queues messages on a channel.  Bulk
+ * messages are fragmented.  A message that doesn't fit in the queue is
+ * dropped whole, and the frame_proto call that started it returns false.
+ */
+frame_proto_encoder_t *uart_mux_encoder(uart_mux_t *mux,
+                                        uart_mux_channel_t channel);
+
+/**
+ * @brief Queue console text as a FRAME_PROTO_TYPE_LOG message, so that it
+ * is numbered and checked like the rest of the stream.  Returns n, or 0 if
+ * it didn't fit and was dropped.
+ */
+size_t uart_mux_write_text(uart_mux_t *mux, const void *text, size_t n);
+
+/**
+ * @brief Hand queued messages to the sink, and measure the latency of those
+ * it has sent.  Call often: the sink runs dry if it isn't refilled within
+ * window_us.
+ *
+ * @param pending Bytes now waiting in the sink.
+ */
+void uart_mux_pump(uart_mux_t *mux, uint32_t pending);
+
+/**
+ * @brief Hold back every channel but UART_MUX_CONTROL, e.g. while the link
+ * changes rate.
+ */
+void uart_mux_hold(uart_mux_t *mux, bool hold);
+
+/**
+ * @brief Change the link capacity, e.g. after the baud rate changes.
+ */
+void uart_mux_set_link_rate(uart_mux_t *mux, uint32_t baud);
+
+/**
+ * @brief Return the queue space a message with a payload of length bytes
+ * would take on a channel.
+ */
+uint32_t uart_mux_cost(const uart_mux_t *mux, uart_mux_channel_t channel,
+                       uint32_t length);
+
+/**
+ * @brief Return the free queue space of a channel.
+ */
+uint32_t uart_mux_free(const uart_mux_t *mux, uart_mux_channel_t channel);
+
+/**
+ * @brief Return the bytes of the messages waiting in all queues, as they
+ * will go on the wire: the queued bytes of uart_mux_stats_t that haven't
+ * been handed to the sink yet.
+ */
+uint32_t uart_mux_pending(const uart_mux_t *mux);
+
+void uart_mux_reset_latency(uart_mux_t *mux);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _UART_MUX_H_ */
@@ -0,0 +1,443 @@
+/**
+ * @file yuv_codec.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "yuv_codec.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAGIC_0 'Y'
+#define MAGIC_1 'C'
+
+typedef enum {
+    ROW_SPATIAL,
+    ROW_TEMPORAL,
+    ROW_REPEAT,
+} row_mode_t;
+
+#define ROW_MODE_BITS 2
+
+// Rice codes with a quotient of ESCAPE_Q or more are replaced by ESCAPE_Q
+// one bits and the 8 bit residual, bounding a sample at ESCAPE_Q + 8 bits.
+#define ESCAPE_Q 16
+
+// LOCO-I context adaptation: halve the accumulators every RESET_COUNT
+// samples so the parameter tracks local statistics.
+#define RESET_COUNT 64
+#define INITIAL_SUM 4
+
+#define CHANNEL_Y 0
+#define CHANNEL_U 1
+#define CHANNEL_V 2
+#define N_CHANNELS 3
+
+/**
+ * @brief Running residual statistics for one channel.
+ */
+typedef struct {
+    uint16_t sum;   // sum of mapped residuals
+    uint16_t count; // number of residuals
+} context_t;
+
+typedef struct {
+    uint8_t *buf;     // output buffer
+    size_t size;      // capacity of buf in bytes
+    size_t pos;       // bytes written
+    uint32_t acc;     // pending bits, left aligned
+    uint8_t n_acc;    // number of pending bits
+    bool overflow;    // ran out of room
+} bit_writer_t;
+
+typedef struct {
+    const uint8_t *buf; // input buffer
+    size_t size;        // length of buf in bytes
+    size_t pos;         // next byte to load
+    uint32_t acc;       // buffered bits, left aligned
+    uint8_t n_acc;      // number of buffered bits
+    bool underflow;     // read past the end
+} bit_reader_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the channel of byte i of a YUYV row.
+ */
+static inline int channel_of(size_t i);
+
+/**
+ * @brief Return the LOCO-I median edge prediction of byte i of row.
+ *
+ * @param above The previous row, or NULL for the first row.
+ */
+static inline uint8_t predict_spatial(const uint8_t *row,
+                                      const uint8_t *above, size_t i);
+
+/**
+ * @brief Map a residual (mod 256) to 0..255: 0, -1, 1, -2, 2, ...
+ */
+static inline uint8_t map_residual(uint8_t residual);
+
+static inline uint8_t unmap_residual(uint8_t mapped);
+
+/**
+ * @brief Return the Rice parameter for a context and update it.
+ */
+static inline uint8_t rice_k(const context_t *ctx);
+static inline void update_context(context_t *ctx, uint8_t mapped);
+
+static void contexts_init(context_t *contexts);
+
+/**
+ * @brief Choose the row mode with the smallest total mapped residual.
+ */
+static row_mode_t choose_row_mode(const uint8_t *row, const uint8_t *above,
+                                  const uint8_t *ref_row, size_t row_bytes);
+
+static void put_bits(bit_writer_t *bw, uint32_t bits, uint8_t n_bits);
+static void flush_bits(bit_writer_t *bw);
+static uint32_t get_bits(bit_reader_t *br, uint8_t n_bits);
+static uint32_t get_unary(bit_reader_t *br, uint32_t limit);
+
+static void write_header(uint8_t *out, uint8_t mode, uint8_t flags,
+                         uint16_t width, uint16_t height);
+
+// *****************************************************************************
+// Public code
+
+size_t yuv_codec_encode(const uint8_t *yuyv, const uint8_t *ref,
+                        uint16_t width, uint16_t height, uint8_t *out,
+                        size_t out_size) {
+    size_t row_bytes = (size_t)width * 2;
+    size_t raw_size = row_bytes * height;
+    context_t contexts[N_CHANNELS];
+    bit_writer_t bw;
+    bool used_ref = false;
+
+    if (out_size < YUV_CODEC_MAX_OUTPUT(width, height) || (width & 1) != 0) {
+        return 0;
+    }
+
+    // Give up on coding as soon as it's no smaller than the raw frame
+    bw.buf = &out[YUV_CODEC_HEADER_SIZE];
+    bw.size = raw_size;
+    bw.pos = 0;
+    bw.acc = 0;
+    bw.n_acc = 0;
+    bw.overflow = false;
+    contexts_init(contexts);
+
+    for (uint16_t y = 0; y < height && !bw.overflow; y++) {
+        const uint8_t *row = &yuyv[y * row_bytes];
+        const uint8_t *above = y == 0 ? NULL : row - row_bytes;
+        const uint8_t *ref_row = ref == NULL ? NULL : &ref[y * row_bytes];
+        row_mode_t mode = choose_row_mode(row, above, ref_row, row_bytes);
+
+        put_bits(&bw, mode, ROW_MODE_BITS);
+        if (mode != ROW_SPATIAL) {
+            used_ref = true;
+        }
+        if (mode == ROW_REPEAT) {
+            continue;
+        }
+        for (size_t i = 0; i < row_bytes; i++) {
+            uint8_t prediction = mode == ROW_TEMPORAL
+                                     ? ref_row[i]
+                                     : predict_spatial(row, above, i);
+            uint8_t mapped = map_residual(row[i] - prediction);
+            context_t *ctx = &contexts[channel_of(i)];
+            uint8_t k = rice_k(ctx);
+            uint32_t q = mapped >> k;
+
+            if (q < ESCAPE_Q) {
+                // q ones, a zero, then the k low bits
+                put_bits(&bw, ((1UL << q) - 1) << 1, q + 1);
+                put_bits(&bw, mapped & ((1UL << k) - 1), k);
+            } else {
+                put_bits(&bw, (1UL << ESCAPE_Q) - 1, ESCAPE_Q);
+                put_bits(&bw, mapped, 8);
+            }
+            update_context(ctx, mapped);
+        }
+    }
+    flush_bits(&bw);
+
+    if (bw.overflow) {
+        write_header(out, YUV_CODEC_MODE_RAW, 0, width, height);
+        memcpy(&out[YUV_CODEC_HEADER_SIZE], yuyv, raw_size);
+        return YUV_CODEC_HEADER_SIZE + raw_size;
+    }
+    write_header(out, YUV_CODEC_MODE_CODED,
+                 used_ref ? YUV_CODEC_FLAG_REFERENCE : 0, width, height);
+    return YUV_CODEC_HEADER_SIZE + bw.pos;
+}
+
+bool yuv_codec_decode(const uint8_t *in, size_t in_len, const uint8_t *ref,
+                      uint8_t *yuyv, size_t yuyv_size) {
+    if (in_len < YUV_CODEC_HEADER_SIZE || in[0] != MAGIC_0 ||
+        in[1] != MAGIC_1) {
+        return false;
+    }
+    uint8_t mode = in[2];
+    uint8_t flags = in[3];
+    uint16_t width = in[4] | (in[5] << 8);
+    uint16_t height = in[6] | (in[7] << 8);
+    size_t row_bytes = (size_t)width * 2;
+    size_t raw_size = row_bytes * height;
+
+    if (raw_size > yuyv_size || (width & 1) != 0) {
+        return false;
+    }
+    if ((flags & YUV_CODEC_FLAG_REFERENCE) != 0 && ref == NULL) {
+        return false;
+    }
+
+    if (mode == YUV_CODEC_MODE_RAW) {
+        if (in_len < YUV_CODEC_HEADER_SIZE + raw_size) {
+            return false;
+        }
+        memcpy(yuyv, &in[YUV_CODEC_HEADER_SIZE], raw_size);
+        return true;
+    } else if (mode != YUV_CODEC_MODE_CODED) {
+        return false;
+    }
+
+    context_t contexts[N_CHANNELS];
+    bit_reader_t br;
+    br.buf = &in[YUV_CODEC_HEADER_SIZE];
+    br.size = in_len - YUV_CODEC_HEADER_SIZE;
+    br.pos = 0;
+    br.acc = 0;
+    br.n_acc = 0;
+    br.underflow = false;
+    contexts_init(contexts);
+
+    for (uint16_t y = 0; y < height; y++) {
+        uint8_t *row = &yuyv[y * row_bytes];
+        const uint8_t *above = y == 0 ? NULL : row - row_bytes;
+        const uint8_t *ref_row = ref == NULL ? NULL : &ref[y * row_bytes];
+        row_mode_t row_mode = get_bits(&br, ROW_MODE_BITS);
+
+        if (row_mode != ROW_SPATIAL && ref_row == NULL) {
+            return false;
+        }
+        if (row_mode == ROW_REPEAT) {
+            memcpy(row, ref_row, row_bytes);
+            continue;
+        } else if (row_mode != ROW_SPATIAL && row_mode != ROW_TEMPORAL) {
+            return false;
+        }
+        for (size_t i = 0; i < row_bytes; i++) {
+            context_t *ctx = &contexts[channel_of(i)];
+            uint8_t k = rice_k(ctx);
+            uint32_t q = get_unary(&br, ESCAPE_Q);
+            uint8_t mapped;
+
+            if (q < ESCAPE_Q) {
+                mapped = (q << k) | get_bits(&br, k);
+            } else {
+                mapped = get_bits(&br, 8);
+            }
+            uint8_t prediction = row_mode == ROW_TEMPORAL
+                                     ? ref_row[i]
+                                     : predict_spatial(row, above, i);
+            row[i] = prediction + unmap_residual(mapped);
+            update_context(ctx, mapped);
+        }
+        if (br.underflow) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool yuv_codec_needs_reference(const uint8_t *in, size_t in_len) {
+    return in_len >= YUV_CODEC_HEADER_SIZE &&
+           (in[3] & YUV_CODEC_FLAG_REFERENCE) != 0;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static inline int channel_of(size_t i) {
+    // [Y0 U Y1 V]
+    if ((i & 1) == 0) {
+        return CHANNEL_Y;
+    }
+    return (i & 2) == 0 ? CHANNEL_U : CHANNEL_V;
+}
+
+static inline uint8_t predict_spatial(const uint8_t *row,
+                                      const uint8_t *above, size_t i) {
+    // distance to the previous sample of the same channel
+    size_t step = (i & 1) == 0 ? 2 : 4;
+
+    if (above == NULL) {
+        return i < step ? 128 : row[i - step];
+    }
+    if (i < step) {
+        return above[i];
+    }
+    int a = row[i - step];   // left
+    int b = above[i];        // above
+    int c = above[i - step]; // above left
+    int min_ab = a < b ? a : b;
+    int max_ab = a < b ? b : a;
+    if (c >= max_ab) {
+        return min_ab;
+    } else if (c <= min_ab) {
+        return max_ab;
+    }
+    return a + b - c;
+}
+
+static inline uint8_t map_residual(uint8_t residual) {
+    int8_t r = (int8_t)residual;
+    return r >= 0 ? (uint8_t)(r << 1) : (uint8_t)((-r << 1) - 1);
+}
+
+static inline uint8_t unmap_residual(uint8_t mapped) {
+    return (mapped & 1) ? (uint8_t)(-((mapped + 1) >> 1))
+                        : (uint8_t)(mapped >> 1);
+}
+
+static inline uint8_t rice_k(const context_t *ctx) {
+    uint8_t k = 0;
+    while (((uint32_t)ctx->count << k) < ctx->sum && k < 7) {
+        k++;
+    }
+    return k;
+}
+
+static inline void update_context(context_t *ctx, uint8_t mapped) {
+    ctx->sum += mapped;
+    if (++ctx->count == RESET_COUNT) {
+        ctx->sum >>= 1;
+        ctx->count >>= 1;
+    }
+}
+
+static void contexts_init(context_t *contexts) {
+    for (int i = 0; i < N_CHANNELS; i++) {
+        contexts[i].sum = INITIAL_SUM;
+        contexts[i].count = 1;
+    }
+}
+
+static row_mode_t choose_row_mode(const uint8_t *row, const uint8_t *above,
+                                  const uint8_t *ref_row, size_t row_bytes) {
+    uint32_t spatial = 0;
+    uint32_t temporal = 0;
+
+    if (ref_row == NULL) {
+        return ROW_SPATIAL;
+    }
+    if (memcmp(row, ref_row, row_bytes) == 0) {
+        return ROW_REPEAT;
+    }
+    for (size_t i = 0; i < row_bytes; i++) {
+        spatial += map_residual(row[i] - predict_spatial(row, above, i));
+        temporal += map_residual(row[i] - ref_row[i]);
+    }
+    return temporal < spatial ? ROW_TEMPORAL : ROW_SPATIAL;
+}
+
+static void put_bits(bit_writer_t *bw, uint32_t bits, uint8_t n_bits) {
+    // n_bits <= 24, so acc never holds more than 31 bits
+    if (n_bits == 0) {
+        return;
+    }
+    bw->acc |= bits << (32 - bw->n_acc - n_bits);
+    bw->n_acc += n_bits;
+    while (bw->n_acc >= 8) {
+        if (bw->pos >= bw->size) {
+            bw->overflow = true;
+            bw->n_acc = 0;
+            bw->acc = 0;
+            return;
+        }
+        bw->buf[bw->pos++] = bw->acc >> 24;
+        bw->acc <<= 8;
+        bw->n_acc -= 8;
+    }
+}
+
+static void flush_bits(bit_writer_t *bw) {
+    if (bw->n_acc > 0) {
+        put_bits(bw, 0, 8 - bw->n_acc);
+    }
+}
+
+static uint32_t get_bits(bit_reader_t *br, uint8_t n_bits) {
+    if (n_bits == 0) {
+        return 0;
+    }
+    while (br->n_acc < n_bits) {
+        uint32_t byte = 0;
+        if (br->pos < br->size) {
+            byte = br->buf[br->pos++];
+        } else {
+            br->underflow = true;
+        }
+        br->acc |= byte << (24 - br->n_acc);
+        br->n_acc += 8;
+    }
+    uint32_t bits = br->acc >> (32 - n_bits);
+    br->acc <<= n_bits;
+    br->n_acc -= n_bits;
+    return bits;
+}
+
+static uint32_t get_unary(bit_reader_t *br, uint32_t limit) {
+    uint32_t q = 0;
+    while (q < limit && get_bits(br, 1) == 1) {
+        q++;
+    }
+    return q;
+}
+
+static void write_header(uint8_t *out, uint8_t mode, uint8_t flags,
+                         uint16_t width, uint16_t height) {
+    out[0] = MAGIC_0;
+    out[1] = MAGIC_1;
+    out[2] = mode;
+    out[3] = flags;
+    out[4] = width & 0xff;
+    out[5] = width >> 8;
+    out[6] = height & 0xff;
+    out[7] = height >> 8;
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,137 @@
+/**
+ * @file yuv_codec.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Lossless compression of packed YUYV frames.
+ *
+ * Each row is coded with one of three predictors, chosen per row by the
+ * encoder:
+ * - SPATIAL: the LOCO-I median edge detector over the left, above and
+ *   above-left samples of the same channel (Y, U or V).
+ * - TEMPORAL: the co-located sample of a reference frame, normally the
+ *   previous frame.
+ * - REPEAT: the row is identical to the reference frame; nothing else is
+ *   coded, which is what makes static scenes nearly free.
+ *
+ * Residuals are coded with adaptive Golomb-Rice codes, one context per
+ * channel, with the parameter derived from the running mean residual as in
+ * LOCO-I.  Long codes are escaped to a fixed 8 bit literal.
+ *
+ * The worst case is bounded: if the coded frame would be larger than the raw
+ * frame, the encoder emits the raw frame instead, so the output never exceeds
+ * YUV_CODEC_MAX_OUTPUT(width, height).
+ *
+ * The codec has no hardware dependencies so the same source is used by the
+ * host tools (see tools/yuv_codec_bench.c) to decode and benchmark.
+ *
+ * Stream format: an 8 byte header followed by the payload.
+ *   [0..1] magic 'Y' 'C'
+ *   [2]    YUV_CODEC_MODE_RAW or YUV_CODEC_MODE_CODED
+ *   [3]    flags: YUV_CODEC_FLAG_REFERENCE if the frame needs the reference
+ *   [4..5] width, little endian
+ *   [6..7] height, little endian
+ * For a coded frame, each row starts with a 2 bit row mode, followed by the
+ * Rice codes of the row's bytes in YUYV order (none for REPEAT rows).  Bits
+ * are packed MSB first.
+ */
+
+#ifndef _YUV_CODEC_H_
+#define _YUV_CODEC_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define YUV_CODEC_HEADER_SIZE 8
+
+#define YUV_CODEC_MODE_RAW 0
+#define YUV_CODEC_MODE_CODED 1
+
+#define YUV_CODEC_FLAG_REFERENCE 0x01
+
+// Largest possible encoded frame: the header and the raw frame.
+#define YUV_CODEC_MAX_OUTPUT(width, height)                                    \
+    (YUV_CODEC_HEADER_SIZE + (size_t)(width) * (height) * 2)
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Encode a frame.
+ *
+ * @param yuyv Frame data, width * height * 2 bytes.  width must be even.
+ * @param ref Reference frame of the same size (normally the previous frame
+ *   as passed to the decoder), or NULL to code a frame that decodes on its
+ *   own.
+ * @param out Receives the encoded frame.
+ * @param out_size Size of out, at least YUV_CODEC_MAX_OUTPUT(width, height).
+ * @return Number of bytes written to out, or 0 if out_size is too small or
+ *   the width is odd.
+ */
+size_t yuv_codec_encode(const uint8_t *yuyv, const uint8_t *ref,
+                        uint16_t width, uint16_t height, uint8_t *out,
+                        size_t out_size);
+
+/**
+ * @brief Decode a frame.
+ *
+ * @param in Encoded frame, as produced by yuv_codec_encode().
+ * @param ref The reference frame used by the encoder.  May be NULL if the
+ *   frame doesn't need one (see yuv_codec_needs_reference()).
+ * @param yuyv Receives the decoded frame.
+ * @param yuyv_size Size of yuyv in bytes.
+ * @return false if the frame is malformed, truncated, larger than yuyv_size
+ *   or needs a reference and ref is NULL.
+ */
+bool yuv_codec_decode(const uint8_t *in, size_t in_len, const uint8_t *ref,
+                      uint8_t *yuyv, size_t yuyv_size);
+
+/**
+ * @brief Return true if the encoded frame refers to a reference frame.
+ */
+bool yuv_codec_needs_reference(const uint8_t *in, size_t in_len);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _YUV_CODEC_H_ */
@@ -0,0 +1,325 @@
+/**
+ * @file yuv_convert.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "yuv_convert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+typedef void (*convert_fn_t)(const uint8_t *yuyv, void *out, size_t n_pixels);
+
+typedef struct {
+    convert_fn_t fn;
+    uint8_t bytes_per_pixel;
+} format_info_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Pack the low bytes of the halfwords of a and b into one word:
+ * (a0, a1) and (b0, b1) become (a0, a1, b0, b1).
+ */
+static inline uint32_t pack_bytes(uint32_t a, uint32_t b);
+
+/**
+ * @brief Adapters giving each per-format conversion the convert_fn_t
+ * signature, for the s_formats table.
+ */
+static void convert_rgb888(const uint8_t *yuyv, void *out, size_t n_pixels);
+static void convert_bgr888(const uint8_t *yuyv, void *out, size_t n_pixels);
+static void convert_rgb565(const uint8_t *yuyv, void *out, size_t n_pixels);
+static void convert_gray8(const uint8_t *yuyv, void *out, size_t n_pixels);
+static void convert_rgb_planar(const uint8_t *yuyv, void *out, size_t n_pixels);
+static void convert_rgb_planar_s8(const uint8_t *yuyv, void *out,
+                                  size_t n_pixels);
+static void convert_rgb_planar_f32(const uint8_t *yuyv, void *out,
+                                   size_t n_pixels);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const format_info_t s_formats[YUV_CONVERT_FORMAT_COUNT] = {
+    [YUV_CONVERT_RGB888] = {convert_rgb888, 3},
+    [YUV_CONVERT_BGR888] = {convert_bgr888, 3},
+    [YUV_CONVERT_RGB565] = {convert_rgb565, 2},
+    [YUV_CONVERT_GRAY8] = {convert_gray8, 1},
+    [YUV_CONVERT_RGB_PLANAR] = {convert_rgb_planar, 3},
+    [YUV_CONVERT_RGB_PLANAR_S8] = {convert_rgb_planar_s8, 3},
+    [YUV_CONVERT_RGB_PLANAR_F32] = {convert_rgb_planar_f32, 3 * sizeof(float)},
+};
+
+// *****************************************************************************
+// Public code
+
+size_t yuv_convert_output_size(yuv_convert_format_t format, size_t n_pixels) {
+    if (format >= YUV_CONVERT_FORMAT_COUNT) {
+        return 0;
+    }
+    return s_formats[format].bytes_per_pixel * n_pixels;
+}
+
+bool yuv_convert(yuv_convert_format_t format, const uint8_t *yuyv, void *out,
+                 size_t n_pixels) {
+    if (format >= YUV_CONVERT_FORMAT_COUNT) {
+        return false;
+    }
+    s_formats[format].fn(yuyv, out, n_pixels);
+    return true;
+}
+
+void yuv_convert_to_rgb888(const uint8_t *yuyv, uint8_t *rgb, size_t n_pixels) {
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        rgb[0] = r;
+        rgb[1] = g;
+        rgb[2] = b;
+        rgb[3] = r >> 16;
+        rgb[4] = g >> 16;
+        rgb[5] = b >> 16;
+        rgb += 6;
+    }
+}
+
+void yuv_convert_to_bgr888(const uint8_t *yuyv, uint8_t *bgr, size_t n_pixels) {
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        bgr[0] = b;
+        bgr[1] = g;
+        bgr[2] = r;
+        bgr[3] = b >> 16;
+        bgr[4] = g >> 16;
+        bgr[5] = r >> 16;
+        bgr += 6;
+    }
+}
+
+void yuv_convert_to_rgb565(const uint8_t *yuyv, uint16_t *rgb565,
+                           size_t n_pixels) {
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        // both pixels are packed at once, one per halfword
+        uint32_t pair = ((r & 0x00f800f8) << 8) | ((g & 0x00fc00fc) << 3) |
+                        ((b >> 3) & 0x001f001f);
+        __UNALIGNED_UINT32_WRITE(rgb565, pair);
+        rgb565 += 2;
+    }
+}
+
+void yuv_convert_to_gray8(const uint8_t *yuyv, uint8_t *gray, size_t n_pixels) {
+    yuv_convert_deinterleave(yuyv, gray, NULL, NULL, n_pixels);
+}
+
+void yuv_convert_deinterleave(const uint8_t *yuyv, uint8_t *y, uint8_t *u,
+                              uint8_t *v, size_t n_pixels) {
+    size_t i = 0;
+
+    if (u == NULL || v == NULL) {
+        // 4 pixels per iteration: two YUYV words in, one word of Y out
+        for (; i + 4 <= n_pixels; i += 4) {
+            uint32_t w0 = __UNALIGNED_UINT32_READ(yuyv);
+            uint32_t w1 = __UNALIGNED_UINT32_READ(yuyv + 4);
+            yuyv += 8;
+            __UNALIGNED_UINT32_WRITE(y, pack_bytes(__UXTB16(w0), __UXTB16(w1)));
+            y += 4;
+        }
+    } else {
+        // 8 pixels per iteration: four YUYV words in, two words of Y and one
+        // each of U and V out
+        for (; i + 8 <= n_pixels; i += 8) {
+            uint32_t w0 = __UNALIGNED_UINT32_READ(yuyv);
+            uint32_t w1 = __UNALIGNED_UINT32_READ(yuyv + 4);
+            uint32_t w2 = __UNALIGNED_UINT32_READ(yuyv + 8);
+            uint32_t w3 = __UNALIGNED_UINT32_READ(yuyv + 12);
+            yuyv += 16;
+            __UNALIGNED_UINT32_WRITE(y, pack_bytes(__UXTB16(w0), __UXTB16(w1)));
+            __UNALIGNED_UINT32_WRITE(y + 4,
+                                     pack_bytes(__UXTB16(w2), __UXTB16(w3)));
+            y += 8;
+
+            // cN = vN : uN
+            uint32_t c0 = __UXTB16(__ROR(w0, 8));
+            uint32_t c1 = __UXTB16(__ROR(w1, 8));
+            uint32_t c2 = __UXTB16(__ROR(w2, 8));
+            uint32_t c3 = __UXTB16(__ROR(w3, 8));
+            __UNALIGNED_UINT32_WRITE(u, pack_bytes(__PKHBT(c0, c1, 16),
+                                                   __PKHBT(c2, c3, 16)));
+            __UNALIGNED_UINT32_WRITE(v, pack_bytes(__PKHTB(c1, c0, 16),
+                                                   __PKHTB(c3, c2, 16)));
+            u += 4;
+            v += 4;
+        }
+    }
+
+    // remaining pixels, if n_pixels isn't a multiple of the block size
+    for (; i < n_pixels; i += 2) {
+        y[0] = yuyv[0];
+        y[1] = yuyv[2];
+        y += 2;
+        if (u != NULL && v != NULL) {
+            *u++ = yuyv[1];
+            *v++ = yuyv[3];
+        }
+        yuyv += 4;
+    }
+}
+
+void yuv_convert_to_rgb_planar(const uint8_t *yuyv, uint8_t *chw,
+                               size_t n_pixels) {
+    uint8_t *r_plane = chw;
+    uint8_t *g_plane = chw + n_pixels;
+    uint8_t *b_plane = chw + 2 * n_pixels;
+
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        *r_plane++ = r;
+        *r_plane++ = r >> 16;
+        *g_plane++ = g;
+        *g_plane++ = g >> 16;
+        *b_plane++ = b;
+        *b_plane++ = b >> 16;
+    }
+}
+
+void yuv_convert_to_rgb_planar_s8(const uint8_t *yuyv, int8_t *chw,
+                                  size_t n_pixels) {
+    int8_t *r_plane = chw;
+    int8_t *g_plane = chw + n_pixels;
+    int8_t *b_plane = chw + 2 * n_pixels;
+
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        // value - 128 is the same as flipping the top bit
+        r ^= 0x00800080;
+        g ^= 0x00800080;
+        b ^= 0x00800080;
+        *r_plane++ = r;
+        *r_plane++ = r >> 16;
+        *g_plane++ = g;
+        *g_plane++ = g >> 16;
+        *b_plane++ = b;
+        *b_plane++ = b >> 16;
+    }
+}
+
+void yuv_convert_to_rgb_planar_f32(const uint8_t *yuyv, float *chw,
+                                   size_t n_pixels) {
+    const float scale = 1.0f / 255.0f;
+    float *r_plane = chw;
+    float *g_plane = chw + n_pixels;
+    float *b_plane = chw + 2 * n_pixels;
+
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        *r_plane++ = (float)(r & 0xff) * scale;
+        *r_plane++ = (float)(r >> 16) * scale;
+        *g_plane++ = (float)(g & 0xff) * scale;
+        *g_plane++ = (float)(g >> 16) * scale;
+        *b_plane++ = (float)(b & 0xff) * scale;
+        *b_plane++ = (float)(b >> 16) * scale;
+    }
+}
+
+void yuv_convert_decimate(const uint8_t *yuyv, uint8_t *out, size_t width,
+                          size_t height) {
+    size_t stride = width * 2;
+
+    for (size_t row = 0; row + 2 <= height; row += 2) {
+        const uint8_t *top = yuyv + row * stride;
+        const uint8_t *bottom = top + stride;
+        // 4 pixels (two YUYV pairs) from each row make one output pair
+        for (size_t x = 0; x + 8 <= stride; x += 8) {
+            out[0] = (top[x] + top[x + 2] + bottom[x] + bottom[x + 2] + 2) >> 2;
+            out[1] = (top[x + 1] + top[x + 5] + bottom[x + 1] +
+                      bottom[x + 5] + 2) >> 2;
+            out[2] = (top[x + 4] + top[x + 6] + bottom[x + 4] +
+                      bottom[x + 6] + 2) >> 2;
+            out[3] = (top[x + 3] + top[x + 7] + bottom[x + 3] +
+                      bottom[x + 7] + 2) >> 2;
+            out += 4;
+        }
+    }
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static inline uint32_t pack_bytes(uint32_t a, uint32_t b) {
+    return __PKHBT(a | (a >> 8), b | (b >> 8), 16);
+}
+
+static void convert_rgb888(const uint8_t *yuyv, void *out, size_t n_pixels) {
+    yuv_convert_to_rgb888(yuyv, out, n_pixels);
+}
+
+static void convert_bgr888(const uint8_t *yuyv, void *out, size_t n_pixels) {
+    yuv_convert_to_bgr888(yuyv, out, n_pixels);
+}
+
+static void convert_rgb565(const uint8_t *yuyv, void *out, size_t n_pixels) {
+    yuv_convert_to_rgb565(yuyv, out, n_pixels);
+}
+
+static void convert_gray8(const uint8_t *yuyv, void *out, size_t n_pixels) {
+    yuv_convert_to_gray8(yuyv, out, n_pixels);
+}
+
+static void convert_rgb_planar(const uint8_t *yuyv, void *out,
+                               size_t n_pixels) {
+    yuv_convert_to_rgb_planar(yuyv, out, n_pixels);
+}
+
+static void convert_rgb_planar_s8(const uint8_t *yuyv, void *out,
+                                  size_t n_pixels) {
+    yuv_convert_to_rgb_planar_s8(yuyv, out, n_pixels);
+}
+
+static void convert_rgb_planar_f32(const uint8_t *yuyv, void *out,
+                                   size_t n_pixels) {
+    yuv_convert_to_rgb_planar_f32(yuyv, out, n_pixels);
+}
+
+// *****************************************************************************
+// End of file
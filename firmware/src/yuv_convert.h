@@ -0,0 +1,215 @@
+/**
+ * @file yuv_convert.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Pixel format conversion from the camera's packed YUYV (YUV422)
+ * output.
+ *
+ * Each output format has its own conversion loop; yuv_convert() selects one
+ * at runtime through a table, so there is no per-pixel switch.
+ *
+ * The RGB conversion uses the same coefficients as the original floating point
+ * code:
+ *
+ *   R = Y + 1.4075 * (V - 128)
+ *   G = Y - 0.3455 * (U - 128) - 0.7169 * (V - 128)
+ *   B = Y + 1.7790 * (U - 128)
+ *
+ * each truncated and clamped to [0, 255], and produces bit-identical
+ * results.  The coefficients are exact in units of 1/10000, so the chroma
+ * terms are computed exactly with 16 bit SIMD multiplies and floored with a
+ * reciprocal multiply.  The chroma terms are shared by both pixels of a YUYV
+ * pair.
+ */
+
+#ifndef _YUV_CONVERT_H_
+#define _YUV_CONVERT_H_
+
+// *****************************************************************************
+// Includes
+
+#include "definitions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// Conversion coefficients in units of 1/10000, packed for __SMUAD against
+// (U - 128) in the low halfword and (V - 128) in the high halfword.
+#define YUV_CONVERT_COEF_R_V 14075
+#define YUV_CONVERT_COEF_B_U 17790
+#define YUV_CONVERT_COEF_G_UV                                                  \
+    ((uint32_t)(uint16_t)-3455 | ((uint32_t)(uint16_t)-7169 << 16))
+
+#define YUV_CONVERT_CHROMA_BIAS 0x00800080 // 128 in each halfword
+
+// floor(n / 10000) for |n| < 256 * 10000: bias n to be non-negative, divide
+// by reciprocal multiply (exact for all 32 bit operands), then unbias.
+#define YUV_CONVERT_FLOOR_BIAS 256
+#define YUV_CONVERT_DIV10000_MUL 3518437209ULL // ceil(2^45 / 10000)
+#define YUV_CONVERT_DIV10000_SHIFT 45
+
+typedef enum {
+    YUV_CONVERT_RGB888,         // interleaved [r, g, b] bytes
+    YUV_CONVERT_BGR888,         // interleaved [b, g, r] bytes
+    YUV_CONVERT_RGB565,         // uint16_t, r in bits 15:11, little endian
+    YUV_CONVERT_GRAY8,          // luma only, one byte per pixel
+    YUV_CONVERT_RGB_PLANAR,     // CHW: all r bytes, then all g, then all b
+    YUV_CONVERT_RGB_PLANAR_S8,  // CHW int8_t, value - 128
+    YUV_CONVERT_RGB_PLANAR_F32, // CHW float, value / 255 (0.0 to 1.0)
+    YUV_CONVERT_FORMAT_COUNT
+} yuv_convert_format_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Return the number of bytes of output for n_pixels pixels in the
+ * given format, or 0 if the format is unknown.
+ */
+size_t yuv_convert_output_size(yuv_convert_format_t format, size_t n_pixels);
+
+/**
+ * @brief Convert packed YUYV pixels to the given format.
+ *
+ * @param yuyv Source pixels, n_pixels * 2 bytes ([y0, u, y1, v] per pair).
+ *   Need not be word aligned.
+ * @param out Destination, yuv_convert_output_size(format, n_pixels) bytes.
+ *   Must be 4 byte aligned for YUV_CONVERT_RGB_PLANAR_F32.
+ * @param n_pixels Number of pixels to convert.  Must be even.
+ * @return false if the format is unknown.
+ */
+bool yuv_convert(yuv_convert_format_t format, const uint8_t *yuyv, void *out,
+                 size_t n_pixels);
+
+/**
+ * @brief Convert packed YUYV pixels to interleaved RGB888.
+ *
+ * @param yuyv Source pixels, n_pixels * 2 bytes ([y0, u, y1, v] per pair).
+ *   Need not be word aligned.
+ * @param rgb Destination, n_pixels * 3 bytes ([r, g, b] per pixel).
+ * @param n_pixels Number of pixels to convert.  Must be even.
+ */
+void yuv_convert_to_rgb888(const uint8_t *yuyv, uint8_t *rgb, size_t n_pixels);
+
+/**
+ * @brief Split packed YUYV into separate Y, U and V planes.
+ *
+ * Works a word at a time with SIMD byte extraction and packing, 4 pixels per
+ * iteration for luma only, 8 with chroma.
+ *
+ * @param y Destination for n_pixels luma bytes.
+ * @param u, v Destinations for n_pixels / 2 chroma bytes each, or both NULL
+ *   to extract luma only.
+ * @param n_pixels Number of pixels.  Must be even.
+ */
+void yuv_convert_deinterleave(const uint8_t *yuyv, uint8_t *y, uint8_t *u,
+                              uint8_t *v, size_t n_pixels);
+
+/**
+ * @brief Halve the resolution of a YUYV frame, averaging each 2 x 2 block
+ * of pixels (and the chroma of the two pairs it spans).
+ *
+ * @param out Destination, (width / 2) * (height / 2) * 2 bytes of YUYV.
+ * @param width Frame width in pixels.  Must be a multiple of 4.
+ * @param height Frame height in pixels.  Must be even.
+ */
+void yuv_convert_decimate(const uint8_t *yuyv, uint8_t *out, size_t width,
+                          size_t height);
+
+/*
+ * Per-format conversions, as selected by yuv_convert().  Arguments are as
+ * for yuv_convert_to_rgb888().
+ */
+void yuv_convert_to_bgr888(const uint8_t *yuyv, uint8_t *bgr, size_t n_pixels);
+void yuv_convert_to_rgb565(const uint8_t *yuyv, uint16_t *rgb565,
+                           size_t n_pixels);
+void yuv_convert_to_gray8(const uint8_t *yuyv, uint8_t *gray, size_t n_pixels);
+void yuv_convert_to_rgb_planar(const uint8_t *yuyv, uint8_t *chw,
+                               size_t n_pixels);
+void yuv_convert_to_rgb_planar_s8(const uint8_t *yuyv, int8_t *chw,
+                                  size_t n_pixels);
+void yuv_convert_to_rgb_planar_f32(const uint8_t *yuyv, float *chw,
+                                   size_t n_pixels);
+
+// *****************************************************************************
+// Public inline code
+
+/**
+ * @brief Return floor(n / 10000), packed into both halfwords.
+ */
+static inline uint32_t yuv_convert_floor_div10000_x2(int32_t n) {
+    uint32_t biased = (uint32_t)(n + YUV_CONVERT_FLOOR_BIAS * 10000);
+    uint32_t q = (uint32_t)(((uint64_t)biased * YUV_CONVERT_DIV10000_MUL) >>
+                            YUV_CONVERT_DIV10000_SHIFT) -
+                 YUV_CONVERT_FLOOR_BIAS;
+    return (q & 0xffff) | (q << 16);
+}
+
+/**
+ * @brief Convert one YUYV pair (as read little endian from the buffer) to
+ * RGB.  Each of r, g and b receives the value for pixel 0 in the low
+ * halfword and pixel 1 in the high halfword.
+ *
+ * This is the kernel shared by all the RGB conversions, exposed for fused
+ * stages (e.g. yuv_tensor) that consume RGB without storing it.
+ */
+static inline void yuv_convert_pair(uint32_t word, uint32_t *r, uint32_t *g,
+                                    uint32_t *b) {
+    uint32_t y = __UXTB16(word); // y1 : y0
+    uint32_t uv = __SSUB16(__UXTB16(__ROR(word, 8)),
+                           YUV_CONVERT_CHROMA_BIAS); // dv : du
+    int32_t du = (int16_t)uv;
+    int32_t dv = (int16_t)(uv >> 16);
+
+    *r = __USAT16(__SADD16(y, yuv_convert_floor_div10000_x2(
+                                  YUV_CONVERT_COEF_R_V * dv)),
+                  8);
+    *g = __USAT16(__SADD16(y, yuv_convert_floor_div10000_x2(
+                                  __SMUAD(uv, YUV_CONVERT_COEF_G_UV))),
+                  8);
+    *b = __USAT16(__SADD16(y, yuv_convert_floor_div10000_x2(
+                                  YUV_CONVERT_COEF_B_U * du)),
+                  8);
+}
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _YUV_CONVERT_H_ */
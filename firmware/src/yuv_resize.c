@@ -0,0 +1,333 @@
+/**
+ * @file yuv_resize.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "yuv_resize.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// Positions are Q16, weights Q8
+#define POS_ONE 65536
+#define WEIGHT_ONE 256
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Compute source indexes and weights for one axis.
+ *
+ * Output sample i covers source positions [i, i + 1) * src_len / dst_len.
+ * index[dst_len] is set to src_len.
+ */
+static void build_axis(yuv_resize_mode_t mode, uint16_t src_len,
+                       uint16_t dst_len, uint16_t *index, uint8_t *weight);
+
+/**
+ * @brief Horizontal passes over one source row (starting at the ROI).
+ * hresample_* write dst_width * 2 bytes of YUYV, accumulate_area adds into
+ * rs->acc.
+ */
+static void hresample_nearest(const yuv_resize_t *rs, const uint8_t *src,
+                              uint8_t *out);
+static void hresample_bilinear(const yuv_resize_t *rs, const uint8_t *src,
+                               uint8_t *out);
+static void accumulate_area(yuv_resize_t *rs, const uint8_t *src);
+
+/**
+ * @brief Write the averages in rs->acc for output row rs->dst_row and clear
+ * the accumulators.
+ */
+static void emit_area(yuv_resize_t *rs, uint8_t *out);
+
+/**
+ * @brief Blend two horizontally resampled rows with a Q8 weight on b.
+ */
+static void blend_rows(const uint8_t *a, const uint8_t *b, uint8_t weight,
+                       uint8_t *out, size_t n_bytes);
+
+// *****************************************************************************
+// Public code
+
+bool yuv_resize_init(yuv_resize_t *rs, yuv_resize_mode_t mode,
+                     uint16_t src_width, uint16_t src_height,
+                     const yuv_resize_roi_t *roi, uint16_t dst_width,
+                     uint16_t dst_height) {
+    yuv_resize_roi_t full = {0, 0, src_width, src_height};
+
+    if (roi == NULL) {
+        roi = &full;
+    }
+    if ((src_width & 1) || (roi->x & 1) || (roi->width & 1) ||
+        (dst_width & 1)) {
+        return false; // not pair aligned
+    }
+    if (roi->width == 0 || roi->height == 0 ||
+        roi->x + roi->width > src_width || roi->y + roi->height > src_height) {
+        return false;
+    }
+    if (dst_width == 0 || dst_width > YUV_RESIZE_MAX_DST_WIDTH ||
+        dst_height == 0 || dst_height > YUV_RESIZE_MAX_DST_HEIGHT) {
+        return false;
+    }
+    if (mode == YUV_RESIZE_AREA &&
+        (dst_width > roi->width || dst_height > roi->height)) {
+        return false;
+    }
+
+    rs->mode = mode;
+    rs->src_width = src_width;
+    rs->src_height = src_height;
+    rs->roi = *roi;
+    rs->dst_width = dst_width;
+    rs->dst_height = dst_height;
+    build_axis(mode, roi->width, dst_width, rs->x_index, rs->x_weight);
+    build_axis(mode, roi->width / 2, dst_width / 2, rs->cx_index,
+               rs->cx_weight);
+    build_axis(mode, roi->height, dst_height, rs->y_index, rs->y_weight);
+    yuv_resize_start(rs);
+    return true;
+}
+
+void yuv_resize_start(yuv_resize_t *rs) {
+    rs->src_row = 0;
+    rs->dst_row = 0;
+    rs->hrow_cur = 0;
+    memset(rs->acc, 0, sizeof(rs->acc));
+}
+
+size_t yuv_resize_push_row(yuv_resize_t *rs, const uint8_t *src_row,
+                           uint8_t *dst) {
+    size_t stride = rs->dst_width * 2;
+    size_t written = 0;
+    uint16_t r = rs->src_row++;
+
+    if (r < rs->roi.y || r >= rs->roi.y + rs->roi.height ||
+        rs->dst_row >= rs->dst_height) {
+        return 0;
+    }
+    r -= rs->roi.y; // row within the ROI
+    const uint8_t *src = src_row + rs->roi.x * 2;
+
+    switch (rs->mode) {
+
+    case YUV_RESIZE_NEAREST: {
+        if (rs->y_index[rs->dst_row] != r) {
+            break; // row not sampled
+        }
+        uint8_t *first = dst + rs->dst_row * stride;
+        hresample_nearest(rs, src, first);
+        rs->dst_row++;
+        written++;
+        // upscaling repeats the row
+        while (rs->dst_row < rs->dst_height && rs->y_index[rs->dst_row] == r) {
+            memcpy(dst + rs->dst_row * stride, first, stride);
+            rs->dst_row++;
+            written++;
+        }
+    } break;
+
+    case YUV_RESIZE_BILINEAR: {
+        rs->hrow_cur ^= 1;
+        const uint8_t *cur = rs->hrow[rs->hrow_cur];
+        const uint8_t *prev = rs->hrow[rs->hrow_cur ^ 1];
+        hresample_bilinear(rs, src, rs->hrow[rs->hrow_cur]);
+        // emit every output row whose lower source row is this one
+        while (rs->dst_row < rs->dst_height) {
+            uint16_t y0 = rs->y_index[rs->dst_row];
+            uint8_t weight = rs->y_weight[rs->dst_row];
+            uint16_t y1 = (weight != 0) ? y0 + 1 : y0;
+            if (y1 != r) {
+                break;
+            }
+            blend_rows((y0 == r) ? cur : prev, cur, weight,
+                       dst + rs->dst_row * stride, stride);
+            rs->dst_row++;
+            written++;
+        }
+    } break;
+
+    case YUV_RESIZE_AREA: {
+        accumulate_area(rs, src);
+        if (r == rs->y_index[rs->dst_row + 1] - 1) {
+            // last source row of this output row's bin
+            emit_area(rs, dst + rs->dst_row * stride);
+            rs->dst_row++;
+            written++;
+        }
+    } break;
+
+    } // switch
+    return written;
+}
+
+bool yuv_resize_is_done(const yuv_resize_t *rs) {
+    return rs->dst_row >= rs->dst_height;
+}
+
+void yuv_resize_frame(yuv_resize_t *rs, const uint8_t *src, uint8_t *dst) {
+    size_t src_stride = rs->src_width * 2;
+
+    yuv_resize_start(rs);
+    // rows above the ROI are skipped without being read
+    rs->src_row = rs->roi.y;
+    for (uint16_t r = rs->roi.y;
+         r < rs->roi.y + rs->roi.height && !yuv_resize_is_done(rs); r++) {
+        yuv_resize_push_row(rs, src + r * src_stride, dst);
+    }
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void build_axis(yuv_resize_mode_t mode, uint16_t src_len,
+                       uint16_t dst_len, uint16_t *index, uint8_t *weight) {
+    for (uint32_t i = 0; i < dst_len; i++) {
+        // centre of output sample i, in source coordinates.  Computed from i
+        // rather than accumulated, so there is no drift across the row.
+        uint64_t numerator = (uint64_t)(2 * i + 1) * src_len * POS_ONE;
+        uint32_t centre = numerator / (2 * dst_len);
+
+        switch (mode) {
+        case YUV_RESIZE_NEAREST: {
+            uint32_t pos = centre / POS_ONE;
+            index[i] = (pos < src_len) ? pos : (uint32_t)src_len - 1;
+            weight[i] = 0;
+        } break;
+
+        case YUV_RESIZE_BILINEAR: {
+            // sample centres are at +0.5, so interpolate from centre - 0.5
+            uint32_t pos = (centre > POS_ONE / 2) ? centre - POS_ONE / 2 : 0;
+            index[i] = pos / POS_ONE;
+            weight[i] = (pos % POS_ONE) / (POS_ONE / WEIGHT_ONE);
+            if (index[i] >= src_len - 1) {
+                index[i] = src_len - 1;
+                weight[i] = 0;
+            }
+        } break;
+
+        case YUV_RESIZE_AREA: {
+            index[i] = (i * src_len) / dst_len;
+            weight[i] = 0;
+        } break;
+        }
+    }
+    index[dst_len] = src_len;
+}
+
+static void hresample_nearest(const yuv_resize_t *rs, const uint8_t *src,
+                              uint8_t *out) {
+    for (int i = 0; i < rs->dst_width; i++) {
+        out[2 * i] = src[2 * rs->x_index[i]];
+    }
+    for (int j = 0; j < rs->dst_width / 2; j++) {
+        const uint8_t *pair = &src[4 * rs->cx_index[j]];
+        out[4 * j + 1] = pair[1];
+        out[4 * j + 3] = pair[3];
+    }
+}
+
+static void hresample_bilinear(const yuv_resize_t *rs, const uint8_t *src,
+                               uint8_t *out) {
+    for (int i = 0; i < rs->dst_width; i++) {
+        const uint8_t *y = &src[2 * rs->x_index[i]];
+        uint32_t w = rs->x_weight[i];
+        // a weight of 0 also marks the last column: don't read past it
+        out[2 * i] = (w == 0) ? y[0]
+                              : (y[0] * (WEIGHT_ONE - w) + y[2] * w +
+                                 WEIGHT_ONE / 2) / WEIGHT_ONE;
+    }
+    for (int j = 0; j < rs->dst_width / 2; j++) {
+        const uint8_t *pair = &src[4 * rs->cx_index[j]];
+        uint32_t w = rs->cx_weight[j];
+        if (w == 0) {
+            out[4 * j + 1] = pair[1];
+            out[4 * j + 3] = pair[3];
+        } else {
+            out[4 * j + 1] = (pair[1] * (WEIGHT_ONE - w) + pair[5] * w +
+                              WEIGHT_ONE / 2) / WEIGHT_ONE;
+            out[4 * j + 3] = (pair[3] * (WEIGHT_ONE - w) + pair[7] * w +
+                              WEIGHT_ONE / 2) / WEIGHT_ONE;
+        }
+    }
+}
+
+static void accumulate_area(yuv_resize_t *rs, const uint8_t *src) {
+    for (int i = 0; i < rs->dst_width; i++) {
+        uint32_t sum = 0;
+        for (int x = rs->x_index[i]; x < rs->x_index[i + 1]; x++) {
+            sum += src[2 * x];
+        }
+        rs->acc[2 * i] += sum;
+    }
+    for (int j = 0; j < rs->dst_width / 2; j++) {
+        uint32_t sum_u = 0;
+        uint32_t sum_v = 0;
+        for (int x = rs->cx_index[j]; x < rs->cx_index[j + 1]; x++) {
+            sum_u += src[4 * x + 1];
+            sum_v += src[4 * x + 3];
+        }
+        rs->acc[4 * j + 1] += sum_u;
+        rs->acc[4 * j + 3] += sum_v;
+    }
+}
+
+static void emit_area(yuv_resize_t *rs, uint8_t *out) {
+    uint32_t rows = rs->y_index[rs->dst_row + 1] - rs->y_index[rs->dst_row];
+
+    for (int i = 0; i < rs->dst_width; i++) {
+        uint32_t n = (rs->x_index[i + 1] - rs->x_index[i]) * rows;
+        out[2 * i] = (rs->acc[2 * i] + n / 2) / n;
+    }
+    for (int j = 0; j < rs->dst_width / 2; j++) {
+        uint32_t n = (rs->cx_index[j + 1] - rs->cx_index[j]) * rows;
+        out[4 * j + 1] = (rs->acc[4 * j + 1] + n / 2) / n;
+        out[4 * j + 3] = (rs->acc[4 * j + 3] + n / 2) / n;
+    }
+    memset(rs->acc, 0, rs->dst_width * 2 * sizeof(uint32_t));
+}
+
+static void blend_rows(const uint8_t *a, const uint8_t *b, uint8_t weight,
+                       uint8_t *out, size_t n_bytes) {
+    if (weight == 0) {
+        memcpy(out, a, n_bytes);
+        return;
+    }
+    uint32_t wa = WEIGHT_ONE - weight;
+    for (size_t k = 0; k < n_bytes; k++) {
+        out[k] = (a[k] * wa + b[k] * weight + WEIGHT_ONE / 2) / WEIGHT_ONE;
+    }
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,173 @@
+/**
+ * @file yuv_resize.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Crop and resize packed YUYV (YUV422) images.
+ *
+ * The output is packed YUYV as well, so any of the yuv_convert or
+ * yuv_tensor stages can follow.  Luma is resampled per pixel and chroma per
+ * pixel pair, so every output pair keeps its own U and V.
+ *
+ * Three modes are supported:
+ * - YUV_RESIZE_NEAREST: pick the nearest source sample.
+ * - YUV_RESIZE_BILINEAR: interpolate between the two nearest source samples
+ *   in each direction, with 8 bit weights.
+ * - YUV_RESIZE_AREA: average all source samples that fall within each output
+ *   sample (downscaling only).  Bin edges are rounded to whole source
+ *   samples.
+ *
+ * Source positions are stepped in Q16 fixed point.  The source index and
+ * weight of every output column and row are computed once, in
+ * yuv_resize_init().
+ *
+ * The resizer streams: source rows are pushed one at a time with
+ * yuv_resize_push_row(), and output rows are written as soon as the source
+ * rows they depend on have arrived.  Only one or two resampled rows (or one
+ * row of accumulators) are kept, so e.g. a VGA frame can be reduced while it
+ * is being read from the camera FIFO without buffering the whole frame.
+ *
+ * This is a library module: app.c doesn't use it, since the firmware
+ * captures at the 96 x 96 size of the model input and hands frames to
+ * yuv_tensor.h as they are.  It is for a capture size that differs from
+ * the model's, e.g. a 224 x 224 model fed from VGA.  tools/yuv_resize_test.c
+ * covers it on the host.
+ */
+
+#ifndef _YUV_RESIZE_H_
+#define _YUV_RESIZE_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define YUV_RESIZE_MAX_DST_WIDTH 224
+#define YUV_RESIZE_MAX_DST_HEIGHT 224
+
+typedef enum {
+    YUV_RESIZE_NEAREST,
+    YUV_RESIZE_BILINEAR,
+    YUV_RESIZE_AREA,
+} yuv_resize_mode_t;
+
+/**
+ * @brief Region of the source image to resample.  x and width must be even
+ * so that the region starts and ends on a YUYV pair.
+ */
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} yuv_resize_roi_t;
+
+typedef struct {
+    yuv_resize_mode_t mode;
+    uint16_t src_width;  // source image width in pixels
+    uint16_t src_height; // source image height in rows
+    yuv_resize_roi_t roi;
+    uint16_t dst_width;  // output width in pixels (even)
+    uint16_t dst_height; // output height in rows
+
+    // Per output column / row source index and Q8 weight of the next sample.
+    // For YUV_RESIZE_AREA, index[i] .. index[i + 1] - 1 is the bin of
+    // output sample i.  Indexes are relative to the ROI.
+    uint16_t x_index[YUV_RESIZE_MAX_DST_WIDTH + 1];
+    uint8_t x_weight[YUV_RESIZE_MAX_DST_WIDTH];
+    uint16_t cx_index[YUV_RESIZE_MAX_DST_WIDTH / 2 + 1]; // chroma (pairs)
+    uint8_t cx_weight[YUV_RESIZE_MAX_DST_WIDTH / 2];
+    uint16_t y_index[YUV_RESIZE_MAX_DST_HEIGHT + 1];
+    uint8_t y_weight[YUV_RESIZE_MAX_DST_HEIGHT];
+
+    // streaming state
+    uint16_t src_row; // next source row expected
+    uint16_t dst_row; // next output row to be written
+    uint8_t hrow[2][YUV_RESIZE_MAX_DST_WIDTH * 2]; // horizontally resampled
+    uint8_t hrow_cur;                               // index of newest hrow
+    uint32_t acc[YUV_RESIZE_MAX_DST_WIDTH * 2];     // YUYV sums (area mode)
+} yuv_resize_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Set up a resizer and compute its coefficient tables.
+ *
+ * @param roi Region of the source to resample, or NULL for the whole image.
+ * @return false if the sizes are out of range, the ROI doesn't fit in the
+ * source or isn't pair aligned, dst_width is odd, or YUV_RESIZE_AREA is
+ * asked to upscale.
+ */
+bool yuv_resize_init(yuv_resize_t *rs, yuv_resize_mode_t mode,
+                     uint16_t src_width, uint16_t src_height,
+                     const yuv_resize_roi_t *roi, uint16_t dst_width,
+                     uint16_t dst_height);
+
+/**
+ * @brief Prepare to receive the first row of a new source frame.
+ */
+void yuv_resize_start(yuv_resize_t *rs);
+
+/**
+ * @brief Push the next source row (src_width * 2 bytes of YUYV).
+ *
+ * Output rows that can be completed are written to their place in dst,
+ * which holds the whole output image (dst_width * dst_height * 2 bytes).
+ * Returns the number of output rows written.
+ */
+size_t yuv_resize_push_row(yuv_resize_t *rs, const uint8_t *src_row,
+                           uint8_t *dst);
+
+/**
+ * @brief Return true once every output row has been written.
+ */
+bool yuv_resize_is_done(const yuv_resize_t *rs);
+
+/**
+ * @brief Resize a whole source frame held in memory.
+ */
+void yuv_resize_frame(yuv_resize_t *rs, const uint8_t *src, uint8_t *dst);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _YUV_RESIZE_H_ */
@@ -0,0 +1,173 @@
+/**
+ * @file yuv_tensor.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "yuv_tensor.h"
+
+#include "yuv_convert.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static void run_rgb_nhwc(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                         uint8_t *out, size_t n_pixels);
+static void run_rgb_nchw(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                         uint8_t *out, size_t n_pixels);
+static void run_gray(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                     uint8_t *out, size_t n_pixels);
+
+// *****************************************************************************
+// Public code
+
+void yuv_tensor_default_config(yuv_tensor_config_t *config) {
+    memset(config, 0, sizeof(yuv_tensor_config_t));
+    config->layout = YUV_TENSOR_NHWC;
+    config->type = YUV_TENSOR_UINT8;
+    config->grayscale = false;
+    for (int c = 0; c < YUV_TENSOR_MAX_CHANNELS; c++) {
+        config->mean[c] = 0.0f;
+        config->std[c] = 1.0f;
+    }
+    config->scale = 1.0f;
+    config->zero_point = 0;
+}
+
+bool yuv_tensor_init(yuv_tensor_t *tensor, const yuv_tensor_config_t *config) {
+    int n_channels = config->grayscale ? 1 : YUV_TENSOR_MAX_CHANNELS;
+    int32_t q_min = (config->type == YUV_TENSOR_INT8) ? INT8_MIN : 0;
+    int32_t q_max = (config->type == YUV_TENSOR_INT8) ? INT8_MAX : UINT8_MAX;
+
+    if (!(config->scale > 0.0f)) {
+        return false;
+    }
+    for (int c = 0; c < n_channels; c++) {
+        if (!(config->std[c] > 0.0f)) {
+            return false;
+        }
+    }
+
+    tensor->config = *config;
+    for (int c = 0; c < n_channels; c++) {
+        float k = 1.0f / (config->std[c] * config->scale);
+        for (int v = 0; v < 256; v++) {
+            int32_t q = (int32_t)lroundf((v - config->mean[c]) * k) +
+                        config->zero_point;
+            if (q < q_min) {
+                q = q_min;
+            } else if (q > q_max) {
+                q = q_max;
+            }
+            // int8 values are stored as their two's complement byte
+            tensor->lut[c][v] = (uint8_t)q;
+        }
+    }
+    return true;
+}
+
+size_t yuv_tensor_size(const yuv_tensor_t *tensor, size_t n_pixels) {
+    return n_pixels * (tensor->config.grayscale ? 1 : YUV_TENSOR_MAX_CHANNELS);
+}
+
+void yuv_tensor_run(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                    void *out, size_t n_pixels) {
+    // int8 and uint8 tensors differ only in the lookup tables
+    if (tensor->config.grayscale) {
+        run_gray(tensor, yuyv, out, n_pixels);
+    } else if (tensor->config.layout == YUV_TENSOR_NCHW) {
+        run_rgb_nchw(tensor, yuyv, out, n_pixels);
+    } else {
+        run_rgb_nhwc(tensor, yuyv, out, n_pixels);
+    }
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void run_rgb_nhwc(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                         uint8_t *out, size_t n_pixels) {
+    const uint8_t *lut_r = tensor->lut[0];
+    const uint8_t *lut_g = tensor->lut[1];
+    const uint8_t *lut_b = tensor->lut[2];
+
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        out[0] = lut_r[r & 0xff];
+        out[1] = lut_g[g & 0xff];
+        out[2] = lut_b[b & 0xff];
+        out[3] = lut_r[r >> 16];
+        out[4] = lut_g[g >> 16];
+        out[5] = lut_b[b >> 16];
+        out += 6;
+    }
+}
+
+static void run_rgb_nchw(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                         uint8_t *out, size_t n_pixels) {
+    const uint8_t *lut_r = tensor->lut[0];
+    const uint8_t *lut_g = tensor->lut[1];
+    const uint8_t *lut_b = tensor->lut[2];
+    uint8_t *r_plane = out;
+    uint8_t *g_plane = out + n_pixels;
+    uint8_t *b_plane = out + 2 * n_pixels;
+
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t r, g, b;
+        yuv_convert_pair(__UNALIGNED_UINT32_READ(yuyv), &r, &g, &b);
+        yuyv += 4;
+        *r_plane++ = lut_r[r & 0xff];
+        *r_plane++ = lut_r[r >> 16];
+        *g_plane++ = lut_g[g & 0xff];
+        *g_plane++ = lut_g[g >> 16];
+        *b_plane++ = lut_b[b & 0xff];
+        *b_plane++ = lut_b[b >> 16];
+    }
+}
+
+static void run_gray(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                     uint8_t *out, size_t n_pixels) {
+    // with one channel NHWC and NCHW are the same
+    const uint8_t *lut_y = tensor->lut[0];
+
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        uint32_t word = __UNALIGNED_UINT32_READ(yuyv);
+        yuyv += 4;
+        out[0] = lut_y[word & 0xff];
+        out[1] = lut_y[(word >> 16) & 0xff];
+        out += 2;
+    }
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,129 @@
+/**
+ * @file yuv_tensor.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Fused preprocessing from captured YUYV frames to a quantized model
+ * input tensor.
+ *
+ * For each pixel and channel c the model expects
+ *
+ *   q = round(((value - mean[c]) / std[c]) / scale) + zero_point
+ *
+ * saturated to the range of the tensor type.  Since value is an 8 bit pixel,
+ * q depends only on (c, value), so yuv_tensor_init() folds normalization and
+ * quantization into one 256 entry table per channel.  yuv_tensor_run() then
+ * converts YUYV to RGB (or takes luma for grayscale) and looks each value up,
+ * writing the tensor in one pass with no intermediate float or RGB buffer.
+ */
+
+#ifndef _YUV_TENSOR_H_
+#define _YUV_TENSOR_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define YUV_TENSOR_MAX_CHANNELS 3
+
+typedef enum {
+    YUV_TENSOR_NHWC, // channels interleaved per pixel
+    YUV_TENSOR_NCHW, // one plane per channel
+} yuv_tensor_layout_t;
+
+typedef enum {
+    YUV_TENSOR_INT8,
+    YUV_TENSOR_UINT8,
+} yuv_tensor_type_t;
+
+typedef struct {
+    yuv_tensor_layout_t layout;
+    yuv_tensor_type_t type;
+    bool grayscale;                      // one channel from luma
+    float mean[YUV_TENSOR_MAX_CHANNELS]; // per channel, in pixel units
+    float std[YUV_TENSOR_MAX_CHANNELS];  // per channel, in pixel units
+    float scale;                         // input quantization scale
+    int32_t zero_point;                  // input quantization zero point
+} yuv_tensor_config_t;
+
+typedef struct {
+    yuv_tensor_config_t config;
+    uint8_t lut[YUV_TENSOR_MAX_CHANNELS][256]; // value -> quantized byte
+} yuv_tensor_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in a config for a uint8 NHWC RGB model that takes raw pixel
+ * values (mean 0, std 1, scale 1, zero point 0).
+ */
+void yuv_tensor_default_config(yuv_tensor_config_t *config);
+
+/**
+ * @brief Build the lookup tables for a config.  Grayscale uses the channel 0
+ * mean and std.
+ *
+ * Returns false if a std or the scale is not positive.
+ */
+bool yuv_tensor_init(yuv_tensor_t *tensor, const yuv_tensor_config_t *config);
+
+/**
+ * @brief Return the size in bytes of the tensor for n_pixels pixels.
+ */
+size_t yuv_tensor_size(const yuv_tensor_t *tensor, size_t n_pixels);
+
+/**
+ * @brief Preprocess a YUYV frame into the caller's tensor buffer.
+ *
+ * @param yuyv Source pixels, n_pixels * 2 bytes.  Need not be word aligned.
+ * @param out Destination, yuv_tensor_size() bytes (int8_t or uint8_t
+ *   elements according to config.type).
+ * @param n_pixels Number of pixels.  Must be even.
+ */
+void yuv_tensor_run(const yuv_tensor_t *tensor, const uint8_t *yuyv,
+                    void *out, size_t n_pixels);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _YUV_TENSOR_H_ */
@@ -0,0 +1,281 @@
+/**
+ * @file ascii_art_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of ASCII art rendering (firmware/src/ascii_art.c).
+ *
+ * Plays the output into a model terminal that understands the two escape
+ * sequences the renderer emits (clear screen and cursor position), and
+ * checks after every frame that the terminal shows each block's average
+ * luma through the ramp.  The frames are a 96 x 96 gradient with a square
+ * crossing it, so that a few lines change per frame.  Also checks that:
+ * - bad grids and empty ramps are rejected
+ * - the first frame and the first after ascii_art_invalidate() clear the
+ *   screen and draw every line, and ASCII_ART_MAX_OUTPUT() holds them
+ * - a static frame produces no output, and a change only its lines
+ * - lines that don't fit in a small buffer are drawn by later frames
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o ascii_art_test ascii_art_test.c \
+ *       ../firmware/src/ascii_art.c
+ *   ./ascii_art_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "ascii_art.h"
+#include "host/check.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define IMAGE_WIDTH 96
+#define IMAGE_HEIGHT 96
+#define FRAME_SIZE (IMAGE_WIDTH * IMAGE_HEIGHT * 2)
+#define OBJECT_SIZE 10
+#define N_FRAMES 64
+
+// Room for one line and its cursor positioning, for the small buffer check
+#define SMALL_OUTPUT(cols) (8 + (cols))
+
+/**
+ * @brief A terminal that understands clear screen and cursor position.
+ */
+typedef struct {
+    char cells[ASCII_ART_MAX_ROWS][ASCII_ART_MAX_COLS];
+    int row; // cursor, from 0
+    int col;
+    unsigned clears;
+    bool bad; // saw a sequence or position it doesn't understand
+} terminal_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Render frame n: a horizontal gradient with a square at a position
+ * that depends on n.
+ */
+static void make_frame(uint8_t *yuyv, int n);
+
+/**
+ * @brief Return the bytes the renderer emits to draw line row (from 0).
+ */
+static size_t line_output(int row, int cols);
+
+/**
+ * @brief Play renderer output into the terminal.
+ */
+static void play(terminal_t *term, const char *out, size_t len);
+
+/**
+ * @brief Return the number of lines on the terminal that don't show the
+ * frame as the config and ramp say.
+ */
+static int wrong_lines(const terminal_t *term, const ascii_art_config_t *config,
+                       const uint8_t *yuyv);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_frame[FRAME_SIZE];
+static char s_out[ASCII_ART_MAX_OUTPUT(ASCII_ART_MAX_ROWS, ASCII_ART_MAX_COLS)];
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    ascii_art_config_t config;
+    ascii_art_t art;
+    terminal_t term;
+
+    ascii_art_default_config(&config, IMAGE_WIDTH, IMAGE_HEIGHT);
+    printf("# default grid: %d x %d\n", config.cols, config.rows);
+    check(config.cols == 48 && config.rows == 24, "default grid");
+    ascii_art_config_t bad = config;
+    bad.cols = 0;
+    check(!ascii_art_init(&art, &bad), "zero columns accepted");
+    bad = config;
+    bad.rows = 7;
+    check(!ascii_art_init(&art, &bad), "uneven rows accepted");
+    bad = config;
+    bad.width = IMAGE_WIDTH * 2;
+    bad.cols = ASCII_ART_MAX_COLS * 2;
+    check(!ascii_art_init(&art, &bad), "too many columns accepted");
+    bad = config;
+    bad.ramp = "";
+    check(!ascii_art_init(&art, &bad), "empty ramp accepted");
+
+    // the default grid and the largest, each through a frame sequence
+    static const uint8_t grids[][2] = {{48, 24}, {96, 48}, {12, 6}};
+    for (size_t g = 0; g < sizeof(grids) / sizeof(grids[0]); g++) {
+        config.cols = grids[g][0];
+        config.rows = grids[g][1];
+        if (!ascii_art_init(&art, &config)) {
+            check(false, "init failed");
+            continue;
+        }
+        memset(&term, 0, sizeof(term));
+        size_t max_output = ASCII_ART_MAX_OUTPUT(config.rows, config.cols);
+        size_t full_output = 4;
+        for (int row = 0; row < config.rows; row++) {
+            full_output += line_output(row, config.cols);
+        }
+        for (int n = 0; n < N_FRAMES; n++) {
+            make_frame(s_frame, n);
+            size_t len = ascii_art_render(&art, s_frame, s_out, max_output);
+            play(&term, s_out, len);
+            if (n == 0) {
+                check(term.clears == 1 && len == full_output,
+                      "first frame isn't a full redraw");
+            }
+            if (wrong_lines(&term, &config, s_frame) != 0) {
+                printf("# %d x %d, frame %d: %d lines wrong\n", config.cols,
+                       config.rows, n, wrong_lines(&term, &config, s_frame));
+                check(false, "terminal doesn't show the frame");
+                break;
+            }
+        }
+
+        // the same frame again costs nothing, and a change only its lines
+        check(ascii_art_render(&art, s_frame, s_out, max_output) == 0,
+              "static frame produced output");
+        int changed = config.rows / 2;
+        size_t y = IMAGE_HEIGHT / config.rows * changed;
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            s_frame[(y * IMAGE_WIDTH + x) * 2] ^= 0x80;
+        }
+        size_t len = ascii_art_render(&art, s_frame, s_out, max_output);
+        play(&term, s_out, len);
+        check(len == line_output(changed, config.cols),
+              "a change in one line redrew others");
+        check(wrong_lines(&term, &config, s_frame) == 0,
+              "changed line not shown");
+
+        // after invalidating, with room for one line per frame
+        ascii_art_invalidate(&art);
+        int frames = 0;
+        do {
+            len = ascii_art_render(&art, s_frame, s_out,
+                                   4 + SMALL_OUTPUT(config.cols));
+            play(&term, s_out, len);
+            frames++;
+        } while (len > 0 && frames <= config.rows + 1);
+        check(term.clears == 2, "invalidate didn't clear the screen");
+        check(frames == config.rows + 1 &&
+                  wrong_lines(&term, &config, s_frame) == 0,
+              "lines left out weren't drawn later");
+        check(!term.bad, "unexpected output");
+    }
+
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void make_frame(uint8_t *yuyv, int n) {
+    int ox = (n * 5) % (IMAGE_WIDTH - OBJECT_SIZE);
+    int oy = (n * 3) % (IMAGE_HEIGHT - OBJECT_SIZE);
+    for (int y = 0; y < IMAGE_HEIGHT; y++) {
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            bool object = x >= ox && x < ox + OBJECT_SIZE && y >= oy &&
+                          y < oy + OBJECT_SIZE;
+            uint8_t *p = &yuyv[(y * IMAGE_WIDTH + x) * 2];
+            p[0] = object ? 255 - x * 2 : x * 255 / (IMAGE_WIDTH - 1);
+            p[1] = 128;
+        }
+    }
+}
+
+static size_t line_output(int row, int cols) {
+    char cursor[12];
+    return snprintf(cursor, sizeof(cursor), "\x1b[%d;1H", row + 1) + cols;
+}
+
+static void play(terminal_t *term, const char *out, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (out[i] != '\x1b') {
+            if (term->row >= ASCII_ART_MAX_ROWS ||
+                term->col >= ASCII_ART_MAX_COLS) {
+                term->bad = true;
+                return;
+            }
+            term->cells[term->row][term->col++] = out[i++];
+            continue;
+        }
+        int row;
+        int consumed;
+        if (len - i >= 4 && memcmp(&out[i], "\x1b[2J", 4) == 0) {
+            memset(term->cells, ' ', sizeof(term->cells));
+            term->clears++;
+            i += 4;
+        } else if (sscanf(&out[i], "\x1b[%d;1H%n", &row, &consumed) == 1 &&
+                   consumed > 0 && row >= 1) {
+            term->row = row - 1;
+            term->col = 0;
+            i += consumed;
+        } else {
+            term->bad = true;
+            return;
+        }
+    }
+}
+
+static int wrong_lines(const terminal_t *term, const ascii_art_config_t *config,
+                       const uint8_t *yuyv) {
+    int block_w = config->width / config->cols;
+    int block_h = config->height / config->rows;
+    size_t ramp_len = strlen(config->ramp);
+    int wrong = 0;
+
+    for (int row = 0; row < config->rows; row++) {
+        for (int col = 0; col < config->cols; col++) {
+            uint32_t sum = 0;
+            for (int y = row * block_h; y < (row + 1) * block_h; y++) {
+                for (int x = col * block_w; x < (col + 1) * block_w; x++) {
+                    sum += yuyv[(y * config->width + x) * 2];
+                }
+            }
+            uint32_t mean = sum / (block_w * block_h);
+            if (term->cells[row][col] != config->ramp[mean * ramp_len / 256]) {
+                wrong++;
+                break;
+            }
+        }
+    }
+    return wrong;
+}
+
+// *****************************************************************************
+// End of file
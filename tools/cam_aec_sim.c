@@ -0,0 +1,266 @@
+/**
+ * @file cam_aec_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the auto exposure / gain controller
+ * (firmware/src/cam_aec.c) in closed loop with a simulated sensor.
+ *
+ * Each scene is a recorded frame: the hex frame in yuv_test.txt, or frames
+ * of a recording made with cam_rx -o rec:FILE (cam_rec.h).  The sensor model
+ * undoes the gamma of the recorded luma to get each pixel's radiance
+ * relative to the recorded exposure, then renders frames at the controller's
+ * exposure and gain, with the scene lit from 1/256 to 256 times as brightly
+ * and the controller starting at its lowest, the firmware's initial and its
+ * highest setting.  As on the OV2640, a setting written after frame n first
+ * shows in frame n + 2.
+ *
+ * For every scene, brightness and start, checks that the controller settles
+ * (on target, or pinned at a limit the target lies beyond) within
+ * CAM_AEC_MAX_STEPS * update_interval + 2 frames, and that it then makes no
+ * further adjustment: it doesn't hunt on a static scene.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I. -I../firmware/src -o cam_aec_sim cam_aec_sim.c cam_rec.c \
+ *       ../firmware/src/cam_aec.c -lm
+ *   ./cam_aec_sim [yuv_test.txt | desk.crec]
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_aec.h"
+#include "cam_rec.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define IMAGE_WIDTH 96
+#define IMAGE_HEIGHT 96
+#define N_PIXELS (IMAGE_WIDTH * IMAGE_HEIGHT)
+#define FRAME_SIZE (N_PIXELS * 2)
+#define MAX_FRAME_SIZE (640 * 480 * 2)
+
+// As in app.c: the exposure the hex frame is assumed to be taken at, and the
+// controller's starting point
+#define AEC_INITIAL_EXPOSURE 300
+#define AEC_INITIAL_GAIN CAM_AEC_GAIN_UNITY
+
+#define GAMMA 2.2
+#define LATENCY 2          // frames from a register write to its effect
+#define N_FRAMES 200       // frames run per case
+#define MAX_SCENES 8       // frames of a recording used as scenes
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Read whitespace separated hex bytes.  Returns the number read.
+ */
+static size_t load_hex(const char *filename, uint8_t *buf, size_t size);
+
+/**
+ * @brief Derive each pixel's radiance from a frame taken at exposure_value
+ * (exposure * gain, Q4).
+ */
+static void set_scene(const uint8_t *yuyv, size_t n_pixels,
+                      uint32_t exposure_value);
+
+/**
+ * @brief Render the scene, lit brightness times as brightly as recorded, at
+ * exposure_value.
+ */
+static void render(double brightness, uint32_t exposure_value);
+
+/**
+ * @brief Run the loop on the current scene.  Returns false on failure.
+ */
+static bool run_case(const char *name, double brightness, uint32_t start);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_recorded[MAX_FRAME_SIZE];
+static uint8_t s_frame[MAX_FRAME_SIZE];
+static double s_radiance[MAX_FRAME_SIZE / 2];
+static size_t s_n_pixels;
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+    const char *filename = argc > 1 ? argv[1] : "yuv_test.txt";
+    static const double brightness[] = {1.0 / 256, 1.0 / 16, 1.0 / 4, 1,
+                                        4,         16,        256};
+    cam_aec_config_t config;
+    cam_rec_t rec;
+    char name[64];
+    bool ok = true;
+    int cases = 0;
+
+    cam_aec_default_config(&config);
+    uint32_t starts[] = {
+        (uint32_t)config.min_exposure * CAM_AEC_GAIN_UNITY,
+        (uint32_t)AEC_INITIAL_EXPOSURE * AEC_INITIAL_GAIN,
+        (uint32_t)config.max_exposure * config.max_gain,
+    };
+
+    int n_scenes = 1;
+    if (cam_rec_open(&rec, filename)) {
+        n_scenes = rec.count < MAX_SCENES ? rec.count : MAX_SCENES;
+    } else if (load_hex(filename, s_recorded, FRAME_SIZE) == FRAME_SIZE) {
+        rec.f = NULL;
+        set_scene(s_recorded, N_PIXELS,
+                  (uint32_t)AEC_INITIAL_EXPOSURE * AEC_INITIAL_GAIN);
+    } else {
+        fprintf(stderr, "%s: not a recording or a %d byte hex frame\n",
+                filename, FRAME_SIZE);
+        return 1;
+    }
+
+    printf("%-12s %10s %7s %6s %8s %9s\n", "scene", "brightness", "start",
+           "frames", "mean", "exposure");
+    for (int s = 0; s < n_scenes; s++) {
+        if (rec.f != NULL) {
+            cam_rec_frame_t meta;
+            uint32_t n = (uint32_t)((uint64_t)s * rec.count / n_scenes);
+            if (!cam_rec_read(&rec, n, &meta, s_recorded,
+                              sizeof(s_recorded))) {
+                fprintf(stderr, "%s: can't read frame %u\n", filename, n);
+                return 1;
+            }
+            uint32_t value = (uint32_t)meta.exposure * meta.gain;
+            set_scene(s_recorded, meta.length / 2,
+                      value > 0 ? value
+                                : (uint32_t)AEC_INITIAL_EXPOSURE *
+                                      AEC_INITIAL_GAIN);
+            snprintf(name, sizeof(name), "frame %u", n);
+        } else {
+            snprintf(name, sizeof(name), "%s", filename);
+        }
+        for (size_t b = 0; b < sizeof(brightness) / sizeof(brightness[0]);
+             b++) {
+            for (size_t i = 0; i < sizeof(starts) / sizeof(starts[0]); i++) {
+                ok &= run_case(name, brightness[b], starts[i]);
+                cases++;
+            }
+        }
+    }
+    if (rec.f != NULL) {
+        cam_rec_close(&rec);
+    }
+
+    printf("%d cases: %s\n", cases, ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t load_hex(const char *filename, uint8_t *buf, size_t size) {
+    FILE *f = fopen(filename, "r");
+    unsigned int byte;
+    size_t n = 0;
+
+    if (f == NULL) {
+        return 0;
+    }
+    while (n < size && fscanf(f, "%x", &byte) == 1) {
+        buf[n++] = byte;
+    }
+    fclose(f);
+    return n;
+}
+
+static void set_scene(const uint8_t *yuyv, size_t n_pixels,
+                      uint32_t exposure_value) {
+    s_n_pixels = n_pixels;
+    for (size_t i = 0; i < n_pixels; i++) {
+        s_radiance[i] = pow(yuyv[i * 2] / 255.0, GAMMA) / exposure_value;
+    }
+    // the chroma is carried over unchanged
+    memcpy(s_frame, yuyv, n_pixels * 2);
+}
+
+static void render(double brightness, uint32_t exposure_value) {
+    for (size_t i = 0; i < s_n_pixels; i++) {
+        double v = s_radiance[i] * brightness * exposure_value;
+        s_frame[i * 2] =
+            (uint8_t)(v >= 1.0 ? 255 : 255.0 * pow(v, 1.0 / GAMMA) + 0.5);
+    }
+}
+
+static bool run_case(const char *name, double brightness, uint32_t start) {
+    cam_aec_t aec;
+    cam_aec_stats_t stats;
+    uint32_t applied[LATENCY]; // applied[k]: setting used k frames on
+    int last_change = -LATENCY;
+
+    // the controller splits the exposure value into exposure and gain
+    cam_aec_init(&aec, NULL, 1, CAM_AEC_GAIN_UNITY);
+    cam_aec_init(&aec, NULL, start > aec.config.max_exposure
+                                 ? aec.config.max_exposure : 1,
+                 (uint16_t)(start > aec.config.max_exposure
+                                ? start / aec.config.max_exposure
+                                : start));
+    for (int k = 0; k < LATENCY; k++) {
+        applied[k] = (uint32_t)aec.exposure * aec.gain;
+    }
+
+    for (int n = 0; n < N_FRAMES; n++) {
+        render(brightness, applied[0]);
+        cam_aec_compute_stats(&aec, s_frame, s_n_pixels, &stats);
+        if (cam_aec_update(&aec, &stats)) {
+            last_change = n;
+        }
+        memmove(&applied[0], &applied[1],
+                (LATENCY - 1) * sizeof(applied[0]));
+        applied[LATENCY - 1] = (uint32_t)aec.exposure * aec.gain;
+    }
+    // first frame with the final setting
+    int settled = last_change + LATENCY;
+
+    uint32_t value = (uint32_t)aec.exposure * aec.gain;
+    bool pinned = value <= (uint32_t)aec.config.min_exposure *
+                               CAM_AEC_GAIN_UNITY ||
+                  value >= (uint32_t)aec.config.max_exposure *
+                               aec.config.max_gain;
+    int bound = CAM_AEC_MAX_STEPS * aec.config.update_interval + LATENCY;
+    bool ok = (aec.converged || pinned) && settled <= bound;
+
+    printf("%-12s %10g %7u %6d %8u %6u x%-4.1f%s\n", name, brightness,
+           start, settled, stats.mean, aec.exposure,
+           (double)aec.gain / CAM_AEC_GAIN_UNITY,
+           ok ? (aec.converged ? "" : "  (pinned)")
+              : settled > bound ? "  FAIL: still adjusting"
+                                : "  FAIL: off target");
+    return ok;
+}
@@ -0,0 +1,186 @@
+"""
+Host side of the command interface (firmware/src/host_cmd.h).
+
+Reads or changes the firmware's settings while it streams, or takes a
+snapshot: a single full resolution YUYV frame sent outside the stream.
+Settings take effect at the next frame boundary.
+
+Messages use the framing of firmware/src/frame_proto.h.
+
+Usage:
+    python cam_cmd.py /dev/ttyUSB0 get fps
+    python cam_cmd.py /dev/ttyUSB0 set format tiles
+    python cam_cmd.py COM3 set profile 1
+    python cam_cmd.py COM3 snapshot -o snapshot.yuv
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+import link_baud
+
+TYPE_FRAME_YUYV = 3
+TYPE_FRAGMENT = 7
+TYPE_COMMAND = 8
+TYPE_REPLY = 9
+
+FLAG_SNAPSHOT = 0x02
+
+OP_GET = 1
+OP_SET = 2
+OP_SNAPSHOT = 3
+
+PARAMS = {'profile': 1, 'fps': 2, 'format': 3, 'compression': 4,
+          'log_level': 5}
+
+# Names accepted for the values of some parameters
+VALUES = {
+    'format': ['raw', 'codec', 'tiles', 'progressive'],
+    'log_level': ['errors', 'reports', 'trace'],
+}
+
+STATUS = ['ok', 'unknown op', 'unknown parameter', 'value out of range',
+          'busy']
+
+FRAGMENT_HEADER = '<BBxxIII'
+FRAGMENT_HEADER_SIZE = 16
+
+REPLY_S = 1.0
+SNAPSHOT_S = 5.0
+
+
+class Reassembler:
+    """Rebuild fragmented messages; others pass through unchanged."""
+
+    def __init__(self):
+        self._tag = None
+        self._buf = bytearray()
+
+    def feed(self, msg):
+        """Return the whole message msg completes, or None."""
+        msg_type, flags, seq, payload = msg
+        if msg_type != TYPE_FRAGMENT:
+            return msg
+        if len(payload) < FRAGMENT_HEADER_SIZE:
+            return None
+        whole_type, whole_flags, tag, total, offset = struct.unpack_from(
+            FRAGMENT_HEADER, payload)
+        if offset == 0:
+            self._tag = (whole_type, whole_flags, tag, total)
+            self._buf = bytearray()
+        elif self._tag != (whole_type, whole_flags, tag, total) or \
+                offset != len(self._buf):
+            # a fragment was lost
+            self._tag = None
+            return None
+        self._buf += payload[FRAGMENT_HEADER_SIZE:]
+        if len(self._buf) < total:
+            return None
+        self._tag = None
+        return whole_type, whole_flags, seq, bytes(self._buf[:total])
+
+
+class Commander:
+    """Send commands and wait for their replies."""
+
+    def __init__(self, ser):
+        self.ser = ser
+        self._decoder = link_baud.Decoder()
+        self._fragments = Reassembler()
+        self._seq = 0
+        self._id = 0
+
+    def get(self, param):
+        return self._command(OP_GET, param)
+
+    def set(self, param, value):
+        return self._command(OP_SET, param, value)
+
+    def snapshot(self, timeout=SNAPSHOT_S):
+        """Return (width, height, yuyv) of a snapshot."""
+        self._command(OP_SNAPSHOT, 0)
+        payload = self._await(
+            lambda t, f, p: t == TYPE_FRAME_YUYV and f & FLAG_SNAPSHOT,
+            timeout)
+        if payload is None:
+            raise RuntimeError("no snapshot received")
+        width, height = struct.unpack_from('<HH', payload)
+        return width, height, payload[4:]
+
+    def _command(self, op, param, value=None):
+        self._id = (self._id + 1) & 0xff
+        payload = bytes([op, self._id, param])
+        if value is not None:
+            payload += struct.pack('<I', value)
+        self.ser.write(link_baud.encode(TYPE_COMMAND, self._seq, payload))
+        self._seq += 1
+        reply = self._await(
+            lambda t, f, p: t == TYPE_REPLY and len(p) >= 8 and
+            p[1] == self._id, REPLY_S)
+        if reply is None:
+            raise RuntimeError("no reply")
+        status, = reply[3:4]
+        if status != 0:
+            name = STATUS[status] if status < len(STATUS) else str(status)
+            raise RuntimeError("refused: %s" % name)
+        return struct.unpack_from('<I', reply, 4)[0]
+
+    def _await(self, match, timeout):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            for msg in self._decoder.feed(
+                    self.ser.read(self.ser.in_waiting or 1)):
+                msg = self._fragments.feed(msg)
+                if msg is not None and match(msg[0], msg[1], msg[3]):
+                    return msg[3]
+        return None
+
+
+def parse_value(param, text):
+    names = VALUES.get(param, [])
+    if text in names:
+        return names.index(text)
+    return int(text, 0)
+
+
+def format_value(param, value):
+    names = VALUES.get(param, [])
+    return names[value] if value < len(names) else str(value)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="control the camera while it streams.")
+    parser.add_argument('--baud', type=int, default=link_baud.BASE_BAUD, help="Link rate. Defaults to %d." % link_baud.BASE_BAUD)
+    parser.add_argument('serial_port', help="Serial port to connect to, e.g. 'COM1' or '/dev/ttyUSB0'.")
+    commands = parser.add_subparsers(dest='command', required=True)
+    get = commands.add_parser('get', help="Read a setting.")
+    get.add_argument('param', choices=PARAMS)
+    set_ = commands.add_parser('set', help="Change a setting.")
+    set_.add_argument('param', choices=PARAMS)
+    set_.add_argument('value', help="A number, or for format and log_level a name.")
+    snap = commands.add_parser('snapshot', help="Save a full resolution YUYV frame.")
+    snap.add_argument('-o', '--output', default='snapshot.yuv', help="File to write. Defaults to snapshot.yuv.")
+    args = parser.parse_args()
+
+    cmd = Commander(serial.Serial(args.serial_port, args.baud, timeout=0.02))
+    try:
+        if args.command == 'get':
+            value = cmd.get(PARAMS[args.param])
+            print("%s = %s" % (args.param, format_value(args.param, value)))
+        elif args.command == 'set':
+            value = cmd.set(PARAMS[args.param],
+                            parse_value(args.param, args.value))
+            print("%s = %s" % (args.param, format_value(args.param, value)))
+        else:
+            width, height, yuyv = cmd.snapshot()
+            with open(args.output, 'wb') as f:
+                f.write(yuyv)
+            print("# snapshot: %dx%d, %d bytes to %s" %
+                  (width, height, len(yuyv), args.output))
+    except RuntimeError as e:
+        print("# %s" % e)
+        sys.exit(1)
@@ -0,0 +1,420 @@
+/**
+ * @file cam_meta_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the per-frame sensor metadata (firmware/src/cam_meta.c)
+ * as cam_data_task.c samples it at 96 x 96.
+ *
+ * Runs cam_data_task.c on a generated recording (host/cam_replay.h), with
+ * cam_meta.c and ov2640_i2c.c queuing their reads through the Harmony I2C
+ * driver (drv_i2c.c) to a stand-in TWIHS0 PLIB that models the OV2640's
+ * register banks.  As in drv_i2c_sim.c, a transfer completes only when the
+ * test runs the "interrupt", here once per pass of the loop that steps
+ * cam_data_task.  The frame callback writes a new gain each frame, as
+ * cam_aec does.  Checks that:
+ * - every frame is delivered with valid metadata holding every register of
+ *   the default list, with no overruns or errors;
+ * - the gain in each frame's metadata is the one in effect when it was read
+ *   out, i.e. the write made by the previous frame's callback, not the one
+ *   made by its own;
+ * - when the bus stalls, frames are still delivered, without metadata, the
+ *   stall is counted once in overruns, and sampling resumes once the bus
+ *   recovers.
+ *
+ * Build and run from this directory:
+ *   cc -O1 -g -fsanitize=address,undefined -DHOST_DRV_I2C \
+ *       -DCAM_REPLAY_WITH_META -I. -Ihost -I../firmware/src \
+ *       -I../firmware/src/config/default -o cam_meta_test cam_meta_test.c \
+ *       cam_rec.c host/cam_replay.c ../firmware/src/cam_data_task.c \
+ *       ../firmware/src/cam_meta.c ../firmware/src/ov2640_i2c.c \
+ *       ../firmware/src/config/default/driver/i2c/src/drv_i2c.c \
+ *       ../firmware/src/frame_stats.c ../firmware/src/yuv_convert.c
+ *   ./cam_meta_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_data_task.h"
+#include "cam_meta.h"
+#include "cam_rec.h"
+#include "cam_replay.h"
+#include "definitions.h"
+#include "host/check.h"
+#include "ov2640_i2c.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define WIDTH 96
+#define HEIGHT 96
+#define FRAME_BYTES (WIDTH * HEIGHT * 2)
+#define FRAMES 20
+#define FRAME_US 33333
+
+// Frames delivered during the stall
+#define STALL_FRAMES 3
+
+#define OV2640_ADDR (0x60 >> 1)
+#define BANK_SELECT 0xff
+#define INITIAL_GAIN 0x05
+
+// The transfer on the stand-in bus, applied when it completes
+typedef struct {
+    bool busy;
+    uint8_t kind; // 'w' write, 'r' write-read, 'p' write pairs
+    uint8_t *wdata;
+    uint32_t wlength;
+    uint8_t *rdata;
+    uint32_t count;
+} bus_transfer_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static bool twihs_read(uint16_t address, uint8_t *data, uint32_t length);
+static bool twihs_write(uint16_t address, uint8_t *data, uint32_t length);
+static bool twihs_write_read(uint16_t address, uint8_t *wdata,
+                             uint32_t wlength, uint8_t *rdata,
+                             uint32_t rlength);
+static bool twihs_write_pairs(uint16_t address, uint8_t *pairs,
+                              uint32_t count);
+static DRV_I2C_ERROR twihs_error_get(void);
+static bool twihs_transfer_setup(DRV_I2C_TRANSFER_SETUP *setup,
+                                 uint32_t src_clk_freq);
+static void twihs_transfer_abort(void);
+static void twihs_callback_register(DRV_I2C_PLIB_CALLBACK callback,
+                                    uintptr_t context);
+
+/**
+ * @brief Start a transfer on the stand-in bus.
+ */
+static bool twihs_start(uint16_t address, bus_transfer_t transfer);
+
+/**
+ * @brief Finish the transfer on the bus, if any, and run the PLIB callback:
+ * the TWIHS0 "interrupt".
+ */
+static void twihs_interrupt(void);
+
+/**
+ * @brief Write a sensor register, honouring the bank select register.
+ */
+static void sensor_write(uint8_t addr, uint8_t value);
+
+/**
+ * @brief Write a recording of FRAMES gray frames to path.
+ */
+static bool make_recording(const char *path);
+
+/**
+ * @brief Step cam_data_task until frames have been delivered, running the
+ * bus interrupt once per pass unless the bus is stalled.
+ */
+static void run_frames(uint32_t frames, bool stalled);
+
+/**
+ * @brief cam_data_task frame callback: check the metadata and write a new
+ * gain.
+ */
+static void on_frame(cam_frame_t *frame, uintptr_t context);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const DRV_I2C_PLIB_INTERFACE s_plib = {
+    .read_t = twihs_read,
+    .write_t = twihs_write,
+    .writeRead = twihs_write_read,
+    .writePairs = twihs_write_pairs,
+    .transferAbort = twihs_transfer_abort,
+    .errorGet = twihs_error_get,
+    .transferSetup = twihs_transfer_setup,
+    .callbackRegister = twihs_callback_register,
+};
+
+static DRV_I2C_CLIENT_OBJ s_client_pool[DRV_I2C_CLIENTS_NUMBER_IDX0];
+static DRV_I2C_TRANSFER_OBJ s_transfer_pool[DRV_I2C_QUEUE_SIZE_IDX0];
+
+static const DRV_I2C_INIT s_init = {
+    .i2cPlib = &s_plib,
+    .numClients = DRV_I2C_CLIENTS_NUMBER_IDX0,
+    .clientObjPool = (uintptr_t)&s_client_pool[0],
+    .transferObjPool = (uintptr_t)&s_transfer_pool[0],
+    .transferObjPoolSize = DRV_I2C_QUEUE_SIZE_IDX0,
+    .clockSpeed = DRV_I2C_CLOCK_SPEED_IDX0,
+};
+
+// The stand-in TWIHS0 and the sensor behind it
+static DRV_I2C_PLIB_CALLBACK s_plib_cb;
+static uintptr_t s_plib_context;
+static bus_transfer_t s_bus;
+static DRV_I2C_ERROR s_error;
+static uint8_t s_regs[2][256]; // by ov2640_i2c_bank_t
+static uint8_t s_bank;
+
+static uint8_t s_frame_buf[2][FRAME_BYTES];
+
+// What the frame callback saw, and the gain it wrote last
+static uint32_t s_delivered;
+static uint32_t s_valid;
+static uint8_t s_expected_gain;
+static ov2640_i2c_pair_t s_gain_pairs[2];
+static bool s_check_gain;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/cam_meta_test_%d.crec", (int)getpid());
+    check(make_recording(path), "recording written");
+
+    cam_replay_config_t config;
+    cam_replay_default_config(&config);
+    config.speed = 0;
+    config.loop = true;
+    check(cam_replay_open(path, &config), "recording opened");
+    remove(path);
+
+    SYS_MODULE_OBJ obj = DRV_I2C_Initialize(DRV_I2C_INDEX_0,
+                                            (SYS_MODULE_INIT *)&s_init);
+    check(obj != SYS_MODULE_OBJ_INVALID, "driver initialized");
+    DRV_HANDLE i2c = DRV_I2C_Open(DRV_I2C_INDEX_0, DRV_IO_INTENT_READWRITE);
+    check(i2c != DRV_HANDLE_INVALID, "driver opened");
+    ov2640_i2c_init(i2c);
+    cam_meta_init();
+    s_regs[OV2640_I2C_SENSOR_BANK][OV2640_I2C_GAIN] = INITIAL_GAIN;
+    s_expected_gain = INITIAL_GAIN;
+
+    cam_data_task_init(s_frame_buf[0], s_frame_buf[1], FRAME_BYTES);
+    cam_data_task_set_trace(false);
+    cam_data_task_set_frame_cb(on_frame, 0);
+    cam_data_task_start_capture();
+
+    // every frame carries the registers as they were at its readout
+    s_check_gain = true;
+    run_frames(FRAMES, false);
+    check(s_valid == FRAMES, "every frame has metadata");
+    cam_meta_stats_t stats;
+    cam_meta_get_stats(&stats);
+    check(stats.batches == FRAMES, "one batch of reads per frame");
+    check(stats.overruns == 0 && stats.errors == 0,
+          "no overruns or errors on a working bus");
+
+    // a stalled bus costs metadata, not frames
+    s_check_gain = false;
+    s_valid = 0;
+    run_frames(STALL_FRAMES, true);
+    check(s_valid == 0, "no metadata while the bus is stalled");
+    cam_meta_get_stats(&stats);
+    check(stats.overruns == 1, "the stall is counted once");
+
+    // and sampling resumes once it recovers
+    while (s_bus.busy) {
+        twihs_interrupt();
+    }
+    s_valid = 0;
+    run_frames(FRAMES, false);
+    check(s_valid >= FRAMES - 1, "metadata resumes after the stall");
+    cam_meta_get_stats(&stats);
+    check(stats.overruns == 1 && stats.errors == 0,
+          "no further overruns after the stall");
+
+    cam_replay_close();
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool twihs_read(uint16_t address, uint8_t *data, uint32_t length) {
+    return twihs_start(address, (bus_transfer_t){.kind = 'R', .rdata = data,
+                                                 .count = length});
+}
+
+static bool twihs_write(uint16_t address, uint8_t *data, uint32_t length) {
+    return twihs_start(address, (bus_transfer_t){.kind = 'w', .wdata = data,
+                                                 .wlength = length});
+}
+
+static bool twihs_write_read(uint16_t address, uint8_t *wdata,
+                             uint32_t wlength, uint8_t *rdata,
+                             uint32_t rlength) {
+    return twihs_start(address,
+                       (bus_transfer_t){.kind = 'r', .wdata = wdata,
+                                        .wlength = wlength, .rdata = rdata,
+                                        .count = rlength});
+}
+
+static bool twihs_write_pairs(uint16_t address, uint8_t *pairs,
+                              uint32_t count) {
+    return twihs_start(address, (bus_transfer_t){.kind = 'p', .wdata = pairs,
+                                                 .count = count});
+}
+
+static DRV_I2C_ERROR twihs_error_get(void) {
+    return s_error;
+}
+
+static bool twihs_transfer_setup(DRV_I2C_TRANSFER_SETUP *setup,
+                                 uint32_t src_clk_freq) {
+    (void)setup;
+    (void)src_clk_freq;
+    return true;
+}
+
+static void twihs_transfer_abort(void) {
+    s_bus.busy = false;
+}
+
+static void twihs_callback_register(DRV_I2C_PLIB_CALLBACK callback,
+                                    uintptr_t context) {
+    s_plib_cb = callback;
+    s_plib_context = context;
+}
+
+static bool twihs_start(uint16_t address, bus_transfer_t transfer) {
+    // as the PLIB, refuse while a transfer is on the bus
+    if (s_bus.busy || address != OV2640_ADDR) {
+        s_error = DRV_I2C_ERROR_BUS;
+        return false;
+    }
+    s_error = DRV_I2C_ERROR_NONE;
+    s_bus = transfer;
+    s_bus.busy = true;
+    return true;
+}
+
+static void twihs_interrupt(void) {
+    if (!s_bus.busy) {
+        return;
+    }
+    bus_transfer_t t = s_bus;
+    switch (t.kind) {
+    case 'w':
+        if (t.wlength == 2) {
+            sensor_write(t.wdata[0], t.wdata[1]);
+        }
+        break;
+    case 'r':
+        for (uint32_t i = 0; i < t.count; i++) {
+            t.rdata[i] = s_regs[s_bank][(uint8_t)(t.wdata[0] + i)];
+        }
+        break;
+    case 'p':
+        for (uint32_t i = 0; i < t.count; i++) {
+            sensor_write(t.wdata[2 * i], t.wdata[2 * i + 1]);
+        }
+        break;
+    default:
+        break;
+    }
+    s_bus.busy = false;
+    s_error = DRV_I2C_ERROR_NONE;
+    s_plib_cb(s_plib_context);
+}
+
+static void sensor_write(uint8_t addr, uint8_t value) {
+    if (addr == BANK_SELECT) {
+        s_bank = value & 1;
+    } else {
+        s_regs[s_bank][addr] = value;
+    }
+}
+
+static bool make_recording(const char *path) {
+    static uint8_t data[FRAME_BYTES];
+    cam_rec_t rec;
+
+    if (!cam_rec_create(&rec, path, WIDTH, HEIGHT)) {
+        return false;
+    }
+    bool ok = true;
+    for (uint32_t i = 0; i < FRAMES && ok; i++) {
+        // mid gray, a little brighter each frame
+        for (size_t j = 0; j < FRAME_BYTES; j += 2) {
+            data[j] = 100 + i;
+            data[j + 1] = 128;
+        }
+        cam_rec_frame_t frame = {
+            .length = FRAME_BYTES,
+            .time_us = (uint64_t)i * FRAME_US,
+            .frame_seq = i,
+            .mean_y = 100 + i,
+            .flags = CAM_REC_FLAG_EXACT,
+        };
+        ok = cam_rec_append(&rec, &frame, data);
+    }
+    return cam_rec_close(&rec) && ok;
+}
+
+static void run_frames(uint32_t frames, bool stalled) {
+    uint32_t until = s_delivered + frames;
+    while (s_delivered < until) {
+        cam_replay_wait();
+        if (!stalled) {
+            twihs_interrupt();
+        }
+        cam_data_task_step();
+    }
+}
+
+static void on_frame(cam_frame_t *frame, uintptr_t context) {
+    (void)context;
+    s_delivered++;
+    if (frame->meta.valid) {
+        s_valid++;
+        check(frame->meta.count == 5, "every default register sampled");
+    }
+
+    uint8_t gain;
+    bool found = cam_meta_lookup(&frame->meta, OV2640_I2C_SENSOR_BANK,
+                                 OV2640_I2C_GAIN, &gain);
+    if (s_check_gain) {
+        check(found && gain == s_expected_gain,
+              "gain is the one in effect at readout");
+    }
+
+    // as cam_aec would, for the next capture: the reads for this frame are
+    // already queued, so they must not see it
+    s_expected_gain = 0x10 + frame->seq % 0x40;
+    s_gain_pairs[0] = (ov2640_i2c_pair_t){BANK_SELECT, 0x01};
+    s_gain_pairs[1] = (ov2640_i2c_pair_t){OV2640_I2C_GAIN, s_expected_gain};
+    if (!s_check_gain || !ov2640_i2c_write_pairs_async(s_gain_pairs, 2, NULL,
+                                                       0)) {
+        s_expected_gain = s_regs[OV2640_I2C_SENSOR_BANK][OV2640_I2C_GAIN];
+    }
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,314 @@
+/**
+ * @file cam_rec.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Recordings of camera frames.  See cam_rec.h.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_rec.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+static const uint8_t FILE_MAGIC[4] = {'C', 'R', 'E', 'C'};
+static const uint8_t RECORD_MAGIC[4] = {'C', 'R', 'F', 'R'};
+static const uint8_t INDEX_MAGIC[4] = {'C', 'I', 'D', 'X'};
+
+#define INITIAL_CAPACITY 256
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Add an index entry, growing the index as needed.
+ */
+static bool add_entry(cam_rec_t *rec, uint64_t offset, uint64_t time_us);
+
+/**
+ * @brief Load the index from the footer.  Returns false if there is none.
+ */
+static bool load_index(cam_rec_t *rec);
+
+/**
+ * @brief Rebuild the index by walking the frame records.
+ */
+static bool scan_records(cam_rec_t *rec);
+
+/**
+ * @brief Read and check a frame record header at the current position.
+ */
+static bool read_record(cam_rec_t *rec, cam_rec_frame_t *frame);
+
+static void put_u16(uint8_t *p, uint16_t v);
+static void put_u32(uint8_t *p, uint32_t v);
+static void put_u64(uint8_t *p, uint64_t v);
+static uint16_t get_u16(const uint8_t *p);
+static uint32_t get_u32(const uint8_t *p);
+static uint64_t get_u64(const uint8_t *p);
+
+// *****************************************************************************
+// Public code
+
+bool cam_rec_create(cam_rec_t *rec, const char *path, uint16_t width,
+                    uint16_t height) {
+    uint8_t header[CAM_REC_HEADER_SIZE] = {0};
+
+    memset(rec, 0, sizeof(*rec));
+    rec->f = fopen(path, "wb");
+    if (rec->f == NULL) {
+        return false;
+    }
+    rec->writing = true;
+    rec->width = width;
+    rec->height = height;
+    memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+    put_u16(&header[4], CAM_REC_VERSION);
+    put_u16(&header[6], width);
+    put_u16(&header[8], height);
+    if (fwrite(header, 1, sizeof(header), rec->f) != sizeof(header)) {
+        fclose(rec->f);
+        rec->f = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool cam_rec_append(cam_rec_t *rec, const cam_rec_frame_t *frame,
+                    const uint8_t *data) {
+    uint8_t record[CAM_REC_RECORD_SIZE] = {0};
+    off_t offset = ftello(rec->f);
+
+    memcpy(record, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+    put_u32(&record[4], frame->length);
+    put_u64(&record[8], frame->time_us);
+    put_u32(&record[16], frame->frame_seq);
+    put_u16(&record[20], frame->exposure);
+    put_u16(&record[22], frame->gain);
+    record[24] = frame->mean_y;
+    record[25] = frame->flags;
+    return offset >= 0 &&
+           fwrite(record, 1, sizeof(record), rec->f) == sizeof(record) &&
+           fwrite(data, 1, frame->length, rec->f) == frame->length &&
+           add_entry(rec, (uint64_t)offset, frame->time_us);
+}
+
+bool cam_rec_open(cam_rec_t *rec, const char *path) {
+    uint8_t header[CAM_REC_HEADER_SIZE];
+
+    memset(rec, 0, sizeof(*rec));
+    rec->f = fopen(path, "rb");
+    if (rec->f == NULL) {
+        return false;
+    }
+    if (fread(header, 1, sizeof(header), rec->f) != sizeof(header) ||
+        memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        get_u16(&header[4]) != CAM_REC_VERSION) {
+        cam_rec_close(rec);
+        return false;
+    }
+    rec->width = get_u16(&header[6]);
+    rec->height = get_u16(&header[8]);
+    rec->indexed = load_index(rec);
+    if (!rec->indexed && !scan_records(rec)) {
+        cam_rec_close(rec);
+        return false;
+    }
+    return true;
+}
+
+bool cam_rec_read(cam_rec_t *rec, uint32_t n, cam_rec_frame_t *frame,
+                  uint8_t *data, size_t size) {
+    if (n >= rec->count ||
+        fseeko(rec->f, (off_t)rec->index[n].offset, SEEK_SET) != 0 ||
+        !read_record(rec, frame)) {
+        return false;
+    }
+    if (data == NULL) {
+        return true;
+    }
+    return frame->length <= size &&
+           fread(data, 1, frame->length, rec->f) == frame->length;
+}
+
+bool cam_rec_close(cam_rec_t *rec) {
+    bool ok = true;
+
+    if (rec->f != NULL && rec->writing) {
+        uint8_t entry[CAM_REC_INDEX_ENTRY_SIZE];
+        uint8_t footer[CAM_REC_FOOTER_SIZE];
+        off_t index_offset = ftello(rec->f);
+
+        ok = index_offset >= 0;
+        for (uint32_t i = 0; ok && i < rec->count; i++) {
+            put_u64(&entry[0], rec->index[i].offset);
+            put_u64(&entry[8], rec->index[i].time_us);
+            ok = fwrite(entry, 1, sizeof(entry), rec->f) == sizeof(entry);
+        }
+        put_u64(&footer[0], (uint64_t)index_offset);
+        put_u32(&footer[8], rec->count);
+        memcpy(&footer[12], INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        ok = ok && fwrite(footer, 1, sizeof(footer), rec->f) == sizeof(footer);
+    }
+    if (rec->f != NULL && fclose(rec->f) != 0) {
+        ok = false;
+    }
+    free(rec->index);
+    memset(rec, 0, sizeof(*rec));
+    return ok;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool add_entry(cam_rec_t *rec, uint64_t offset, uint64_t time_us) {
+    if (rec->count == rec->capacity) {
+        uint32_t capacity =
+            rec->capacity == 0 ? INITIAL_CAPACITY : rec->capacity * 2;
+        cam_rec_entry_t *index =
+            realloc(rec->index, capacity * sizeof(cam_rec_entry_t));
+        if (index == NULL) {
+            return false;
+        }
+        rec->index = index;
+        rec->capacity = capacity;
+    }
+    rec->index[rec->count].offset = offset;
+    rec->index[rec->count].time_us = time_us;
+    rec->count++;
+    return true;
+}
+
+static bool load_index(cam_rec_t *rec) {
+    uint8_t footer[CAM_REC_FOOTER_SIZE];
+    uint8_t entry[CAM_REC_INDEX_ENTRY_SIZE];
+
+    if (fseeko(rec->f, -CAM_REC_FOOTER_SIZE, SEEK_END) != 0) {
+        return false;
+    }
+    off_t footer_offset = ftello(rec->f);
+    if (footer_offset < 0 ||
+        fread(footer, 1, sizeof(footer), rec->f) != sizeof(footer) ||
+        memcmp(&footer[12], INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        return false;
+    }
+    uint64_t index_offset = get_u64(&footer[0]);
+    uint32_t count = get_u32(&footer[8]);
+    if (index_offset + (uint64_t)count * CAM_REC_INDEX_ENTRY_SIZE !=
+            (uint64_t)footer_offset ||
+        fseeko(rec->f, (off_t)index_offset, SEEK_SET) != 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (fread(entry, 1, sizeof(entry), rec->f) != sizeof(entry) ||
+            !add_entry(rec, get_u64(&entry[0]), get_u64(&entry[8]))) {
+            free(rec->index);
+            rec->index = NULL;
+            rec->count = rec->capacity = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool scan_records(cam_rec_t *rec) {
+    cam_rec_frame_t frame;
+    off_t offset = CAM_REC_HEADER_SIZE;
+
+    if (fseeko(rec->f, 0, SEEK_END) != 0) {
+        return false;
+    }
+    off_t end = ftello(rec->f);
+    while (end >= 0 && fseeko(rec->f, offset, SEEK_SET) == 0 &&
+           read_record(rec, &frame)) {
+        off_t next = offset + CAM_REC_RECORD_SIZE + (off_t)frame.length;
+        if (next > end) {
+            // cut short while writing the data
+            break;
+        }
+        if (!add_entry(rec, (uint64_t)offset, frame.time_us)) {
+            return false;
+        }
+        offset = next;
+    }
+    return true;
+}
+
+static bool read_record(cam_rec_t *rec, cam_rec_frame_t *frame) {
+    uint8_t record[CAM_REC_RECORD_SIZE];
+
+    if (fread(record, 1, sizeof(record), rec->f) != sizeof(record) ||
+        memcmp(record, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0) {
+        return false;
+    }
+    frame->length = get_u32(&record[4]);
+    frame->time_us = get_u64(&record[8]);
+    frame->frame_seq = get_u32(&record[16]);
+    frame->exposure = get_u16(&record[20]);
+    frame->gain = get_u16(&record[22]);
+    frame->mean_y = record[24];
+    frame->flags = record[25];
+    return true;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, v);
+    put_u16(p + 2, v >> 16);
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | (uint32_t)get_u16(p + 2) << 16;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    return get_u32(p) | (uint64_t)get_u32(p + 4) << 32;
+}
+
+// *****************************************************************************
+// End of file
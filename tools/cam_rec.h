@@ -0,0 +1,177 @@
+/**
+ * @file cam_rec.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Recordings of camera frames with their metadata, for replay on the
+ * host (see host/cam_replay.h).
+ *
+ * A recording is a file of YUYV frames, each stored as the bytes received
+ * with its sequence number, device time and exposure, followed by an index
+ * that gives the position and time of every frame, so a reader can seek
+ * straight to any frame.  All fields are little endian.
+ *
+ *   File header, CAM_REC_HEADER_SIZE bytes:
+ *     [0..3]   magic 'C' 'R' 'E' 'C'
+ *     [4..5]   version (CAM_REC_VERSION)
+ *     [6..7]   frame width in pixels
+ *     [8..9]   frame height in pixels
+ *     [10..31] zero
+ *   Frame records, each CAM_REC_RECORD_SIZE bytes and the frame data:
+ *     [0..3]   magic 'C' 'R' 'F' 'R'
+ *     [4..7]   data length
+ *     [8..15]  device time of readout, microseconds
+ *     [16..19] camera frame sequence number
+ *     [20..21] exposure, lines
+ *     [22..23] gain, Q4
+ *     [24]     mean luma
+ *     [25]     flags (CAM_REC_FLAG_*)
+ *     [26..31] zero
+ *   Index, written when the recording is closed, 16 bytes per frame:
+ *     [0..7]   file position of the frame record
+ *     [8..15]  device time
+ *   Footer, CAM_REC_FOOTER_SIZE bytes, at the end of the file:
+ *     [0..7]   file position of the index
+ *     [8..11]  number of frames
+ *     [12..15] magic 'C' 'I' 'D' 'X'
+ *
+ * A recording that was never closed (the recorder was killed, the disk
+ * filled) has no index; the reader then rebuilds it by walking the records,
+ * up to the last complete one.
+ *
+ * YUV4MPEG2 output (cam_rx.h) suits video tools; this format keeps what
+ * YUV4MPEG2 can't: the timing and metadata of each frame, and frames of
+ * different sizes.
+ */
+
+#ifndef _CAM_REC_H_
+#define _CAM_REC_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define CAM_REC_VERSION 1
+
+#define CAM_REC_HEADER_SIZE 32
+#define CAM_REC_RECORD_SIZE 32
+#define CAM_REC_INDEX_ENTRY_SIZE 16
+#define CAM_REC_FOOTER_SIZE 16
+
+// The data is exactly what the camera produced (it wasn't decimated or
+// coded lossily on the way)
+#define CAM_REC_FLAG_EXACT 0x01
+
+/**
+ * @brief A frame's metadata.
+ */
+typedef struct {
+    uint32_t length;    // data length in bytes
+    uint64_t time_us;   // device time of readout
+    uint32_t frame_seq; // camera frame sequence number
+    uint16_t exposure;  // lines
+    uint16_t gain;      // Q4
+    uint8_t mean_y;     // mean luma
+    uint8_t flags;      // CAM_REC_FLAG_*
+} cam_rec_frame_t;
+
+typedef struct {
+    uint64_t offset;  // file position of the frame record
+    uint64_t time_us; // device time
+} cam_rec_entry_t;
+
+typedef struct {
+    FILE *f;
+    bool writing;           // opened by cam_rec_create()
+    bool indexed;           // the index was read from the file
+    uint16_t width;         // frame width in pixels
+    uint16_t height;        // frame height in pixels
+    uint32_t count;         // frames in the recording
+    uint32_t capacity;      // entries allocated in index
+    cam_rec_entry_t *index; // one per frame
+} cam_rec_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Create a recording, replacing any file of the same name.
+ * @return false if the file can't be created.
+ */
+bool cam_rec_create(cam_rec_t *rec, const char *path, uint16_t width,
+                    uint16_t height);
+
+/**
+ * @brief Append a frame.  frame->length bytes are written from data.
+ * @return false if writing failed.
+ */
+bool cam_rec_append(cam_rec_t *rec, const cam_rec_frame_t *frame,
+                    const uint8_t *data);
+
+/**
+ * @brief Open a recording for reading, and load or rebuild its index.
+ * @return false if the file can't be read or isn't a recording.
+ */
+bool cam_rec_open(cam_rec_t *rec, const char *path);
+
+/**
+ * @brief Read frame n (counting from 0).
+ *
+ * @param data Receives the frame data, or NULL to read just the metadata.
+ * @param size Size of data.
+ * @return false if n is out of range, the frame is larger than size or the
+ *   file can't be read.
+ */
+bool cam_rec_read(cam_rec_t *rec, uint32_t n, cam_rec_frame_t *frame,
+                  uint8_t *data, size_t size);
+
+/**
+ * @brief Close a recording.  When writing, this writes the index.
+ * @return false if writing failed.
+ */
+bool cam_rec_close(cam_rec_t *rec);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _CAM_REC_H_ */
@@ -0,0 +1,470 @@
+/**
+ * @file cam_replay_bench.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host benchmark of the frame pipeline on recorded footage.
+ *
+ * Runs cam_data_task.c as built for the firmware, with the camera replaced
+ * by a recording (host/cam_replay.h, recordings are made with cam_rx -o
+ * rec:FILE), and times each downstream stage on every frame it delivers:
+ * pixel conversion to each of the RGB888, BGR888, RGB565, GRAY8 and planar
+ * CHW formats, statistics, metering, motion detection, compression and
+ * decimation.  Plane extraction (yuv_convert_deinterleave(), luma only and
+ * Y, U and V) is timed against a naive byte loop, whose output must match.
+ * On the host the SIMD intrinsics are emulated (host/definitions.h) while the
+ * compiler vectorizes the naive loop, so the two are only comparable on the
+ * target; here the comparison mainly checks the output.  Reports the time per stage and how closely the replay kept
+ * to the recorded frame timing.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I. -Ihost -I../firmware/src -o cam_replay_bench \
+ *       cam_replay_bench.c cam_rec.c host/cam_replay.c \
+ *       ../firmware/src/cam_data_task.c ../firmware/src/frame_stats.c \
+ *       ../firmware/src/yuv_convert.c ../firmware/src/cam_aec.c \
+ *       ../firmware/src/motion_detect.c ../firmware/src/yuv_codec.c \
+ *       ../firmware/src/tile_stream.c
+ *   ./cam_replay_bench [-s speed] [-n frames] [-l] desk.crec
+ * -s 0 runs flat out; -l loops the recording until -n frames are done.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_aec.h"
+#include "cam_data_task.h"
+#include "cam_rec.h"
+#include "cam_replay.h"
+#include "frame_stats.h"
+#include "motion_detect.h"
+#include "tile_stream.h"
+#include "yuv_codec.h"
+#include "yuv_convert.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// The camera FIFO holds this much more than the frame (see app.c)
+#define FIFO_EXTRA 8
+
+typedef enum {
+    STAGE_RGB888,
+    STAGE_BGR888,
+    STAGE_RGB565,
+    STAGE_GRAY8,
+    STAGE_RGB_PLANAR,
+    STAGE_LUMA,
+    STAGE_LUMA_NAIVE,   // after STAGE_LUMA, whose output it checks
+    STAGE_PLANES,
+    STAGE_PLANES_NAIVE, // after STAGE_PLANES, whose output it checks
+    STAGE_FRAME_STATS,
+    STAGE_AEC,
+    STAGE_MOTION, // after STAGE_LUMA, whose output it uses
+    STAGE_CODEC,
+    STAGE_TILES,
+    STAGE_DECIMATE,
+    N_STAGES,
+} stage_id_t;
+
+/**
+ * @brief A pipeline stage and its timings.
+ */
+typedef struct {
+    const char *name;
+    void (*run)(const uint8_t *yuyv); // process a frame
+    bool enabled;                     // set up for this frame size
+    uint32_t runs;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} stage_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Allocate the stage buffers for the recording's frame size.
+ */
+static bool setup_stages(uint16_t width, uint16_t height);
+
+static void on_frame(cam_frame_t *frame, uintptr_t context);
+
+static void run_rgb888(const uint8_t *yuyv);
+static void run_bgr888(const uint8_t *yuyv);
+static void run_rgb565(const uint8_t *yuyv);
+static void run_gray8(const uint8_t *yuyv);
+static void run_rgb_planar(const uint8_t *yuyv);
+static void run_luma(const uint8_t *yuyv);
+static void run_luma_naive(const uint8_t *yuyv);
+static void run_planes(const uint8_t *yuyv);
+static void run_planes_naive(const uint8_t *yuyv);
+
+/**
+ * @brief Extract planes one byte at a time, as the SIMD code replaced.
+ * u and v may be NULL for luma only.
+ */
+static void deinterleave_naive(const uint8_t *yuyv, uint8_t *y, uint8_t *u,
+                               uint8_t *v, size_t n_pixels);
+static void run_frame_stats(const uint8_t *yuyv);
+static void run_aec(const uint8_t *yuyv);
+static void run_motion(const uint8_t *yuyv);
+static void run_codec(const uint8_t *yuyv);
+static void run_tiles(const uint8_t *yuyv);
+static void run_decimate(const uint8_t *yuyv);
+
+static uint64_t now_ns(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static stage_t s_stages[N_STAGES] = {
+    [STAGE_RGB888] = {"rgb888", run_rgb888, true},
+    [STAGE_BGR888] = {"bgr888", run_bgr888, true},
+    [STAGE_RGB565] = {"rgb565", run_rgb565, true},
+    [STAGE_GRAY8] = {"gray8", run_gray8, true},
+    [STAGE_RGB_PLANAR] = {"rgb_planar", run_rgb_planar, true},
+    [STAGE_LUMA] = {"luma", run_luma, true},
+    [STAGE_LUMA_NAIVE] = {"luma_naive", run_luma_naive, true},
+    [STAGE_PLANES] = {"planes", run_planes, true},
+    [STAGE_PLANES_NAIVE] = {"planes_naive", run_planes_naive, true},
+    [STAGE_FRAME_STATS] = {"frame_stats", run_frame_stats, true},
+    [STAGE_AEC] = {"aec_stats", run_aec, true},
+    [STAGE_MOTION] = {"motion", run_motion, false},
+    [STAGE_CODEC] = {"codec", run_codec, true},
+    [STAGE_TILES] = {"tiles", run_tiles, false},
+    [STAGE_DECIMATE] = {"decimate", run_decimate, false},
+};
+
+static uint16_t s_width;
+static uint16_t s_height;
+static uint8_t *s_converted; // output of the conversion stages
+static uint8_t *s_luma;
+static uint8_t *s_planes;       // Y, U and V planes
+static uint8_t *s_naive;        // the same from the naive loop
+static uint32_t s_naive_errors; // frames where the naive output differed
+static uint8_t *s_background;
+static uint8_t *s_prev;
+static uint8_t *s_codec_out;
+static uint8_t *s_tile_ref;
+static uint8_t *s_tile_out;
+static uint8_t *s_decimated;
+static size_t s_codec_size;
+static size_t s_tile_size;
+static bool s_have_prev;
+static frame_stats_t s_stats;
+static cam_aec_t s_aec;
+static motion_detect_t s_motion;
+static tile_stream_t s_tiles;
+
+static uint32_t s_frames;
+static uint64_t s_first_ns;      // host time of the first frame
+static uint64_t s_last_ns;       // host time of the latest frame
+static uint64_t s_last_time_us;  // recorded time of the latest frame
+static uint64_t s_recorded_us;   // recorded time spanned, across loops
+static uint64_t s_pipeline_ns;   // total time in the stages
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+    cam_replay_config_t config;
+    uint32_t limit = 0;
+    int opt;
+
+    cam_replay_default_config(&config);
+    while ((opt = getopt(argc, argv, "s:n:l")) != -1) {
+        switch (opt) {
+        case 's':
+            config.speed = atof(optarg);
+            break;
+        case 'n':
+            limit = strtoul(optarg, NULL, 10);
+            break;
+        case 'l':
+            config.loop = true;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != argc - 1 || (config.loop && limit == 0)) {
+        fprintf(stderr, "usage: %s [-s speed] [-n frames] [-l] RECORDING\n"
+                        "  -s  1 for the recorded timing (default), 0 for "
+                        "flat out\n"
+                        "  -n  stop after this many frames (needed with -l)\n"
+                        "  -l  loop the recording\n",
+                argv[0]);
+        return 2;
+    }
+
+    // Open once to learn the frame size, which sets the FIFO size
+    cam_rec_t rec;
+    if (!cam_rec_open(&rec, argv[optind])) {
+        fprintf(stderr, "%s: not a readable recording\n", argv[optind]);
+        return 1;
+    }
+    s_width = rec.width;
+    s_height = rec.height;
+    printf("%s: %u frames of %ux%u%s\n", argv[optind], rec.count, s_width,
+           s_height, rec.indexed ? "" : " (index rebuilt)");
+    cam_rec_close(&rec);
+
+    size_t buflen = (size_t)s_width * s_height * 2 + FIFO_EXTRA;
+    config.fifo_size = buflen;
+    uint8_t *buf_a = malloc(buflen);
+    uint8_t *buf_b = malloc(buflen);
+    if (buf_a == NULL || buf_b == NULL || !setup_stages(s_width, s_height) ||
+        !cam_replay_open(argv[optind], &config)) {
+        fprintf(stderr, "%s: can't set up the replay\n", argv[optind]);
+        return 1;
+    }
+
+    cam_data_task_init(buf_a, buf_b, buflen);
+    cam_data_task_set_trace(false);
+    cam_data_task_set_frame_cb(on_frame, 0);
+    cam_data_task_start_capture();
+    while (!cam_replay_done() && (limit == 0 || s_frames < limit)) {
+        cam_replay_wait();
+        cam_data_task_step();
+    }
+    cam_replay_close();
+
+    if (s_frames == 0) {
+        fprintf(stderr, "no frames\n");
+        return 1;
+    }
+    printf("%-12s %10s %10s %10s\n", "stage", "mean us", "max us", "MB/s");
+    double frame_mb = (double)s_width * s_height * 2 / 1e6;
+    for (size_t i = 0; i < N_STAGES; i++) {
+        const stage_t *stage = &s_stages[i];
+        if (!stage->enabled || stage->runs == 0) {
+            printf("%-12s %10s\n", stage->name, "-");
+            continue;
+        }
+        double mean_us = stage->total_ns / 1e3 / stage->runs;
+        printf("%-12s %10.1f %10.1f %10.1f\n", stage->name, mean_us,
+               stage->max_ns / 1e3, frame_mb / (mean_us / 1e6));
+    }
+    double replay_s = (s_last_ns - s_first_ns) / 1e9;
+    double recorded_s = s_recorded_us / 1e6;
+    printf("%u frames in %.2f s (%.1f fps), recorded over %.2f s; pipeline "
+           "%.1f us/frame\n",
+           s_frames, replay_s, s_frames > 1 ? (s_frames - 1) / replay_s : 0,
+           recorded_s, s_pipeline_ns / 1e3 / s_frames);
+    free(buf_a);
+    free(buf_b);
+    if (s_naive_errors > 0) {
+        printf("plane extraction differs from the naive loop on %u frames\n",
+               s_naive_errors);
+        return 1;
+    }
+    return 0;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool setup_stages(uint16_t width, uint16_t height) {
+    size_t n_pixels = (size_t)width * height;
+    motion_detect_config_t motion_config;
+    tile_stream_config_t tile_config;
+
+    s_codec_size = YUV_CODEC_MAX_OUTPUT(width, height);
+    s_tile_size = TILE_STREAM_MAX_OUTPUT(width, height, 16);
+    size_t converted_size = 0;
+    for (int f = 0; f < YUV_CONVERT_FORMAT_COUNT; f++) {
+        size_t size = yuv_convert_output_size(f, n_pixels);
+        converted_size = size > converted_size ? size : converted_size;
+    }
+    s_converted = malloc(converted_size);
+    s_luma = malloc(n_pixels);
+    s_planes = malloc(n_pixels * 2);
+    s_naive = malloc(n_pixels * 2);
+    s_background = malloc(n_pixels);
+    s_prev = malloc(n_pixels * 2);
+    s_codec_out = malloc(s_codec_size);
+    s_tile_ref = malloc(n_pixels * 2);
+    s_tile_out = malloc(s_tile_size);
+    s_decimated = malloc(n_pixels / 2);
+    if (s_converted == NULL || s_luma == NULL || s_planes == NULL ||
+        s_naive == NULL || s_background == NULL ||
+        s_prev == NULL || s_codec_out == NULL || s_tile_ref == NULL ||
+        s_tile_out == NULL || s_decimated == NULL) {
+        return false;
+    }
+
+    // Stages with size limits run if the recording fits them
+    cam_aec_init(&s_aec, NULL, 0, 0);
+    motion_detect_default_config(&motion_config, width, height);
+    s_stages[STAGE_MOTION].enabled =
+        motion_detect_init(&s_motion, &motion_config, s_background);
+    tile_stream_default_config(&tile_config, width, height);
+    s_stages[STAGE_TILES].enabled =
+        tile_stream_init(&s_tiles, &tile_config, s_tile_ref);
+    s_stages[STAGE_DECIMATE].enabled = width % 4 == 0 && height % 2 == 0;
+    return true;
+}
+
+static void on_frame(cam_frame_t *frame, uintptr_t context) {
+    (void)context;
+    const cam_rec_frame_t *recorded = cam_replay_frame();
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < N_STAGES; i++) {
+        stage_t *stage = &s_stages[i];
+        if (!stage->enabled) {
+            continue;
+        }
+        uint64_t t0 = now_ns();
+        stage->run(frame->buf);
+        uint64_t ns = now_ns() - t0;
+        stage->runs++;
+        stage->total_ns += ns;
+        if (ns > stage->max_ns) {
+            stage->max_ns = ns;
+        }
+    }
+    memcpy(s_prev, frame->buf, (size_t)s_width * s_height * 2);
+    s_have_prev = true;
+    s_pipeline_ns += now_ns() - start;
+
+    if (s_frames == 0) {
+        s_first_ns = start;
+    } else if (recorded->time_us > s_last_time_us) {
+        // intervals only, so that wrapping around a loop adds nothing
+        s_recorded_us += recorded->time_us - s_last_time_us;
+    }
+    s_last_ns = start;
+    s_last_time_us = recorded->time_us;
+    s_frames++;
+}
+
+static void run_rgb888(const uint8_t *yuyv) {
+    yuv_convert(YUV_CONVERT_RGB888, yuyv, s_converted,
+                (size_t)s_width * s_height);
+}
+
+static void run_bgr888(const uint8_t *yuyv) {
+    yuv_convert(YUV_CONVERT_BGR888, yuyv, s_converted,
+                (size_t)s_width * s_height);
+}
+
+static void run_rgb565(const uint8_t *yuyv) {
+    yuv_convert(YUV_CONVERT_RGB565, yuyv, s_converted,
+                (size_t)s_width * s_height);
+}
+
+static void run_gray8(const uint8_t *yuyv) {
+    yuv_convert(YUV_CONVERT_GRAY8, yuyv, s_converted,
+                (size_t)s_width * s_height);
+}
+
+static void run_rgb_planar(const uint8_t *yuyv) {
+    yuv_convert(YUV_CONVERT_RGB_PLANAR, yuyv, s_converted,
+                (size_t)s_width * s_height);
+}
+
+static void run_luma(const uint8_t *yuyv) {
+    yuv_convert_deinterleave(yuyv, s_luma, NULL, NULL,
+                             (size_t)s_width * s_height);
+}
+
+static void run_luma_naive(const uint8_t *yuyv) {
+    size_t n_pixels = (size_t)s_width * s_height;
+    deinterleave_naive(yuyv, s_naive, NULL, NULL, n_pixels);
+    s_naive_errors += memcmp(s_naive, s_luma, n_pixels) != 0;
+}
+
+static void run_planes(const uint8_t *yuyv) {
+    size_t n_pixels = (size_t)s_width * s_height;
+    yuv_convert_deinterleave(yuyv, s_planes, s_planes + n_pixels,
+                             s_planes + n_pixels * 3 / 2, n_pixels);
+}
+
+static void run_planes_naive(const uint8_t *yuyv) {
+    size_t n_pixels = (size_t)s_width * s_height;
+    deinterleave_naive(yuyv, s_naive, s_naive + n_pixels,
+                       s_naive + n_pixels * 3 / 2, n_pixels);
+    s_naive_errors += memcmp(s_naive, s_planes, n_pixels * 2) != 0;
+}
+
+static void deinterleave_naive(const uint8_t *yuyv, uint8_t *y, uint8_t *u,
+                               uint8_t *v, size_t n_pixels) {
+    for (size_t i = 0; i < n_pixels; i += 2) {
+        *y++ = yuyv[0];
+        *y++ = yuyv[2];
+        if (u != NULL) {
+            *u++ = yuyv[1];
+            *v++ = yuyv[3];
+        }
+        yuyv += 4;
+    }
+}
+
+static void run_frame_stats(const uint8_t *yuyv) {
+    frame_stats_compute(yuyv, (size_t)s_width * s_height, &s_stats);
+}
+
+static void run_aec(const uint8_t *yuyv) {
+    cam_aec_stats_t stats;
+    cam_aec_compute_stats(&s_aec, yuyv, (size_t)s_width * s_height, &stats);
+    cam_aec_update(&s_aec, &stats);
+}
+
+static void run_motion(const uint8_t *yuyv) {
+    (void)yuyv;
+    // uses the Y plane extracted by run_luma
+    motion_detect_update(&s_motion, s_luma);
+}
+
+static void run_codec(const uint8_t *yuyv) {
+    yuv_codec_encode(yuyv, s_have_prev ? s_prev : NULL, s_width, s_height,
+                     s_codec_out, s_codec_size);
+}
+
+static void run_tiles(const uint8_t *yuyv) {
+    tile_stream_encode(&s_tiles, yuyv, s_tile_out, s_tile_size);
+}
+
+static void run_decimate(const uint8_t *yuyv) {
+    yuv_convert_decimate(yuyv, s_decimated, s_width, s_height);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// *****************************************************************************
+// End of file
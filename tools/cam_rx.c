@@ -0,0 +1,979 @@
+/**
+ * @file cam_rx.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host receiver for the camera stream.  See cam_rx.h.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_rx.h"
+
+#include "interlace.h"
+#include "tile_stream.h"
+#include "tx_pacer.h"
+#include "yuv_codec.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// FRAME_YUYV payload: width and height (u16) before the pixels
+#define YUYV_HEADER_SIZE 4
+
+// FRAME_ROI payload: x, y, width and height (u16) before the pixels
+#define ROI_HEADER_SIZE 8
+
+// Room for a LOG message
+#define MIN_SLOT_SIZE 4096
+
+// Bytes decoded between checks for a preview
+#define PREVIEW_CHUNK 256
+
+// Pixel pairs converted per pass of the RGB kernel
+#define RGB_BLOCK 32
+
+// Conversion coefficients in units of 1/10000, as in yuv_convert.h (which
+// can't be included here: its inline kernel uses Cortex-M intrinsics)
+#define COEF_R_V 14075
+#define COEF_G_U -3455
+#define COEF_G_V -7169
+#define COEF_B_U 17790
+
+// floor(n / 10000) for |n| < FLOOR_BIAS * 10000
+#define FLOOR_BIAS 256
+
+// Smoothing of the device timestamp rate estimate, as a shift
+#define TICK_RATE_SHIFT 4
+
+// Largest stored deflate block
+#define DEFLATE_BLOCK_MAX 65535
+#define ADLER_MOD 65521
+
+/**
+ * @brief A PNG chunk or stream being written: tracks the chunk CRC, the
+ * deflate blocks and the zlib checksum.
+ */
+typedef struct {
+    FILE *f;
+    bool ok;              // every write succeeded
+    uint32_t crc;         // CRC of the chunk so far
+    uint32_t block_left;  // bytes left in the current stored block
+    uint32_t stream_left; // uncompressed bytes left in the stream
+    uint32_t adler_a;
+    uint32_t adler_b;
+} png_writer_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief frame_proto callback: handle a message and move the decoder on to
+ * the next slot of the ring.
+ */
+static void on_message(const frame_proto_msg_t *msg, uintptr_t context);
+
+/**
+ * @brief Call the preview callback if another pass of a progressive frame
+ * has arrived.
+ */
+static void check_preview(cam_rx_t *rx);
+
+/**
+ * @brief Hold a frame message until its telemetry arrives, or deliver it
+ * now if it is tagged and its telemetry came first.
+ */
+static void hold_frame(cam_rx_t *rx, const frame_proto_msg_t *msg);
+
+/**
+ * @brief Keep the telemetry of a frame still to arrive.
+ */
+static void announce(cam_rx_t *rx, const frame_proto_telemetry_t *telemetry,
+                     double device_us);
+
+/**
+ * @brief Account for a telemetry message and complete the frame it
+ * describes.
+ */
+static void on_telemetry(cam_rx_t *rx, const frame_proto_msg_t *msg);
+
+/**
+ * @brief Decode the held frame and deliver it.  telemetry is NULL if the
+ * frame's telemetry was lost, else device_us is the device time of the
+ * frame.
+ */
+static void complete_frame(cam_rx_t *rx,
+                           const frame_proto_telemetry_t *telemetry,
+                           double device_us);
+
+/**
+ * @brief Decode the held frame into frame->yuyv, width and height.  Returns
+ * false if it can't be decoded.
+ */
+static bool decode_frame(cam_rx_t *rx, const uint8_t *payload,
+                         const frame_proto_telemetry_t *telemetry,
+                         cam_rx_frame_t *frame);
+
+/**
+ * @brief Return true if a delta frame of the given type can be decoded
+ * against the latest frame.
+ */
+static bool reference_usable(const cam_rx_t *rx, uint8_t type,
+                             const frame_proto_telemetry_t *telemetry);
+
+/**
+ * @brief Make the latest frame the reference for messages of the given
+ * type.
+ */
+static void set_reference(cam_rx_t *rx, uint8_t type,
+                          const frame_proto_telemetry_t *telemetry);
+
+/**
+ * @brief Link errors that may have cost a message.
+ */
+static uint32_t link_errors(const cam_rx_t *rx);
+
+/**
+ * @brief Advance the device clock to the telemetry's frame and return the
+ * device time in microseconds.
+ */
+static double device_time(cam_rx_t *rx,
+                          const frame_proto_telemetry_t *telemetry);
+
+/**
+ * @brief Double the size of a YUYV frame by repeating pixels and rows.
+ */
+static void upscale(const uint8_t *in, uint8_t *out, uint16_t width,
+                    uint16_t height);
+
+static inline int32_t floor_div10000(int32_t n);
+static inline uint8_t clamp_u8(int32_t v);
+
+static void png_put(png_writer_t *w, const void *data, size_t n);
+static void png_put_u32(png_writer_t *w, uint32_t v);
+static void png_chunk_begin(png_writer_t *w, const char *type,
+                            uint32_t length);
+static void png_chunk_end(png_writer_t *w);
+
+/**
+ * @brief Append uncompressed bytes to the zlib stream in the IDAT chunk,
+ * starting stored blocks as needed.
+ */
+static void png_deflate(png_writer_t *w, const uint8_t *data, size_t n);
+
+// *****************************************************************************
+// Public code
+
+bool cam_rx_init(cam_rx_t *rx, uint16_t max_width, uint16_t max_height,
+                 cam_rx_frame_cb_t frame_cb, cam_rx_log_cb_t log_cb,
+                 uintptr_t context) {
+    size_t frame_size = (size_t)max_width * max_height * 2;
+    size_t slot_size = YUV_CODEC_MAX_OUTPUT(max_width, max_height);
+
+    // a tile update of every tile carries an index byte per tile
+    if (slot_size < TILE_STREAM_HEADER_SIZE + TILE_STREAM_MAX_TILES +
+                        frame_size) {
+        slot_size = TILE_STREAM_HEADER_SIZE + TILE_STREAM_MAX_TILES +
+                    frame_size;
+    }
+    if (slot_size < MIN_SLOT_SIZE) {
+        slot_size = MIN_SLOT_SIZE;
+    }
+
+    memset(rx, 0, sizeof(*rx));
+    rx->slot_size = slot_size;
+    rx->max_width = max_width;
+    rx->max_height = max_height;
+    rx->frame_cb = frame_cb;
+    rx->log_cb = log_cb;
+    rx->context = context;
+    for (int i = 0; i < CAM_RX_SLOTS; i++) {
+        rx->slots[i] = malloc(slot_size);
+    }
+    rx->spare = malloc(slot_size);
+    for (int i = 0; i < 2; i++) {
+        rx->frames[i] = malloc(frame_size);
+    }
+    for (int i = 0; i < CAM_RX_SLOTS; i++) {
+        if (rx->slots[i] == NULL) {
+            cam_rx_free(rx);
+            return false;
+        }
+    }
+    if (rx->spare == NULL || rx->frames[0] == NULL || rx->frames[1] == NULL) {
+        cam_rx_free(rx);
+        return false;
+    }
+    frame_proto_decoder_init(&rx->decoder, rx->slots[0], slot_size,
+                             on_message, (uintptr_t)rx);
+    frame_proto_decoder_set_reassembly(&rx->decoder, rx->spare, slot_size);
+    return true;
+}
+
+void cam_rx_free(cam_rx_t *rx) {
+    for (int i = 0; i < CAM_RX_SLOTS; i++) {
+        free(rx->slots[i]);
+        rx->slots[i] = NULL;
+    }
+    free(rx->spare);
+    rx->spare = NULL;
+    for (int i = 0; i < 2; i++) {
+        free(rx->frames[i]);
+        rx->frames[i] = NULL;
+    }
+}
+
+void cam_rx_set_preview_cb(cam_rx_t *rx, cam_rx_frame_cb_t preview_cb) {
+    rx->preview_cb = preview_cb;
+}
+
+void cam_rx_feed(cam_rx_t *rx, const uint8_t *data, size_t n) {
+    rx->stats.bytes += n;
+    if (rx->preview_cb == NULL) {
+        frame_proto_decode(&rx->decoder, data, n);
+        return;
+    }
+    // in pieces, so a preview isn't held back by the rest of the input
+    while (n > 0) {
+        size_t chunk = n < PREVIEW_CHUNK ? n : PREVIEW_CHUNK;
+        frame_proto_decode(&rx->decoder, data, chunk);
+        check_preview(rx);
+        data += chunk;
+        n -= chunk;
+    }
+}
+
+void cam_rx_flush(cam_rx_t *rx) {
+    if (rx->has_pending) {
+        complete_frame(rx, NULL, 0);
+    }
+    rx->stats.link_lost += rx->n_announced;
+    rx->n_announced = 0;
+}
+
+const cam_rx_stats_t *cam_rx_stats(cam_rx_t *rx) {
+    rx->stats.link = rx->decoder.stats;
+    return &rx->stats;
+}
+
+uint64_t cam_rx_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void cam_rx_yuyv_to_rgb(const uint8_t *restrict yuyv, uint8_t *restrict rgb,
+                        size_t n_pixels) {
+    size_t pairs = n_pixels / 2;
+
+    // Each block is converted in passes over plain arrays, which the
+    // compiler vectorizes: the chroma terms of every pair, then each channel
+    // of every pixel, then the interleaving.
+    while (pairs > 0) {
+        size_t n = pairs < RGB_BLOCK ? pairs : RGB_BLOCK;
+        int16_t r_v[RGB_BLOCK];
+        int16_t g_uv[RGB_BLOCK];
+        int16_t b_u[RGB_BLOCK];
+        uint8_t r[2 * RGB_BLOCK];
+        uint8_t g[2 * RGB_BLOCK];
+        uint8_t b[2 * RGB_BLOCK];
+
+        for (size_t i = 0; i < n; i++) {
+            int32_t du = yuyv[4 * i + 1] - 128;
+            int32_t dv = yuyv[4 * i + 3] - 128;
+            r_v[i] = floor_div10000(COEF_R_V * dv);
+            g_uv[i] = floor_div10000(COEF_G_U * du + COEF_G_V * dv);
+            b_u[i] = floor_div10000(COEF_B_U * du);
+        }
+        for (size_t i = 0; i < 2 * n; i++) {
+            int16_t y = yuyv[2 * i];
+            r[i] = clamp_u8(y + r_v[i / 2]);
+            g[i] = clamp_u8(y + g_uv[i / 2]);
+            b[i] = clamp_u8(y + b_u[i / 2]);
+        }
+        for (size_t i = 0; i < 2 * n; i++) {
+            rgb[3 * i] = r[i];
+            rgb[3 * i + 1] = g[i];
+            rgb[3 * i + 2] = b[i];
+        }
+        yuyv += 4 * n;
+        rgb += 6 * n;
+        pairs -= n;
+    }
+}
+
+bool cam_rx_write_png(FILE *f, const uint8_t *rgb, uint16_t width,
+                      uint16_t height) {
+    static const uint8_t signature[8] = {0x89, 'P',  'N',  'G',
+                                         '\r', '\n', 0x1a, '\n'};
+    static const uint8_t zlib_header[2] = {0x78, 0x01};
+    png_writer_t w = {.f = f, .ok = true};
+    uint32_t row_size = 1 + (uint32_t)width * 3; // filter type, then pixels
+    uint32_t raw_size = row_size * height;
+    uint32_t blocks = (raw_size + DEFLATE_BLOCK_MAX - 1) / DEFLATE_BLOCK_MAX;
+
+    png_put(&w, signature, sizeof(signature));
+
+    png_chunk_begin(&w, "IHDR", 13);
+    png_put_u32(&w, width);
+    png_put_u32(&w, height);
+    // 8 bits, truecolor, deflate, adaptive filtering, no interlace
+    static const uint8_t format[5] = {8, 2, 0, 0, 0};
+    png_put(&w, format, sizeof(format));
+    png_chunk_end(&w);
+
+    // zlib header, stored blocks of up to 64K with a 5 byte header each,
+    // Adler-32
+    png_chunk_begin(&w, "IDAT", sizeof(zlib_header) + 5 * blocks +
+                                    raw_size + 4);
+    png_put(&w, zlib_header, sizeof(zlib_header));
+    w.stream_left = raw_size;
+    w.adler_a = 1;
+    for (uint16_t row = 0; row < height; row++) {
+        static const uint8_t filter_none = 0;
+        png_deflate(&w, &filter_none, 1);
+        png_deflate(&w, rgb + (size_t)row * width * 3, row_size - 1);
+    }
+    png_put_u32(&w, (w.adler_b % ADLER_MOD) << 16 | (w.adler_a % ADLER_MOD));
+    png_chunk_end(&w);
+
+    png_chunk_begin(&w, "IEND", 0);
+    png_chunk_end(&w);
+    return w.ok;
+}
+
+bool cam_rx_write_y4m_header(FILE *f, uint16_t width, uint16_t height,
+                             uint32_t fps) {
+    return fprintf(f, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C422\n", width, height,
+                   fps) > 0;
+}
+
+bool cam_rx_write_y4m_frame(FILE *f, const uint8_t *yuyv, uint16_t width,
+                            uint16_t height) {
+    uint8_t buf[4096];
+    size_t n_pixels = (size_t)width * height;
+    bool ok = fputs("FRAME\n", f) >= 0;
+
+    // Y is every other byte; U and V every fourth, from offsets 1 and 3
+    static const struct {
+        uint8_t offset;
+        uint8_t step;
+    } planes[3] = {{0, 2}, {1, 4}, {3, 4}};
+    for (int p = 0; p < 3; p++) {
+        size_t count = n_pixels * 2 / planes[p].step;
+        const uint8_t *in = yuyv + planes[p].offset;
+        while (count > 0) {
+            size_t n = count < sizeof(buf) ? count : sizeof(buf);
+            for (size_t i = 0; i < n; i++) {
+                buf[i] = in[i * planes[p].step];
+            }
+            ok = ok && fwrite(buf, 1, n, f) == n;
+            in += n * planes[p].step;
+            count -= n;
+        }
+    }
+    return ok;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void on_message(const frame_proto_msg_t *msg, uintptr_t context) {
+    cam_rx_t *rx = (cam_rx_t *)context;
+
+    if (msg->fragmented) {
+        // Swap the reassembled payload into the ring, where it is handled
+        // as if it had been received there
+        uint8_t *buf = rx->slots[rx->slot];
+        rx->slots[rx->slot] = rx->spare;
+        rx->spare = buf;
+        frame_proto_decoder_set_reassembly(&rx->decoder, rx->spare,
+                                           rx->slot_size);
+    }
+
+    switch (msg->type) {
+    case FRAME_PROTO_TYPE_FRAME_YUYV:
+    case FRAME_PROTO_TYPE_FRAME_CODEC:
+    case FRAME_PROTO_TYPE_FRAME_TILES:
+    case FRAME_PROTO_TYPE_FRAME_PROGRESSIVE:
+    case FRAME_PROTO_TYPE_FRAME_ROI:
+        // snapshots are requested out of band (see host_cmd.h) and aren't
+        // part of the stream
+        if (!(msg->flags & FRAME_PROTO_FLAG_SNAPSHOT)) {
+            hold_frame(rx, msg);
+        }
+        break;
+    case FRAME_PROTO_TYPE_TELEMETRY:
+        on_telemetry(rx, msg);
+        break;
+    case FRAME_PROTO_TYPE_LOG:
+        if (rx->log_cb != NULL) {
+            rx->log_cb((const char *)msg->payload, msg->length, rx->context);
+        }
+        break;
+    default:
+        break;
+    }
+
+    // The next message goes to the next slot.  A held frame is completed
+    // before its payload is overwritten.
+    rx->slot = (rx->slot + 1) % CAM_RX_SLOTS;
+    if (rx->has_pending && rx->pending_slot == rx->slot) {
+        complete_frame(rx, NULL, 0);
+    }
+    rx->decoder.buf = rx->slots[rx->slot];
+}
+
+static void check_preview(cam_rx_t *rx) {
+    const frame_proto_decoder_t *dec = &rx->decoder;
+    const uint8_t *payload;
+    uint32_t got;
+    bool tagged;
+    uint32_t id;
+
+    // The payload so far, reassembled or still being received
+    if (dec->reasm_active &&
+        dec->reasm_type == FRAME_PROTO_TYPE_FRAME_PROGRESSIVE) {
+        tagged = true;
+        payload = dec->reasm_buf;
+        got = dec->reasm_got;
+        id = dec->reasm_tag;
+    } else if (dec->state == FRAME_PROTO_STATE_PAYLOAD &&
+               dec->header[2] == FRAME_PROTO_TYPE_FRAME_PROGRESSIVE) {
+        tagged = false;
+        payload = dec->buf;
+        got = dec->pos;
+        id = dec->header[4] | dec->header[5] << 8;
+    } else {
+        return;
+    }
+    if (got < YUYV_HEADER_SIZE) {
+        return;
+    }
+    uint16_t width = payload[0] | payload[1] << 8;
+    uint16_t height = payload[2] | payload[3] << 8;
+    if (width > rx->max_width || height > rx->max_height || height == 0) {
+        return;
+    }
+    size_t row_bytes = (size_t)width * 2;
+    uint16_t rows = (got - YUYV_HEADER_SIZE) / row_bytes;
+    uint8_t passes = 0;
+    while (passes < INTERLACE_PASSES - 1 &&
+           rows >= interlace_pass_start(height, passes + 1)) {
+        passes++;
+    }
+    if (tagged != rx->preview_tagged || id != rx->preview_id) {
+        rx->preview_tagged = tagged;
+        rx->preview_id = id;
+        rx->preview_passes = 0;
+    }
+    // The last pass completes the frame, which is delivered as such
+    if (passes <= rx->preview_passes) {
+        return;
+    }
+    rx->preview_passes = passes;
+
+    // Into the work buffer: the latest frame may still be a reference
+    uint8_t *work = rx->frames[rx->current ^ 1];
+    interlace_restore(payload + YUYV_HEADER_SIZE, rows, work, height,
+                      row_bytes);
+    cam_rx_frame_t frame = {
+        .yuyv = work,
+        .width = width,
+        .height = height,
+        .source = CAM_RX_SOURCE_PROGRESSIVE,
+        .key = true,
+        .rx_us = cam_rx_now_us(),
+    };
+    frame.device_us = rx->has_offset ? (uint64_t)((double)frame.rx_us -
+                                                  rx->min_offset_us)
+                                     : (uint64_t)rx->device_us;
+    rx->stats.previews++;
+    rx->preview_cb(&frame, rx->context);
+}
+
+static void hold_frame(cam_rx_t *rx, const frame_proto_msg_t *msg) {
+    if (rx->has_pending) {
+        complete_frame(rx, NULL, 0);
+    }
+    rx->has_pending = true;
+    rx->pending_type = msg->type;
+    rx->pending_flags = msg->flags;
+    rx->pending_seq = msg->seq;
+    rx->pending_tagged = msg->fragmented;
+    rx->pending_tag = msg->tag;
+    rx->pending_slot = rx->slot;
+    rx->pending_length = msg->length;
+    rx->pending_rx_us = cam_rx_now_us();
+    if (!msg->fragmented) {
+        return;
+    }
+
+    // Fragmented frames arrive in order, so the frames announced before
+    // this one never will
+    uint8_t n = 0;
+    while (n < rx->n_announced &&
+           rx->announced[n].telemetry.frame_seq < msg->tag) {
+        n++;
+    }
+    rx->stats.link_lost += n;
+    bool found = n < rx->n_announced &&
+                 rx->announced[n].telemetry.frame_seq == msg->tag;
+    cam_rx_announced_t match;
+    if (found) {
+        match = rx->announced[n++];
+    }
+    rx->n_announced -= n;
+    memmove(rx->announced, &rx->announced[n],
+            rx->n_announced * sizeof(rx->announced[0]));
+    if (found) {
+        complete_frame(rx, &match.telemetry, match.device_us);
+    }
+}
+
+static void announce(cam_rx_t *rx, const frame_proto_telemetry_t *telemetry,
+                     double device_us) {
+    if (rx->n_announced == CAM_RX_ANNOUNCED) {
+        // too late to arrive
+        rx->stats.link_lost++;
+        rx->n_announced--;
+        memmove(rx->announced, &rx->announced[1],
+                rx->n_announced * sizeof(rx->announced[0]));
+    }
+    rx->announced[rx->n_announced].telemetry = *telemetry;
+    rx->announced[rx->n_announced].device_us = device_us;
+    rx->n_announced++;
+}
+
+static void on_telemetry(cam_rx_t *rx, const frame_proto_msg_t *msg) {
+    frame_proto_telemetry_t telemetry;
+
+    if (!frame_proto_unpack_telemetry(msg->payload, msg->length,
+                                      &telemetry)) {
+        return;
+    }
+    double device_us = device_time(rx, &telemetry);
+
+    if (telemetry.pacing == TX_PACER_SKIP) {
+        rx->stats.device_skipped++;
+    }
+    // The frame message goes immediately before its telemetry, unless it
+    // was fragmented: then its telemetry usually overtakes it
+    bool ours = rx->has_pending &&
+                (rx->pending_tagged
+                     ? rx->pending_tag == telemetry.frame_seq
+                     : rx->pending_seq == (uint16_t)(msg->seq - 1));
+    if (rx->has_pending && !ours) {
+        complete_frame(rx, NULL, 0);
+    }
+    if (!ours) {
+        if (telemetry.pacing != TX_PACER_SKIP) {
+            // counted as lost if the frame doesn't follow
+            announce(rx, &telemetry, device_us);
+        }
+        return;
+    }
+    complete_frame(rx, &telemetry, device_us);
+}
+
+static void complete_frame(cam_rx_t *rx,
+                           const frame_proto_telemetry_t *telemetry,
+                           double device_us) {
+    const uint8_t *payload = rx->slots[rx->pending_slot];
+    cam_rx_frame_t frame = {
+        .key = (rx->pending_flags & FRAME_PROTO_FLAG_KEY) != 0,
+        .msg_seq = rx->pending_seq,
+        .rx_us = rx->pending_rx_us,
+    };
+
+    rx->has_pending = false;
+    if (!decode_frame(rx, payload, telemetry, &frame)) {
+        rx->stats.undecodable++;
+        return;
+    }
+    if (telemetry != NULL) {
+        // Latency relative to the fastest frame so far
+        double offset = (double)frame.rx_us - device_us;
+        if (!rx->has_offset || offset < rx->min_offset_us) {
+            rx->min_offset_us = offset;
+            rx->has_offset = true;
+        }
+        frame.has_telemetry = true;
+        frame.telemetry = *telemetry;
+        frame.latency_us = (uint32_t)(offset - rx->min_offset_us);
+        frame.device_us = (uint64_t)device_us;
+        rx->stats.latency_count++;
+        rx->stats.latency_sum_us += frame.latency_us;
+        if (frame.latency_us > rx->stats.latency_max_us) {
+            rx->stats.latency_max_us = frame.latency_us;
+        }
+    } else {
+        // estimated from the arrival time
+        frame.device_us = rx->has_offset
+                              ? (uint64_t)((double)frame.rx_us -
+                                           rx->min_offset_us)
+                              : (uint64_t)rx->device_us;
+    }
+    rx->stats.frames++;
+    rx->stats.by_source[frame.source]++;
+    if (rx->frame_cb != NULL) {
+        rx->frame_cb(&frame, rx->context);
+    }
+}
+
+static bool decode_frame(cam_rx_t *rx, const uint8_t *payload,
+                         const frame_proto_telemetry_t *telemetry,
+                         cam_rx_frame_t *frame) {
+    uint32_t length = rx->pending_length;
+    uint8_t *work = rx->frames[rx->current ^ 1];
+    size_t frame_size = (size_t)rx->max_width * rx->max_height * 2;
+
+    switch (rx->pending_type) {
+    case FRAME_PROTO_TYPE_FRAME_YUYV: {
+        if (length < YUYV_HEADER_SIZE) {
+            return false;
+        }
+        uint16_t width = payload[0] | payload[1] << 8;
+        uint16_t height = payload[2] | payload[3] << 8;
+        if ((size_t)width * height * 2 != length - YUYV_HEADER_SIZE ||
+            width > rx->max_width || height > rx->max_height) {
+            return false;
+        }
+        // Sent straight from the payload, or scaled up if it was decimated
+        if (width * 2 == rx->width && height * 2 == rx->height) {
+            upscale(payload + YUYV_HEADER_SIZE, work, width, height);
+            rx->current ^= 1;
+            frame->yuyv = work;
+            frame->source = CAM_RX_SOURCE_DECIMATED;
+            rx->has_background = true;
+        } else if (rx->roi_seen) {
+            // kept for the ROI updates that follow
+            memcpy(work, payload + YUYV_HEADER_SIZE, length - YUYV_HEADER_SIZE);
+            rx->current ^= 1;
+            frame->yuyv = work;
+            frame->source = CAM_RX_SOURCE_RAW;
+            rx->width = width;
+            rx->height = height;
+            rx->has_background = true;
+        } else {
+            frame->yuyv = payload + YUYV_HEADER_SIZE;
+            frame->source = CAM_RX_SOURCE_RAW;
+            rx->width = width;
+            rx->height = height;
+            rx->has_background = false;
+        }
+        frame->width = rx->width;
+        frame->height = rx->height;
+        rx->ref_type = 0;
+        return true;
+    }
+
+    case FRAME_PROTO_TYPE_FRAME_PROGRESSIVE: {
+        if (length < YUYV_HEADER_SIZE) {
+            return false;
+        }
+        uint16_t width = payload[0] | payload[1] << 8;
+        uint16_t height = payload[2] | payload[3] << 8;
+        if ((size_t)width * height * 2 != length - YUYV_HEADER_SIZE ||
+            width > rx->max_width || height > rx->max_height) {
+            return false;
+        }
+        interlace_restore(payload + YUYV_HEADER_SIZE, height, work, height,
+                          (size_t)width * 2);
+        rx->current ^= 1;
+        rx->width = width;
+        rx->height = height;
+        frame->yuyv = work;
+        frame->source = CAM_RX_SOURCE_PROGRESSIVE;
+        frame->width = width;
+        frame->height = height;
+        rx->ref_type = 0;
+        rx->has_background = true;
+        return true;
+    }
+
+    case FRAME_PROTO_TYPE_FRAME_ROI: {
+        if (length < ROI_HEADER_SIZE) {
+            return false;
+        }
+        uint16_t x = payload[0] | payload[1] << 8;
+        uint16_t y = payload[2] | payload[3] << 8;
+        uint16_t width = payload[4] | payload[5] << 8;
+        uint16_t height = payload[6] | payload[7] << 8;
+        if ((size_t)width * height * 2 != length - ROI_HEADER_SIZE) {
+            return false;
+        }
+        rx->roi_seen = true;
+        if (!rx->has_background || x % 2 != 0 || x + width > rx->width ||
+            y + height > rx->height) {
+            return false;
+        }
+        // Pasted in place: the frame stays the background until the next
+        // full frame replaces it, but no delta can be decoded against it
+        uint8_t *row = rx->frames[rx->current] +
+                       ((size_t)y * rx->width + x) * 2;
+        for (uint16_t i = 0; i < height; i++) {
+            memcpy(row, payload + ROI_HEADER_SIZE + (size_t)i * width * 2,
+                   (size_t)width * 2);
+            row += (size_t)rx->width * 2;
+        }
+        frame->yuyv = rx->frames[rx->current];
+        frame->source = CAM_RX_SOURCE_ROI;
+        frame->width = rx->width;
+        frame->height = rx->height;
+        rx->ref_type = 0;
+        return true;
+    }
+
+    case FRAME_PROTO_TYPE_FRAME_CODEC: {
+        if (length < YUV_CODEC_HEADER_SIZE) {
+            return false;
+        }
+        uint16_t width = payload[4] | payload[5] << 8;
+        uint16_t height = payload[6] | payload[7] << 8;
+        const uint8_t *ref = NULL;
+        if (yuv_codec_needs_reference(payload, length)) {
+            if (!reference_usable(rx, FRAME_PROTO_TYPE_FRAME_CODEC,
+                                  telemetry) ||
+                width != rx->width || height != rx->height) {
+                return false;
+            }
+            ref = rx->frames[rx->current];
+        }
+        if (!yuv_codec_decode(payload, length, ref, work, frame_size)) {
+            rx->ref_type = 0;
+            return false;
+        }
+        rx->current ^= 1;
+        rx->width = width;
+        rx->height = height;
+        frame->source = CAM_RX_SOURCE_CODEC;
+        break;
+    }
+
+    case FRAME_PROTO_TYPE_FRAME_TILES: {
+        if (length < TILE_STREAM_HEADER_SIZE) {
+            return false;
+        }
+        uint16_t width = (uint16_t)payload[3] * payload[4];
+        uint16_t height = (uint16_t)payload[3] * payload[5];
+        bool key = (payload[2] & TILE_STREAM_FLAG_KEY) != 0;
+        if (width > rx->max_width || height > rx->max_height) {
+            return false;
+        }
+        if (!key &&
+            (!reference_usable(rx, FRAME_PROTO_TYPE_FRAME_TILES,
+                               telemetry) ||
+             width != rx->width || height != rx->height)) {
+            return false;
+        }
+        // Updates apply in place to the frame they were made against
+        if (!tile_stream_apply(payload, length, rx->frames[rx->current],
+                               (size_t)width * height * 2)) {
+            rx->ref_type = 0;
+            return false;
+        }
+        rx->width = width;
+        rx->height = height;
+        frame->key = key;
+        frame->source = CAM_RX_SOURCE_TILES;
+        break;
+    }
+
+    default:
+        return false;
+    }
+
+    set_reference(rx, rx->pending_type, telemetry);
+    rx->has_background = true;
+    frame->yuyv = rx->frames[rx->current];
+    frame->width = rx->width;
+    frame->height = rx->height;
+    return true;
+}
+
+static bool reference_usable(const cam_rx_t *rx, uint8_t type,
+                             const frame_proto_telemetry_t *telemetry) {
+    if (rx->ref_type != type) {
+        return false;
+    }
+    // A codec delta is made against the previous camera frame.  A tile
+    // update is made against the previous update, which can't be told from
+    // the telemetry; nor can a codec frame's without it: then any message
+    // lost since the reference may have been a frame.
+    if (type == FRAME_PROTO_TYPE_FRAME_CODEC && telemetry != NULL &&
+        rx->ref_seq_known) {
+        return telemetry->frame_seq == rx->ref_frame_seq + 1;
+    }
+    return link_errors(rx) == rx->ref_link_errors;
+}
+
+static void set_reference(cam_rx_t *rx, uint8_t type,
+                          const frame_proto_telemetry_t *telemetry) {
+    rx->ref_type = type;
+    rx->ref_seq_known = telemetry != NULL;
+    if (telemetry != NULL) {
+        rx->ref_frame_seq = telemetry->frame_seq;
+    }
+    rx->ref_link_errors = link_errors(rx);
+}
+
+static uint32_t link_errors(const cam_rx_t *rx) {
+    const frame_proto_stats_t *stats = &rx->decoder.stats;
+    return stats->lost + stats->crc_errors + stats->oversize +
+           stats->fragment_errors;
+}
+
+static double device_time(cam_rx_t *rx,
+                          const frame_proto_telemetry_t *telemetry) {
+    const frame_proto_telemetry_t *last = &rx->last_telemetry;
+
+    if (!rx->has_telemetry || telemetry->frame_seq <= last->frame_seq) {
+        // the first frame, or the device restarted
+        rx->device_us = 0;
+        rx->ticks_per_us = 0;
+        rx->has_offset = false;
+        rx->n_announced = 0;
+    } else {
+        uint32_t gap = telemetry->frame_seq - last->frame_seq;
+        uint32_t ticks = telemetry->timestamp - last->timestamp;
+        if (gap == 1) {
+            // interval_us is exact, and calibrates the timestamp rate
+            rx->device_us += telemetry->interval_us;
+            if (telemetry->interval_us > 0) {
+                double rate = (double)ticks / telemetry->interval_us;
+                rx->ticks_per_us +=
+                    rx->ticks_per_us == 0
+                        ? rate
+                        : (rate - rx->ticks_per_us) / (1 << TICK_RATE_SHIFT);
+            }
+        } else {
+            rx->stats.telemetry_lost += gap - 1;
+            rx->device_us += rx->ticks_per_us > 0
+                                 ? ticks / rx->ticks_per_us
+                                 : (double)telemetry->interval_us * gap;
+        }
+    }
+    rx->last_telemetry = *telemetry;
+    rx->has_telemetry = true;
+    return rx->device_us;
+}
+
+static void upscale(const uint8_t *in, uint8_t *out, uint16_t width,
+                    uint16_t height) {
+    size_t out_stride = (size_t)width * 4;
+
+    for (uint16_t row = 0; row < height; row++) {
+        uint8_t *top = out + 2 * row * out_stride;
+        // each input pair [y0 u y1 v] becomes [y0 u y0 v] [y1 u y1 v]
+        for (uint16_t x = 0; x < width / 2; x++) {
+            const uint8_t *p = in + 4 * x;
+            uint8_t *q = top + 8 * x;
+            q[0] = p[0];
+            q[1] = p[1];
+            q[2] = p[0];
+            q[3] = p[3];
+            q[4] = p[2];
+            q[5] = p[1];
+            q[6] = p[2];
+            q[7] = p[3];
+        }
+        memcpy(top + out_stride, top, out_stride);
+        in += (size_t)width * 2;
+    }
+}
+
+static inline int32_t floor_div10000(int32_t n) {
+    // biased to be non-negative so that division floors
+    return (int32_t)((uint32_t)(n + FLOOR_BIAS * 10000) / 10000) - FLOOR_BIAS;
+}
+
+static inline uint8_t clamp_u8(int32_t v) {
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static void png_put(png_writer_t *w, const void *data, size_t n) {
+    w->crc = frame_proto_crc32(w->crc, data, n);
+    w->ok = w->ok && fwrite(data, 1, n, w->f) == n;
+}
+
+static void png_put_u32(png_writer_t *w, uint32_t v) {
+    uint8_t be[4] = {v >> 24, v >> 16, v >> 8, v};
+    png_put(w, be, sizeof(be));
+}
+
+static void png_chunk_begin(png_writer_t *w, const char *type,
+                            uint32_t length) {
+    png_put_u32(w, length);
+    // the CRC covers the type and the data
+    w->crc = 0;
+    png_put(w, type, 4);
+}
+
+static void png_chunk_end(png_writer_t *w) {
+    png_put_u32(w, w->crc);
+}
+
+static void png_deflate(png_writer_t *w, const uint8_t *data, size_t n) {
+    while (n > 0) {
+        if (w->block_left == 0) {
+            uint32_t len = w->stream_left < DEFLATE_BLOCK_MAX
+                               ? w->stream_left
+                               : DEFLATE_BLOCK_MAX;
+            uint8_t header[5] = {len == w->stream_left, len, len >> 8,
+                                 ~len, ~len >> 8};
+            png_put(w, header, sizeof(header));
+            w->block_left = len;
+        }
+        size_t take = n < w->block_left ? n : w->block_left;
+        png_put(w, data, take);
+        for (size_t i = 0; i < take; i++) {
+            w->adler_a += data[i];
+            w->adler_b += w->adler_a;
+            // reduce before the sums can overflow (zlib's NMAX is 5552)
+            if ((i & 0xfff) == 0xfff) {
+                w->adler_a %= ADLER_MOD;
+                w->adler_b %= ADLER_MOD;
+            }
+        }
+        w->adler_a %= ADLER_MOD;
+        w->adler_b %= ADLER_MOD;
+        w->block_left -= take;
+        w->stream_left -= take;
+        data += take;
+        n -= take;
+    }
+}
+
+// *****************************************************************************
+// End of file
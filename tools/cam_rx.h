@@ -0,0 +1,311 @@
+/**
+ * @file cam_rx.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host receiver for the camera stream (firmware/src/frame_proto.h).
+ *
+ * Feed it the bytes read from the serial port (or any file descriptor: a
+ * pty, a pipe, a recording) and it calls back with each frame as YUYV,
+ * whatever form it was sent in:
+ * - FRAME_YUYV at full size is delivered straight from the payload buffer.
+ *   Payloads are received into a ring of buffers, rotated after every
+ *   message, so a frame is never copied after the decoder has assembled it.
+ *   Frames sent in fragments (uart_mux.h) are reassembled into a spare
+ *   buffer, which then takes the place of the slot in the ring.
+ * - FRAME_YUYV at half size (decimated by tx_pacer.h) is scaled back up to
+ *   the full size last seen.
+ * - FRAME_CODEC (yuv_codec.h) is decoded against the previous frame.  A
+ *   delta frame whose previous camera frame wasn't received can't be
+ *   decoded, and is counted as undecodable, as is every delta frame after
+ *   it until the next key frame.
+ * - FRAME_TILES (tile_stream.h) is applied to the frame held since the
+ *   last key frame, likewise until an update is lost.
+ * - FRAME_PROGRESSIVE (interlace.h) is put back in row order.  While one
+ *   arrives, an optional preview callback is given the whole frame as each
+ *   pass completes, the missing rows filled in from those above.  Previews
+ *   aren't checked by the payload CRC, unless the frame is fragmented: a
+ *   damaged frame is previewed but not delivered.
+ * - FRAME_ROI (a region of interest, see dual_stream.h) is pasted over the
+ *   latest full size frame.  Once a ROI has been seen, full size FRAME_YUYV
+ *   frames are copied to be kept for this; until one has been, a ROI can't
+ *   be decoded.
+ *
+ * A frame is delivered together with its telemetry, which the firmware
+ * sends right after it, so the callback sees the camera sequence number and
+ * exposure of the frame it is given.  A frame sent in fragments is tagged
+ * with its camera sequence number instead, and its telemetry, which may
+ * overtake it, is kept until it arrives.  Telemetry also drives the
+ * statistics:
+ * - loss: camera frames the device skipped to keep up with the link
+ *   (tx_pacer.h), frames sent but lost or damaged on the link, and frames
+ *   received that couldn't be decoded;
+ * - latency: the time from readout on the device to arrival at the host.
+ *   The two clocks aren't synchronized, so this is measured relative to the
+ *   fastest frame seen: it is the queueing delay added on top of the
+ *   transfer time of an unqueued frame.
+ *
+ * LOG messages are passed to an optional callback.
+ *
+ * Also here are the outputs used by the command line tool (cam_rx_cli.c):
+ * an RGB conversion bit-identical to the firmware's yuv_convert.h, written
+ * for the compiler to vectorize, and PNG and YUV4MPEG2 writers with no
+ * library dependencies.
+ */
+
+#ifndef _CAM_RX_H_
+#define _CAM_RX_H_
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// Payload buffers in the receive ring
+#define CAM_RX_SLOTS 4
+
+// Telemetry kept for fragmented frames still to arrive
+#define CAM_RX_ANNOUNCED 8
+
+/**
+ * @brief How a frame reached the host.
+ */
+typedef enum {
+    CAM_RX_SOURCE_RAW,       // FRAME_YUYV at full size
+    CAM_RX_SOURCE_DECIMATED, // FRAME_YUYV at half size, scaled up
+    CAM_RX_SOURCE_CODEC,     // FRAME_CODEC
+    CAM_RX_SOURCE_TILES,     // FRAME_TILES
+    CAM_RX_SOURCE_PROGRESSIVE, // FRAME_PROGRESSIVE
+    CAM_RX_SOURCE_ROI,       // FRAME_ROI over the latest full frame
+    CAM_RX_N_SOURCES,
+} cam_rx_source_t;
+
+/**
+ * @brief A received frame.  The data is valid until the callback returns.
+ */
+typedef struct {
+    const uint8_t *yuyv;         // width * height * 2 bytes
+    uint16_t width;              // pixels
+    uint16_t height;             // pixels
+    cam_rx_source_t source;      // how it was sent
+    bool key;                    // decodable without earlier frames
+    uint16_t msg_seq;            // frame_proto sequence number
+    uint64_t rx_us;              // host time of arrival (cam_rx_now_us())
+    bool has_telemetry;          // telemetry and latency_us are valid
+    frame_proto_telemetry_t telemetry; // device side details of the frame
+    uint32_t latency_us;         // relative latency (see above)
+    uint64_t device_us;          // device time of readout, from the
+                                 // telemetry or estimated from rx_us
+} cam_rx_frame_t;
+
+/**
+ * @brief Telemetry of a frame sent but not yet received.
+ */
+typedef struct {
+    frame_proto_telemetry_t telemetry;
+    double device_us;             // device time of readout
+} cam_rx_announced_t;
+
+typedef void (*cam_rx_frame_cb_t)(const cam_rx_frame_t *frame,
+                                  uintptr_t context);
+typedef void (*cam_rx_log_cb_t)(const char *text, size_t length,
+                                uintptr_t context);
+
+/**
+ * @brief Receiver statistics, cumulative since cam_rx_init().
+ */
+typedef struct {
+    uint32_t frames;            // frames delivered
+    uint32_t previews;          // previews of partly received frames
+    uint32_t by_source[CAM_RX_N_SOURCES]; // frames delivered, by source
+    uint32_t undecodable;       // frames received but not decodable
+    uint32_t device_skipped;    // camera frames the device didn't send
+    uint32_t link_lost;         // frames sent by the device but not received
+    uint32_t telemetry_lost;    // gaps in the camera sequence numbers
+    uint32_t latency_count;     // frames with a latency measurement
+    uint64_t latency_sum_us;    // sum of the measurements
+    uint32_t latency_max_us;    // largest measurement
+    uint64_t bytes;             // bytes fed to the receiver
+    frame_proto_stats_t link;   // frame_proto decoder statistics
+} cam_rx_stats_t;
+
+typedef struct {
+    frame_proto_decoder_t decoder;
+    uint8_t *slots[CAM_RX_SLOTS]; // payload ring
+    uint8_t *spare;               // reassembly buffer, swapped into the ring
+    size_t slot_size;             // capacity of each slot
+    uint8_t slot;                 // slot the decoder is filling
+    uint16_t max_width;           // largest frame accepted
+    uint16_t max_height;
+
+    // The latest frame message, decoded when its telemetry arrives
+    bool has_pending;
+    uint8_t pending_type;         // frame_proto_type_t
+    uint8_t pending_flags;
+    uint16_t pending_seq;         // message sequence number
+    bool pending_tagged;          // sent in fragments, tagged
+    uint32_t pending_tag;         // camera sequence number, if tagged
+    uint8_t pending_slot;         // slot holding the payload
+    uint32_t pending_length;      // payload length
+    uint64_t pending_rx_us;       // arrival time
+
+    // Decoded frames: the latest, which is the reference for the next
+    // delta frame, and a work buffer
+    uint8_t *frames[2];
+    uint8_t current;              // index of the latest in frames
+    uint16_t width;               // size of the latest full size frame
+    uint16_t height;
+    uint8_t ref_type;             // message type that can use the reference,
+                                  // 0 if it can't be used
+    bool ref_seq_known;           // ref_frame_seq is valid
+    uint32_t ref_frame_seq;       // camera sequence number of the reference
+    uint32_t ref_link_errors;     // link errors when the reference was made
+    bool has_background;          // the latest frame is in frames[current]
+    bool roi_seen;                // keep full frames for ROI updates
+
+    // Device clock, reconstructed from the telemetry
+    bool has_telemetry;           // last_telemetry is valid
+    frame_proto_telemetry_t last_telemetry;
+    double device_us;             // device time of last_telemetry
+    double ticks_per_us;          // device timestamp rate, 0 until known
+    bool has_offset;              // min_offset_us is valid
+    double min_offset_us;         // smallest arrival - device time seen
+
+    // The progressive frame being received, and its passes previewed
+    bool preview_tagged;          // preview_id is a tag, else a msg seq
+    uint32_t preview_id;
+    uint8_t preview_passes;
+
+    // Telemetry that overtook its fragmented frame, oldest first
+    cam_rx_announced_t announced[CAM_RX_ANNOUNCED];
+    uint8_t n_announced;
+
+    cam_rx_frame_cb_t frame_cb;
+    cam_rx_frame_cb_t preview_cb;
+    cam_rx_log_cb_t log_cb;
+    uintptr_t context;
+    cam_rx_stats_t stats;
+} cam_rx_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Initialize a receiver for frames of up to max_width x max_height.
+ *
+ * @param frame_cb Called for each frame.
+ * @param log_cb Called for each LOG message, or NULL.
+ * @return false if memory couldn't be allocated.
+ */
+bool cam_rx_init(cam_rx_t *rx, uint16_t max_width, uint16_t max_height,
+                 cam_rx_frame_cb_t frame_cb, cam_rx_log_cb_t log_cb,
+                 uintptr_t context);
+
+/**
+ * @brief Release the memory allocated by cam_rx_init().
+ */
+void cam_rx_free(cam_rx_t *rx);
+
+/**
+ * @brief Call preview_cb with a preview of each progressive frame as it
+ * arrives, or don't if it is NULL.  A preview has no telemetry, and its
+ * data is valid until the callback returns.
+ */
+void cam_rx_set_preview_cb(cam_rx_t *rx, cam_rx_frame_cb_t preview_cb);
+
+/**
+ * @brief Feed received bytes.  Callbacks are made from here.
+ */
+void cam_rx_feed(cam_rx_t *rx, const uint8_t *data, size_t n);
+
+/**
+ * @brief Deliver a frame still waiting for its telemetry, e.g. at the end of
+ * the input, and count frames whose telemetry arrived but which didn't as
+ * lost.
+ */
+void cam_rx_flush(cam_rx_t *rx);
+
+/**
+ * @brief Return the statistics, with the decoder's brought up to date.
+ */
+const cam_rx_stats_t *cam_rx_stats(cam_rx_t *rx);
+
+/**
+ * @brief Monotonic host time in microseconds.
+ */
+uint64_t cam_rx_now_us(void);
+
+/**
+ * @brief Convert YUYV to interleaved RGB888, with the same result as the
+ * firmware's yuv_convert_to_rgb888().
+ *
+ * @param n_pixels Number of pixels.  Must be even.
+ */
+void cam_rx_yuyv_to_rgb(const uint8_t *yuyv, uint8_t *rgb, size_t n_pixels);
+
+/**
+ * @brief Write an RGB888 image as a PNG file.  The image data is stored
+ * uncompressed (deflate stored blocks), which costs space but no time.
+ *
+ * @return false if writing failed.
+ */
+bool cam_rx_write_png(FILE *f, const uint8_t *rgb, uint16_t width,
+                      uint16_t height);
+
+/**
+ * @brief Write the YUV4MPEG2 stream header for 4:2:2 frames.  fps is the
+ * nominal frame rate.
+ */
+bool cam_rx_write_y4m_header(FILE *f, uint16_t width, uint16_t height,
+                             uint32_t fps);
+
+/**
+ * @brief Write a YUYV frame to a YUV4MPEG2 stream, as planar 4:2:2.
+ */
+bool cam_rx_write_y4m_frame(FILE *f, const uint8_t *yuyv, uint16_t width,
+                            uint16_t height);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _CAM_RX_H_ */
@@ -0,0 +1,511 @@
+/**
+ * @file cam_rx_cli.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Command line receiver for the camera stream (see cam_rx.h).
+ *
+ * Reads the stream from a serial port, or from any other file (a pty, a
+ * pipe, a capture of the raw bytes, or - for stdin), and writes the frames
+ * as a numbered PNG sequence, as a YUV4MPEG2 stream, or as a recording with
+ * each frame's timing and metadata for replay (cam_rec.h).  Statistics go to stderr once a
+ * second and at the end: frame rate, how frames arrived, what was lost and
+ * where, and the relative latency.
+ *
+ * A serial port is set to raw mode at the given rate.  On Linux any rate
+ * can be used, e.g. the firmware's 937500 base rate; elsewhere only the
+ * standard rates.
+ *
+ * Build from this directory:
+ *   cc -O3 -march=native -Ihost -I../firmware/src -o cam_rx cam_rx_cli.c \
+ *       cam_rx.c cam_rec.c ../firmware/src/frame_proto.c \
+ *       ../firmware/src/yuv_codec.c ../firmware/src/tile_stream.c \
+ *       ../firmware/src/interlace.c
+ * Examples:
+ *   ./cam_rx -b 937500 -o png:frames /dev/ttyACM0
+ *   ./cam_rx -b 937500 -o y4m:- /dev/ttyACM0 | ffplay -i -
+ *   ./cam_rx -n 100 -o y4m:capture.y4m - < capture.bin
+ *   ./cam_rx -b 937500 -o rec:desk.crec /dev/ttyACM0
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_rec.h"
+#include "cam_rx.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_BAUD 937500
+#define DEFAULT_FPS 30
+
+// Largest frame accepted
+#define MAX_WIDTH 640
+#define MAX_HEIGHT 480
+
+#define READ_SIZE 65536
+#define POLL_MS 250
+#define STATS_INTERVAL_US 1000000
+
+#ifdef __linux__
+// The kernel's struct termios2, declared here because <asm/termbits.h>
+// clashes with <termios.h>.  It takes an arbitrary rate with BOTHER.
+struct serial_termios2 {
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+#define SERIAL_TCGETS2 _IOR('T', 0x2a, struct serial_termios2)
+#define SERIAL_TCSETS2 _IOW('T', 0x2b, struct serial_termios2)
+#define SERIAL_CBAUD 0010017
+#define SERIAL_BOTHER 0010000
+#endif
+
+typedef enum {
+    OUTPUT_NONE,
+    OUTPUT_PNG, // numbered files in a directory
+    OUTPUT_Y4M, // one stream
+    OUTPUT_REC, // a recording
+} output_kind_t;
+
+typedef struct {
+    output_kind_t output;
+    const char *path;    // directory or file
+    FILE *y4m;           // the open stream
+    bool y4m_started;    // header written
+    cam_rec_t rec;       // the open recording
+    bool rec_started;    // recording created
+    uint16_t width;      // size in the y4m header
+    uint16_t height;
+    uint32_t fps;        // nominal rate for the y4m header
+    uint8_t *rgb;        // conversion buffer for PNG
+    uint32_t written;    // frames written
+    uint32_t mismatched; // frames not matching the y4m size, dropped
+    uint32_t limit;      // stop after this many frames, 0 for no limit
+    bool failed;         // an output error occurred
+} cli_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Open the input and, if it is a serial port, configure it.  Returns
+ * the file descriptor, or -1.
+ */
+static int open_input(const char *path, uint32_t baud);
+
+/**
+ * @brief Put a serial port in raw mode at the given rate.
+ */
+static bool configure_serial(int fd, uint32_t baud);
+
+/**
+ * @brief Return the termios constant for a standard rate, or 0.
+ */
+static speed_t standard_speed(uint32_t baud);
+
+/**
+ * @brief Parse "png:DIR", "y4m:FILE" or "rec:FILE".
+ */
+static bool parse_output(cli_t *cli, const char *arg);
+
+static void on_frame(const cam_rx_frame_t *frame, uintptr_t context);
+static void on_log(const char *text, size_t length, uintptr_t context);
+
+/**
+ * @brief Print the statistics, with the rates since the previous call.
+ */
+static void print_stats(cam_rx_t *rx, uint64_t now_us);
+
+static void usage(const char *name);
+
+// *****************************************************************************
+// Private (static) storage
+
+static cli_t s_cli;
+static uint8_t s_read_buf[READ_SIZE];
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+    uint32_t baud = DEFAULT_BAUD;
+    cam_rx_t rx;
+    int opt;
+
+    s_cli.fps = DEFAULT_FPS;
+    while ((opt = getopt(argc, argv, "b:o:n:r:")) != -1) {
+        switch (opt) {
+        case 'b':
+            baud = strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            if (!parse_output(&s_cli, optarg)) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'n':
+            s_cli.limit = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            s_cli.fps = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1 || baud == 0 || s_cli.fps == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int fd = open_input(argv[optind], baud);
+    if (fd < 0) {
+        return 1;
+    }
+    if (s_cli.output == OUTPUT_PNG) {
+        s_cli.rgb = malloc((size_t)MAX_WIDTH * MAX_HEIGHT * 3);
+    }
+    if (s_cli.output == OUTPUT_Y4M) {
+        s_cli.y4m = strcmp(s_cli.path, "-") == 0 ? stdout
+                                                 : fopen(s_cli.path, "wb");
+        if (s_cli.y4m == NULL) {
+            perror(s_cli.path);
+            return 1;
+        }
+    }
+    if ((s_cli.output == OUTPUT_PNG && s_cli.rgb == NULL) ||
+        !cam_rx_init(&rx, MAX_WIDTH, MAX_HEIGHT, on_frame, on_log,
+                     (uintptr_t)&s_cli)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    uint64_t stats_at = cam_rx_now_us() + STATS_INTERVAL_US;
+    bool done = false;
+    while (!done && !s_cli.failed) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        if (poll(&pfd, 1, POLL_MS) > 0) {
+            ssize_t n = read(fd, s_read_buf, sizeof(s_read_buf));
+            if (n < 0 && errno != EINTR && errno != EAGAIN) {
+                perror("read");
+                done = true;
+            } else if (n == 0) {
+                // end of a file or pipe
+                done = true;
+            } else if (n > 0) {
+                cam_rx_feed(&rx, s_read_buf, (size_t)n);
+            }
+        }
+        if (s_cli.limit > 0 && s_cli.written >= s_cli.limit) {
+            done = true;
+        }
+        uint64_t now = cam_rx_now_us();
+        if (now >= stats_at) {
+            print_stats(&rx, now);
+            stats_at = now + STATS_INTERVAL_US;
+        }
+    }
+    if (s_cli.limit == 0 || s_cli.written < s_cli.limit) {
+        cam_rx_flush(&rx);
+    }
+    print_stats(&rx, cam_rx_now_us());
+
+    if (s_cli.y4m != NULL && fflush(s_cli.y4m) != 0) {
+        s_cli.failed = true;
+    }
+    if (s_cli.y4m != NULL && s_cli.y4m != stdout) {
+        fclose(s_cli.y4m);
+    }
+    if (s_cli.rec_started && !cam_rec_close(&s_cli.rec)) {
+        perror(s_cli.path);
+        s_cli.failed = true;
+    }
+    if (s_cli.mismatched > 0) {
+        fprintf(stderr, "# rx: %u frames not %ux%u, not written\n",
+                s_cli.mismatched, s_cli.width, s_cli.height);
+    }
+    cam_rx_free(&rx);
+    free(s_cli.rgb);
+    close(fd);
+    return s_cli.failed ? 1 : 0;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static int open_input(const char *path, uint32_t baud) {
+    if (strcmp(path, "-") == 0) {
+        return STDIN_FILENO;
+    }
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (isatty(fd) && !configure_serial(fd, baud)) {
+        fprintf(stderr, "%s: can't set %u baud\n", path, baud);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool configure_serial(int fd, uint32_t baud) {
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) != 0) {
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~CRTSCTS;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+
+    speed_t speed = standard_speed(baud);
+    if (speed != 0) {
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        return tcsetattr(fd, TCSANOW, &tio) == 0;
+    }
+#ifdef __linux__
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        return false;
+    }
+    struct serial_termios2 tio2;
+    if (ioctl(fd, SERIAL_TCGETS2, &tio2) != 0) {
+        return false;
+    }
+    tio2.c_cflag = (tio2.c_cflag & ~SERIAL_CBAUD) | SERIAL_BOTHER;
+    tio2.c_ispeed = baud;
+    tio2.c_ospeed = baud;
+    return ioctl(fd, SERIAL_TCSETS2, &tio2) == 0;
+#else
+    return false;
+#endif
+}
+
+static speed_t standard_speed(uint32_t baud) {
+    static const struct {
+        uint32_t baud;
+        speed_t speed;
+    } speeds[] = {
+        {9600, B9600},     {19200, B19200},   {38400, B38400},
+        {57600, B57600},   {115200, B115200}, {230400, B230400},
+#ifdef B460800
+        {460800, B460800}, {921600, B921600}, {1000000, B1000000},
+        {2000000, B2000000}, {3000000, B3000000},
+#endif
+    };
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+        if (speeds[i].baud == baud) {
+            return speeds[i].speed;
+        }
+    }
+    return 0;
+}
+
+static bool parse_output(cli_t *cli, const char *arg) {
+    if (strncmp(arg, "png:", 4) == 0 && arg[4] != '\0') {
+        cli->output = OUTPUT_PNG;
+    } else if (strncmp(arg, "y4m:", 4) == 0 && arg[4] != '\0') {
+        cli->output = OUTPUT_Y4M;
+    } else if (strncmp(arg, "rec:", 4) == 0 && arg[4] != '\0') {
+        cli->output = OUTPUT_REC;
+    } else {
+        return false;
+    }
+    cli->path = arg + 4;
+    return true;
+}
+
+static void on_frame(const cam_rx_frame_t *frame, uintptr_t context) {
+    cli_t *cli = (cli_t *)context;
+
+    if (cli->failed || (cli->limit > 0 && cli->written >= cli->limit)) {
+        return;
+    }
+    if (cli->output == OUTPUT_PNG) {
+        char name[4096];
+        snprintf(name, sizeof(name), "%s/frame_%06u.png", cli->path,
+                 cli->written);
+        FILE *f = fopen(name, "wb");
+        if (f == NULL) {
+            perror(name);
+            cli->failed = true;
+            return;
+        }
+        cam_rx_yuyv_to_rgb(frame->yuyv, cli->rgb,
+                           (size_t)frame->width * frame->height);
+        bool ok = cam_rx_write_png(f, cli->rgb, frame->width, frame->height);
+        if (fclose(f) != 0 || !ok) {
+            perror(name);
+            cli->failed = true;
+            return;
+        }
+    } else if (cli->output == OUTPUT_Y4M) {
+        // the stream's size is fixed by its first frame
+        if (!cli->y4m_started) {
+            cli->width = frame->width;
+            cli->height = frame->height;
+            cli->y4m_started = true;
+            if (!cam_rx_write_y4m_header(cli->y4m, cli->width, cli->height,
+                                         cli->fps)) {
+                cli->failed = true;
+            }
+        }
+        if (frame->width != cli->width || frame->height != cli->height) {
+            cli->mismatched++;
+            return;
+        }
+        if (!cam_rx_write_y4m_frame(cli->y4m, frame->yuyv, frame->width,
+                                    frame->height)) {
+            perror(cli->path);
+            cli->failed = true;
+            return;
+        }
+    } else if (cli->output == OUTPUT_REC) {
+        cam_rec_frame_t rec_frame = {
+            .length = (uint32_t)frame->width * frame->height * 2,
+            .time_us = frame->device_us,
+            .frame_seq = frame->telemetry.frame_seq,
+            .exposure = frame->telemetry.exposure,
+            .gain = frame->telemetry.gain,
+            .mean_y = frame->telemetry.mean_y,
+            // decimated frames were scaled back up, tile updates are only
+            // within their change threshold, and a ROI is only current
+            // within the region
+            .flags = frame->source != CAM_RX_SOURCE_DECIMATED &&
+                             frame->source != CAM_RX_SOURCE_TILES &&
+                             frame->source != CAM_RX_SOURCE_ROI
+                         ? CAM_REC_FLAG_EXACT
+                         : 0,
+        };
+        if (!cli->rec_started) {
+            cli->rec_started = true;
+            if (!cam_rec_create(&cli->rec, cli->path, frame->width,
+                                frame->height)) {
+                perror(cli->path);
+                cli->rec_started = false;
+                cli->failed = true;
+                return;
+            }
+        }
+        if (!cam_rec_append(&cli->rec, &rec_frame, frame->yuyv)) {
+            perror(cli->path);
+            cli->failed = true;
+            return;
+        }
+    }
+    cli->written++;
+}
+
+static void on_log(const char *text, size_t length, uintptr_t context) {
+    (void)context;
+    fputs("# device: ", stderr);
+    fwrite(text, 1, length, stderr);
+    if (length == 0 || text[length - 1] != '\n') {
+        fputc('\n', stderr);
+    }
+}
+
+static void print_stats(cam_rx_t *rx, uint64_t now_us) {
+    static uint64_t s_last_us;
+    static uint32_t s_last_frames;
+    static uint64_t s_last_bytes;
+    const cam_rx_stats_t *stats = cam_rx_stats(rx);
+    double seconds = s_last_us > 0 ? (now_us - s_last_us) / 1e6 : 0;
+
+    fprintf(stderr,
+            "# rx: %u frames (%u raw, %u decimated, %u codec, %u tiles, "
+            "%u progressive, %u roi)",
+            stats->frames, stats->by_source[CAM_RX_SOURCE_RAW],
+            stats->by_source[CAM_RX_SOURCE_DECIMATED],
+            stats->by_source[CAM_RX_SOURCE_CODEC],
+            stats->by_source[CAM_RX_SOURCE_TILES],
+            stats->by_source[CAM_RX_SOURCE_PROGRESSIVE],
+            stats->by_source[CAM_RX_SOURCE_ROI]);
+    if (seconds > 0) {
+        fprintf(stderr, ", %.1f fps, %.1f KB/s",
+                (stats->frames - s_last_frames) / seconds,
+                (stats->bytes - s_last_bytes) / seconds / 1000);
+    }
+    fprintf(stderr, "\n# rx: lost %u skipped by device, %u on the link, "
+                    "%u undecodable, %u without telemetry\n",
+            stats->device_skipped, stats->link_lost, stats->undecodable,
+            stats->telemetry_lost);
+    fprintf(stderr, "# rx: link %u messages, %u lost, %u CRC errors, "
+                    "%u header errors, %u fragment errors, %u bytes skipped\n",
+            stats->link.messages, stats->link.lost, stats->link.crc_errors,
+            stats->link.header_errors, stats->link.fragment_errors,
+            stats->link.skipped);
+    if (stats->latency_count > 0) {
+        fprintf(stderr, "# rx: latency %.1f ms mean, %.1f ms max\n",
+                stats->latency_sum_us / 1e3 / stats->latency_count,
+                stats->latency_max_us / 1e3);
+    }
+    s_last_us = now_us;
+    s_last_frames = stats->frames;
+    s_last_bytes = stats->bytes;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [-b baud] [-o png:DIR | y4m:FILE | rec:FILE] "
+            "[-n frames] "
+            "[-r fps] INPUT\n"
+            "  INPUT   serial port, other file, or - for stdin\n"
+            "  -b      serial rate (default %u)\n"
+            "  -o      write frames as PNG files in DIR, or as a YUV4MPEG2\n"
+            "          stream to FILE (- for stdout), or as a recording for\n"
+            "          replay to FILE\n"
+            "  -n      stop after this many frames\n"
+            "  -r      frame rate in the YUV4MPEG2 header (default %u)\n",
+            name, DEFAULT_BAUD, DEFAULT_FPS);
+}
+
+// *****************************************************************************
+// End of file
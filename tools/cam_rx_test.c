@@ -0,0 +1,537 @@
+/**
+ * @file cam_rx_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the stream receiver (tools/cam_rx.c).
+ *
+ * Encodes a stream with the firmware's own encoders, in every form
+ * stream_frame() in app.c can send a frame, and checks that:
+ * - each frame delivered is the frame the device meant, with its telemetry,
+ *   whether sent whole, decimated, coded, as tiles, progressive or as a ROI
+ * - a frame lost on the link is counted as lost, the deltas that depend on
+ *   it as undecodable, and frames the device skipped as skipped
+ * - progressive previews hold the rows received, and each missing row is a
+ *   copy of one above it
+ * - fragmented frames whose telemetry overtook them get that telemetry
+ * - LOG messages reach the log callback
+ * - the RGB conversion matches yuv_convert_to_rgb888() for every U, V
+ * - the PNG and YUV4MPEG2 writers produce the expected headers and sizes
+ * The stream is fed in small chunks, as reads from a serial port return it.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -Ihost -I../firmware/src -o cam_rx_test cam_rx_test.c cam_rx.c \
+ *       ../firmware/src/frame_proto.c ../firmware/src/yuv_codec.c \
+ *       ../firmware/src/tile_stream.c ../firmware/src/interlace.c \
+ *       ../firmware/src/yuv_convert.c
+ *   ./cam_rx_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_rx.h"
+#include "host/check.h"
+#include "interlace.h"
+#include "tile_stream.h"
+#include "tx_pacer.h"
+#include "yuv_codec.h"
+#include "yuv_convert.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define W 96
+#define H 96
+#define FRAME_SIZE (W * H * 2)
+#define FRAMES 40
+
+// Bytes per cam_rx_feed() call
+#define CHUNK 100
+
+#define WIRE_SIZE (4 * 1024 * 1024)
+
+// The ROI sent in place of a full frame
+#define ROI_X 24
+#define ROI_Y 24
+#define ROI_W 48
+#define ROI_H 48
+
+// The camera frame whose message is lost on the link
+#define LOST_FRAME 22
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Encode a mixed stream, with one frame lost, feed it to a receiver
+ * and check what comes out.
+ */
+static void test_stream(void);
+
+/**
+ * @brief Send full size frames in fragments, each preceded by its
+ * telemetry, with one lost.
+ */
+static void test_fragments(void);
+
+static void test_rgb(void);
+
+static void test_writers(void);
+
+/**
+ * @brief Fill s_image with camera frame n: a gradient that moves a little
+ * from frame to frame.
+ */
+static void make_image(uint32_t n);
+
+/**
+ * @brief Send camera frame n's telemetry, saying what was sent for it.
+ */
+static void send_telemetry(frame_proto_encoder_t *enc, uint32_t n,
+                           tx_pacer_decision_t pacing);
+
+/**
+ * @brief Send a frame as YUYV with the 4 byte size header, rows in
+ * progressive order if progressive.
+ */
+static void send_yuyv(frame_proto_encoder_t *enc, uint8_t type,
+                      const uint8_t *yuyv, uint16_t width, uint16_t height);
+
+/**
+ * @brief Feed the wire to a receiver CHUNK bytes at a time, then empty it.
+ */
+static void feed(cam_rx_t *rx);
+
+/**
+ * @brief Decimated YUYV scaled back up, as the receiver is expected to:
+ * each pixel pair doubled in both directions.
+ */
+static void expect_upscaled(const uint8_t *half, uint8_t *out);
+
+static size_t wire_write(const void *data, size_t n, uintptr_t context);
+static void on_frame(const cam_rx_frame_t *frame, uintptr_t context);
+static void on_preview(const cam_rx_frame_t *frame, uintptr_t context);
+static void on_log(const char *text, size_t length, uintptr_t context);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_wire[WIRE_SIZE];
+static size_t s_wire_n;
+static bool s_drop; // wire_write() discards
+
+static uint8_t s_image[FRAME_SIZE];
+// what the receiver should deliver for each camera frame, if anything
+static uint8_t s_expected[FRAMES][FRAME_SIZE];
+static bool s_expect[FRAMES];
+static cam_rx_source_t s_expect_source[FRAMES];
+
+static uint32_t s_delivered;
+static uint32_t s_wrong;
+static uint32_t s_previews;
+static uint32_t s_bad_previews;
+static uint32_t s_logs;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    test_stream();
+    test_fragments();
+    test_rgb();
+    test_writers();
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void test_stream(void) {
+    static uint8_t codec_buf[YUV_CODEC_MAX_OUTPUT(W, H)];
+    static uint8_t tile_buf[TILE_STREAM_MAX_OUTPUT(W, H, 16)];
+    static uint8_t tile_ref[FRAME_SIZE];
+    static uint8_t prev[FRAME_SIZE];
+    static uint8_t half[FRAME_SIZE / 4];
+    static uint8_t background[FRAME_SIZE];
+    frame_proto_encoder_t enc;
+    tile_stream_t tiles;
+    tile_stream_config_t tile_config;
+    cam_rx_t rx;
+    uint32_t undecodable = 0;
+    uint32_t skipped = 0;
+    uint32_t by_source[CAM_RX_N_SOURCES] = {0};
+
+    frame_proto_encoder_init(&enc, wire_write, 0);
+    tile_stream_default_config(&tile_config, W, H);
+    tile_stream_init(&tiles, &tile_config, tile_ref);
+    check(cam_rx_init(&rx, W, H, on_frame, on_log, 0), "init");
+    cam_rx_set_preview_cb(&rx, on_preview);
+
+    for (uint32_t n = 0; n < FRAMES; n++) {
+        make_image(n);
+        tx_pacer_decision_t pacing = TX_PACER_FULL;
+        cam_rx_source_t source = CAM_RX_SOURCE_RAW;
+        bool expect = true;
+        memcpy(s_expected[n], s_image, FRAME_SIZE);
+        if (n % 10 == 0) {
+            char text[32];
+            int length = snprintf(text, sizeof(text), "# frame %u\r\n", n);
+            frame_proto_send(&enc, FRAME_PROTO_TYPE_LOG, 0, text,
+                             (uint32_t)length);
+        }
+        s_drop = n == LOST_FRAME;
+
+        switch (n % 10) {
+        case 0:
+            send_yuyv(&enc, FRAME_PROTO_TYPE_FRAME_YUYV, s_image, W, H);
+            break;
+        case 1:
+        case 2:
+        case 3: {
+            // a key frame, then deltas against the previous camera frame
+            size_t length =
+                yuv_codec_encode(s_image, n % 10 == 1 ? NULL : prev, W, H,
+                                 codec_buf, sizeof(codec_buf));
+            frame_proto_send(&enc, FRAME_PROTO_TYPE_FRAME_CODEC,
+                             n % 10 == 1 ? FRAME_PROTO_FLAG_KEY : 0,
+                             codec_buf, (uint32_t)length);
+            source = CAM_RX_SOURCE_CODEC;
+            // a delta after the lost frame can't be decoded
+            expect = n != LOST_FRAME + 1;
+            break;
+        }
+        case 4:
+            yuv_convert_decimate(s_image, half, W, H);
+            send_yuyv(&enc, FRAME_PROTO_TYPE_FRAME_YUYV, half, W / 2, H / 2);
+            expect_upscaled(half, s_expected[n]);
+            pacing = TX_PACER_DECIMATED;
+            source = CAM_RX_SOURCE_DECIMATED;
+            break;
+        case 5:
+            pacing = TX_PACER_SKIP;
+            expect = false;
+            skipped++;
+            break;
+        case 6:
+        case 7: {
+            // a key frame, since the receiver's frame has moved on, then
+            // an update
+            if (n % 10 == 6) {
+                tile_stream_request_key(&tiles);
+            }
+            size_t length = tile_stream_encode(&tiles, s_image, tile_buf,
+                                               sizeof(tile_buf));
+            frame_proto_send(&enc, FRAME_PROTO_TYPE_FRAME_TILES,
+                             n % 10 == 6 ? FRAME_PROTO_FLAG_KEY : 0, tile_buf,
+                             (uint32_t)length);
+            memcpy(s_expected[n], tile_ref, FRAME_SIZE);
+            source = CAM_RX_SOURCE_TILES;
+            break;
+        }
+        case 8:
+            send_yuyv(&enc, FRAME_PROTO_TYPE_FRAME_PROGRESSIVE, s_image, W,
+                      H);
+            source = CAM_RX_SOURCE_PROGRESSIVE;
+            break;
+        case 9: {
+            // pasted over the progressive frame before, which is kept as
+            // it is decoded into the receiver's own buffer
+            uint8_t header[8] = {ROI_X, 0, ROI_Y, 0, ROI_W, 0, ROI_H, 0};
+            frame_proto_begin(&enc, FRAME_PROTO_TYPE_FRAME_ROI, 0,
+                              sizeof(header) + ROI_W * ROI_H * 2);
+            frame_proto_write(&enc, header, sizeof(header));
+            memcpy(s_expected[n], background, FRAME_SIZE);
+            for (int y = ROI_Y; y < ROI_Y + ROI_H; y++) {
+                size_t offset = ((size_t)y * W + ROI_X) * 2;
+                frame_proto_write(&enc, &s_image[offset], ROI_W * 2);
+                memcpy(&s_expected[n][offset], &s_image[offset], ROI_W * 2);
+            }
+            frame_proto_end(&enc);
+            source = CAM_RX_SOURCE_ROI;
+            break;
+        }
+        }
+        if (n % 10 == 8) {
+            memcpy(background, s_image, FRAME_SIZE);
+        }
+        memcpy(prev, s_image, FRAME_SIZE);
+        s_drop = false;
+
+        if (pacing != TX_PACER_SKIP && n != LOST_FRAME && !expect) {
+            undecodable++;
+        }
+        expect = expect && n != LOST_FRAME;
+        s_expect[n] = expect;
+        s_expect_source[n] = source;
+        by_source[source] += expect;
+        send_telemetry(&enc, n, pacing);
+        feed(&rx);
+    }
+    cam_rx_flush(&rx);
+
+    const cam_rx_stats_t *stats = cam_rx_stats(&rx);
+    uint32_t expected = 0;
+    for (int i = 0; i < CAM_RX_N_SOURCES; i++) {
+        expected += by_source[i];
+        check(stats->by_source[i] == by_source[i], "frames by source");
+    }
+    printf("# stream: %u frames delivered of %u expected, %u wrong; "
+           "%u undecodable, %u lost, %u skipped; %u previews, %u bad\n",
+           s_delivered, expected, s_wrong, stats->undecodable,
+           stats->link_lost, stats->device_skipped, s_previews,
+           s_bad_previews);
+    check(s_delivered == expected && stats->frames == expected,
+          "frames delivered");
+    check(s_wrong == 0, "wrong frames delivered");
+    check(stats->undecodable == undecodable, "undecodable frames");
+    check(stats->link_lost == 1, "lost frames");
+    check(stats->device_skipped == skipped, "skipped frames");
+    check(stats->link.crc_errors == 0, "link errors");
+    // every pass of each progressive frame, the last being the frame itself
+    check(s_previews >= (FRAMES / 10) * (INTERLACE_PASSES - 1) &&
+              s_bad_previews == 0,
+          "previews");
+    check(s_logs == FRAMES / 10, "log messages");
+    cam_rx_free(&rx);
+}
+
+static void test_fragments(void) {
+    frame_proto_encoder_t enc;
+    cam_rx_t rx;
+
+    frame_proto_encoder_init(&enc, wire_write, 0);
+    check(cam_rx_init(&rx, W, H, on_frame, NULL, 0), "init");
+    s_delivered = 0;
+    s_wrong = 0;
+
+    for (uint32_t n = 0; n < FRAMES; n++) {
+        make_image(n);
+        memcpy(s_expected[n], s_image, FRAME_SIZE);
+        s_expect[n] = n != LOST_FRAME;
+        s_expect_source[n] = CAM_RX_SOURCE_RAW;
+
+        // the telemetry overtakes the frame, as through uart_mux.h
+        frame_proto_set_fragment_size(&enc, 0);
+        send_telemetry(&enc, n, TX_PACER_FULL);
+        frame_proto_set_fragment_size(&enc, 512);
+        frame_proto_set_tag(&enc, n);
+        s_drop = n == LOST_FRAME;
+        send_yuyv(&enc, FRAME_PROTO_TYPE_FRAME_YUYV, s_image, W, H);
+        s_drop = false;
+        feed(&rx);
+    }
+    cam_rx_flush(&rx);
+
+    const cam_rx_stats_t *stats = cam_rx_stats(&rx);
+    printf("# fragments: %u frames delivered, %u wrong, %u lost, "
+           "%u fragment errors\n",
+           s_delivered, s_wrong, stats->link_lost,
+           stats->link.fragment_errors);
+    check(s_delivered == FRAMES - 1 && s_wrong == 0,
+          "fragmented frames delivered");
+    check(stats->link_lost == 1, "lost fragmented frames");
+    cam_rx_free(&rx);
+}
+
+static void test_rgb(void) {
+    // every U, V pair, with varied Y and the extremes of Y
+    static uint8_t yuyv[256 * 256 * 4];
+    static uint8_t rgb[256 * 256 * 6];
+    static uint8_t expected[256 * 256 * 6];
+    size_t n = 0;
+
+    srand(1);
+    for (int u = 0; u < 256; u++) {
+        for (int v = 0; v < 256; v++) {
+            yuyv[4 * n + 0] = (uint8_t)rand();
+            yuyv[4 * n + 1] = (uint8_t)u;
+            yuyv[4 * n + 2] = (uint8_t)(u * 7 + v);
+            yuyv[4 * n + 3] = (uint8_t)v;
+            n++;
+        }
+    }
+    yuyv[0] = 0;
+    yuyv[2] = 255;
+    cam_rx_yuyv_to_rgb(yuyv, rgb, 2 * n);
+    yuv_convert_to_rgb888(yuyv, expected, 2 * n);
+    check(memcmp(rgb, expected, 6 * n) == 0, "RGB conversion");
+    // and from an unaligned start, with a length the vector loop doesn't
+    // divide
+    cam_rx_yuyv_to_rgb(yuyv + 4, rgb, 2 * n - 6);
+    yuv_convert_to_rgb888(yuyv + 4, expected, 2 * n - 6);
+    check(memcmp(rgb, expected, 6 * n - 18) == 0, "unaligned RGB conversion");
+}
+
+static void test_writers(void) {
+    static uint8_t rgb[W * H * 3];
+    static const uint8_t png_signature[] = {0x89, 'P',  'N',  'G',
+                                            '\r', '\n', 0x1a, '\n'};
+    static char buf[W * H * 4];
+    FILE *f;
+
+    make_image(0);
+    cam_rx_yuyv_to_rgb(s_image, rgb, W * H);
+
+    f = tmpfile();
+    check(f != NULL && cam_rx_write_png(f, rgb, W, H), "PNG written");
+    long size = ftell(f);
+    rewind(f);
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    // stored deflate blocks: the image, a filter byte per row, and headers
+    check(n == (size_t)size && memcmp(buf, png_signature, 8) == 0 &&
+              memcmp(&buf[12], "IHDR", 4) == 0 &&
+              buf[18] == 0 && buf[19] == W && buf[22] == 0 && buf[23] == H &&
+              n > sizeof(rgb) + H && n < sizeof(rgb) + H + 256,
+          "PNG header");
+
+    f = tmpfile();
+    check(f != NULL && cam_rx_write_y4m_header(f, W, H, 30) &&
+              cam_rx_write_y4m_frame(f, s_image, W, H),
+          "Y4M written");
+    rewind(f);
+    n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    char *frame = strstr(buf, "FRAME\n");
+    check(strncmp(buf, "YUV4MPEG2 W96 H96 F30:1", 23) == 0 &&
+              strstr(buf, "C422") != NULL && frame != NULL &&
+              n - (size_t)(frame + 6 - buf) == FRAME_SIZE &&
+              (uint8_t)frame[6] == s_image[0] &&
+              (uint8_t)frame[6 + W * H] == s_image[1],
+          "Y4M frame");
+}
+
+static void make_image(uint32_t n) {
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            uint8_t *p = &s_image[(y * W + x) * 2];
+            p[0] = (uint8_t)(x * 2 + y + n * 3);
+            p[1] = (x & 1) ? (uint8_t)(128 + y - n) : (uint8_t)(100 + x + n);
+        }
+    }
+}
+
+static void send_telemetry(frame_proto_encoder_t *enc, uint32_t n,
+                           tx_pacer_decision_t pacing) {
+    frame_proto_telemetry_t telemetry = {
+        .frame_seq = n,
+        .timestamp = n * 33333 * 2,
+        .interval_us = n == 0 ? 0 : 33333,
+        .pacing = (uint8_t)pacing,
+    };
+    uint8_t buf[FRAME_PROTO_TELEMETRY_SIZE];
+    frame_proto_pack_telemetry(&telemetry, buf);
+    frame_proto_send(enc, FRAME_PROTO_TYPE_TELEMETRY, 0, buf, sizeof(buf));
+}
+
+static void send_yuyv(frame_proto_encoder_t *enc, uint8_t type,
+                      const uint8_t *yuyv, uint16_t width, uint16_t height) {
+    uint8_t header[4] = {(uint8_t)width, (uint8_t)(width >> 8),
+                         (uint8_t)height, (uint8_t)(height >> 8)};
+    size_t row_bytes = (size_t)width * 2;
+
+    frame_proto_begin(enc, type, FRAME_PROTO_FLAG_KEY,
+                      (uint32_t)(sizeof(header) + row_bytes * height));
+    frame_proto_write(enc, header, sizeof(header));
+    for (uint16_t i = 0; i < height; i++) {
+        uint16_t row = type == FRAME_PROTO_TYPE_FRAME_PROGRESSIVE
+                           ? interlace_row(height, i)
+                           : i;
+        frame_proto_write(enc, &yuyv[row * row_bytes], row_bytes);
+    }
+    frame_proto_end(enc);
+}
+
+static void feed(cam_rx_t *rx) {
+    for (size_t i = 0; i < s_wire_n; i += CHUNK) {
+        cam_rx_feed(rx, &s_wire[i],
+                    s_wire_n - i < CHUNK ? s_wire_n - i : CHUNK);
+    }
+    s_wire_n = 0;
+}
+
+static void expect_upscaled(const uint8_t *half, uint8_t *out) {
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            const uint8_t *pair = &half[((y / 2) * (W / 2) + (x / 2 & ~1)) * 2];
+            uint8_t *p = &out[(y * W + x) * 2];
+            p[0] = pair[(x / 2 & 1) * 2];
+            p[1] = pair[(x & 1) ? 3 : 1];
+        }
+    }
+}
+
+static size_t wire_write(const void *data, size_t n, uintptr_t context) {
+    (void)context;
+    if (!s_drop && s_wire_n + n <= sizeof(s_wire)) {
+        memcpy(&s_wire[s_wire_n], data, n);
+        s_wire_n += n;
+    }
+    return n;
+}
+
+static void on_frame(const cam_rx_frame_t *frame, uintptr_t context) {
+    (void)context;
+    uint32_t n = frame->telemetry.frame_seq;
+    s_delivered++;
+    if (!frame->has_telemetry || n >= FRAMES || !s_expect[n] ||
+        frame->source != s_expect_source[n] || frame->width != W ||
+        frame->height != H ||
+        memcmp(frame->yuyv, s_expected[n], FRAME_SIZE) != 0) {
+        printf("# frame %u (source %d) not as sent\n", n, frame->source);
+        s_wrong++;
+    }
+}
+
+static void on_preview(const cam_rx_frame_t *frame, uintptr_t context) {
+    (void)context;
+    s_previews++;
+    // each row is the row itself or one of those above it that the passes
+    // so far include
+    for (int row = 0; row < H; row++) {
+        bool ok = false;
+        for (int mask = 0; mask < 8 && !ok; mask = mask << 1 | 1) {
+            ok = memcmp(&frame->yuyv[row * W * 2],
+                        &s_image[(row & ~mask) * W * 2], W * 2) == 0;
+        }
+        s_bad_previews += !ok;
+    }
+}
+
+static void on_log(const char *text, size_t length, uintptr_t context) {
+    (void)context;
+    s_logs += length > 8 && strncmp(text, "# frame ", 8) == 0;
+}
+
+// *****************************************************************************
+// End of file
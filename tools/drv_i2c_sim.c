@@ -0,0 +1,541 @@
+/**
+ * @file drv_i2c_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the queued DRV_I2C transfers
+ * (firmware/src/config/default/driver/i2c/src/drv_i2c.c) against a stand-in
+ * for the TWIHS0 PLIB.
+ *
+ * The stand-in accepts one transfer at a time and completes it only when the
+ * test runs its "interrupt", so every interleaving is deterministic.  Checks
+ * that:
+ *   - queued transfers start in the order they were added, each one when the
+ *     previous completes, and report COMPLETE or ERROR to the event handler
+ *     once each, in that order;
+ *   - a full queue refuses a transfer with DRV_I2C_TRANSFER_HANDLE_INVALID;
+ *   - a transfer the PLIB refuses to start is retired at once with ERROR and
+ *     the next one started, including when the refused transfer is the one
+ *     being added, and when the event handler queues a retry;
+ *   - DRV_I2C_QueuePurge and DRV_I2C_Close drop a client's waiting transfers
+ *     without events, leave the one on the bus and other clients' alone;
+ *   - a PLIB that completes a transfer before its start call returns, and a
+ *     blocking transfer, leave the queue consistent;
+ *   - a blocking transfer waits behind the transfers already queued but not
+ *     behind ones queued after it, even by an event handler that requeues on
+ *     every completion, and fails at once when the queue is full.
+ *
+ * For the blocking transfers the stand-in's interrupt also runs when the
+ * driver re-enables interrupts (HOST_INT_HOOK), as it would on the target.
+ *
+ * Build and run from this directory (the sanitizers are recommended):
+ *   cc -O1 -g -fsanitize=address,undefined -DHOST_INT_HOOK -Ihost \
+ *       -I../firmware/src/config/default -o drv_i2c_sim drv_i2c_sim.c \
+ *       ../firmware/src/config/default/driver/i2c/src/drv_i2c.c
+ *   ./drv_i2c_sim
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "configuration.h"
+#include "driver/i2c/drv_i2c.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_LOG 64
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond);            \
+            s_failures++;                                                      \
+        }                                                                      \
+    } while (0)
+
+/**
+ * @brief An event delivered to a client's event handler.
+ */
+typedef struct {
+    DRV_I2C_TRANSFER_EVENT event;
+    DRV_I2C_TRANSFER_HANDLE handle;
+    uintptr_t context; // the client that received it
+} event_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief The PLIB transfer functions: start a transfer if the bus is free
+ * and the test does not want the start refused.
+ */
+static bool twihs_read(uint16_t address, uint8_t *data, uint32_t length);
+static bool twihs_write(uint16_t address, uint8_t *data, uint32_t length);
+static bool twihs_write_read(uint16_t address, uint8_t *wdata,
+                             uint32_t wlength, uint8_t *rdata,
+                             uint32_t rlength);
+static bool twihs_write_pairs(uint16_t address, uint8_t *pairs,
+                              uint32_t count);
+static bool twihs_start(uint16_t address);
+
+static DRV_I2C_ERROR twihs_error_get(void);
+static bool twihs_transfer_setup(DRV_I2C_TRANSFER_SETUP *setup,
+                                 uint32_t src_clk_freq);
+static void twihs_transfer_abort(void);
+static void twihs_callback_register(DRV_I2C_PLIB_CALLBACK callback,
+                                    uintptr_t context);
+
+/**
+ * @brief Run the PLIB interrupt that ends the transfer on the bus.
+ */
+static void twihs_complete(DRV_I2C_ERROR error);
+
+/**
+ * @brief Client event handler: log the event.  On an error event for a
+ * client with s_retry set, queue one retry to address s_retry_address.
+ */
+static void on_event(DRV_I2C_TRANSFER_EVENT event,
+                     DRV_I2C_TRANSFER_HANDLE handle, uintptr_t context);
+
+static DRV_I2C_TRANSFER_HANDLE add(DRV_HANDLE client, uint16_t address);
+
+static void reset_logs(void);
+
+static void test_queue_order(DRV_HANDLE a);
+static void test_start_failure(DRV_HANDLE a);
+static void test_purge(DRV_HANDLE a, DRV_HANDLE b);
+static void test_immediate(DRV_HANDLE a);
+static void test_blocking(DRV_HANDLE a);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const DRV_I2C_PLIB_INTERFACE s_plib = {
+    .read_t = twihs_read,
+    .write_t = twihs_write,
+    .writeRead = twihs_write_read,
+    .writePairs = twihs_write_pairs,
+    .transferAbort = twihs_transfer_abort,
+    .errorGet = twihs_error_get,
+    .transferSetup = twihs_transfer_setup,
+    .callbackRegister = twihs_callback_register,
+};
+
+static DRV_I2C_CLIENT_OBJ s_client_pool[DRV_I2C_CLIENTS_NUMBER_IDX0];
+static DRV_I2C_TRANSFER_OBJ s_transfer_pool[DRV_I2C_QUEUE_SIZE_IDX0];
+
+static const DRV_I2C_INIT s_init = {
+    .i2cPlib = &s_plib,
+    .numClients = DRV_I2C_CLIENTS_NUMBER_IDX0,
+    .clientObjPool = (uintptr_t)&s_client_pool[0],
+    .transferObjPool = (uintptr_t)&s_transfer_pool[0],
+    .transferObjPoolSize = DRV_I2C_QUEUE_SIZE_IDX0,
+    .clockSpeed = DRV_I2C_CLOCK_SPEED_IDX0,
+};
+
+// The stand-in TWIHS0
+static DRV_I2C_PLIB_CALLBACK s_plib_cb;
+static uintptr_t s_plib_context;
+static bool s_busy;
+static DRV_I2C_ERROR s_error;
+static unsigned s_refuse;        // refuse this many starts
+static bool s_complete_at_once;  // complete each transfer inside its start
+static unsigned s_depth;         // nesting of twihs_start calls
+
+// Addresses in the order their transfers started
+static uint16_t s_started[MAX_LOG];
+static unsigned s_n_started;
+
+static event_t s_events[MAX_LOG];
+static unsigned s_n_events;
+
+// Client that queues a retry from its event handler
+static DRV_HANDLE s_retry_client = DRV_HANDLE_INVALID;
+static uint16_t s_retry_address;
+static DRV_I2C_TRANSFER_HANDLE s_retry_handle;
+
+// Client that queues another transfer from every COMPLETE event
+static DRV_HANDLE s_requeue_client = DRV_HANDLE_INVALID;
+static unsigned s_n_requeued;
+
+// Complete the transfer on the bus whenever interrupts are re-enabled
+static bool s_auto_irq;
+
+static uint8_t s_data[4];
+static unsigned s_failures;
+
+bool host_int_enabled = true;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    SYS_MODULE_OBJ obj = DRV_I2C_Initialize(DRV_I2C_INDEX_0,
+                                            (SYS_MODULE_INIT *)&s_init);
+    CHECK(obj != SYS_MODULE_OBJ_INVALID);
+    CHECK(s_plib_cb != NULL);
+
+    DRV_HANDLE a = DRV_I2C_Open(DRV_I2C_INDEX_0, DRV_IO_INTENT_READWRITE);
+    DRV_HANDLE b = DRV_I2C_Open(DRV_I2C_INDEX_0, DRV_IO_INTENT_READWRITE);
+    CHECK(a != DRV_HANDLE_INVALID && b != DRV_HANDLE_INVALID);
+    DRV_I2C_TransferEventHandlerSet(a, on_event, 'a');
+    DRV_I2C_TransferEventHandlerSet(b, on_event, 'b');
+
+    test_queue_order(a);
+    test_start_failure(a);
+    test_purge(a, b);
+    test_immediate(a);
+    test_blocking(a);
+
+    printf("%s\n", s_failures == 0 ? "PASS" : "FAIL");
+    return s_failures == 0 ? 0 : 1;
+}
+
+void host_int_hook(void) {
+    if (!s_auto_irq || !s_busy) {
+        return;
+    }
+    // the handler runs with interrupts disabled, so it does not nest
+    host_int_enabled = false;
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    host_int_enabled = true;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool twihs_read(uint16_t address, uint8_t *data, uint32_t length) {
+    (void)data;
+    (void)length;
+    return twihs_start(address);
+}
+
+static bool twihs_write(uint16_t address, uint8_t *data, uint32_t length) {
+    (void)data;
+    (void)length;
+    return twihs_start(address);
+}
+
+static bool twihs_write_read(uint16_t address, uint8_t *wdata,
+                             uint32_t wlength, uint8_t *rdata,
+                             uint32_t rlength) {
+    (void)wdata;
+    (void)wlength;
+    (void)rdata;
+    (void)rlength;
+    return twihs_start(address);
+}
+
+static bool twihs_write_pairs(uint16_t address, uint8_t *pairs,
+                              uint32_t count) {
+    (void)pairs;
+    (void)count;
+    return twihs_start(address);
+}
+
+static bool twihs_start(uint16_t address) {
+    // as the PLIB, refuse while a transfer is on the bus
+    if (s_busy) {
+        s_error = DRV_I2C_ERROR_BUS;
+        return false;
+    }
+    if (s_refuse > 0) {
+        s_refuse--;
+        s_error = DRV_I2C_ERROR_BUS;
+        return false;
+    }
+    s_error = DRV_I2C_ERROR_NONE;
+    s_busy = true;
+    if (s_n_started < MAX_LOG) {
+        s_started[s_n_started++] = address;
+    }
+    if (s_complete_at_once && s_depth == 0) {
+        // a short transfer can end before the start call returns
+        s_depth++;
+        twihs_complete(DRV_I2C_ERROR_NONE);
+        s_depth--;
+    }
+    return true;
+}
+
+static DRV_I2C_ERROR twihs_error_get(void) {
+    return s_error;
+}
+
+static bool twihs_transfer_setup(DRV_I2C_TRANSFER_SETUP *setup,
+                                 uint32_t src_clk_freq) {
+    (void)setup;
+    (void)src_clk_freq;
+    return true;
+}
+
+static void twihs_transfer_abort(void) {
+    s_busy = false;
+}
+
+static void twihs_callback_register(DRV_I2C_PLIB_CALLBACK callback,
+                                    uintptr_t context) {
+    s_plib_cb = callback;
+    s_plib_context = context;
+}
+
+static void twihs_complete(DRV_I2C_ERROR error) {
+    CHECK(s_busy);
+    s_busy = false;
+    s_error = error;
+    s_plib_cb(s_plib_context);
+}
+
+static void on_event(DRV_I2C_TRANSFER_EVENT event,
+                     DRV_I2C_TRANSFER_HANDLE handle, uintptr_t context) {
+    if (s_n_events < MAX_LOG) {
+        s_events[s_n_events++] = (event_t){event, handle, context};
+    }
+    if (event == DRV_I2C_TRANSFER_EVENT_ERROR &&
+        s_retry_client != DRV_HANDLE_INVALID) {
+        DRV_HANDLE client = s_retry_client;
+        s_retry_client = DRV_HANDLE_INVALID;
+        s_retry_handle = add(client, s_retry_address);
+    }
+    if (event == DRV_I2C_TRANSFER_EVENT_COMPLETE &&
+        context == 'b' && s_requeue_client != DRV_HANDLE_INVALID &&
+        s_n_requeued < MAX_LOG) {
+        s_n_requeued++;
+        add(s_requeue_client, 0x68);
+    }
+}
+
+static DRV_I2C_TRANSFER_HANDLE add(DRV_HANDLE client, uint16_t address) {
+    DRV_I2C_TRANSFER_HANDLE handle;
+    DRV_I2C_WriteTransferAdd(client, address, s_data, sizeof(s_data),
+                             &handle);
+    return handle;
+}
+
+static void reset_logs(void) {
+    s_n_started = 0;
+    s_n_events = 0;
+}
+
+static void test_queue_order(DRV_HANDLE a) {
+    DRV_I2C_TRANSFER_HANDLE h[DRV_I2C_QUEUE_SIZE_IDX0];
+
+    reset_logs();
+    for (int i = 0; i < DRV_I2C_QUEUE_SIZE_IDX0; i++) {
+        h[i] = add(a, 0x10 + i);
+        CHECK(h[i] != DRV_I2C_TRANSFER_HANDLE_INVALID);
+    }
+    // the first starts at once on the idle bus, the rest wait
+    CHECK(s_n_started == 1 && s_started[0] == 0x10);
+    CHECK(DRV_I2C_TransferStatusGet(h[1]) == DRV_I2C_TRANSFER_EVENT_PENDING);
+    CHECK(add(a, 0x30) == DRV_I2C_TRANSFER_HANDLE_INVALID);
+
+    // a NACK on the third fails only that one
+    for (int i = 0; i < DRV_I2C_QUEUE_SIZE_IDX0; i++) {
+        CHECK(s_n_started == (unsigned)i + 1);
+        twihs_complete(i == 2 ? DRV_I2C_ERROR_NACK : DRV_I2C_ERROR_NONE);
+    }
+    CHECK(!s_busy);
+    CHECK(s_n_started == DRV_I2C_QUEUE_SIZE_IDX0);
+    CHECK(s_n_events == DRV_I2C_QUEUE_SIZE_IDX0);
+    for (int i = 0; i < DRV_I2C_QUEUE_SIZE_IDX0; i++) {
+        DRV_I2C_TRANSFER_EVENT expect = i == 2 ? DRV_I2C_TRANSFER_EVENT_ERROR
+                                               : DRV_I2C_TRANSFER_EVENT_COMPLETE;
+        CHECK(s_started[i] == 0x10 + i);
+        CHECK(s_events[i].handle == h[i] && s_events[i].event == expect);
+        CHECK(DRV_I2C_TransferStatusGet(h[i]) == expect);
+    }
+    printf("queue order: %u transfers started, %u events\n", s_n_started,
+           s_n_events);
+}
+
+static void test_start_failure(DRV_HANDLE a) {
+    // refused while being added: retired before the add returns
+    reset_logs();
+    s_refuse = 1;
+    DRV_I2C_TRANSFER_HANDLE h0 = add(a, 0x40);
+    CHECK(h0 != DRV_I2C_TRANSFER_HANDLE_INVALID);
+    CHECK(s_n_events == 1 && s_events[0].handle == h0 &&
+          s_events[0].event == DRV_I2C_TRANSFER_EVENT_ERROR);
+    CHECK(!s_busy && s_n_started == 0);
+
+    // refused when its turn comes: retired, and the next one starts
+    reset_logs();
+    DRV_I2C_TRANSFER_HANDLE h1 = add(a, 0x41);
+    DRV_I2C_TRANSFER_HANDLE h2 = add(a, 0x42);
+    DRV_I2C_TRANSFER_HANDLE h3 = add(a, 0x43);
+    s_refuse = 1;
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    CHECK(s_n_events == 2);
+    CHECK(s_events[0].handle == h1 &&
+          s_events[0].event == DRV_I2C_TRANSFER_EVENT_COMPLETE);
+    CHECK(s_events[1].handle == h2 &&
+          s_events[1].event == DRV_I2C_TRANSFER_EVENT_ERROR);
+    CHECK(s_busy && s_n_started == 2 && s_started[1] == 0x43);
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    CHECK(s_n_events == 3 && s_events[2].handle == h3 &&
+          s_events[2].event == DRV_I2C_TRANSFER_EVENT_COMPLETE);
+
+    // the handler queues a retry from the retire: it goes to the back of the
+    // queue and runs once the bus is free
+    reset_logs();
+    s_refuse = 1;
+    s_retry_client = a;
+    s_retry_address = 0x45;
+    DRV_I2C_TRANSFER_HANDLE h4 = add(a, 0x44);
+    CHECK(h4 != DRV_I2C_TRANSFER_HANDLE_INVALID);
+    CHECK(s_retry_handle != DRV_I2C_TRANSFER_HANDLE_INVALID);
+    CHECK(s_n_events == 1 && s_events[0].handle == h4 &&
+          s_events[0].event == DRV_I2C_TRANSFER_EVENT_ERROR);
+    CHECK(s_busy && s_n_started == 1 && s_started[0] == 0x45);
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    CHECK(s_n_events == 2 && s_events[1].handle == s_retry_handle &&
+          s_events[1].event == DRV_I2C_TRANSFER_EVENT_COMPLETE);
+    CHECK(!s_busy);
+    printf("start failure: retired with one ERROR event each\n");
+}
+
+static void test_purge(DRV_HANDLE a, DRV_HANDLE b) {
+    reset_logs();
+    DRV_I2C_TRANSFER_HANDLE a0 = add(a, 0x50);
+    DRV_I2C_TRANSFER_HANDLE a1 = add(a, 0x51);
+    DRV_I2C_TRANSFER_HANDLE b0 = add(b, 0x60);
+    DRV_I2C_TRANSFER_HANDLE a2 = add(a, 0x52);
+    DRV_I2C_TRANSFER_HANDLE b1 = add(b, 0x61);
+
+    // a0 is on the bus and stays; a1 and a2 go
+    DRV_I2C_QueuePurge(a);
+    CHECK(DRV_I2C_TransferStatusGet(a1) ==
+          DRV_I2C_TRANSFER_EVENT_HANDLE_EXPIRED);
+    CHECK(DRV_I2C_TransferStatusGet(a2) ==
+          DRV_I2C_TRANSFER_EVENT_HANDLE_EXPIRED);
+    CHECK(DRV_I2C_TransferStatusGet(b0) == DRV_I2C_TRANSFER_EVENT_PENDING);
+    CHECK(s_n_events == 0);
+
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    CHECK(!s_busy);
+    CHECK(s_n_started == 3 && s_started[0] == 0x50 && s_started[1] == 0x60 &&
+          s_started[2] == 0x61);
+    CHECK(s_n_events == 3 && s_events[0].handle == a0 &&
+          s_events[1].handle == b0 && s_events[2].handle == b1);
+
+    // closing a client purges it too
+    reset_logs();
+    b0 = add(b, 0x62);
+    b1 = add(b, 0x63);
+    a0 = add(a, 0x53);
+    DRV_I2C_Close(b);
+    CHECK(DRV_I2C_TransferStatusGet(b1) ==
+          DRV_I2C_TRANSFER_EVENT_HANDLE_EXPIRED);
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    CHECK(!s_busy);
+    CHECK(s_n_started == 2 && s_started[0] == 0x62 && s_started[1] == 0x53);
+    // b's handler is gone with it
+    CHECK(s_n_events == 1 && s_events[0].handle == a0);
+    printf("purge: waiting transfers dropped, the one on the bus kept\n");
+}
+
+static void test_immediate(DRV_HANDLE a) {
+    DRV_I2C_TRANSFER_HANDLE h[3];
+
+    reset_logs();
+    s_complete_at_once = true;
+    for (int i = 0; i < 3; i++) {
+        h[i] = add(a, 0x70 + i);
+    }
+    CHECK(!s_busy && s_n_started == 3 && s_n_events == 3);
+    for (int i = 0; i < 3; i++) {
+        CHECK(s_events[i].handle == h[i] &&
+              s_events[i].event == DRV_I2C_TRANSFER_EVENT_COMPLETE);
+    }
+
+    // a blocking transfer shares the bus with the queue
+    CHECK(DRV_I2C_WriteTransfer(a, 0x7f, s_data, sizeof(s_data)));
+    CHECK(s_n_started == 4 && s_started[3] == 0x7f && s_n_events == 3);
+    s_complete_at_once = false;
+
+    h[0] = add(a, 0x74);
+    CHECK(h[0] != DRV_I2C_TRANSFER_HANDLE_INVALID && s_busy);
+    twihs_complete(DRV_I2C_ERROR_NONE);
+    CHECK(s_n_events == 4 && s_events[3].handle == h[0]);
+    printf("immediate completion: %u transfers, %u events\n", s_n_started,
+           s_n_events);
+}
+
+static void test_blocking(DRV_HANDLE a) {
+    DRV_HANDLE b = DRV_I2C_Open(DRV_I2C_INDEX_0, DRV_IO_INTENT_READWRITE);
+    CHECK(b != DRV_HANDLE_INVALID);
+    DRV_I2C_TransferEventHandlerSet(b, on_event, 'b');
+
+    // b keeps the queue busy: each of its completions queues another
+    reset_logs();
+    s_requeue_client = b;
+    s_n_requeued = 0;
+    add(b, 0x60);
+    add(b, 0x61);
+    s_auto_irq = true;
+    CHECK(DRV_I2C_WriteTransfer(a, 0x7e, s_data, sizeof(s_data)));
+    CHECK(s_n_started >= 3 && s_started[0] == 0x60 && s_started[1] == 0x61 &&
+          s_started[2] == 0x7e);
+    // one requeue for each transfer ahead of it, and at most one more from
+    // the interrupt that runs as the call returns
+    unsigned requeued = s_n_requeued;
+    CHECK(requeued <= 3);
+    s_requeue_client = DRV_HANDLE_INVALID;
+    while (s_busy) {
+        host_int_hook();
+    }
+    // no event for the blocking transfer
+    for (unsigned i = 0; i < s_n_events; i++) {
+        CHECK(s_events[i].context == 'b');
+    }
+    s_auto_irq = false;
+
+    // a full queue fails the blocking call without waiting
+    reset_logs();
+    DRV_I2C_TRANSFER_HANDLE h[DRV_I2C_QUEUE_SIZE_IDX0];
+    for (int i = 0; i < DRV_I2C_QUEUE_SIZE_IDX0; i++) {
+        h[i] = add(a, 0x20 + i);
+    }
+    CHECK(!DRV_I2C_WriteTransfer(a, 0x7d, s_data, sizeof(s_data)));
+    for (int i = 0; i < DRV_I2C_QUEUE_SIZE_IDX0; i++) {
+        twihs_complete(DRV_I2C_ERROR_NONE);
+    }
+    CHECK(!s_busy && s_n_events == DRV_I2C_QUEUE_SIZE_IDX0);
+    CHECK(DRV_I2C_TransferStatusGet(h[DRV_I2C_QUEUE_SIZE_IDX0 - 1]) ==
+          DRV_I2C_TRANSFER_EVENT_COMPLETE);
+    printf("blocking: done after %u requeued transfers, refused when full\n",
+           requeued);
+    DRV_I2C_Close(b);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file dual_stream_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the dual stream scheduler
+ * (firmware/src/dual_stream.c).
+ *
+ * Schedules 30 fps of full frames and substream frames over a link too slow
+ * for every frame in full, with tx_pacer.h draining a simulated queue and
+ * each frame decided by dual_stream_decide() as in stream_frame() in app.c,
+ * and checks that:
+ * - the first frame is full
+ * - the link is split between the streams by their weights
+ * - full frames are at least full_interval frames apart
+ * - a stream that can't use its share lends it to the other
+ * - on a fast link, full frames go every full_interval frames and the
+ *   substream takes every other frame
+ * - a full frame the pacer vetoes is sent as soon as the queue has drained
+ *   enough, rather than starved by substream frames sent in its place, and
+ *   a full frame requested with dual_stream_request_full() goes next
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o dual_stream_test dual_stream_test.c \
+ *       ../firmware/src/dual_stream.c ../firmware/src/tx_pacer.c
+ *   ./dual_stream_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "dual_stream.h"
+#include "host/check.h"
+#include "tx_pacer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define FRAME_US 33333
+#define FRAMES 3000
+
+// The base rate of the console link, and 96 x 96 frames and 48 x 48
+// thumbnails with their framing
+#define SLOW_BAUD 937500
+#define FAST_BAUD 12000000
+#define FULL_COST 18460
+#define SUB_COST 4660
+
+#define BURST_INTERVAL 7
+
+typedef struct {
+    const char *name;
+    uint8_t full_weight;
+    uint8_t sub_weight;
+    uint16_t full_interval;
+    uint32_t baud;
+    uint32_t sub_cost;
+    uint32_t max_latency_us; // of the pacer
+    uint32_t burst;          // other traffic every BURST_INTERVAL frames
+} scenario_t;
+
+typedef struct {
+    uint32_t counts[TX_PACER_N_DECISIONS];
+    uint64_t bytes[TX_PACER_N_DECISIONS];
+    uint64_t capacity;     // bytes the link could have sent
+    uint32_t min_gap;      // fewest frames between full frames
+    uint32_t vetoed;       // full frames the pacer refused
+    uint32_t owed_max;     // most frames from a veto to the full frame
+    bool first_full;
+} result_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Stream FRAMES frames as stream_frame() does with APP_DUAL_STREAM.
+ */
+static result_t run(const scenario_t *s);
+
+/**
+ * @brief Return the percentage of the link's capacity a stream used.
+ */
+static uint32_t share(const result_t *r, tx_pacer_decision_t stream);
+
+// *****************************************************************************
+// Private (static) storage
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    static const scenario_t default_split = {"1:3", 1, 3, 10, SLOW_BAUD,
+                                             SUB_COST, 1000000, 0};
+    static const scenario_t even_split = {"1:1", 1, 1, 10, SLOW_BAUD,
+                                          SUB_COST, 1000000, 0};
+    static const scenario_t small_sub = {"small sub", 1, 3, 1, SLOW_BAUD,
+                                         500, 1000000, 0};
+    static const scenario_t fast = {"fast link", 1, 3, 10, FAST_BAUD,
+                                    SUB_COST, 1000000, 0};
+    static const scenario_t vetoes = {"vetoes", 1, 3, 10, SLOW_BAUD,
+                                      SUB_COST, 300000, 10000};
+    result_t r;
+
+    // the link split by weight, give or take a frame's rounding
+    r = run(&default_split);
+    check(r.first_full, "first frame not full");
+    check(share(&r, TX_PACER_FULL) >= 23 && share(&r, TX_PACER_FULL) <= 27 &&
+              share(&r, TX_PACER_DECIMATED) >= 72 &&
+              share(&r, TX_PACER_DECIMATED) <= 77,
+          "1:3 split");
+    check(r.min_gap >= default_split.full_interval, "full interval");
+
+    r = run(&even_split);
+    check(share(&r, TX_PACER_FULL) >= 47 && share(&r, TX_PACER_FULL) <= 53 &&
+              share(&r, TX_PACER_DECIMATED) >= 47 &&
+              share(&r, TX_PACER_DECIMATED) <= 53,
+          "1:1 split");
+
+    // the substream needs far less than its share, so full frames get it
+    r = run(&small_sub);
+    check(share(&r, TX_PACER_FULL) > 80 &&
+              r.counts[TX_PACER_SKIP] == 0,
+          "unused share not lent");
+    check(r.min_gap >= small_sub.full_interval, "full interval");
+
+    // nothing held back on a fast link
+    r = run(&fast);
+    check(r.counts[TX_PACER_FULL] == FRAMES / fast.full_interval &&
+              r.counts[TX_PACER_SKIP] == 0 &&
+              r.min_gap == fast.full_interval,
+          "fast link");
+
+    // bursts of other traffic hold up some full frames: each is sent once
+    // the queue has drained enough, which a burst or two may delay
+    r = run(&vetoes);
+    check(r.vetoed > 0 && r.owed_max <= 2 * BURST_INTERVAL &&
+              share(&r, TX_PACER_FULL) >= 20,
+          "vetoed full frames");
+
+    // a requested full frame goes next, whatever the credit
+    dual_stream_config_t config;
+    dual_stream_t ds;
+    dual_stream_default_config(&config);
+    dual_stream_init(&ds, &config);
+    dual_stream_update(&ds, 0, 0);
+    dual_stream_sent(&ds, dual_stream_choose(&ds, FULL_COST, SUB_COST),
+                     FULL_COST);
+    dual_stream_update(&ds, FRAME_US, SLOW_BAUD / 10);
+    bool sub = dual_stream_choose(&ds, FULL_COST, SUB_COST) ==
+               TX_PACER_DECIMATED;
+    dual_stream_sent(&ds, TX_PACER_DECIMATED, SUB_COST);
+    dual_stream_request_full(&ds);
+    dual_stream_update(&ds, FRAME_US, SLOW_BAUD / 10);
+    check(sub && dual_stream_choose(&ds, FULL_COST, SUB_COST) ==
+                     TX_PACER_FULL,
+          "requested full frame");
+
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static result_t run(const scenario_t *s) {
+    dual_stream_config_t config = {
+        .full_weight = s->full_weight,
+        .sub_weight = s->sub_weight,
+        .full_interval = s->full_interval,
+    };
+    tx_pacer_config_t pacer_config;
+    dual_stream_t ds;
+    tx_pacer_t pacer;
+    result_t r = {.min_gap = UINT32_MAX};
+    uint32_t drain_rate = s->baud / 10;
+    uint32_t queue = 0;
+    uint32_t last_full = 0;
+    uint32_t owed_since = 0;
+    bool owed = false;
+
+    dual_stream_init(&ds, &config);
+    tx_pacer_default_config(&pacer_config, s->baud);
+    pacer_config.max_latency_us = s->max_latency_us;
+    tx_pacer_init(&pacer, &pacer_config);
+
+    for (uint32_t n = 0; n < FRAMES; n++) {
+        uint32_t elapsed = n == 0 ? 0 : FRAME_US;
+
+        // as stream_frame()
+        if (n % BURST_INTERVAL == 0) {
+            tx_pacer_sent(&pacer, s->burst);
+            queue += s->burst;
+        }
+        tx_pacer_update(&pacer, elapsed, queue);
+        dual_stream_update(&ds, elapsed, pacer.rate);
+        tx_pacer_decision_t decision = dual_stream_decide(
+            &ds, &pacer, FULL_COST, s->sub_cost, UINT32_MAX);
+        uint32_t cost = decision == TX_PACER_FULL        ? FULL_COST
+                        : decision == TX_PACER_DECIMATED ? s->sub_cost
+                                                         : 0;
+        if (ds.need_full) {
+            // a full frame was wanted and vetoed
+            r.vetoed++;
+            if (!owed) {
+                owed = true;
+                owed_since = n;
+            }
+        }
+        tx_pacer_sent(&pacer, cost);
+        queue += cost;
+
+        r.counts[decision]++;
+        r.bytes[decision] += cost;
+        if (decision == TX_PACER_FULL) {
+            if (n == 0) {
+                r.first_full = true;
+            } else if (n - last_full < r.min_gap) {
+                r.min_gap = n - last_full;
+            }
+            if (owed && n - owed_since > r.owed_max) {
+                r.owed_max = n - owed_since;
+            }
+            owed = false;
+            last_full = n;
+        }
+
+        // the link drains the queue until the next frame
+        uint32_t drained = drain_rate / 30;
+        queue -= queue < drained ? queue : drained;
+        r.capacity += drained;
+    }
+    if (owed && FRAMES - owed_since > r.owed_max) {
+        r.owed_max = FRAMES - owed_since;
+    }
+    printf("# %-9s: %4u full (%2u%%), %4u sub (%2u%%), %4u skipped, "
+           "%3u vetoed, owed for up to %u frames\n",
+           s->name, r.counts[TX_PACER_FULL], share(&r, TX_PACER_FULL),
+           r.counts[TX_PACER_DECIMATED], share(&r, TX_PACER_DECIMATED),
+           r.counts[TX_PACER_SKIP], r.vetoed, r.owed_max);
+    return r;
+}
+
+static uint32_t share(const result_t *r, tx_pacer_decision_t stream) {
+    return (uint32_t)(r->bytes[stream] * 100 / r->capacity);
+}
+
+// *****************************************************************************
+// End of file
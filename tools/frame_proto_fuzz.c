@@ -0,0 +1,409 @@
+/**
+ * @file frame_proto_fuzz.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host fuzz test of the framed transport protocol
+ * (firmware/src/frame_proto.c).
+ *
+ * Encodes a stream of random messages and checks that:
+ *   - a clean stream, fed in random sized chunks, decodes exactly;
+ *   - with bit flips, dropped bytes and inserted garbage, every message the
+ *     decoder delivers is identical to the one sent, and every undamaged
+ *     message starting at least one maximum sized message after the last
+ *     damage is delivered (i.e. the decoder resynchronizes as soon as the
+ *     damaged message's announced length has passed);
+ *   - pure random input delivers nothing and doesn't upset the decoder;
+ *   - the same messages sent in fragments of random sizes are reassembled
+ *     exactly from a clean stream, and with bit flips no corrupt message is
+ *     reassembled and every undamaged one clear of the damage is.
+ *
+ * Build and run from this directory (the sanitizers are recommended):
+ *   cc -O1 -g -fsanitize=address,undefined -I../firmware/src \
+ *       -o frame_proto_fuzz frame_proto_fuzz.c ../firmware/src/frame_proto.c
+ *   ./frame_proto_fuzz [seed]
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define N_MESSAGES 4000
+#define MAX_PAYLOAD 3000     // largest payload generated
+#define DECODER_BUF_SIZE 2048 // longer payloads are skipped as oversize
+#define STREAM_SIZE (N_MESSAGES * (FRAME_PROTO_MESSAGE_SIZE(MAX_PAYLOAD) + 64))
+#define RANDOM_BYTES (16 * 1024 * 1024)
+#define FRAGMENT_MIN 256      // range of fragment sizes
+#define FRAGMENT_MAX 1024
+
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t length;
+    uint8_t *payload;
+    size_t offset;   // position in the clean stream
+    size_t size;     // bytes on the wire
+    bool damaged;    // altered in the damaged stream
+    size_t resync;   // bytes in the damaged stream since the last damage
+    bool delivered;  // seen by the decoder
+} message_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Encoder write function: append to the clean stream.
+ */
+static size_t stream_write(const void *data, size_t n, uintptr_t context);
+
+/**
+ * @brief Decoder callback: check a message against the one sent.
+ */
+static void on_message(const frame_proto_msg_t *msg, uintptr_t context);
+
+/**
+ * @brief Feed a buffer to the decoder in random sized chunks.
+ */
+static void feed(frame_proto_decoder_t *dec, const uint8_t *data, size_t n);
+
+static void reset_delivered(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static message_t s_messages[N_MESSAGES];
+static uint8_t s_stream[STREAM_SIZE];
+static size_t s_stream_len;
+static uint8_t s_damaged[STREAM_SIZE + N_MESSAGES * 64];
+static uint8_t s_decoder_buf[DECODER_BUF_SIZE];
+static uint8_t s_reasm_buf[DECODER_BUF_SIZE];
+static unsigned s_mismatches;
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+    frame_proto_encoder_t enc;
+    frame_proto_decoder_t dec;
+    bool ok = true;
+
+    srand(argc > 1 ? (unsigned)atoi(argv[1]) : 1);
+
+    // Known answer: the CRC must match zlib's crc32()
+    if (frame_proto_crc32(0, "123456789", 9) != 0xcbf43926u) {
+        printf("FAIL: CRC32 check value\n");
+        return 1;
+    }
+
+    // Encode the messages, some in pieces
+    frame_proto_encoder_init(&enc, stream_write, 0);
+    for (int i = 0; i < N_MESSAGES; i++) {
+        message_t *m = &s_messages[i];
+        m->type = (uint8_t)(1 + rand() % 5);
+        m->flags = (uint8_t)(rand() % 2);
+        m->length = (rand() % 8 == 0) ? 0 : (uint32_t)(rand() % MAX_PAYLOAD);
+        m->payload = malloc(m->length + 1);
+        for (uint32_t k = 0; k < m->length; k++) {
+            // Plenty of sync bytes in the payloads to tempt the decoder
+            m->payload[k] = (rand() % 4 == 0) ? (uint8_t)(0xa5 + (rand() % 2) * 0xb5)
+                                              : (uint8_t)rand();
+        }
+        m->offset = s_stream_len;
+        if (i % 2) {
+            ok &= frame_proto_send(&enc, m->type, m->flags, m->payload,
+                                   m->length);
+        } else {
+            uint32_t split = m->length / 3;
+            ok &= frame_proto_begin(&enc, m->type, m->flags, m->length);
+            ok &= frame_proto_write(&enc, m->payload, split);
+            ok &= frame_proto_write(&enc, m->payload + split,
+                                    m->length - split);
+            ok &= frame_proto_end(&enc);
+        }
+        m->size = s_stream_len - m->offset;
+        if (m->size != FRAME_PROTO_MESSAGE_SIZE(m->length)) {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        printf("FAIL: encoder\n");
+        return 1;
+    }
+
+    // 1. Clean stream
+    unsigned expect_oversize = 0;
+    for (int i = 0; i < N_MESSAGES; i++) {
+        expect_oversize += s_messages[i].length > DECODER_BUF_SIZE;
+    }
+    frame_proto_decoder_init(&dec, s_decoder_buf, sizeof(s_decoder_buf),
+                             on_message, 0);
+    feed(&dec, s_stream, s_stream_len);
+    printf("clean:   %u delivered, %u oversize, %u header errors, "
+           "%u CRC errors, %u lost\n",
+           dec.stats.messages, dec.stats.oversize, dec.stats.header_errors,
+           dec.stats.crc_errors, dec.stats.lost);
+    if (dec.stats.messages + dec.stats.oversize != N_MESSAGES ||
+        dec.stats.oversize != expect_oversize || dec.stats.header_errors ||
+        dec.stats.crc_errors || dec.stats.lost || dec.stats.skipped ||
+        s_mismatches) {
+        printf("FAIL: clean stream\n");
+        ok = false;
+    }
+
+    // 2. Damaged stream
+    size_t n = 0;
+    size_t last_damage = 0;
+    bool any_damage = false;
+    unsigned damaged = 0;
+    for (int i = 0; i < N_MESSAGES; i++) {
+        message_t *m = &s_messages[i];
+        const uint8_t *src = &s_stream[m->offset];
+        int what = rand() % 10;
+
+        m->damaged = what < 3;
+        damaged += m->damaged;
+        m->resync = any_damage ? n - last_damage : SIZE_MAX;
+        if (m->damaged) {
+            any_damage = true;
+            last_damage = n;
+        }
+        if (what == 0) {
+            // Flip a bit
+            memcpy(&s_damaged[n], src, m->size);
+            s_damaged[n + rand() % m->size] ^= (uint8_t)(1 << (rand() % 8));
+            n += m->size;
+        } else if (what == 1) {
+            // Drop up to 8 bytes
+            size_t at = rand() % m->size;
+            size_t drop = 1 + rand() % 8;
+            if (drop > m->size - at) {
+                drop = m->size - at;
+            }
+            memcpy(&s_damaged[n], src, at);
+            n += at;
+            memcpy(&s_damaged[n], src + at + drop, m->size - at - drop);
+            n += m->size - at - drop;
+        } else if (what == 2) {
+            // Truncate the message
+            size_t keep = rand() % m->size;
+            memcpy(&s_damaged[n], src, keep);
+            n += keep;
+        } else {
+            if (what == 3) {
+                // Garbage (or console text) between messages
+                size_t len = rand() % 64;
+                for (size_t k = 0; k < len; k++) {
+                    s_damaged[n++] = (uint8_t)rand();
+                }
+            }
+            memcpy(&s_damaged[n], src, m->size);
+            n += m->size;
+        }
+    }
+    reset_delivered();
+    frame_proto_decoder_init(&dec, s_decoder_buf, sizeof(s_decoder_buf),
+                             on_message, 0);
+    feed(&dec, s_damaged, n);
+    unsigned missed = 0;
+    for (int i = 0; i < N_MESSAGES; i++) {
+        const message_t *m = &s_messages[i];
+        if (!m->damaged && m->resync >= FRAME_PROTO_MESSAGE_SIZE(MAX_PAYLOAD) &&
+            m->length <= DECODER_BUF_SIZE && !m->delivered) {
+            missed++;
+        }
+    }
+    printf("damaged: %u of %u messages damaged, %u delivered, %u oversize, "
+           "%u header errors, %u CRC errors, %u lost, %u bytes skipped\n",
+           damaged, N_MESSAGES, dec.stats.messages, dec.stats.oversize,
+           dec.stats.header_errors, dec.stats.crc_errors, dec.stats.lost,
+           dec.stats.skipped);
+    if (s_mismatches || missed) {
+        printf("FAIL: %u corrupt messages delivered, %u intact messages "
+               "missed\n",
+               s_mismatches, missed);
+        ok = false;
+    }
+
+    // 3. Random input
+    uint8_t *noise = malloc(RANDOM_BYTES);
+    for (size_t k = 0; k < RANDOM_BYTES; k++) {
+        // Bias towards the sync bytes to exercise the header path
+        noise[k] = (rand() % 8 == 0) ? (uint8_t)(0xa5 + (rand() % 2) * 0xb5)
+                                     : (uint8_t)rand();
+    }
+    frame_proto_decoder_init(&dec, s_decoder_buf, sizeof(s_decoder_buf),
+                             on_message, 0);
+    feed(&dec, noise, RANDOM_BYTES);
+    printf("random:  %u bytes, %u delivered, %u header errors\n",
+           RANDOM_BYTES, dec.stats.messages, dec.stats.header_errors);
+    if (s_mismatches) {
+        printf("FAIL: messages delivered from random input\n");
+        ok = false;
+    }
+    free(noise);
+
+    // 4. Fragmented stream, tagged with the message index
+    frame_proto_encoder_init(&enc, stream_write, 0);
+    s_stream_len = 0;
+    for (int i = 0; i < N_MESSAGES; i++) {
+        message_t *m = &s_messages[i];
+        frame_proto_set_fragment_size(
+            &enc, FRAGMENT_MIN + rand() % (FRAGMENT_MAX - FRAGMENT_MIN + 1));
+        frame_proto_set_tag(&enc, (uint32_t)i);
+        m->offset = s_stream_len;
+        ok &= frame_proto_send(&enc, m->type, m->flags, m->payload,
+                               m->length);
+        m->size = s_stream_len - m->offset;
+        if (m->size != frame_proto_wire_size(&enc, m->length)) {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        printf("FAIL: fragmenting encoder\n");
+        return 1;
+    }
+    reset_delivered();
+    frame_proto_decoder_init(&dec, s_decoder_buf, sizeof(s_decoder_buf),
+                             on_message, 0);
+    frame_proto_decoder_set_reassembly(&dec, s_reasm_buf, sizeof(s_reasm_buf));
+    feed(&dec, s_stream, s_stream_len);
+    unsigned reassembled = 0;
+    for (int i = 0; i < N_MESSAGES; i++) {
+        reassembled += s_messages[i].delivered;
+    }
+    printf("fragmented: %u reassembled, %u oversize, %u fragment errors\n",
+           reassembled, dec.stats.oversize, dec.stats.fragment_errors);
+    if (reassembled + dec.stats.oversize != N_MESSAGES ||
+        dec.stats.oversize != expect_oversize || dec.stats.fragment_errors ||
+        dec.stats.crc_errors || dec.stats.lost || s_mismatches) {
+        printf("FAIL: clean fragmented stream\n");
+        ok = false;
+    }
+
+    // Flip a bit in one message in ten
+    any_damage = false;
+    for (int i = 0; i < N_MESSAGES; i++) {
+        message_t *m = &s_messages[i];
+        m->damaged = rand() % 10 == 0;
+        m->resync = any_damage ? m->offset - last_damage : SIZE_MAX;
+        if (m->damaged) {
+            s_stream[m->offset + rand() % m->size] ^= (uint8_t)(1 << (rand() % 8));
+            any_damage = true;
+            last_damage = m->offset + m->size;
+        }
+    }
+    reset_delivered();
+    frame_proto_decoder_init(&dec, s_decoder_buf, sizeof(s_decoder_buf),
+                             on_message, 0);
+    frame_proto_decoder_set_reassembly(&dec, s_reasm_buf, sizeof(s_reasm_buf));
+    feed(&dec, s_stream, s_stream_len);
+    missed = 0;
+    reassembled = 0;
+    for (int i = 0; i < N_MESSAGES; i++) {
+        const message_t *m = &s_messages[i];
+        reassembled += m->delivered;
+        if (!m->damaged &&
+            m->resync >= FRAME_PROTO_MESSAGE_SIZE(DECODER_BUF_SIZE) &&
+            m->length <= DECODER_BUF_SIZE && !m->delivered) {
+            missed++;
+        }
+    }
+    printf("fragmented, damaged: %u reassembled, %u fragment errors, "
+           "%u CRC errors, %u lost\n",
+           reassembled, dec.stats.fragment_errors, dec.stats.crc_errors,
+           dec.stats.lost);
+    if (s_mismatches || missed) {
+        printf("FAIL: %u corrupt messages reassembled, %u intact messages "
+               "missed\n",
+               s_mismatches, missed);
+        ok = false;
+    }
+
+    for (int i = 0; i < N_MESSAGES; i++) {
+        free(s_messages[i].payload);
+    }
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t stream_write(const void *data, size_t n, uintptr_t context) {
+    (void)context;
+    if (n > sizeof(s_stream) - s_stream_len) {
+        n = sizeof(s_stream) - s_stream_len;
+    }
+    memcpy(&s_stream[s_stream_len], data, n);
+    s_stream_len += n;
+    return n;
+}
+
+static void on_message(const frame_proto_msg_t *msg, uintptr_t context) {
+    (void)context;
+    // Sequence numbers start at 0 and N_MESSAGES < 65536, so they index
+    // the messages directly, as do the tags of fragmented messages
+    uint32_t index = msg->fragmented ? msg->tag : msg->seq;
+    if (index >= N_MESSAGES) {
+        s_mismatches++;
+        return;
+    }
+    message_t *m = &s_messages[index];
+    if (msg->type != m->type || msg->flags != m->flags ||
+        msg->length != m->length ||
+        memcmp(msg->payload, m->payload, m->length) != 0) {
+        s_mismatches++;
+        return;
+    }
+    m->delivered = true;
+}
+
+static void feed(frame_proto_decoder_t *dec, const uint8_t *data, size_t n) {
+    while (n > 0) {
+        size_t chunk = 1 + rand() % 700;
+        if (chunk > n) {
+            chunk = n;
+        }
+        frame_proto_decode(dec, data, chunk);
+        data += chunk;
+        n -= chunk;
+    }
+}
+
+static void reset_delivered(void) {
+    for (int i = 0; i < N_MESSAGES; i++) {
+        s_messages[i].delivered = false;
+    }
+}
@@ -0,0 +1,277 @@
+/**
+ * @file frame_stats_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of single-pass frame statistics
+ * (firmware/src/frame_stats.c).
+ *
+ * Checks every field of frame_stats_t against a plain per-pixel loop over
+ * random frames, flat frames and frames of FRAME_STATS_MAX_PIXELS, with the
+ * frame pushed whole, a row at a time and in pieces of random even size,
+ * from word aligned and unaligned buffers.  The CMSIS intrinsics are the
+ * portable C versions in host/definitions.h.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -Ihost -I../firmware/src -o frame_stats_test frame_stats_test.c \
+ *       ../firmware/src/frame_stats.c
+ *   ./frame_stats_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "frame_stats.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define IMAGE_WIDTH 96
+#define IMAGE_HEIGHT 96
+#define N_RANDOM_FRAMES 200
+
+typedef enum {
+    PUSH_WHOLE,
+    PUSH_ROWS,
+    PUSH_PIECES,
+    N_PUSH_MODES,
+} push_mode_t;
+
+static const char *const s_mode_names[] = {"whole", "rows", "pieces"};
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Compute the statistics with a plain loop over the pixels.
+ */
+static void reference(const uint8_t *yuyv, size_t n_pixels,
+                      frame_stats_t *stats);
+
+/**
+ * @brief Compute the statistics with frame_stats.c, pushing the frame as
+ * mode says.
+ */
+static void measure(const uint8_t *yuyv, size_t n_pixels, push_mode_t mode,
+                    frame_stats_t *stats);
+
+/**
+ * @brief Check a frame in every push mode, aligned and not.  Returns false
+ * and reports the first mismatch if any.
+ */
+static bool check_frame(const char *name, const uint8_t *yuyv,
+                        size_t n_pixels);
+
+/**
+ * @brief Describe the first field of two statistics that differs, or return
+ * NULL if they are equal.
+ */
+static const char *first_difference(const frame_stats_t *a,
+                                    const frame_stats_t *b);
+
+// *****************************************************************************
+// Private (static) storage
+
+// FRAME_STATS_MAX_PIXELS is a multiple of 2, plus a byte to misalign
+static uint8_t s_frame[FRAME_STATS_MAX_PIXELS * 2 + 1];
+static uint8_t s_shifted[FRAME_STATS_MAX_PIXELS * 2 + 1];
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    size_t n_frame = IMAGE_WIDTH * IMAGE_HEIGHT;
+    unsigned failures = 0;
+    char name[32];
+
+    srand(1);
+    for (int f = 0; f < N_RANDOM_FRAMES; f++) {
+        // a random range, so that the extremes aren't always 0 and 255
+        int lo = rand() % 256;
+        int span = 1 + rand() % (256 - lo);
+        for (size_t i = 0; i < n_frame * 2; i++) {
+            s_frame[i] = lo + rand() % span;
+        }
+        snprintf(name, sizeof(name), "random %d", f);
+        failures += !check_frame(name, s_frame, n_frame);
+    }
+
+    static const uint8_t flat[] = {0, FRAME_STATS_CLIP_LOW,
+                                   FRAME_STATS_CLIP_LOW + 1, 128,
+                                   FRAME_STATS_CLIP_HIGH - 1,
+                                   FRAME_STATS_CLIP_HIGH, 255};
+    for (size_t v = 0; v < sizeof(flat); v++) {
+        memset(s_frame, flat[v], n_frame * 2);
+        snprintf(name, sizeof(name), "flat %d", flat[v]);
+        failures += !check_frame(name, s_frame, n_frame);
+    }
+
+    // the largest frame, with every counter and chroma lane at its limit
+    memset(s_frame, 255, FRAME_STATS_MAX_PIXELS * 2);
+    failures += !check_frame("largest, 255", s_frame, FRAME_STATS_MAX_PIXELS);
+    for (size_t i = 0; i < FRAME_STATS_MAX_PIXELS * 2; i++) {
+        s_frame[i] = rand();
+    }
+    failures +=
+        !check_frame("largest, random", s_frame, FRAME_STATS_MAX_PIXELS);
+
+    failures += !check_frame("one pair", s_frame, 2);
+
+    frame_stats_t stats;
+    frame_stats_acc_t acc;
+    frame_stats_begin(&acc);
+    frame_stats_end(&acc, &stats);
+    frame_stats_t zero;
+    memset(&zero, 0, sizeof(zero));
+    if (memcmp(&stats, &zero, sizeof(stats)) != 0) {
+        printf("# empty frame: statistics not all zero\n");
+        failures++;
+    }
+
+    printf(failures == 0 ? "PASS\n" : "FAIL: %u frames\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void reference(const uint8_t *yuyv, size_t n_pixels,
+                      frame_stats_t *stats) {
+    uint64_t sum[FRAME_STATS_CHANNELS] = {0};
+    uint64_t sum_sq = 0;
+    uint32_t clip_low = 0;
+    uint32_t clip_high = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->n_pixels = n_pixels;
+    for (int c = 0; c < FRAME_STATS_CHANNELS; c++) {
+        stats->min[c] = 255;
+    }
+    for (size_t i = 0; i < n_pixels; i++) {
+        uint8_t y = yuyv[i * 2];
+        // U with even pixels, V with odd ones
+        int c = i % 2 == 0 ? FRAME_STATS_U : FRAME_STATS_V;
+        uint8_t uv = yuyv[i * 2 + 1];
+
+        stats->histogram[y]++;
+        sum[FRAME_STATS_Y] += y;
+        sum[c] += uv;
+        sum_sq += (uint64_t)y * y;
+        clip_low += y <= FRAME_STATS_CLIP_LOW;
+        clip_high += y >= FRAME_STATS_CLIP_HIGH;
+        stats->min[FRAME_STATS_Y] =
+            y < stats->min[FRAME_STATS_Y] ? y : stats->min[FRAME_STATS_Y];
+        stats->max[FRAME_STATS_Y] =
+            y > stats->max[FRAME_STATS_Y] ? y : stats->max[FRAME_STATS_Y];
+        stats->min[c] = uv < stats->min[c] ? uv : stats->min[c];
+        stats->max[c] = uv > stats->max[c] ? uv : stats->max[c];
+    }
+    stats->mean[FRAME_STATS_Y] = sum[FRAME_STATS_Y] / n_pixels;
+    stats->mean[FRAME_STATS_U] = sum[FRAME_STATS_U] / (n_pixels / 2);
+    stats->mean[FRAME_STATS_V] = sum[FRAME_STATS_V] / (n_pixels / 2);
+    // the variance rounded down, without any intermediate rounding
+    uint64_t n = n_pixels;
+    stats->variance =
+        (n * sum_sq - sum[FRAME_STATS_Y] * sum[FRAME_STATS_Y]) / (n * n);
+    stats->clip_low_permille = clip_low * 1000ULL / n_pixels;
+    stats->clip_high_permille = clip_high * 1000ULL / n_pixels;
+}
+
+static void measure(const uint8_t *yuyv, size_t n_pixels, push_mode_t mode,
+                    frame_stats_t *stats) {
+    static frame_stats_acc_t acc;
+
+    if (mode == PUSH_WHOLE) {
+        frame_stats_compute(yuyv, n_pixels, stats);
+        return;
+    }
+    frame_stats_begin(&acc);
+    size_t done = 0;
+    while (done < n_pixels) {
+        size_t n = mode == PUSH_ROWS ? IMAGE_WIDTH : 2 + 2 * (rand() % 300);
+        n = n < n_pixels - done ? n : n_pixels - done;
+        frame_stats_push(&acc, &yuyv[done * 2], n);
+        done += n;
+    }
+    frame_stats_end(&acc, stats);
+}
+
+static bool check_frame(const char *name, const uint8_t *yuyv,
+                        size_t n_pixels) {
+    frame_stats_t expected;
+    frame_stats_t actual;
+
+    reference(yuyv, n_pixels, &expected);
+    memcpy(&s_shifted[1], yuyv, n_pixels * 2);
+    for (int shift = 0; shift < 2; shift++) {
+        const uint8_t *in = shift ? &s_shifted[1] : yuyv;
+        for (int mode = 0; mode < N_PUSH_MODES; mode++) {
+            measure(in, n_pixels, mode, &actual);
+            const char *field = first_difference(&expected, &actual);
+            if (field != NULL) {
+                printf("# %s, pushed %s%s: %s differs\n", name,
+                       s_mode_names[mode], shift ? ", unaligned" : "", field);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static const char *first_difference(const frame_stats_t *a,
+                                    const frame_stats_t *b) {
+    if (a->n_pixels != b->n_pixels) {
+        return "n_pixels";
+    }
+    if (memcmp(a->mean, b->mean, sizeof(a->mean)) != 0) {
+        return "mean";
+    }
+    if (memcmp(a->min, b->min, sizeof(a->min)) != 0) {
+        return "min";
+    }
+    if (memcmp(a->max, b->max, sizeof(a->max)) != 0) {
+        return "max";
+    }
+    if (a->variance != b->variance) {
+        return "variance";
+    }
+    if (a->clip_low_permille != b->clip_low_permille ||
+        a->clip_high_permille != b->clip_high_permille) {
+        return "clipping";
+    }
+    if (memcmp(a->histogram, b->histogram, sizeof(a->histogram)) != 0) {
+        return "histogram";
+    }
+    return NULL;
+}
+
+// *****************************************************************************
+// End of file
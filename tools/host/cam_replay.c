@@ -0,0 +1,317 @@
+/**
+ * @file cam_replay.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Replay of a recording in place of the camera.  See cam_replay.h.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_replay.h"
+
+#include "cam_meta.h"
+#include "ov2640_spi.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// ArduChip registers, as in cam_data_task.c
+#define ARDUCHIP_FIFO 0x04
+#define FIFO_CLEAR_MASK 0x01
+#define FIFO_START_MASK 0x02
+#define ARDUCHIP_TRIG 0x41
+#define CAP_DONE_MASK 0x08
+#define BURST_FIFO_READ 0x3c
+#define FIFO_SIZE1 0x42
+#define FIFO_SIZE2 0x43
+#define FIFO_SIZE3 0x44
+
+typedef struct {
+    cam_rec_t rec;            // the recording
+    cam_replay_config_t config;
+    uint8_t regs[256];        // registers without special behaviour
+    uint8_t *data;            // the frame being captured
+    size_t data_size;         // capacity of data
+    cam_rec_frame_t frame;    // its metadata
+    cam_rec_frame_t last;     // metadata of the frame last read out
+    uint32_t next;            // index of the next frame to capture
+    uint32_t count;           // frames read out
+    bool capturing;           // a capture is in progress
+    bool done;                // no frames left
+    bool started;             // due_us is valid
+    uint64_t due_us;          // host time the capture completes
+    uint64_t prev_time_us;    // recorded time of the previous frame
+} cam_replay_ctx_t;
+
+// *****************************************************************************
+// Private (static) storage
+
+/**
+ * @brief Singleton replay context.
+ */
+static cam_replay_ctx_t s_replay;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Take the next frame of the recording and set when it is due.
+ */
+static void start_capture(void);
+
+static uint64_t now_us(void);
+
+// *****************************************************************************
+// Public code
+
+void cam_replay_default_config(cam_replay_config_t *config) {
+    config->speed = 1.0;
+    config->loop = false;
+    config->fifo_size = 0;
+}
+
+bool cam_replay_open(const char *path, const cam_replay_config_t *config) {
+    cam_rec_frame_t frame;
+
+    memset(&s_replay, 0, sizeof(s_replay));
+    if (!cam_rec_open(&s_replay.rec, path)) {
+        return false;
+    }
+    s_replay.config = *config;
+
+    // Room for the largest frame, or the FIFO if that is larger
+    s_replay.data_size = config->fifo_size;
+    for (uint32_t i = 0; i < s_replay.rec.count; i++) {
+        if (!cam_rec_read(&s_replay.rec, i, &frame, NULL, 0)) {
+            cam_rec_close(&s_replay.rec);
+            return false;
+        }
+        if (frame.length > s_replay.data_size) {
+            s_replay.data_size = frame.length;
+        }
+    }
+    s_replay.data = malloc(s_replay.data_size);
+    if (s_replay.rec.count == 0 || s_replay.data == NULL) {
+        cam_replay_close();
+        return false;
+    }
+    return true;
+}
+
+void cam_replay_close(void) {
+    cam_rec_close(&s_replay.rec);
+    free(s_replay.data);
+    s_replay.data = NULL;
+}
+
+const cam_rec_t *cam_replay_recording(void) {
+    return &s_replay.rec;
+}
+
+void cam_replay_wait(void) {
+    if (!s_replay.capturing) {
+        return;
+    }
+    uint64_t now = now_us();
+    if (now < s_replay.due_us) {
+        uint64_t wait = s_replay.due_us - now;
+        struct timespec ts = {
+            .tv_sec = wait / 1000000,
+            .tv_nsec = (wait % 1000000) * 1000,
+        };
+        nanosleep(&ts, NULL);
+    }
+}
+
+bool cam_replay_done(void) {
+    return s_replay.done;
+}
+
+const cam_rec_frame_t *cam_replay_frame(void) {
+    return &s_replay.last;
+}
+
+uint32_t cam_replay_count(void) {
+    return s_replay.count;
+}
+
+// ov2640_spi.h
+
+bool ov2640_spi_read_byte(uint8_t addr, uint8_t *data) {
+    uint32_t fifo_size = s_replay.config.fifo_size != 0
+                             ? s_replay.config.fifo_size
+                             : s_replay.frame.length;
+
+    switch (addr) {
+    case ARDUCHIP_TRIG:
+        *data = s_replay.regs[addr] & ~CAP_DONE_MASK;
+        if (s_replay.capturing && now_us() >= s_replay.due_us) {
+            *data |= CAP_DONE_MASK;
+        }
+        break;
+    case FIFO_SIZE1:
+        *data = fifo_size;
+        break;
+    case FIFO_SIZE2:
+        *data = fifo_size >> 8;
+        break;
+    case FIFO_SIZE3:
+        *data = fifo_size >> 16;
+        break;
+    default:
+        *data = s_replay.regs[addr];
+        break;
+    }
+    return true;
+}
+
+bool ov2640_spi_write_byte(uint8_t addr, uint8_t data) {
+    addr &= 0x7f; // the write flag, if set
+    if (addr == ARDUCHIP_FIFO && (data & FIFO_START_MASK) != 0) {
+        start_capture();
+    }
+    // FIFO_CLEAR_MASK needs nothing: a capture restarted after a timeout
+    // keeps its frame and due time
+    s_replay.regs[addr] = data & ~(FIFO_START_MASK | FIFO_CLEAR_MASK);
+    return true;
+}
+
+bool ov2640_spi_read_bytes(uint8_t command, uint8_t *rx_buf,
+                           size_t rx_buflen) {
+    if (command != BURST_FIFO_READ || !s_replay.capturing) {
+        return false;
+    }
+    size_t n = s_replay.frame.length < rx_buflen ? s_replay.frame.length
+                                                 : rx_buflen;
+    memcpy(rx_buf, s_replay.data, n);
+    memset(rx_buf + n, 0, rx_buflen - n);
+    s_replay.last = s_replay.frame;
+    s_replay.count++;
+    s_replay.capturing = false;
+    s_replay.done = !s_replay.config.loop &&
+                    s_replay.next >= s_replay.rec.count;
+    return true;
+}
+
+bool ov2640_spi_set_bit(uint8_t addr, uint8_t bitmask) {
+    uint8_t value;
+    return ov2640_spi_read_byte(addr, &value) &&
+           ov2640_spi_write_byte(addr, value | bitmask);
+}
+
+bool ov2640_spi_clear_bit(uint8_t addr, uint8_t bitmask) {
+    uint8_t value;
+    return ov2640_spi_read_byte(addr, &value) &&
+           ov2640_spi_write_byte(addr, value & ~bitmask);
+}
+
+bool ov2640_spi_test_bit(uint8_t addr, uint8_t bitmask, bool *value) {
+    uint8_t data;
+    if (!ov2640_spi_read_byte(addr, &data)) {
+        return false;
+    }
+    *value = (data & bitmask) != 0;
+    return true;
+}
+
+#ifndef CAM_REPLAY_WITH_META
+// cam_meta.h: there is no sensor to sample
+
+bool cam_meta_window_open(void) {
+    return false;
+}
+
+bool cam_meta_window_pending(void) {
+    return false;
+}
+
+bool cam_meta_window_close(cam_meta_t *meta) {
+    memset(meta, 0, sizeof(*meta));
+    return false;
+}
+#endif
+
+// *****************************************************************************
+// Private (static) code
+
+static void start_capture(void) {
+    if (s_replay.capturing || s_replay.done) {
+        return;
+    }
+    if (s_replay.next >= s_replay.rec.count) {
+        if (!s_replay.config.loop) {
+            s_replay.done = true;
+            return;
+        }
+        s_replay.next = 0;
+    }
+    if (!cam_rec_read(&s_replay.rec, s_replay.next, &s_replay.frame,
+                      s_replay.data, s_replay.data_size)) {
+        s_replay.done = true;
+        return;
+    }
+
+    // Due one recorded interval after the previous frame was due.  The
+    // interval before the first frame (or the first after looping) is the
+    // one after it.  Time going backwards (the device restarted) counts as
+    // no interval.
+    uint64_t now = now_us();
+    uint64_t from = s_replay.prev_time_us;
+    uint64_t to = s_replay.frame.time_us;
+    if (s_replay.next == 0 && s_replay.rec.count > 1) {
+        from = s_replay.rec.index[0].time_us;
+        to = s_replay.rec.index[1].time_us;
+    }
+    uint64_t interval_us = to > from ? to - from : 0;
+    if (!s_replay.started || s_replay.config.speed <= 0) {
+        s_replay.due_us = now;
+        s_replay.started = true;
+    } else {
+        s_replay.due_us += (uint64_t)(interval_us / s_replay.config.speed);
+        if (s_replay.due_us + interval_us < now) {
+            // far behind (e.g. stopped in a debugger): don't race to catch up
+            s_replay.due_us = now;
+        }
+    }
+    s_replay.prev_time_us = s_replay.frame.time_us;
+    s_replay.next++;
+    s_replay.capturing = true;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// *****************************************************************************
+// End of file
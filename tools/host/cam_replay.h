@@ -0,0 +1,132 @@
+/**
+ * @file cam_replay.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Replay of a recording (cam_rec.h) in place of the camera, for a
+ * host build of cam_data_task.c.
+ *
+ * Implements the ov2640_spi.h interface by emulating the ArduChip registers
+ * cam_data_task uses: starting a capture takes the next frame of the
+ * recording, the capture done flag is raised when the frame is due, the
+ * FIFO size registers report the configured FIFO length and a burst FIFO
+ * read returns the frame, zero padded to that length (the camera's FIFO
+ * holds a few more bytes than the frame).  cam_meta.h is stubbed out: the
+ * sensor isn't there to sample, so frames carry invalid metadata; the
+ * recorded exposure and gain are available from cam_replay_frame().  Define
+ * CAM_REPLAY_WITH_META to drop the stubs and link cam_meta.c against a
+ * simulated I2C bus instead (see cam_meta_test.c).
+ *
+ * Frames fall due at the recorded intervals divided by the speed, measured
+ * from when the previous frame fell due, so time spent processing a frame
+ * doesn't delay the ones after it unless it exceeds the interval.  At speed
+ * 0 every frame is due at once, to run the pipeline flat out.
+ *
+ * Link this in place of ov2640_spi.c (and cam_meta.c), and call
+ * cam_replay_wait() before each cam_data_task_step(): it sleeps until the
+ * capture in progress is due, where the firmware would poll.
+ */
+
+#ifndef _CAM_REPLAY_H_
+#define _CAM_REPLAY_H_
+
+// *****************************************************************************
+// Includes
+
+#include "cam_rec.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+typedef struct {
+    double speed;       // 1 for the recorded timing, 2 for twice as fast,
+                        // 0 for no waiting
+    bool loop;          // start again at the end of the recording
+    uint32_t fifo_size; // bytes the FIFO holds per frame, 0 for the frame
+                        // length
+} cam_replay_config_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Fill in a config structure with defaults: recorded timing, no
+ * looping, a FIFO of the frame length.
+ */
+void cam_replay_default_config(cam_replay_config_t *config);
+
+/**
+ * @brief Open a recording to replay.
+ * @return false if it can't be read or has no frames.
+ */
+bool cam_replay_open(const char *path, const cam_replay_config_t *config);
+
+void cam_replay_close(void);
+
+/**
+ * @brief The recording being replayed.
+ */
+const cam_rec_t *cam_replay_recording(void);
+
+/**
+ * @brief Sleep until the capture in progress is due.  Returns at once if no
+ * capture is in progress.
+ */
+void cam_replay_wait(void);
+
+/**
+ * @brief Return true when every frame has been read out (never when
+ * looping).
+ */
+bool cam_replay_done(void);
+
+/**
+ * @brief Metadata of the frame last read out.
+ */
+const cam_rec_frame_t *cam_replay_frame(void);
+
+/**
+ * @brief Number of frames read out.
+ */
+uint32_t cam_replay_count(void);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _CAM_REPLAY_H_ */
@@ -0,0 +1,84 @@
+/**
+ * @file check.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Pass/fail bookkeeping for the host tests.
+ *
+ * check() prints a "# FAIL:" line for each condition that does not hold
+ * and counts it; check_result() prints PASS or FAIL at the end and returns
+ * the exit status for main().  The count is static, so include this header
+ * from the test's own source file only.
+ */
+
+#ifndef _HOST_CHECK_H_
+#define _HOST_CHECK_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public declarations
+
+static unsigned s_check_failures;
+
+/**
+ * @brief Count a failure, and print what was expected, unless ok.
+ */
+static inline void check(bool ok, const char *what) {
+    if (!ok) {
+        printf("# FAIL: %s\n", what);
+        s_check_failures++;
+    }
+}
+
+/**
+ * @brief Print PASS if no check() failed, FAIL otherwise.
+ *
+ * @return The exit status: 0 on PASS, 1 on FAIL.
+ */
+static inline int check_result(void) {
+    printf(s_check_failures == 0 ? "PASS\n" : "FAIL\n");
+    return s_check_failures == 0 ? 0 : 1;
+}
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _HOST_CHECK_H_ */
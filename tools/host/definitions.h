@@ -0,0 +1,257 @@
+/**
+ * @file definitions.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host stand-in for the firmware's definitions.h.
+ *
+ * Lets the host tools compile the hardware-independent firmware modules,
+ * and cam_data_task.c with the SPI replaced by a recording (cam_replay.h):
+ * - the CMSIS SIMD intrinsics, each implemented in portable C with the same
+ *   result as the Cortex-M7 instruction;
+ * - SYS_TIME, ticking at SYS_TIME_TICK_FREQ_IN_HZ as on the target, read from
+ *   the host's monotonic clock, or with HOST_SIM_TIME defined from
+ *   host_sim_time, a tick count that the tool advances itself;
+ * - the driver types and configuration that the camera headers refer to,
+ *   or with HOST_DRV_I2C defined the Harmony I2C driver itself, for tools
+ *   that link drv_i2c.c against a stand-in PLIB (add
+ *   -I../firmware/src/config/default to the include path);
+ * - SYS_INT, as host/system/int/sys_int.h;
+ * - the USART1 calls link_baud.c makes, for the tool to define;
+ * - the board LED, as a no-op.
+ *
+ * Add to the include path ahead of firmware/src:
+ *   cc -Ihost -I../firmware/src ...
+ */
+
+#ifndef _HOST_DEFINITIONS_H_
+#define _HOST_DEFINITIONS_H_
+
+// *****************************************************************************
+// Includes
+
+#include "system/int/sys_int.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HOST_DRV_I2C
+#include "configuration.h"
+#include "driver/i2c/drv_i2c.h"
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+typedef uintptr_t SYS_TIME_HANDLE;
+#define SYS_TIME_HANDLE_INVALID ((SYS_TIME_HANDLE)0)
+
+// As in config/default/configuration.h.  Tick-based timeouts in the firmware
+// (e.g. CAPTURE_TIMEOUT_TICS) assume this rate.
+#define SYS_TIME_TICK_FREQ_IN_HZ 1000
+
+typedef enum {
+    SYS_TIME_ERROR = -1,
+    SYS_TIME_SUCCESS = 0,
+} SYS_TIME_RESULT;
+
+typedef uintptr_t DRV_HANDLE;
+
+// As in peripheral/usart/plib_usart1.h.  The other calls are defined by the
+// tool that links link_baud.c.
+#define USART1_FrequencyGet() (uint32_t)(150000000UL)
+uint32_t USART1_ReadErrorCountGet(void);
+bool USART1_BaudDivisorSet(uint32_t cd, uint32_t fp, bool over8);
+bool USART1_TransmitComplete(void);
+
+#ifdef HOST_SIM_TIME
+extern uint32_t host_sim_time;
+#endif
+
+// As in config/default/configuration.h
+#define DRV_I2C_QUEUE_SIZE_IDX0 8
+
+#define LED0__Toggle() ((void)0)
+
+// *****************************************************************************
+// Public declarations
+
+static inline uint32_t __UNALIGNED_UINT32_READ(const void *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void __UNALIGNED_UINT32_WRITE(void *p, uint32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline uint32_t __ROR(uint32_t x, uint32_t n) {
+    n &= 31;
+    return n == 0 ? x : (x >> n) | (x << (32 - n));
+}
+
+/**
+ * @brief Bytes 0 and 2 of x, zero extended into the two halfwords.
+ */
+static inline uint32_t __UXTB16(uint32_t x) {
+    return x & 0x00ff00ff;
+}
+
+/**
+ * @brief acc plus bytes 0 and 2 of x, per halfword.
+ */
+static inline uint32_t __UXTAB16(uint32_t acc, uint32_t x) {
+    return ((acc + (x & 0xff)) & 0xffff) |
+           ((acc & 0xffff0000) + (x & 0x00ff0000));
+}
+
+#define __PKHBT(a, b, n)                                                       \
+    ((((uint32_t)(a)) & 0x0000ffff) | ((((uint32_t)(b)) << (n)) & 0xffff0000))
+#define __PKHTB(a, b, n)                                                       \
+    ((((uint32_t)(a)) & 0xffff0000) | ((((uint32_t)(b)) >> (n)) & 0x0000ffff))
+
+static inline uint32_t host_pack16(int32_t lo, int32_t hi) {
+    return ((uint32_t)lo & 0xffff) | ((uint32_t)hi << 16);
+}
+
+static inline uint32_t __SADD16(uint32_t a, uint32_t b) {
+    return host_pack16((int16_t)a + (int16_t)b,
+                       (int16_t)(a >> 16) + (int16_t)(b >> 16));
+}
+
+static inline uint32_t __SSUB16(uint32_t a, uint32_t b) {
+    return host_pack16((int16_t)a - (int16_t)b,
+                       (int16_t)(a >> 16) - (int16_t)(b >> 16));
+}
+
+/**
+ * @brief Sum of the products of the signed halfwords of a and b.
+ */
+static inline int32_t __SMUAD(uint32_t a, uint32_t b) {
+    return (int16_t)a * (int16_t)b + (int16_t)(a >> 16) * (int16_t)(b >> 16);
+}
+
+static inline int32_t host_usat(int32_t v, uint32_t bits) {
+    int32_t max = (1 << bits) - 1;
+    return v < 0 ? 0 : v > max ? max : v;
+}
+
+/**
+ * @brief Saturate each signed halfword of x to an unsigned bits-bit value.
+ */
+#define __USAT16(x, bits)                                                      \
+    host_pack16(host_usat((int16_t)(x), (bits)),                              \
+                host_usat((int16_t)((uint32_t)(x) >> 16), (bits)))
+
+/**
+ * @brief Sum of absolute differences of the four bytes of a and b, plus acc.
+ */
+static inline uint32_t __USADA8(uint32_t a, uint32_t b, uint32_t acc) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        int d = (int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff);
+        acc += d < 0 ? -d : d;
+    }
+    return acc;
+}
+
+// The APSR.GE flags, set by __USUB8 and used by __SEL
+__attribute__((unused)) static uint32_t s_host_ge;
+
+/**
+ * @brief Bytewise a - b, setting a GE flag for each byte where a >= b.
+ */
+static inline uint32_t __USUB8(uint32_t a, uint32_t b) {
+    uint32_t result = 0;
+    s_host_ge = 0;
+    for (int i = 0; i < 4; i++) {
+        int d = (int)((a >> (8 * i)) & 0xff) - (int)((b >> (8 * i)) & 0xff);
+        if (d >= 0) {
+            s_host_ge |= 1u << i;
+        }
+        result |= ((uint32_t)d & 0xff) << (8 * i);
+    }
+    return result;
+}
+
+/**
+ * @brief Each byte from a where its GE flag is set, else from b.
+ */
+static inline uint32_t __SEL(uint32_t a, uint32_t b) {
+    uint32_t result = 0;
+    for (int i = 0; i < 4; i++) {
+        uint32_t mask = 0xffu << (8 * i);
+        result |= ((s_host_ge >> i) & 1 ? a : b) & mask;
+    }
+    return result;
+}
+
+static inline uint32_t SYS_TIME_CounterGet(void) {
+#ifdef HOST_SIM_TIME
+    return host_sim_time;
+#endif
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * SYS_TIME_TICK_FREQ_IN_HZ +
+                      (uint64_t)ts.tv_nsec * SYS_TIME_TICK_FREQ_IN_HZ /
+                          1000000000);
+}
+
+static inline uint32_t SYS_TIME_CountToUS(uint32_t count) {
+    return (uint32_t)((uint64_t)count * 1000000 / SYS_TIME_TICK_FREQ_IN_HZ);
+}
+
+static inline uint32_t SYS_TIME_CountToMS(uint32_t count) {
+    return (uint32_t)((uint64_t)count * 1000 / SYS_TIME_TICK_FREQ_IN_HZ);
+}
+
+static inline uint32_t SYS_TIME_USToCount(uint32_t us) {
+    return (uint32_t)((uint64_t)us * SYS_TIME_TICK_FREQ_IN_HZ / 1000000);
+}
+
+static inline uint32_t SYS_TIME_MSToCount(uint32_t ms) {
+    return (uint32_t)((uint64_t)ms * SYS_TIME_TICK_FREQ_IN_HZ / 1000);
+}
+
+/**
+ * @brief Start a delay.  The handle holds its deadline.
+ */
+static inline SYS_TIME_RESULT SYS_TIME_DelayMS(uint32_t ms,
+                                               SYS_TIME_HANDLE *handle) {
+    *handle = (SYS_TIME_HANDLE)(SYS_TIME_CounterGet() +
+                                 ms * SYS_TIME_TICK_FREQ_IN_HZ / 1000) | 1;
+    return SYS_TIME_SUCCESS;
+}
+
+static inline bool SYS_TIME_DelayIsComplete(SYS_TIME_HANDLE handle) {
+    return (int32_t)(SYS_TIME_CounterGet() - (uint32_t)(handle | 1)) >= 0;
+}
+
+// *****************************************************************************
+// End of file
+
+#endif /* #ifndef _HOST_DEFINITIONS_H_ */
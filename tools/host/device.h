@@ -0,0 +1,87 @@
+/**
+ * @file device.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host stand-in for the Harmony device.h.
+ *
+ * The host builds of the Harmony driver sources (e.g. drv_i2c_sim.c) need
+ * none of the SAMV71 register definitions, only the CMSIS compiler macros
+ * the Harmony headers use.
+ *
+ * With HOST_TWIHS0 defined, it also lets a tool build the TWIHS0 PLIB
+ * (plib_twihs0_master.c) against a simulated peripheral:
+ * - the TWIHS register layout and fields, from the device pack;
+ * - TWIHS0_REGS, which calls host_twihs0_regs() on every register access,
+ *   so the tool can act on the previous write before the next access;
+ * - __disable_irq() and __enable_irq(), as SYS_INT_Disable() and
+ *   SYS_INT_Restore(true) (see host/system/int/sys_int.h).
+ */
+
+#ifndef _HOST_DEVICE_H_
+#define _HOST_DEVICE_H_
+
+// *****************************************************************************
+// Includes
+
+#ifdef HOST_TWIHS0
+#include "system/int/sys_int.h"
+#include <stdint.h>
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define __STATIC_INLINE static inline
+
+#ifdef HOST_TWIHS0
+// As in the device pack and CMSIS, except that the read-only registers are
+// writable: the simulated peripheral sets them.
+#define _UINT8_(x) ((uint8_t)(x))
+#define _UINT32_(x) ((uint32_t)(x))
+#define __I volatile
+#define __O volatile
+#define __IO volatile
+
+#include "packs/ATSAMV71Q21B_DFP/component/twihs.h"
+
+#define TWIHS0_REGS (host_twihs0_regs())
+
+#define __disable_irq() ((void)SYS_INT_Disable())
+#define __enable_irq() SYS_INT_Restore(true)
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief The simulated TWIHS0 registers, defined by the tool.
+ */
+twihs_registers_t *host_twihs0_regs(void);
+#endif
+
+// *****************************************************************************
+// End of file
+
+#endif /* #ifndef _HOST_DEVICE_H_ */
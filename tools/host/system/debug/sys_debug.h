@@ -0,0 +1,51 @@
+/**
+ * @file sys_debug.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host stand-in for system/debug/sys_debug.h: debug messages are
+ * discarded, as in the firmware's release build.
+ */
+
+#ifndef _HOST_SYS_DEBUG_H_
+#define _HOST_SYS_DEBUG_H_
+
+// *****************************************************************************
+// Public types and definitions
+
+typedef enum {
+    SYS_ERROR_FATAL = 0,
+    SYS_ERROR_ERROR = 1,
+    SYS_ERROR_WARNING = 2,
+    SYS_ERROR_INFO = 3,
+    SYS_ERROR_DEBUG = 4,
+} SYS_ERROR_LEVEL;
+
+#define SYS_DEBUG_MESSAGE(level, message) ((void)(level), (void)(message))
+
+// *****************************************************************************
+// End of file
+
+#endif /* #ifndef _HOST_SYS_DEBUG_H_ */
@@ -0,0 +1,82 @@
+/**
+ * @file sys_int.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host stand-in for system/int/sys_int.h.
+ *
+ * There are no interrupts on the host: the "interrupt handlers" of a
+ * simulated peripheral run only when the test calls them, so disabling
+ * interrupts has nothing to do.
+ *
+ * With HOST_INT_HOOK defined the interrupt enable is tracked, and
+ * re-enabling interrupts calls host_int_hook(), which the tool defines to
+ * advance its simulated peripheral and run any interrupt handler that has
+ * become pending.  Code that waits with interrupts enabled then sees the
+ * peripheral make progress, as on the target.
+ */
+
+#ifndef _HOST_SYS_INT_H_
+#define _HOST_SYS_INT_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+
+// *****************************************************************************
+// Public declarations
+
+#ifdef HOST_INT_HOOK
+extern bool host_int_enabled;
+
+void host_int_hook(void);
+
+static inline bool SYS_INT_Disable(void) {
+    bool state = host_int_enabled;
+    host_int_enabled = false;
+    return state;
+}
+
+static inline void SYS_INT_Restore(bool state) {
+    host_int_enabled = state;
+    if (state) {
+        host_int_hook();
+    }
+}
+#else
+static inline bool SYS_INT_Disable(void) {
+    return true;
+}
+
+static inline void SYS_INT_Restore(bool state) {
+    (void)state;
+}
+#endif
+
+// *****************************************************************************
+// End of file
+
+#endif /* #ifndef _HOST_SYS_INT_H_ */
@@ -0,0 +1,355 @@
+/**
+ * @file host_cmd_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the command interface (firmware/src/host_cmd.c).
+ *
+ * Sends commands as tools/cam_cmd.py does, decodes them a byte at a time as
+ * poll_rx() in app.c does from the receive ring, and checks that:
+ * - GET, SET and SNAPSHOT reach the handler and are answered with the id,
+ *   op and parameter echoed and the handler's status and value
+ * - unknown ops and parameters, and a SET without its value, are refused
+ *   without calling the handler
+ * - a message too short to be a command gets no reply
+ * - commands split across reads, among console text and other messages,
+ *   are all found, and a damaged one is ignored
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o host_cmd_test host_cmd_test.c \
+ *       ../firmware/src/host_cmd.c ../firmware/src/frame_proto.c
+ *   ./host_cmd_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+#include "host/check.h"
+#include "host_cmd.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define STREAM_SIZE 4096
+#define MAX_REPLIES 32
+
+// Largest value the test handler accepts for a SET
+#define MAX_VALUE 100
+
+typedef struct {
+    uint8_t op;
+    uint8_t id;
+    uint8_t param;
+    uint8_t status;
+    uint32_t value;
+} reply_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Queue a command for the firmware, as cam_cmd.py sends it.  Without
+ * has_value, the value is left out.
+ */
+static void host_send(uint8_t op, uint8_t id, uint8_t param, bool has_value,
+                      uint32_t value);
+
+/**
+ * @brief Feed the queued bytes to the firmware's decoder in reads of up to
+ * read_size bytes, then decode its replies.
+ */
+static void deliver(size_t read_size);
+
+/**
+ * @brief Return true if reply i is as expected.
+ */
+static bool expect_reply(unsigned i, uint8_t op, uint8_t id, uint8_t param,
+                         host_cmd_status_t status, uint32_t value);
+
+/**
+ * @brief Command handler standing in for app.c: a value per parameter, and
+ * one snapshot at a time.
+ */
+static host_cmd_status_t on_command(const host_cmd_request_t *request,
+                                    uint32_t *value, uintptr_t context);
+
+static size_t to_device(const void *data, size_t n, uintptr_t context);
+static size_t to_host(const void *data, size_t n, uintptr_t context);
+static void on_device_message(const frame_proto_msg_t *msg,
+                              uintptr_t context);
+static void on_host_message(const frame_proto_msg_t *msg, uintptr_t context);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_to_device[STREAM_SIZE];
+static size_t s_to_device_n;
+static uint8_t s_to_host[STREAM_SIZE];
+static size_t s_to_host_n;
+
+static frame_proto_encoder_t s_host_enc;
+static frame_proto_encoder_t s_device_enc;
+static frame_proto_decoder_t s_device_dec;
+static uint8_t s_device_dec_buf[64];
+static frame_proto_decoder_t s_host_dec;
+static uint8_t s_host_dec_buf[64];
+
+static host_cmd_t s_cmd;
+
+// The handler's state
+static uint32_t s_settings[HOST_CMD_N_PARAMS];
+static bool s_snapshot_pending;
+static unsigned s_handled;
+
+static reply_t s_replies[MAX_REPLIES];
+static unsigned s_n_replies;
+static unsigned s_other_messages;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    frame_proto_encoder_init(&s_host_enc, to_device, 0);
+    frame_proto_encoder_init(&s_device_enc, to_host, 0);
+    frame_proto_decoder_init(&s_device_dec, s_device_dec_buf,
+                             sizeof(s_device_dec_buf), on_device_message, 0);
+    frame_proto_decoder_init(&s_host_dec, s_host_dec_buf,
+                             sizeof(s_host_dec_buf), on_host_message, 0);
+    host_cmd_init(&s_cmd, &s_device_enc, on_command, 0);
+
+    // every parameter can be set and read back
+    for (uint8_t param = 1; param < HOST_CMD_N_PARAMS; param++) {
+        host_send(HOST_CMD_OP_SET, param, param, true, param * 10u);
+        host_send(HOST_CMD_OP_GET, 100 + param, param, false, 0);
+    }
+    deliver(1);
+    check(s_n_replies == 2 * (HOST_CMD_N_PARAMS - 1), "replies");
+    for (uint8_t param = 1; param < HOST_CMD_N_PARAMS; param++) {
+        unsigned i = 2 * (param - 1u);
+        check(expect_reply(i, HOST_CMD_OP_SET, param, param, HOST_CMD_OK,
+                           param * 10u) &&
+                  expect_reply(i + 1, HOST_CMD_OP_GET, 100 + param, param,
+                               HOST_CMD_OK, param * 10u),
+              "set and get");
+    }
+    check(s_cmd.commands == 2 * (HOST_CMD_N_PARAMS - 1) && s_cmd.errors == 0,
+          "commands counted");
+
+    // refused by host_cmd, without calling the handler
+    unsigned handled = s_handled;
+    s_n_replies = 0;
+    host_send(9, 1, HOST_CMD_PARAM_FPS, false, 0);
+    host_send(HOST_CMD_OP_GET, 2, HOST_CMD_PARAM_NONE, false, 0);
+    host_send(HOST_CMD_OP_GET, 3, HOST_CMD_N_PARAMS, false, 0);
+    host_send(HOST_CMD_OP_SET, 4, HOST_CMD_PARAM_FPS, false, 0);
+    deliver(7);
+    check(s_handled == handled, "handler called for a bad command");
+    check(s_n_replies == 4 &&
+              expect_reply(0, 9, 1, HOST_CMD_PARAM_FPS, HOST_CMD_ERR_OP, 0) &&
+              expect_reply(1, HOST_CMD_OP_GET, 2, HOST_CMD_PARAM_NONE,
+                           HOST_CMD_ERR_PARAM, 0) &&
+              expect_reply(2, HOST_CMD_OP_GET, 3, HOST_CMD_N_PARAMS,
+                           HOST_CMD_ERR_PARAM, 0) &&
+              expect_reply(3, HOST_CMD_OP_SET, 4, HOST_CMD_PARAM_FPS,
+                           HOST_CMD_ERR_VALUE, 0),
+          "bad commands");
+    check(s_settings[HOST_CMD_PARAM_FPS] == 20, "SET without a value");
+
+    // refused by the handler, and a snapshot that is busy until taken
+    s_n_replies = 0;
+    host_send(HOST_CMD_OP_SET, 5, HOST_CMD_PARAM_FPS, true, MAX_VALUE + 1);
+    host_send(HOST_CMD_OP_SNAPSHOT, 6, HOST_CMD_PARAM_NONE, false, 0);
+    host_send(HOST_CMD_OP_SNAPSHOT, 7, HOST_CMD_PARAM_NONE, false, 0);
+    deliver(64);
+    check(s_n_replies == 3 &&
+              expect_reply(0, HOST_CMD_OP_SET, 5, HOST_CMD_PARAM_FPS,
+                           HOST_CMD_ERR_VALUE, 20) &&
+              expect_reply(1, HOST_CMD_OP_SNAPSHOT, 6, HOST_CMD_PARAM_NONE,
+                           HOST_CMD_OK, 0) &&
+              expect_reply(2, HOST_CMD_OP_SNAPSHOT, 7, HOST_CMD_PARAM_NONE,
+                           HOST_CMD_ERR_BUSY, 0),
+          "handler status");
+    check(s_cmd.errors == 6, "errors counted");
+
+    // too short to answer
+    uint8_t stub[2] = {HOST_CMD_OP_GET, 8};
+    s_n_replies = 0;
+    frame_proto_send(&s_host_enc, FRAME_PROTO_TYPE_COMMAND, 0, stub,
+                     sizeof(stub));
+    deliver(3);
+    check(s_n_replies == 0 && s_cmd.errors == 7, "short command");
+
+    // among console text and other messages, and one damaged on the way
+    s_n_replies = 0;
+    for (uint8_t id = 0; id < 20; id++) {
+        static const char text[] = "# plain text\r\n";
+        memcpy(&s_to_device[s_to_device_n], text, sizeof(text) - 1);
+        s_to_device_n += sizeof(text) - 1;
+        uint8_t link[5] = {7, 0, 0, 0, 0};
+        frame_proto_send(&s_host_enc, FRAME_PROTO_TYPE_LINK, 0, link,
+                         sizeof(link));
+        size_t start = s_to_device_n;
+        host_send(HOST_CMD_OP_GET, id, HOST_CMD_PARAM_PROFILE, false, 0);
+        if (id == 10) {
+            s_to_device[start + FRAME_PROTO_HEADER_SIZE + 1] ^= 0x01;
+        }
+    }
+    deliver(5);
+    bool in_order = s_n_replies == 19;
+    for (unsigned i = 0; i < s_n_replies && in_order; i++) {
+        in_order = expect_reply(i, HOST_CMD_OP_GET, i < 10 ? i : i + 1,
+                                HOST_CMD_PARAM_PROFILE, HOST_CMD_OK, 10);
+    }
+    check(in_order, "commands among other traffic");
+    check(s_other_messages == 0, "replies to other messages");
+
+    printf("# %u commands handled, %u refused\n", s_cmd.commands,
+           s_cmd.errors);
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void host_send(uint8_t op, uint8_t id, uint8_t param, bool has_value,
+                      uint32_t value) {
+    uint8_t payload[HOST_CMD_COMMAND_SIZE] = {
+        op,
+        id,
+        param,
+        (uint8_t)value,
+        (uint8_t)(value >> 8),
+        (uint8_t)(value >> 16),
+        (uint8_t)(value >> 24),
+    };
+    frame_proto_send(&s_host_enc, FRAME_PROTO_TYPE_COMMAND, 0, payload,
+                     has_value ? HOST_CMD_COMMAND_SIZE
+                               : HOST_CMD_MIN_COMMAND_SIZE);
+}
+
+static void deliver(size_t read_size) {
+    for (size_t i = 0; i < s_to_device_n; i += read_size) {
+        size_t n = s_to_device_n - i < read_size ? s_to_device_n - i
+                                                 : read_size;
+        frame_proto_decode(&s_device_dec, &s_to_device[i], n);
+    }
+    s_to_device_n = 0;
+    frame_proto_decode(&s_host_dec, s_to_host, s_to_host_n);
+    s_to_host_n = 0;
+}
+
+static bool expect_reply(unsigned i, uint8_t op, uint8_t id, uint8_t param,
+                         host_cmd_status_t status, uint32_t value) {
+    const reply_t *r = &s_replies[i];
+    bool ok = i < s_n_replies && r->op == op && r->id == id &&
+              r->param == param && r->status == status && r->value == value;
+    if (!ok) {
+        printf("# reply %u: op %u id %u param %u status %u value %u\n", i,
+               r->op, r->id, r->param, r->status, r->value);
+    }
+    return ok;
+}
+
+static host_cmd_status_t on_command(const host_cmd_request_t *request,
+                                    uint32_t *value, uintptr_t context) {
+    (void)context;
+    s_handled++;
+    switch (request->op) {
+    case HOST_CMD_OP_SNAPSHOT:
+        if (s_snapshot_pending) {
+            return HOST_CMD_ERR_BUSY;
+        }
+        s_snapshot_pending = true;
+        return HOST_CMD_OK;
+    case HOST_CMD_OP_SET:
+        if (request->value > MAX_VALUE) {
+            *value = s_settings[request->param];
+            return HOST_CMD_ERR_VALUE;
+        }
+        s_settings[request->param] = request->value;
+        break;
+    default:
+        break;
+    }
+    *value = s_settings[request->param];
+    return HOST_CMD_OK;
+}
+
+static size_t to_device(const void *data, size_t n, uintptr_t context) {
+    (void)context;
+    if (s_to_device_n + n > sizeof(s_to_device)) {
+        return 0;
+    }
+    memcpy(&s_to_device[s_to_device_n], data, n);
+    s_to_device_n += n;
+    return n;
+}
+
+static size_t to_host(const void *data, size_t n, uintptr_t context) {
+    (void)context;
+    if (s_to_host_n + n > sizeof(s_to_host)) {
+        return 0;
+    }
+    memcpy(&s_to_host[s_to_host_n], data, n);
+    s_to_host_n += n;
+    return n;
+}
+
+static void on_device_message(const frame_proto_msg_t *msg,
+                              uintptr_t context) {
+    (void)context;
+    // as on_rx_message() in app.c
+    if (msg->type == FRAME_PROTO_TYPE_COMMAND) {
+        host_cmd_on_message(&s_cmd, msg);
+    }
+}
+
+static void on_host_message(const frame_proto_msg_t *msg, uintptr_t context) {
+    (void)context;
+    if (msg->type != FRAME_PROTO_TYPE_REPLY ||
+        msg->length != HOST_CMD_REPLY_SIZE) {
+        s_other_messages++;
+        return;
+    }
+    if (s_n_replies == MAX_REPLIES) {
+        return;
+    }
+    reply_t *r = &s_replies[s_n_replies++];
+    r->op = msg->payload[0];
+    r->id = msg->payload[1];
+    r->param = msg->payload[2];
+    r->status = msg->payload[3];
+    r->value = (uint32_t)msg->payload[4] | (msg->payload[5] << 8) |
+               (msg->payload[6] << 16) | ((uint32_t)msg->payload[7] << 24);
+}
+
+// *****************************************************************************
+// End of file
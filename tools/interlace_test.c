@@ -0,0 +1,199 @@
+/**
+ * @file interlace_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the progressive row order (firmware/src/interlace.c).
+ *
+ * For every frame height up to MAX_HEIGHT, checks that:
+ * - each row is sent exactly once, and interlace_position() inverts
+ *   interlace_row()
+ * - the first pass is every 8th row, so a preview is possible after 1/8 of
+ *   the rows, and each later pass halves the row spacing
+ * - all the rows restore the frame exactly
+ * - after any number of rows, each row of a preview is the nearest row at
+ *   or above it received so far, and before the first pass is complete the
+ *   rows not received are left alone
+ * The end to end path, from the encoder to the receiver's previews, is
+ * covered by cam_rx_test.c.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o interlace_test interlace_test.c \
+ *       ../firmware/src/interlace.c
+ *   ./interlace_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "host/check.h"
+#include "interlace.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_HEIGHT 240
+
+// Each row holds its own number, and a byte to catch stride mistakes
+#define ROW_BYTES 3
+
+// Rows not written by interlace_restore()
+#define UNTOUCHED 0xee
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Check the order of rows for one height.
+ */
+static void test_order(uint16_t height);
+
+/**
+ * @brief Check the frames restored from every prefix of the rows sent.
+ */
+static void test_restore(uint16_t height);
+
+/**
+ * @brief Return the row number stored in a row, or -1 if it is untouched.
+ */
+static int row_of(const uint8_t *dst, uint16_t row);
+
+static void check_height(bool ok, const char *what, uint16_t height);
+
+// *****************************************************************************
+// Private (static) storage
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    for (uint16_t height = 1; height <= MAX_HEIGHT; height++) {
+        test_order(height);
+        test_restore(height);
+    }
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void test_order(uint16_t height) {
+    static bool seen[MAX_HEIGHT];
+    bool ok = true;
+
+    memset(seen, 0, sizeof(seen));
+    for (uint16_t i = 0; i < height && ok; i++) {
+        uint16_t row = interlace_row(height, i);
+        ok = row < height && !seen[row] && interlace_position(height, row) == i;
+        seen[row] = true;
+    }
+    check_height(ok, "rows sent once each, in order", height);
+
+    // pass 0 is every 8th row, then every 8th row between them, and so on
+    static const uint8_t spacing[INTERLACE_PASSES] = {8, 8, 4, 2};
+    check_height(interlace_pass_start(height, 1) == (height + 7) / 8,
+                 "first pass size", height);
+    check_height(interlace_pass_start(height, INTERLACE_PASSES) == height,
+                 "all passes", height);
+    for (uint8_t pass = 0; pass < INTERLACE_PASSES; pass++) {
+        uint16_t start = interlace_pass_start(height, pass);
+        uint16_t end = interlace_pass_start(height, pass + 1);
+        for (uint16_t i = start; i < end; i++) {
+            uint16_t row = interlace_row(height, i);
+            bool in_pass =
+                row % spacing[pass] == (pass == 0 ? 0 : spacing[pass] / 2);
+            bool ascending = i == start || row > interlace_row(height, i - 1);
+            ok = ok && in_pass && ascending;
+        }
+    }
+    check_height(ok, "pass contents", height);
+}
+
+static void test_restore(uint16_t height) {
+    static uint8_t src[MAX_HEIGHT * ROW_BYTES];
+    static uint8_t dst[MAX_HEIGHT * ROW_BYTES];
+    uint16_t first_pass = interlace_pass_start(height, 1);
+
+    for (uint16_t i = 0; i < height; i++) {
+        uint16_t row = interlace_row(height, i);
+        src[i * ROW_BYTES + 0] = (uint8_t)row;
+        src[i * ROW_BYTES + 1] = (uint8_t)(row >> 8);
+        src[i * ROW_BYTES + 2] = (uint8_t)(row ^ 0x5a);
+    }
+
+    for (uint16_t n_rows = 0; n_rows <= height; n_rows++) {
+        memset(dst, UNTOUCHED, sizeof(dst));
+        bool preview =
+            interlace_restore(src, n_rows, dst, height, ROW_BYTES);
+        bool ok = preview == (n_rows >= first_pass);
+        for (uint16_t row = 0; row < height && ok; row++) {
+            // the nearest row at or above it received so far, and only
+            // the row itself without a preview
+            int expected = -1;
+            for (int from = row; from >= 0 && expected < 0; from--) {
+                if (interlace_position(height, (uint16_t)from) < n_rows &&
+                    (preview || from == row)) {
+                    expected = from;
+                }
+            }
+            ok = row_of(dst, row) == expected;
+        }
+        check_height(ok, "restored rows", height);
+        if (!ok) {
+            printf("#   after %u rows\n", n_rows);
+            break;
+        }
+    }
+
+    interlace_restore(src, height, dst, height, ROW_BYTES);
+    bool ok = true;
+    for (uint16_t row = 0; row < height; row++) {
+        ok = ok && row_of(dst, row) == row;
+    }
+    check_height(ok, "whole frame", height);
+}
+
+static int row_of(const uint8_t *dst, uint16_t row) {
+    const uint8_t *p = &dst[row * ROW_BYTES];
+    if (p[0] == UNTOUCHED && p[1] == UNTOUCHED && p[2] == UNTOUCHED) {
+        return -1;
+    }
+    int n = p[0] | p[1] << 8;
+    return p[2] == (uint8_t)(n ^ 0x5a) ? n : -2;
+}
+
+static void check_height(bool ok, const char *what, uint16_t height) {
+    char msg[80];
+    snprintf(msg, sizeof(msg), "%s, height %u", what, height);
+    check(ok, msg);
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,238 @@
+"""
+Host side of the console link rate negotiation (firmware/src/link_baud.h).
+
+Opens the port at the firmware's base rate, then proposes the candidate
+rates fastest first and locks onto the first one that passes a test pattern
+in both directions.  While locked, keepalives carry the count of errors seen
+by the host; if the firmware falls back, or nothing valid arrives for a
+while, the host returns to the base rate and renegotiates below the rate
+that failed.
+
+Messages use the framing of firmware/src/frame_proto.h.
+
+Usage:
+    python link_baud.py /dev/ttyUSB0
+    python link_baud.py COM3 --candidates 2000000 1000000 921600
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+SYNC = b'\xa5\x5a'
+HEADER_SIZE = 12
+
+TYPE_LINK = 6
+
+OP_PROPOSE = 1
+OP_ACCEPT = 2
+OP_REJECT = 3
+OP_PATTERN = 4
+OP_COMMIT = 5
+OP_LOCKED = 6
+OP_KEEPALIVE = 7
+OP_FALLBACK = 8
+
+BASE_BAUD = 937500
+TRIAL_S = 0.5
+KEEPALIVE_S = 0.5
+SILENCE_S = 2.0
+
+# Rates most USB-serial adapters can generate, fastest first
+CANDIDATES = [3000000, 2000000, 1500000, 1000000, 921600, 500000, 460800,
+              230400, 115200]
+
+
+def pattern():
+    """The test pattern: every byte value, alternating bits, zeros, ones."""
+    return (bytes(range(256)) + b'\x55\xaa' * 32 + b'\x00' * 32 +
+            b'\xff' * 32)
+
+
+def encode(msg_type, seq, payload, flags=0):
+    """Frame a message."""
+    fields = struct.pack('<BBHI', msg_type, flags, seq & 0xffff, len(payload))
+    check = zlib.crc32(fields) & 0xffff
+    return (SYNC + fields + struct.pack('<H', check) + payload +
+            struct.pack('<I', zlib.crc32(payload)))
+
+
+class Decoder:
+    """Extract messages from a byte stream, skipping anything else."""
+
+    def __init__(self, max_payload=1 << 16):
+        self._buf = bytearray()
+        self._max_payload = max_payload
+        self.errors = 0
+
+    def feed(self, data):
+        """Return the (type, flags, seq, payload) of each complete message."""
+        self._buf += data
+        messages = []
+        while True:
+            start = self._buf.find(SYNC)
+            if start < 0:
+                # keep a trailing first sync byte
+                del self._buf[:max(0, len(self._buf) - 1)]
+                return messages
+            del self._buf[:start]
+            if len(self._buf) < HEADER_SIZE:
+                return messages
+            msg_type, flags, seq, length, check = struct.unpack_from(
+                '<BBHIH', self._buf, 2)
+            if (zlib.crc32(self._buf[2:10]) & 0xffff != check or
+                    length > self._max_payload):
+                self.errors += 1
+                del self._buf[:1]
+                continue
+            end = HEADER_SIZE + length + 4
+            if len(self._buf) < end:
+                return messages
+            payload = bytes(self._buf[HEADER_SIZE:HEADER_SIZE + length])
+            crc, = struct.unpack_from('<I', self._buf, end - 4)
+            del self._buf[:end]
+            if zlib.crc32(payload) != crc:
+                self.errors += 1
+                continue
+            messages.append((msg_type, flags, seq, payload))
+
+
+class Link:
+    """A serial port whose rate is negotiated with the firmware."""
+
+    def __init__(self, port, base=BASE_BAUD):
+        self.base = base
+        self.ser = serial.Serial(port, base, timeout=0.02)
+        self.decoder = Decoder()
+        self._seq = 0
+        self._keepalive_at = 0.0
+        self._reported_errors = 0
+        self._heard_at = time.monotonic()
+        self._candidates = CANDIDATES
+
+    @property
+    def baud(self):
+        return self.ser.baudrate
+
+    def send(self, msg_type, payload):
+        self.ser.write(encode(msg_type, self._seq, payload))
+        self._seq += 1
+
+    def send_op(self, op, value=None, payload=b''):
+        if value is not None:
+            payload = struct.pack('<I', value)
+        self.send(TYPE_LINK, bytes([op]) + payload)
+
+    def read(self):
+        """Return the messages received so far, and handle LINK messages
+        from the firmware (keepalives, fallback)."""
+        messages = self.decoder.feed(self.ser.read(self.ser.in_waiting or 1))
+        now = time.monotonic()
+        if messages:
+            self._heard_at = now
+        failed = None
+        for msg_type, _, _, payload in messages:
+            if msg_type == TYPE_LINK and payload[:1] == bytes([OP_FALLBACK]):
+                print("# link: firmware fell back from %d baud" % self.baud)
+                failed = self.baud
+        if self.baud != self.base:
+            if failed is None and now - self._heard_at > SILENCE_S:
+                print("# link: nothing received at %d baud" % self.baud)
+                failed = self.baud
+            if failed is not None:
+                # give the firmware time to notice too
+                time.sleep(SILENCE_S)
+                self._set_baud(self.base)
+                self.negotiate([c for c in self._candidates if c < failed])
+            else:
+                self.keepalive()
+        return messages
+
+    def keepalive(self):
+        """Send a keepalive if one is due.  Callers that read the port
+        themselves rather than through read() must call this regularly to
+        hold a negotiated rate."""
+        now = time.monotonic()
+        if self.baud != self.base and now - self._keepalive_at >= KEEPALIVE_S:
+            errors = self.decoder.errors - self._reported_errors
+            self._reported_errors = self.decoder.errors
+            self.send_op(OP_KEEPALIVE, errors)
+            self._keepalive_at = now
+
+    def negotiate(self, candidates=CANDIDATES):
+        """Try the candidates fastest first; return the rate locked onto."""
+        self._candidates = candidates
+        for baud in sorted(candidates, reverse=True):
+            if baud <= self.base:
+                break
+            if self._try(baud):
+                print("# link: locked at %d baud" % baud)
+                return baud
+        self._set_baud(self.base)
+        print("# link: staying at %d baud" % self.base)
+        return self.base
+
+    def _try(self, baud):
+        self.send_op(OP_PROPOSE, baud)
+        reply = self._await_op((OP_ACCEPT, OP_REJECT), TRIAL_S)
+        if reply is None or reply[0] != OP_ACCEPT:
+            return False
+        actual, cd, fp, over = struct.unpack_from('<IHBB', reply, 5)
+        print("# link: trying %d baud (%d generated, CD %d, FP %d, %dx)" %
+              (baud, actual, cd, fp, over))
+
+        # The firmware switches once the ACCEPT has left its transmitter
+        self.ser.flush()
+        self._set_baud(baud)
+        deadline = time.monotonic() + TRIAL_S
+        expected = bytes([OP_PATTERN]) + pattern()
+        while time.monotonic() < deadline:
+            self.send_op(OP_PATTERN, payload=pattern())
+            echo = self._await_op((OP_PATTERN,), 0.05)
+            if echo == expected:
+                self.send_op(OP_COMMIT)
+                if self._await_op((OP_LOCKED,), deadline - time.monotonic()):
+                    self._heard_at = self._keepalive_at = time.monotonic()
+                    return True
+                break
+        # The firmware reverts when its trial times out
+        time.sleep(max(0.0, deadline - time.monotonic()) + 0.05)
+        self._set_baud(self.base)
+        return False
+
+    def _await_op(self, ops, timeout):
+        deadline = time.monotonic() + max(timeout, 0.0)
+        while time.monotonic() < deadline:
+            for msg_type, _, _, payload in self.decoder.feed(
+                    self.ser.read(self.ser.in_waiting or 1)):
+                if msg_type == TYPE_LINK and payload and payload[0] in ops:
+                    return payload
+        return None
+
+    def _set_baud(self, baud):
+        self.ser.baudrate = baud
+        self.ser.reset_input_buffer()
+        self.decoder = Decoder()
+        self._reported_errors = 0
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="negotiate the console link rate.")
+    parser.add_argument('--base', type=int, default=BASE_BAUD, help="Firmware's base rate. Defaults to %d." % BASE_BAUD)
+    parser.add_argument('--candidates', type=int, nargs='+', default=CANDIDATES, help="Rates to try, e.g. those the adapter supports.")
+    parser.add_argument('--hold', type=float, default=10.0, help="Seconds to hold the link and count errors afterwards.")
+    parser.add_argument('serial_port', help="Serial port to connect to, e.g. 'COM1' or '/dev/ttyUSB0'.")
+    args = parser.parse_args()
+
+    link = Link(args.serial_port, args.base)
+    baud = link.negotiate(args.candidates)
+    count = 0
+    end = time.monotonic() + args.hold
+    while time.monotonic() < end:
+        count += len(link.read())
+    print("# link: %d messages, %d errors at %d baud" % (count, link.decoder.errors, link.baud))
+    sys.exit(0 if baud == link.baud else 1)
@@ -0,0 +1,354 @@
+/**
+ * @file link_baud_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of console baud rate negotiation
+ * (firmware/src/link_baud.c).
+ *
+ * Plays the host's side of the protocol against the firmware state machine,
+ * with a stand-in USART1 whose transmitter can be held busy and a simulated
+ * SYS_TIME clock.  Checks that:
+ * - the divisors for the rates tools/link_baud.py tries (and two faster
+ *   ones) are within LINK_BAUD_MAX_ERROR_PPM and generate the rate they
+ *   report, and rates that can't be generated are refused
+ * - a trial locks after PROPOSE, PATTERN and COMMIT, and returns to the
+ *   previous rate if it isn't committed in time or the pattern is corrupt
+ * - a locked rate falls back to the base rate when keepalives stop or
+ *   errors burst
+ * - the divisor is only ever changed with the transmitter idle: a trial
+ *   whose switch can't drain in time is abandoned at the current rate, and
+ *   a return to the base rate waits for the drain
+ *
+ * Build and run from this directory:
+ *   cc -O2 -DHOST_SIM_TIME -Ihost -I../firmware/src -o link_baud_test \
+ *       link_baud_test.c ../firmware/src/link_baud.c \
+ *       ../firmware/src/frame_proto.c
+ *   ./link_baud_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "definitions.h"
+#include "frame_proto.h"
+#include "host/check.h"
+#include "link_baud.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MCK 150000000UL
+
+// Replies kept from the firmware, and the largest
+#define MAX_REPLIES 8
+#define MAX_REPLY (1 + LINK_BAUD_PATTERN_SIZE)
+
+typedef struct {
+    uint8_t op;
+    uint32_t value; // the u32 after the op, if any
+    uint32_t length;
+} reply_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Send the firmware a LINK message: op, then value unless it is a
+ * PATTERN, whose payload is the test pattern with corrupt bytes flipped.
+ */
+static void host_send(uint8_t op, uint32_t value, bool corrupt);
+
+/**
+ * @brief Run link_baud_step() for ms milliseconds of simulated time.
+ */
+static void run_ms(uint32_t ms);
+
+/**
+ * @brief Return true if the firmware's only reply since the last call was
+ * op (with value, unless it is ACCEPT or PATTERN), and forget the replies.
+ */
+static bool expect_reply(uint8_t op, uint32_t value);
+
+/**
+ * @brief Negotiate baud from the base rate and return true if it locked.
+ */
+static bool negotiate(uint32_t baud);
+
+/**
+ * @brief frame_proto write and message callbacks: the firmware's messages
+ * go straight to a decoder, as the host would read them.
+ */
+static size_t link_write(const void *data, size_t n, uintptr_t context);
+static void on_reply(const frame_proto_msg_t *msg, uintptr_t context);
+
+// *****************************************************************************
+// Private (static) storage
+
+uint32_t host_sim_time;
+
+static frame_proto_encoder_t s_enc;
+static frame_proto_decoder_t s_dec;
+static uint8_t s_dec_buf[FRAME_PROTO_MESSAGE_SIZE(MAX_REPLY)];
+
+static reply_t s_replies[MAX_REPLIES];
+static unsigned s_n_replies;
+
+// the stand-in USART1
+static bool s_tx_busy;
+static uint32_t s_rx_errors;
+static unsigned s_divisor_sets;
+static unsigned s_mid_byte_sets;
+static uint32_t s_baud; // rate the divisor generates
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    // the rates tools/link_baud.py tries, and some that can't be generated
+    static const uint32_t good[] = {3000000, 2000000, 1500000, 1000000,
+                                    937500,  921600,  500000,  460800,
+                                    230400,  115200,  6000000, 9375000};
+    static const uint32_t bad[] = {0, 12000000, 11000000, 20000000, 100};
+    for (size_t i = 0; i < sizeof(good) / sizeof(good[0]); i++) {
+        link_baud_divisor_t div;
+        bool ok = link_baud_divisor(good[i], MCK, &div);
+        uint32_t actual = (uint32_t)((uint64_t)MCK * 8 /
+                                     ((div.over8 ? 8 : 16) *
+                                      ((uint64_t)div.cd * 8 + div.fp)));
+        uint32_t diff =
+            actual > good[i] ? actual - good[i] : good[i] - actual;
+        printf("# %8u baud: CD %5u FP %u %2ux, %8u actual\n", good[i], div.cd,
+               div.fp, div.over8 ? 8 : 16, div.actual);
+        check(ok && actual == div.actual &&
+                  (uint64_t)diff * 1000000 <=
+                      (uint64_t)LINK_BAUD_MAX_ERROR_PPM * good[i],
+              "divisor");
+    }
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        link_baud_divisor_t div;
+        check(!link_baud_divisor(bad[i], MCK, &div), "impossible rate");
+    }
+
+    frame_proto_encoder_init(&s_enc, link_write, 0);
+    frame_proto_decoder_init(&s_dec, s_dec_buf, sizeof(s_dec_buf), on_reply,
+                             0);
+    link_baud_init(&s_enc);
+    run_ms(1);
+    check(!link_baud_busy() && s_baud == LINK_BAUD_BASE, "init");
+
+    // a trial that locks; a proposal while locked starts another trial, but
+    // one during a trial is refused
+    check(negotiate(3000000) && link_baud_rate() == 3000000 &&
+              s_baud == 3000000,
+          "trial didn't lock");
+    host_send(LINK_BAUD_OP_PROPOSE, 6000000, false);
+    check(expect_reply(LINK_BAUD_OP_ACCEPT, 0), "locked rate not changed");
+    run_ms(1);
+    host_send(LINK_BAUD_OP_PROPOSE, 2000000, false);
+    check(expect_reply(LINK_BAUD_OP_REJECT, 2000000), "second trial accepted");
+    run_ms(LINK_BAUD_TRIAL_MS + 10);
+    check(!link_baud_busy() && s_baud == 3000000,
+          "uncommitted trial didn't return");
+
+    // keepalives hold the rate, then stop
+    for (int i = 0; i < 10; i++) {
+        host_send(LINK_BAUD_OP_KEEPALIVE, 0, false);
+        run_ms(LINK_BAUD_KEEPALIVE_MS);
+    }
+    check(s_baud == 3000000 && s_n_replies == 0, "keepalives not enough");
+    run_ms(4 * LINK_BAUD_KEEPALIVE_MS + 10);
+    check(expect_reply(LINK_BAUD_OP_FALLBACK, LINK_BAUD_BASE) &&
+              s_baud == LINK_BAUD_BASE,
+          "no fallback without keepalives");
+
+    // an error burst, reported by the host and seen by the firmware
+    check(negotiate(2000000), "second trial didn't lock");
+    host_send(LINK_BAUD_OP_KEEPALIVE, LINK_BAUD_ERROR_BURST / 2, false);
+    s_rx_errors += LINK_BAUD_ERROR_BURST / 2;
+    run_ms(LINK_BAUD_ERROR_WINDOW_MS + 10);
+    check(expect_reply(LINK_BAUD_OP_FALLBACK, LINK_BAUD_BASE) &&
+              s_baud == LINK_BAUD_BASE,
+          "no fallback on an error burst");
+
+    // a corrupt pattern isn't echoed, and the trial can't be committed
+    host_send(LINK_BAUD_OP_PROPOSE, 1000000, false);
+    check(expect_reply(LINK_BAUD_OP_ACCEPT, 0), "no accept");
+    run_ms(1);
+    host_send(LINK_BAUD_OP_PATTERN, 0, true);
+    host_send(LINK_BAUD_OP_COMMIT, 0, false);
+    check(s_n_replies == 0, "corrupt pattern accepted");
+    run_ms(LINK_BAUD_TRIAL_MS + 10);
+    check(s_baud == LINK_BAUD_BASE && !link_baud_busy(),
+          "failed trial didn't return");
+    host_send(LINK_BAUD_OP_PROPOSE, 11000000, false);
+    check(expect_reply(LINK_BAUD_OP_REJECT, 11000000), "bad rate accepted");
+
+    // the transmitter stays busy: the trial is abandoned, and the divisor
+    // is never touched
+    unsigned sets = s_divisor_sets;
+    host_send(LINK_BAUD_OP_PROPOSE, 3000000, false);
+    check(expect_reply(LINK_BAUD_OP_ACCEPT, 0), "no accept");
+    s_tx_busy = true;
+    check(link_baud_busy(), "not busy while draining");
+    run_ms(2 * LINK_BAUD_TRIAL_MS);
+    check(!link_baud_busy() && s_divisor_sets == sets &&
+              link_baud_rate() == LINK_BAUD_BASE,
+          "trial not abandoned");
+    s_tx_busy = false;
+
+    // a fallback while the transmitter is busy waits for it
+    check(negotiate(3000000), "third trial didn't lock");
+    s_tx_busy = true;
+    sets = s_divisor_sets;
+    run_ms(4 * LINK_BAUD_KEEPALIVE_MS + 10);
+    check(expect_reply(LINK_BAUD_OP_FALLBACK, LINK_BAUD_BASE),
+          "no fallback while busy");
+    run_ms(5000);
+    check(link_baud_busy() && s_divisor_sets == sets,
+          "fallback didn't wait for the transmitter");
+    s_tx_busy = false;
+    run_ms(1);
+    check(!link_baud_busy() && s_baud == LINK_BAUD_BASE,
+          "fallback didn't complete");
+
+    check(s_mid_byte_sets == 0, "divisor changed mid-byte");
+    return check_result();
+}
+
+uint32_t USART1_ReadErrorCountGet(void) { return s_rx_errors; }
+
+bool USART1_BaudDivisorSet(uint32_t cd, uint32_t fp, bool over8) {
+    s_divisor_sets++;
+    s_mid_byte_sets += s_tx_busy;
+    s_baud = (uint32_t)((uint64_t)MCK * 8 / ((over8 ? 8 : 16) * (cd * 8 + fp)));
+    // report the requested rate, as link_baud_divisor() rounds it
+    link_baud_divisor_t div;
+    static const uint32_t rates[] = {LINK_BAUD_BASE, 6000000, 3000000,
+                                     2000000, 1000000};
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (link_baud_divisor(rates[i], MCK, &div) && div.cd == cd &&
+            div.fp == fp && div.over8 == over8) {
+            s_baud = rates[i];
+        }
+    }
+    return true;
+}
+
+bool USART1_TransmitComplete(void) { return !s_tx_busy; }
+
+// *****************************************************************************
+// Private (static) code
+
+static void host_send(uint8_t op, uint32_t value, bool corrupt) {
+    uint8_t payload[MAX_REPLY];
+    frame_proto_msg_t msg = {
+        .type = FRAME_PROTO_TYPE_LINK,
+        .payload = payload,
+    };
+
+    payload[0] = op;
+    if (op == LINK_BAUD_OP_PATTERN) {
+        link_baud_pattern(&payload[1]);
+        if (corrupt) {
+            payload[100] ^= 0x10;
+        }
+        msg.length = 1 + LINK_BAUD_PATTERN_SIZE;
+    } else {
+        payload[1] = (uint8_t)value;
+        payload[2] = (uint8_t)(value >> 8);
+        payload[3] = (uint8_t)(value >> 16);
+        payload[4] = (uint8_t)(value >> 24);
+        msg.length = op == LINK_BAUD_OP_COMMIT ? 1 : 5;
+    }
+    link_baud_on_message(&msg);
+}
+
+static void run_ms(uint32_t ms) {
+    for (uint32_t i = 0; i < ms * SYS_TIME_TICK_FREQ_IN_HZ / 1000; i++) {
+        host_sim_time++;
+        link_baud_step();
+    }
+}
+
+static bool expect_reply(uint8_t op, uint32_t value) {
+    bool ok = s_n_replies == 1 && s_replies[0].op == op &&
+              (op == LINK_BAUD_OP_ACCEPT || op == LINK_BAUD_OP_PATTERN ||
+               s_replies[0].value == value);
+    if (!ok) {
+        printf("# expected op %u, got %u replies, first op %u value %u\n", op,
+               s_n_replies, s_n_replies > 0 ? s_replies[0].op : 0,
+               s_n_replies > 0 ? s_replies[0].value : 0);
+    }
+    s_n_replies = 0;
+    return ok;
+}
+
+static bool negotiate(uint32_t baud) {
+    host_send(LINK_BAUD_OP_PROPOSE, baud, false);
+    if (!expect_reply(LINK_BAUD_OP_ACCEPT, 0)) {
+        return false;
+    }
+    run_ms(1);
+    if (s_baud != baud) {
+        return false;
+    }
+    host_send(LINK_BAUD_OP_PATTERN, 0, false);
+    if (!expect_reply(LINK_BAUD_OP_PATTERN, 0)) {
+        return false;
+    }
+    host_send(LINK_BAUD_OP_COMMIT, 0, false);
+    return expect_reply(LINK_BAUD_OP_LOCKED, baud) && !link_baud_busy();
+}
+
+static size_t link_write(const void *data, size_t n, uintptr_t context) {
+    (void)context;
+    frame_proto_decode(&s_dec, data, n);
+    return n;
+}
+
+static void on_reply(const frame_proto_msg_t *msg, uintptr_t context) {
+    (void)context;
+    if (msg->type != FRAME_PROTO_TYPE_LINK || msg->length < 1 ||
+        s_n_replies == MAX_REPLIES) {
+        return;
+    }
+    reply_t *r = &s_replies[s_n_replies++];
+    r->op = msg->payload[0];
+    r->length = msg->length;
+    r->value = 0;
+    if (msg->length >= 5) {
+        r->value = (uint32_t)msg->payload[1] | (msg->payload[2] << 8) |
+                   (msg->payload[3] << 16) | ((uint32_t)msg->payload[4] << 24);
+    }
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,237 @@
+/**
+ * @file motion_detect_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of block-based motion detection
+ * (firmware/src/motion_detect.c).
+ *
+ * Feeds synthetic 96 x 96 Y planes (a textured scene with +/-2 sensor
+ * noise) and checks that:
+ * - sizes that aren't a multiple of the block size are rejected
+ * - the first frame is reported as motion, with every block set
+ * - noise and slow lighting drift are not motion
+ * - a single changed block is marked but doesn't flag the frame
+ * - an object marks the blocks it covers and no others, wherever it is
+ * - an object that stops is absorbed into the background
+ * - the result doesn't depend on the alignment of the Y plane
+ * The CMSIS intrinsics are the portable C versions in host/definitions.h.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -Ihost -I../firmware/src -o motion_detect_test \
+ *       motion_detect_test.c ../firmware/src/motion_detect.c
+ *   ./motion_detect_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "host/check.h"
+#include "motion_detect.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define IMAGE_WIDTH 96
+#define IMAGE_HEIGHT 96
+#define N_PIXELS (IMAGE_WIDTH * IMAGE_HEIGHT)
+#define OBJECT_SIZE 12
+#define OBJECT_Y 240
+#define NOISE 2
+
+// Pixels of a block the object must cover to mark it for certain
+#define MIN_COVER 8
+
+// Frames a stopped object may take to fade into the background
+#define SETTLE_FRAMES 32
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Render the scene, offset by brightness, with noise and optionally
+ * an OBJECT_SIZE square at (x, y).
+ */
+static void make_frame(uint8_t *y_plane, int brightness, bool object, int x,
+                       int y);
+
+/**
+ * @brief Return true if the blocks an OBJECT_SIZE square at (x, y) covers
+ * by at least MIN_COVER pixels are marked and those it misses are not, and
+ * print the first difference otherwise.  A sliver of the object may or may
+ * not be enough to mark a block.
+ */
+static bool check_blocks(const motion_detect_t *md, int x, int y);
+
+/**
+ * @brief Return how many of the MOTION_DETECT_BLOCK_SIZE pixels from
+ * block_start an OBJECT_SIZE span from start covers, along one axis.
+ */
+static int overlap(int start, int block_start);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_frame[N_PIXELS];
+static uint8_t s_shifted[N_PIXELS + 1];
+static uint8_t s_background[N_PIXELS];
+static uint8_t s_background_shifted[N_PIXELS];
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    motion_detect_config_t config;
+    motion_detect_t md;
+
+    motion_detect_default_config(&config, IMAGE_WIDTH, IMAGE_HEIGHT);
+    motion_detect_config_t bad = config;
+    bad.width = IMAGE_WIDTH - 4;
+    check(!motion_detect_init(&md, &bad, s_background), "odd width accepted");
+    bad = config;
+    bad.height = MOTION_DETECT_MAX_HEIGHT + MOTION_DETECT_BLOCK_SIZE;
+    check(!motion_detect_init(&md, &bad, s_background), "tall image accepted");
+    check(motion_detect_init(&md, &config, s_background), "init failed");
+    srand(1);
+
+    make_frame(s_frame, 0, false, 0, 0);
+    check(motion_detect_update(&md, s_frame), "first frame not motion");
+    check(md.moving_blocks == md.blocks_x * md.blocks_y,
+          "first frame doesn't set every block");
+
+    // noise alone, then lighting drifting faster than the noise
+    bool moved = false;
+    for (int n = 0; n < 64; n++) {
+        make_frame(s_frame, n / 4, false, 0, 0);
+        moved |= motion_detect_update(&md, s_frame);
+        moved |= md.moving_blocks != 0;
+    }
+    check(!moved, "noise or drift reported as motion");
+
+    // one changed block is marked, but fewer than min_blocks
+    make_frame(s_frame, 16, false, 0, 0);
+    for (int y = 8; y < 16; y++) {
+        memset(&s_frame[y * IMAGE_WIDTH + 24], OBJECT_Y, 8);
+    }
+    check(!motion_detect_update(&md, s_frame), "single block flags the frame");
+    check(md.moving_blocks == 1 && motion_detect_block_moved(&md, 3, 1),
+          "single block not marked");
+
+    // an object appearing in front of a fresh background, at every alignment
+    for (int n = 0; n <= IMAGE_WIDTH - OBJECT_SIZE; n++) {
+        motion_detect_init(&md, &config, s_background);
+        make_frame(s_frame, 16, false, 0, 0);
+        motion_detect_update(&md, s_frame);
+        int x = n;
+        int y = (n * 7) % (IMAGE_HEIGHT - OBJECT_SIZE + 1);
+        make_frame(s_frame, 16, true, x, y);
+        bool motion = motion_detect_update(&md, s_frame);
+        if (!motion || !check_blocks(&md, x, y)) {
+            printf("# object at (%d, %d): motion %d, %d blocks\n", x, y,
+                   motion, md.moving_blocks);
+            check(false, "object blocks");
+            break;
+        }
+    }
+
+    // the object stops: it fades into the background
+    int settled = -1;
+    for (int n = 0; n < SETTLE_FRAMES && settled < 0; n++) {
+        make_frame(s_frame, 16, true, 40, 40);
+        if (!motion_detect_update(&md, s_frame)) {
+            settled = n;
+        }
+    }
+    printf("# stopped object absorbed after %d frames\n", settled);
+    check(settled > 0, "stopped object never absorbed");
+
+    // a Y plane that isn't word aligned gives the same result
+    motion_detect_t shifted;
+    motion_detect_init(&md, &config, s_background);
+    motion_detect_init(&shifted, &config, s_background_shifted);
+    bool same = true;
+    for (int n = 0; n < 16; n++) {
+        make_frame(s_frame, 0, n > 4, n * 5, 30);
+        memcpy(&s_shifted[1], s_frame, N_PIXELS);
+        same &= motion_detect_update(&md, s_frame) ==
+                motion_detect_update(&shifted, &s_shifted[1]);
+        same &= memcmp(md.bitmap, shifted.bitmap, sizeof(md.bitmap)) == 0;
+    }
+    same &= memcmp(s_background, s_background_shifted, N_PIXELS) == 0;
+    check(same, "alignment changes the result");
+
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void make_frame(uint8_t *y_plane, int brightness, bool object, int x,
+                       int y) {
+    for (int row = 0; row < IMAGE_HEIGHT; row++) {
+        for (int col = 0; col < IMAGE_WIDTH; col++) {
+            int v = 64 + ((row ^ col) & 63) + brightness +
+                    rand() % (2 * NOISE + 1) - NOISE;
+            if (object && col >= x && col < x + OBJECT_SIZE && row >= y &&
+                row < y + OBJECT_SIZE) {
+                v = OBJECT_Y;
+            }
+            y_plane[row * IMAGE_WIDTH + col] = v;
+        }
+    }
+}
+
+static bool check_blocks(const motion_detect_t *md, int x, int y) {
+    for (int by = 0; by < md->blocks_y; by++) {
+        for (int bx = 0; bx < md->blocks_x; bx++) {
+            int cover = overlap(x, bx * MOTION_DETECT_BLOCK_SIZE) *
+                        overlap(y, by * MOTION_DETECT_BLOCK_SIZE);
+            bool moved = motion_detect_block_moved(md, bx, by);
+            if ((cover >= MIN_COVER && !moved) || (cover == 0 && moved)) {
+                printf("# block (%d, %d): %d pixels covered, moved %d\n", bx,
+                       by, cover, moved);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static int overlap(int start, int block_start) {
+    int lo = start > block_start ? start : block_start;
+    int end = start + OBJECT_SIZE;
+    int block_end = block_start + MOTION_DETECT_BLOCK_SIZE;
+    int hi = end < block_end ? end : block_end;
+    return hi > lo ? hi - lo : 0;
+}
+
+// *****************************************************************************
+// End of file
@@ -3,6 +3,8 @@ import serial
 import tkinter
 import sys  # Import the sys module
 
+import link_baud
+
 IMG_W = 96
 IMG_H = 96
 FILENAME = "yuv_test.txt"
@@ -13,7 +15,15 @@ CAN_H = IMG_H * SCALE
 class App(tkinter.Frame):  # Inherit from tkinter.Frame
     def __init__(self, args, t):
         super().__init__(t)  # Initialize tkinter.Frame
-        self._ser = serial.Serial(args.serial_port, args.baud, timeout=0.1)
+        self._link = None
+        if args.negotiate:
+            # run as fast as the adapter allows (see link_baud.py)
+            self._link = link_baud.Link(args.serial_port, args.baud)
+            self._link.negotiate()
+            self._ser = self._link.ser
+            self._ser.timeout = 0.1
+        else:
+            self._ser = serial.Serial(args.serial_port, args.baud, timeout=0.1)
         self._row = 0
         self._col = 0
 
@@ -27,8 +37,10 @@ class App(tkinter.Frame):  # Inherit from tkinter.Frame
 
     def read_loop(self):
         while True:
+            if self._link is not None:
+                self._link.keepalive()
             line = self._ser.read_until(size=1024)
-            line = line.decode('utf-8')
+            line = line.decode('utf-8', errors='replace')
             if len(line) == 0:
                 break
             elif line.startswith("#"):
@@ -87,7 +99,8 @@ class App(tkinter.Frame):  # Inherit from tkinter.Frame
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description="display captured images.")
-    parser.add_argument('--baud', type=int, default=460800, help="Baud rate of serial port. Defaults to 460800.")
+    parser.add_argument('--baud', type=int, default=link_baud.BASE_BAUD, help="Baud rate of serial port. Defaults to the firmware's %d." % link_baud.BASE_BAUD)
+    parser.add_argument('--negotiate', action='store_true', help="Negotiate the fastest rate the adapter supports, starting from --baud.")
     parser.add_argument('serial_port', help="Serial port to connect to, e.g. 'COM1' or '/dev/usb3'.")
     args = parser.parse_args()
 
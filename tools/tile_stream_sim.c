@@ -0,0 +1,329 @@
+/**
+ * @file tile_stream_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host simulation of tile change streaming
+ * (firmware/src/tile_stream.c).
+ *
+ * Builds a surveillance-style sequence from a 96 x 96 YUYV frame in the
+ * firmware's hex text format (e.g. yuv_test.txt): a static scene with +/-1
+ * sensor noise on every sample and a small object crossing it.  Each frame
+ * is encoded as a tile update, applied to a receiver frame as the host
+ * would, and the receiver's frame is checked against the original.  Reports
+ * link bytes per frame against sending full frames.
+ *
+ * Then gates the tiles by motion as app.c does in APP_FORMAT_TILES: only
+ * tiles over blocks motion_detect marked are compared, and an update is sent
+ * only if it has tiles or is a key frame.  An object that moves within one
+ * block is too small to flag the frame as motion, but its tile must still
+ * reach the receiver, whose frame is checked against the encoder's reference
+ * after every frame.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -Ihost -I../firmware/src -o tile_stream_sim tile_stream_sim.c \
+ *       ../firmware/src/tile_stream.c ../firmware/src/motion_detect.c
+ *   ./tile_stream_sim yuv_test.txt
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "motion_detect.h"
+#include "tile_stream.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define IMAGE_WIDTH 96
+#define IMAGE_HEIGHT 96
+#define FRAME_SIZE (IMAGE_WIDTH * IMAGE_HEIGHT * 2)
+#define N_FRAMES 256
+#define OBJECT_SIZE 12
+
+// An object small enough to stay within block (BLOCK_X, BLOCK_Y)
+#define BLOCK_X 5
+#define BLOCK_Y 5
+#define SMALL_OBJECT_SIZE 6
+#define GATED_FRAMES 32
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Read whitespace separated hex bytes.  Returns the number read.
+ */
+static size_t load_hex(const char *filename, uint8_t *buf, size_t size);
+
+/**
+ * @brief Render frame n of the sequence into frame, or for n < 0 the scene
+ * alone.
+ */
+static void make_frame(uint8_t *frame, int n);
+
+/**
+ * @brief Return the largest mean absolute difference of any tile.
+ */
+static uint32_t worst_tile_error(const uint8_t *a, const uint8_t *b,
+                                 uint8_t tile_size);
+
+/**
+ * @brief Stream a small object moving within one motion block, with the
+ * tiles gated by motion.  Returns false if an update was lost.
+ */
+static bool run_one_moving_block(void);
+
+/**
+ * @brief Mark in s_candidates the tiles of ts that overlap a block md
+ * marked as moving, as moving_tiles() in app.c.
+ */
+static void mark_candidates(const tile_stream_t *ts,
+                            const motion_detect_t *md);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_scene[FRAME_SIZE];
+static uint8_t s_frame[FRAME_SIZE];
+static uint8_t s_reference[FRAME_SIZE];
+static uint8_t s_received[FRAME_SIZE];
+static uint8_t s_update[TILE_STREAM_MAX_OUTPUT(IMAGE_WIDTH, IMAGE_HEIGHT, 4)];
+static uint8_t s_luma[IMAGE_WIDTH * IMAGE_HEIGHT];
+static uint8_t s_background[IMAGE_WIDTH * IMAGE_HEIGHT];
+static uint8_t s_candidates[TILE_STREAM_MAX_TILES];
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+    const char *filename = argc > 1 ? argv[1] : "yuv_test.txt";
+    tile_stream_config_t config;
+    tile_stream_t ts;
+
+    if (load_hex(filename, s_scene, FRAME_SIZE) != FRAME_SIZE) {
+        fprintf(stderr, "%s: expected %d bytes\n", filename, FRAME_SIZE);
+        return 1;
+    }
+
+    printf("%4s %9s %10s %12s %7s %9s\n", "tile", "threshold", "bytes/frame",
+           "tiles/frame", "ratio", "max error");
+    static const uint8_t tile_sizes[] = {8, 16, 32};
+    for (size_t t = 0; t < sizeof(tile_sizes); t++) {
+        tile_stream_default_config(&config, IMAGE_WIDTH, IMAGE_HEIGHT);
+        config.tile_size = tile_sizes[t];
+        if (!tile_stream_init(&ts, &config, s_reference)) {
+            fprintf(stderr, "bad config\n");
+            return 1;
+        }
+        memset(s_received, 0, sizeof(s_received));
+        srand(1);
+
+        uint64_t bytes = 0;
+        uint64_t tiles = 0;
+        uint32_t max_error = 0;
+        for (int n = 0; n < N_FRAMES; n++) {
+            make_frame(s_frame, n);
+            size_t len =
+                tile_stream_encode(&ts, s_frame, s_update, sizeof(s_update));
+            if (len == 0 ||
+                !tile_stream_apply(s_update, len, s_received,
+                                   sizeof(s_received))) {
+                fprintf(stderr, "frame %d: encode / apply failed\n", n);
+                return 1;
+            }
+            bytes += len;
+            tiles += ts.last_tiles;
+            uint32_t error =
+                worst_tile_error(s_frame, s_received, config.tile_size);
+            max_error = error > max_error ? error : max_error;
+        }
+        printf("%4d %9d %10llu %12.1f %6.1fx %9d\n", config.tile_size,
+               config.threshold, (unsigned long long)(bytes / N_FRAMES),
+               (double)tiles / N_FRAMES,
+               (double)FRAME_SIZE * N_FRAMES / bytes, max_error);
+        if (max_error > config.threshold) {
+            fprintf(stderr, "receiver drifted beyond the threshold\n");
+            return 1;
+        }
+    }
+    return run_one_moving_block() ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t load_hex(const char *filename, uint8_t *buf, size_t size) {
+    FILE *f = fopen(filename, "r");
+    unsigned int byte;
+    size_t n = 0;
+
+    if (f == NULL) {
+        perror(filename);
+        return 0;
+    }
+    while (n < size && fscanf(f, "%x", &byte) == 1) {
+        buf[n++] = byte;
+    }
+    fclose(f);
+    return n;
+}
+
+static void make_frame(uint8_t *frame, int n) {
+    // sensor noise
+    for (size_t i = 0; i < FRAME_SIZE; i++) {
+        int v = s_scene[i] + (rand() % 3) - 1;
+        frame[i] = v < 0 ? 0 : v > 255 ? 255 : v;
+    }
+    if (n < 0) {
+        return;
+    }
+    // a dark object crossing the scene diagonally, one pixel per frame
+    int x0 = n % (IMAGE_WIDTH - OBJECT_SIZE);
+    int y0 = (n / 2) % (IMAGE_HEIGHT - OBJECT_SIZE);
+    for (int y = y0; y < y0 + OBJECT_SIZE; y++) {
+        for (int x = x0; x < x0 + OBJECT_SIZE; x++) {
+            frame[(y * IMAGE_WIDTH + x) * 2] = 16;
+        }
+    }
+}
+
+static uint32_t worst_tile_error(const uint8_t *a, const uint8_t *b,
+                                 uint8_t tile_size) {
+    size_t stride = IMAGE_WIDTH * 2;
+    size_t row_bytes = tile_size * 2;
+    uint32_t worst = 0;
+
+    for (int ty = 0; ty < IMAGE_HEIGHT / tile_size; ty++) {
+        for (int tx = 0; tx < IMAGE_WIDTH / tile_size; tx++) {
+            uint32_t sad = 0;
+            for (int y = 0; y < tile_size; y++) {
+                size_t offset = (ty * tile_size + y) * stride + tx * row_bytes;
+                for (size_t x = 0; x < row_bytes; x++) {
+                    sad += abs((int)a[offset + x] - (int)b[offset + x]);
+                }
+            }
+            uint32_t mean = sad / (row_bytes * tile_size);
+            worst = mean > worst ? mean : worst;
+        }
+    }
+    return worst;
+}
+
+static bool run_one_moving_block(void) {
+    tile_stream_config_t config;
+    tile_stream_t ts;
+    motion_detect_config_t md_config;
+    motion_detect_t md;
+
+    tile_stream_default_config(&config, IMAGE_WIDTH, IMAGE_HEIGHT);
+    motion_detect_default_config(&md_config, IMAGE_WIDTH, IMAGE_HEIGHT);
+    if (!tile_stream_init(&ts, &config, s_reference) ||
+        !motion_detect_init(&md, &md_config, s_background)) {
+        fprintf(stderr, "bad config\n");
+        return false;
+    }
+    memset(s_received, 0, sizeof(s_received));
+    srand(1);
+
+    int sent = 0;
+    int unflagged = 0;
+    for (int n = 0; n < GATED_FRAMES; n++) {
+        make_frame(s_frame, -1);
+        if (n >= 4 && n % 2 == 1) {
+            // after a still start, the object blinks on and off
+            int x0 = BLOCK_X * MOTION_DETECT_BLOCK_SIZE + 1;
+            int y0 = BLOCK_Y * MOTION_DETECT_BLOCK_SIZE + 1;
+            for (int y = y0; y < y0 + SMALL_OBJECT_SIZE; y++) {
+                for (int x = x0; x < x0 + SMALL_OBJECT_SIZE; x++) {
+                    s_frame[(y * IMAGE_WIDTH + x) * 2] = 16;
+                }
+            }
+        }
+        for (size_t i = 0; i < sizeof(s_luma); i++) {
+            s_luma[i] = s_frame[i * 2];
+        }
+        bool motion = motion_detect_update(&md, s_luma);
+        mark_candidates(&ts, &md);
+        size_t len = tile_stream_encode_candidates(&ts, s_frame, s_candidates,
+                                                   s_update, sizeof(s_update));
+        bool key = (s_update[2] & TILE_STREAM_FLAG_KEY) != 0;
+        if (n >= 4 && !motion && ts.last_tiles > 0) {
+            unflagged++;
+        }
+        // sent as app.c streams it
+        if (ts.last_tiles > 0 || key) {
+            sent++;
+            if (!tile_stream_apply(s_update, len, s_received,
+                                   sizeof(s_received))) {
+                fprintf(stderr, "frame %d: apply failed\n", n);
+                return false;
+            }
+        }
+        if (memcmp(s_received, s_reference, FRAME_SIZE) != 0) {
+            fprintf(stderr,
+                    "frame %d: receiver differs from the encoder's "
+                    "reference\n",
+                    n);
+            return false;
+        }
+    }
+    printf("one moving block: %d of %d frames sent, %d with tiles but no "
+           "motion\n",
+           sent, GATED_FRAMES, unflagged);
+    if (unflagged == 0) {
+        fprintf(stderr, "no tiles changed without motion\n");
+        return false;
+    }
+    return true;
+}
+
+static void mark_candidates(const tile_stream_t *ts,
+                            const motion_detect_t *md) {
+    uint16_t size = ts->config.tile_size;
+    uint16_t block = MOTION_DETECT_BLOCK_SIZE;
+    uint8_t *tile = s_candidates;
+    for (uint16_t ty = 0; ty < ts->tiles_y; ty++) {
+        for (uint16_t tx = 0; tx < ts->tiles_x; tx++) {
+            bool moved = false;
+            for (uint16_t by = ty * size / block;
+                 by <= ((ty + 1) * size - 1) / block && !moved; by++) {
+                for (uint16_t bx = tx * size / block;
+                     bx <= ((tx + 1) * size - 1) / block && !moved; bx++) {
+                    moved = motion_detect_block_moved(md, bx, by);
+                }
+            }
+            *tile++ = moved;
+        }
+    }
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,458 @@
+/**
+ * @file twihs_isr_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host count of the TWIHS0 interrupts taken by
+ * cam_ctrl_task_setup_camera(), with the format table sent as register
+ * pairs (TWIHS0_WritePairs) and, for comparison, as one two-byte write per
+ * register, as ov2640_i2c_write_pairs() did before.
+ *
+ * Runs cam_ctrl_task.c, ov2640_i2c.c, the Harmony I2C driver and the TWIHS0
+ * PLIB itself (plib_twihs0_master.c) against a register-level model of the
+ * TWIHS0 master and the OV2640 behind it (see host/device.h).  The model
+ * moves one byte per step, and steps whenever the firmware re-enables
+ * interrupts or the main loop goes round, so the CPU is always much faster
+ * than the bus, as at 400 kHz.  TWIHS0_InterruptHandler runs while an
+ * enabled status bit is set, and each call is counted.  Only writes are
+ * modelled: setup_camera makes no reads.
+ *
+ * Checks that:
+ * - setup_camera completes and the sensor receives the bank select, the
+ *   reset and then every register of the format table, in order;
+ * - each table register costs one interrupt as a pair (TXCOMP), and two as a
+ *   two-byte write (TXRDY, then TXCOMP);
+ * - both ways leave the sensor registers the same.
+ *
+ * Build and run from this directory:
+ *   cc -O1 -g -fsanitize=address,undefined -DHOST_DRV_I2C -DHOST_TWIHS0 \
+ *       -DHOST_INT_HOOK -DHOST_SIM_TIME -Ihost -I../firmware/src \
+ *       -I../firmware/src/config/default -o twihs_isr_sim twihs_isr_sim.c \
+ *       ../firmware/src/cam_ctrl_task.c ../firmware/src/ov2640_i2c.c \
+ *       ../firmware/src/config/default/driver/i2c/src/drv_i2c.c \
+ *       ../firmware/src/config/default/peripheral/twihs/master/plib_twihs0_master.c
+ *   ./twihs_isr_sim
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "cam_ctrl_task.h"
+#include "definitions.h"
+#include "host/check.h"
+#include "interrupts.h"
+#include "ov2640_i2c.h"
+#include "peripheral/twihs/master/plib_twihs0_master.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define OV2640_ADDR (0x60 >> 1)
+#define BANK_SELECT 0xff
+#define COM7 0x12
+
+// Most register writes the sensor log holds
+#define MAX_WRITES 512
+
+// Bus steps before a run is declared hung
+#define MAX_STEPS 1000000
+
+// Interrupts in a row before the handler is declared stuck
+#define MAX_IRQ_BURST 16
+
+// No byte written to TWIHS_THR since the model last looked
+#define THR_EMPTY 0xffffffffu
+
+#define IDLE_SR                                                                \
+    (TWIHS_SR_TXCOMP_Msk | TWIHS_SR_TXRDY_Msk | TWIHS_SR_SDA_Msk |             \
+     TWIHS_SR_SCL_Msk)
+
+/**
+ * @brief A register write as the sensor received it.
+ */
+typedef struct {
+    uint8_t addr;
+    uint8_t value;
+} sensor_write_t;
+
+/**
+ * @brief The TWIHS0 master: what the registers do not show.
+ */
+typedef struct {
+    bool enabled;      // master mode
+    bool active;       // between START and STOP
+    bool thr_full;     // a byte waits in TWIHS_THR
+    uint8_t thr;
+    bool shifting;     // a byte is in the shifter
+    uint8_t shifter;
+    bool stop;         // STOP requested
+    uint8_t bytes[2];  // the internal address and data bytes sent
+    uint32_t n_bytes;
+    uint32_t steps;
+    uint32_t errors;   // anything a write from this firmware should not do
+} twihs_model_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+// PLIB calls with the driver's argument types
+static bool plib_read(uint16_t address, uint8_t *data, uint32_t length);
+static bool plib_write(uint16_t address, uint8_t *data, uint32_t length);
+static bool plib_write_read(uint16_t address, uint8_t *wdata,
+                            uint32_t wlength, uint8_t *rdata,
+                            uint32_t rlength);
+static bool plib_write_pairs(uint16_t address, uint8_t *pairs,
+                             uint32_t count);
+static DRV_I2C_ERROR plib_error_get(void);
+static bool plib_transfer_setup(DRV_I2C_TRANSFER_SETUP *setup,
+                                uint32_t src_clk_freq);
+static void plib_callback_register(DRV_I2C_PLIB_CALLBACK callback,
+                                   uintptr_t context);
+
+/**
+ * @brief Act on the register writes made since the last call.
+ */
+static void twihs_commit(void);
+
+/**
+ * @brief A byte was written to TWIHS_THR.
+ */
+static void twihs_thr_written(uint8_t byte);
+
+/**
+ * @brief Move the bus on by one byte.
+ */
+static void twihs_step(void);
+
+/**
+ * @brief Run TWIHS0_InterruptHandler while an enabled status bit is set.
+ */
+static void twihs_service(void);
+
+/**
+ * @brief Reset the sensor model and the counts.
+ */
+static void reset_counts(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const DRV_I2C_PLIB_INTERFACE s_plib = {
+    .read_t = plib_read,
+    .write_t = plib_write,
+    .writeRead = plib_write_read,
+    .writePairs = plib_write_pairs,
+    .transferAbort = TWIHS0_TransferAbort,
+    .errorGet = plib_error_get,
+    .transferSetup = plib_transfer_setup,
+    .callbackRegister = plib_callback_register,
+};
+
+static DRV_I2C_CLIENT_OBJ s_client_pool[DRV_I2C_CLIENTS_NUMBER_IDX0];
+static DRV_I2C_TRANSFER_OBJ s_transfer_pool[DRV_I2C_QUEUE_SIZE_IDX0];
+
+static const DRV_I2C_INIT s_init = {
+    .i2cPlib = &s_plib,
+    .numClients = DRV_I2C_CLIENTS_NUMBER_IDX0,
+    .clientObjPool = (uintptr_t)&s_client_pool[0],
+    .transferObjPool = (uintptr_t)&s_transfer_pool[0],
+    .transferObjPoolSize = DRV_I2C_QUEUE_SIZE_IDX0,
+    .clockSpeed = DRV_I2C_CLOCK_SPEED_IDX0,
+};
+
+static twihs_registers_t s_regs;
+static twihs_model_t s_twihs;
+static bool s_in_isr;
+static uint32_t s_isr_count;
+
+// The sensor: its register banks and every write it received
+static uint8_t s_sensor[2][256];
+static uint8_t s_bank;
+static sensor_write_t s_writes[MAX_WRITES];
+static uint32_t s_n_writes;
+
+// *****************************************************************************
+// Public data
+
+bool host_int_enabled = true;
+uint32_t host_sim_time;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    s_regs.TWIHS_SR = IDLE_SR;
+    s_regs.TWIHS_THR = THR_EMPTY;
+    TWIHS0_Initialize();
+
+    SYS_MODULE_OBJ obj = DRV_I2C_Initialize(DRV_I2C_INDEX_0,
+                                            (SYS_MODULE_INIT *)&s_init);
+    check(obj != SYS_MODULE_OBJ_INVALID, "driver initialized");
+    DRV_HANDLE i2c = DRV_I2C_Open(DRV_I2C_INDEX_0, DRV_IO_INTENT_READWRITE);
+    check(i2c != DRV_HANDLE_INVALID, "driver opened");
+    ov2640_i2c_init(i2c);
+    cam_ctrl_task_init();
+
+    // the format load as register pairs
+    reset_counts();
+    cam_ctrl_task_setup_camera();
+    while (!cam_ctrl_task_succeeded() && !cam_ctrl_task_had_error() &&
+           s_twihs.steps < MAX_STEPS) {
+        cam_ctrl_task_step();
+        host_sim_time++;
+        host_int_hook();
+    }
+    check(cam_ctrl_task_succeeded(), "setup_camera completed");
+    check(s_twihs.errors == 0, "only register writes on the bus");
+    check(s_n_writes > 2 && s_writes[0].addr == BANK_SELECT &&
+              s_writes[0].value == 1 && s_writes[1].addr == COM7 &&
+              s_writes[1].value == 0x80,
+          "bank select and reset, then the table");
+
+    uint32_t table = s_n_writes - 2;
+    uint32_t pairs_isrs = s_isr_count;
+    sensor_write_t sent[MAX_WRITES];
+    uint8_t pairs_regs[2][256];
+    memcpy(sent, s_writes, sizeof(sent));
+    memcpy(pairs_regs, s_sensor, sizeof(pairs_regs));
+    // two for each two-byte write, one for each pair
+    check(pairs_isrs == 2 * 2 + table, "one interrupt per register pair");
+
+    // the same writes, the table one register per transfer, as
+    // ov2640_i2c_write_byte() sends them (less its trace)
+    reset_counts();
+    for (uint32_t i = 0; i < table + 2; i++) {
+        uint8_t buf[2] = {sent[i].addr, sent[i].value};
+        if (!DRV_I2C_WriteTransfer(i2c, OV2640_ADDR, buf, sizeof(buf))) {
+            break;
+        }
+    }
+    uint32_t single_isrs = s_isr_count;
+    check(s_twihs.errors == 0 && s_n_writes == table + 2 &&
+              memcmp(s_writes, sent, s_n_writes * sizeof(s_writes[0])) == 0,
+          "per-register writes reach the sensor in order");
+    check(memcmp(s_sensor, pairs_regs, sizeof(pairs_regs)) == 0,
+          "both leave the sensor registers the same");
+    check(single_isrs == 2 * (table + 2), "two interrupts per register write");
+
+    printf("setup_camera: %u register writes, %u in the format table\n",
+           (unsigned)(table + 2), (unsigned)table);
+    printf("TWIHS0 interrupts, table as register pairs: %u\n",
+           (unsigned)pairs_isrs);
+    printf("TWIHS0 interrupts, table as two-byte writes: %u\n",
+           (unsigned)single_isrs);
+    return check_result();
+}
+
+twihs_registers_t *host_twihs0_regs(void) {
+    twihs_commit();
+    return &s_regs;
+}
+
+void host_int_hook(void) {
+    if (s_in_isr) {
+        return;
+    }
+    twihs_service();
+    twihs_step();
+    twihs_service();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool plib_read(uint16_t address, uint8_t *data, uint32_t length) {
+    return TWIHS0_Read(address, data, length);
+}
+
+static bool plib_write(uint16_t address, uint8_t *data, uint32_t length) {
+    return TWIHS0_Write(address, data, length);
+}
+
+static bool plib_write_read(uint16_t address, uint8_t *wdata,
+                            uint32_t wlength, uint8_t *rdata,
+                            uint32_t rlength) {
+    return TWIHS0_WriteRead(address, wdata, wlength, rdata, rlength);
+}
+
+static bool plib_write_pairs(uint16_t address, uint8_t *pairs,
+                             uint32_t count) {
+    return TWIHS0_WritePairs(address, pairs, count);
+}
+
+static DRV_I2C_ERROR plib_error_get(void) {
+    return (DRV_I2C_ERROR)TWIHS0_ErrorGet();
+}
+
+static bool plib_transfer_setup(DRV_I2C_TRANSFER_SETUP *setup,
+                                uint32_t src_clk_freq) {
+    return TWIHS0_TransferSetup((TWIHS_TRANSFER_SETUP *)setup, src_clk_freq);
+}
+
+static void plib_callback_register(DRV_I2C_PLIB_CALLBACK callback,
+                                   uintptr_t context) {
+    TWIHS0_CallbackRegister(callback, context);
+}
+
+static void twihs_commit(void) {
+    if (s_regs.TWIHS_IER != 0) {
+        s_regs.TWIHS_IMR |= s_regs.TWIHS_IER;
+        s_regs.TWIHS_IER = 0;
+    }
+    if (s_regs.TWIHS_IDR != 0) {
+        s_regs.TWIHS_IMR &= ~s_regs.TWIHS_IDR;
+        s_regs.TWIHS_IDR = 0;
+    }
+    if (s_regs.TWIHS_THR != THR_EMPTY) {
+        uint8_t byte = (uint8_t)s_regs.TWIHS_THR;
+        s_regs.TWIHS_THR = THR_EMPTY;
+        twihs_thr_written(byte);
+    }
+
+    uint32_t cr = s_regs.TWIHS_CR;
+    s_regs.TWIHS_CR = 0;
+    if (cr & TWIHS_CR_SWRST_Msk) {
+        memset(&s_twihs, 0, offsetof(twihs_model_t, steps));
+        s_regs.TWIHS_IMR = 0;
+        s_regs.TWIHS_SR = IDLE_SR;
+    }
+    if (cr & TWIHS_CR_MSDIS_Msk) {
+        s_twihs.enabled = false;
+    }
+    if (cr & TWIHS_CR_MSEN_Msk) {
+        s_twihs.enabled = true;
+    }
+    if (cr & TWIHS_CR_THRCLR_Msk) {
+        s_twihs.thr_full = false;
+    }
+    if (cr & TWIHS_CR_START_Msk) {
+        // a read, or a repeated start
+        s_twihs.errors++;
+    }
+    if (cr & TWIHS_CR_STOP_Msk) {
+        s_twihs.stop = true;
+    }
+}
+
+static void twihs_thr_written(uint8_t byte) {
+    if (!s_twihs.enabled || s_twihs.thr_full ||
+        (s_regs.TWIHS_MMR & TWIHS_MMR_MREAD_Msk)) {
+        s_twihs.errors++;
+        return;
+    }
+    if (!s_twihs.active) {
+        // START and the device address, then any internal address
+        s_twihs.active = true;
+        s_twihs.n_bytes = 0;
+        if ((s_regs.TWIHS_MMR & TWIHS_MMR_IADRSZ_Msk) == TWIHS_MMR_IADRSZ(1)) {
+            s_twihs.bytes[s_twihs.n_bytes++] = (uint8_t)s_regs.TWIHS_IADR;
+        }
+        s_regs.TWIHS_SR &= ~TWIHS_SR_TXCOMP_Msk;
+    }
+    s_twihs.thr = byte;
+    s_twihs.thr_full = true;
+    s_regs.TWIHS_SR &= ~TWIHS_SR_TXRDY_Msk;
+}
+
+static void twihs_step(void) {
+    twihs_commit();
+    s_twihs.steps++;
+    if (!s_twihs.active) {
+        return;
+    }
+    if (s_twihs.shifting) {
+        // the sensor ACKs every byte
+        if (s_twihs.n_bytes < sizeof(s_twihs.bytes)) {
+            s_twihs.bytes[s_twihs.n_bytes] = s_twihs.shifter;
+        }
+        s_twihs.n_bytes++;
+        s_twihs.shifting = false;
+    }
+    if (s_twihs.thr_full) {
+        s_twihs.shifter = s_twihs.thr;
+        s_twihs.shifting = true;
+        s_twihs.thr_full = false;
+        s_regs.TWIHS_SR |= TWIHS_SR_TXRDY_Msk;
+    } else if (s_twihs.stop) {
+        // STOP: the sensor latches a register write
+        uint32_t dadr = (s_regs.TWIHS_MMR & TWIHS_MMR_DADR_Msk) >>
+                        TWIHS_MMR_DADR_Pos;
+        if (dadr != OV2640_ADDR || s_twihs.n_bytes != 2 ||
+            s_n_writes == MAX_WRITES) {
+            s_twihs.errors++;
+        } else {
+            uint8_t addr = s_twihs.bytes[0];
+            uint8_t value = s_twihs.bytes[1];
+            s_writes[s_n_writes].addr = addr;
+            s_writes[s_n_writes].value = value;
+            s_n_writes++;
+            if (addr == BANK_SELECT) {
+                s_bank = value & 1;
+            }
+            s_sensor[s_bank][addr] = value;
+        }
+        s_twihs.active = false;
+        s_twihs.stop = false;
+        s_regs.TWIHS_SR |= TWIHS_SR_TXCOMP_Msk | TWIHS_SR_TXRDY_Msk;
+    }
+}
+
+static void twihs_service(void) {
+    if (!host_int_enabled) {
+        return;
+    }
+    twihs_commit();
+    for (int burst = 0; (s_regs.TWIHS_SR & s_regs.TWIHS_IMR) != 0; burst++) {
+        if (burst == MAX_IRQ_BURST) {
+            s_twihs.errors++;
+            return;
+        }
+        s_in_isr = true;
+        host_int_enabled = false;
+        s_isr_count++;
+        TWIHS0_InterruptHandler();
+        host_int_enabled = true;
+        s_in_isr = false;
+        twihs_commit();
+    }
+}
+
+static void reset_counts(void) {
+    memset(s_sensor, 0, sizeof(s_sensor));
+    s_bank = 0;
+    s_n_writes = 0;
+    s_isr_count = 0;
+    s_twihs.steps = 0;
+    s_twihs.errors = 0;
+}
+
+// *****************************************************************************
+// End of file
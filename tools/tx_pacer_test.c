@@ -0,0 +1,228 @@
+/**
+ * @file tx_pacer_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of link pacing (firmware/src/tx_pacer.c).
+ *
+ * Streams frames at 30 fps into a simulated transmit queue that drains at a
+ * fixed rate, calling the pacer in the order stream_frame() in app.c does,
+ * and checks that:
+ * - frames that fit the link are all sent full
+ * - frames that don't are sent decimated or skipped so that, once the
+ *   estimate has settled, nothing waits longer than max_latency_us, while
+ *   the link stays busy
+ * - the drain rate estimate finds a link slower than its nominal rate, and
+ *   isn't dragged down by a queue that runs dry
+ * - other traffic counted with tx_pacer_sent() is paced around
+ * - a change of baud rate restarts the estimate
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o tx_pacer_test tx_pacer_test.c \
+ *       ../firmware/src/tx_pacer.c
+ *   ./tx_pacer_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "host/check.h"
+#include "tx_pacer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define BAUD 10000000 // 1,000,000 bytes/s
+#define FRAME_US 33333
+#define QUEUE_SIZE (256 * 1024)
+
+// Frames before the estimate is expected to have settled
+#define SETTLE_FRAMES 30
+#define FRAMES 300
+
+typedef struct {
+    const char *name;
+    uint32_t drain_rate; // bytes/s the link actually takes
+    uint32_t full_size;
+    uint32_t decimated_size;
+    uint32_t other_size; // other traffic per frame
+} scenario_t;
+
+typedef struct {
+    uint32_t counts[TX_PACER_N_DECISIONS];
+    uint32_t max_latency_us; // after SETTLE_FRAMES, at the true rate
+    uint32_t busy_us;        // time the link was sending
+    uint32_t total_us;
+    uint32_t rate;           // final estimate
+} result_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Stream FRAMES frames through a fresh pacer and queue.
+ */
+static result_t run(const scenario_t *s, tx_pacer_t *pacer);
+
+/**
+ * @brief Continue streaming with an existing pacer and queue.
+ */
+static void stream(const scenario_t *s, tx_pacer_t *pacer, uint32_t *queue,
+                   int frames, result_t *r);
+
+static bool within(uint32_t value, uint32_t expected, uint32_t percent);
+
+// *****************************************************************************
+// Private (static) storage
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    static const scenario_t fits = {"fits", 1000000, 20000, 5000, 0};
+    static const scenario_t too_big = {"too big", 1000000, 60000, 15000, 0};
+    static const scenario_t slow = {"slow link", 400000, 20000, 5000, 0};
+    static const scenario_t idle = {"mostly idle", 1000000, 3000, 750, 0};
+    static const scenario_t shared = {"shared", 1000000, 20000, 5000, 20000};
+    static const scenario_t tiny = {"tiny", 1000000, 0, 0, 0};
+    tx_pacer_t pacer;
+    result_t r;
+
+    r = run(&fits, &pacer);
+    check(r.counts[TX_PACER_FULL] == FRAMES, "frames that fit not all full");
+
+    r = run(&too_big, &pacer);
+    check(r.counts[TX_PACER_FULL] > 0 && r.counts[TX_PACER_DECIMATED] > 0,
+          "oversized frames not mixed");
+    check(r.max_latency_us <= pacer.config.max_latency_us,
+          "latency bound exceeded");
+    check(r.busy_us * 10ULL >= r.total_us * 9ULL, "link left idle");
+
+    r = run(&slow, &pacer);
+    check(within(r.rate, slow.drain_rate, 5), "slow link not measured");
+    check(r.max_latency_us <= pacer.config.max_latency_us * 105ULL / 100,
+          "latency bound exceeded on a slow link");
+    check(r.busy_us * 10ULL >= r.total_us * 9ULL, "slow link left idle");
+
+    r = run(&idle, &pacer);
+    check(r.counts[TX_PACER_FULL] == FRAMES && r.rate == BAUD / 10,
+          "idle link misjudged");
+
+    r = run(&shared, &pacer);
+    check(r.counts[TX_PACER_SKIP] + r.counts[TX_PACER_DECIMATED] > 0,
+          "other traffic ignored");
+    check(r.max_latency_us <= pacer.config.max_latency_us,
+          "latency bound exceeded with other traffic");
+
+    // nothing to choose
+    r = run(&tiny, &pacer);
+    check(r.counts[TX_PACER_SKIP] == FRAMES, "empty choice not skipped");
+
+    // a slow estimate restarts from the new link rate when the baud rate
+    // changes, and not when it doesn't
+    uint32_t queue = 0;
+    r = (result_t){0};
+    run(&slow, &pacer);
+    tx_pacer_set_link_rate(&pacer, BAUD);
+    check(within(pacer.rate, slow.drain_rate, 5), "estimate reset at the same rate");
+    tx_pacer_set_link_rate(&pacer, BAUD / 2);
+    check(pacer.rate == BAUD / 20, "estimate not restarted");
+    static const scenario_t faster = {"faster", 500000, 20000, 5000, 0};
+    stream(&faster, &pacer, &queue, FRAMES, &r);
+    check(within(pacer.rate, faster.drain_rate, 5) &&
+              r.max_latency_us <= pacer.config.max_latency_us,
+          "new rate not paced");
+
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static result_t run(const scenario_t *s, tx_pacer_t *pacer) {
+    tx_pacer_config_t config;
+    uint32_t queue = 0;
+    result_t r = {0};
+
+    tx_pacer_default_config(&config, BAUD);
+    tx_pacer_init(pacer, &config);
+    stream(s, pacer, &queue, FRAMES, &r);
+    printf("# %-11s: %3u full, %3u decimated, %3u skipped, "
+           "%6u us max latency, %3u%% busy, %7u bytes/s\n",
+           s->name, r.counts[TX_PACER_FULL], r.counts[TX_PACER_DECIMATED],
+           r.counts[TX_PACER_SKIP], r.max_latency_us,
+           (uint32_t)(r.busy_us * 100ULL / r.total_us), r.rate);
+    return r;
+}
+
+static void stream(const scenario_t *s, tx_pacer_t *pacer, uint32_t *queue,
+                   int frames, result_t *r) {
+    for (int i = 0; i < frames; i++) {
+        // a little jitter in the frame interval, as from the camera
+        uint32_t elapsed = FRAME_US + (uint32_t)(i % 7) * 400 - 1200;
+
+        // as stream_frame(): other traffic since the last frame, then the
+        // queue depth, then the choice
+        tx_pacer_sent(pacer, s->other_size);
+        *queue += s->other_size;
+        tx_pacer_update(pacer, i == 0 ? 0 : elapsed, *queue);
+        tx_pacer_decision_t decision =
+            tx_pacer_decide(pacer, s->full_size, s->decimated_size,
+                            QUEUE_SIZE - *queue);
+        uint32_t size = decision == TX_PACER_FULL        ? s->full_size
+                        : decision == TX_PACER_DECIMATED ? s->decimated_size
+                                                         : 0;
+        tx_pacer_sent(pacer, size);
+        *queue += size;
+        r->counts[decision]++;
+
+        uint32_t latency = (uint32_t)(*queue * 1000000ULL / s->drain_rate);
+        if (i >= SETTLE_FRAMES && latency > r->max_latency_us) {
+            r->max_latency_us = latency;
+        }
+
+        // the link drains the queue until the next frame
+        uint32_t drained = (uint32_t)((uint64_t)s->drain_rate * elapsed /
+                                      1000000);
+        if (i >= SETTLE_FRAMES) {
+            r->busy_us += *queue >= drained ? elapsed : latency;
+            r->total_us += elapsed;
+        }
+        *queue -= *queue >= drained ? drained : *queue;
+    }
+    r->rate = pacer->rate;
+}
+
+static bool within(uint32_t value, uint32_t expected, uint32_t percent) {
+    uint32_t diff = value > expected ? value - expected : expected - value;
+    return (uint64_t)diff * 100 <= (uint64_t)expected * percent;
+}
+
+// *****************************************************************************
+// End of file
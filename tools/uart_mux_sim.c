@@ -0,0 +1,538 @@
+/**
+ * @file uart_mux_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host simulation of the console link multiplexer
+ * (firmware/src/uart_mux.c).
+ *
+ * Streams frames, telemetry, console text and link control messages over a
+ * simulated UART at full frame load, as the firmware does, twice: through
+ * the multiplexer, and written straight into the transmit ring in the order
+ * they are produced, as before it.  Frames are paced by tx_pacer.h in both
+ * cases.  The byte stream is decoded as the host would, and the latency of
+ * every message, from being produced to its last byte leaving the UART, is
+ * measured at the receiver and reported per channel.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o uart_mux_sim uart_mux_sim.c \
+ *       ../firmware/src/uart_mux.c ../firmware/src/frame_proto.c \
+ *       ../firmware/src/tx_pacer.c
+ *   ./uart_mux_sim [-b baud] [-f fps] [-s seconds] [-p processing_us]
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "frame_proto.h"
+#include "tx_pacer.h"
+#include "uart_mux.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define DEFAULT_BAUD 937500
+#define DEFAULT_FPS 30
+#define DEFAULT_SECONDS 20
+#define DEFAULT_PROCESSING_US 3000
+
+// Simulation step, and how often the superloop pumps outside frame
+// processing
+#define STEP_US 20
+#define LOOP_US 200
+
+// Compressed frame sizes: a 96x96 frame at roughly the codec's ratio
+#define FRAME_MIN 1500
+#define FRAME_MAX 4500
+#define MAX_FRAME (96 * 96 * 2)
+
+// Link control traffic: a keepalive reply every so often
+#define CONTROL_INTERVAL_US 250000
+
+#define SINK_SIZE (1 << 17)
+#define RX_BUF_SIZE (MAX_FRAME + 64)
+
+// Queue sizes, as in app.c
+#define CONTROL_QUEUE_SIZE 1024
+#define TELEMETRY_QUEUE_SIZE 1024
+#define LOG_QUEUE_SIZE 2048
+#define BULK_QUEUE_SIZE 24576
+
+typedef enum {
+    CH_CONTROL,
+    CH_TELEMETRY,
+    CH_LOG,
+    CH_BULK,
+    N_CH,
+} channel_t;
+
+static const char *const s_names[N_CH] = {"control", "telemetry", "log",
+                                          "bulk"};
+
+typedef struct {
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+} latency_t;
+
+typedef struct {
+    bool mux;           // through the multiplexer, else straight to the ring
+    uint32_t baud;
+    uint32_t fps;
+    uint32_t seconds;
+    uint32_t processing_us;
+} sim_config_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Run one simulation and print its results.  Returns false if the
+ * receiver saw anything other than what was sent.
+ */
+static bool run(const sim_config_t *config);
+
+/**
+ * @brief Superloop work at time now: produce the traffic that is due, and
+ * pump the multiplexer.
+ */
+static void produce(const sim_config_t *config, uint32_t now);
+
+/**
+ * @brief Send a frame and its telemetry, if the pacer allows.
+ */
+static void produce_frame(const sim_config_t *config, uint32_t now);
+
+/**
+ * @brief Send a message whose payload starts with the time it was produced.
+ */
+static void send_stamped(frame_proto_encoder_t *enc, uint8_t type,
+                         uint32_t length, uint32_t now);
+
+/**
+ * @brief Send console text carrying the time it was produced.
+ */
+static void send_text(uint32_t now);
+
+/**
+ * @brief Move the bytes the UART has sent by now to the receiver.
+ */
+static void drain(uint32_t now, uint32_t rate);
+
+static size_t sink_write(const void *data, size_t n, uintptr_t context);
+static uint32_t sink_pending(void);
+static uint32_t clock_us(void);
+
+static void on_message(const frame_proto_msg_t *msg, uintptr_t context);
+
+/**
+ * @brief Scan console text for time stamps: the bytes between messages
+ * when it is written straight to the ring, LOG payloads through the
+ * multiplexer.
+ */
+static void scan_text(uint8_t byte);
+
+static void record(channel_t channel, uint32_t produced);
+
+static void put_u32(uint8_t *p, uint32_t v);
+static uint32_t get_u32(const uint8_t *p);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_sink[SINK_SIZE];
+static uint32_t s_sink_in;
+static uint32_t s_sink_out;
+static uint32_t s_sink_written; // bytes written to the sink, wrapping
+
+static uint8_t s_control_q[CONTROL_QUEUE_SIZE];
+static uint8_t s_telemetry_q[TELEMETRY_QUEUE_SIZE];
+static uint8_t s_log_q[LOG_QUEUE_SIZE];
+static uint8_t s_bulk_q[BULK_QUEUE_SIZE];
+
+static uint8_t s_payload[MAX_FRAME];
+static uint8_t s_rx_buf[RX_BUF_SIZE];
+static uint8_t s_reasm_buf[RX_BUF_SIZE];
+
+static uart_mux_t s_mux;
+static frame_proto_encoder_t s_direct; // writes straight to the sink
+static frame_proto_decoder_t s_rx;
+static tx_pacer_t s_pacer;
+
+static uint32_t s_now;           // simulated time, us
+static uint32_t s_next_frame;    // when the next frame is read out
+static uint32_t s_next_control;  // when the next control message is due
+static uint32_t s_busy_until;    // end of the current frame's processing
+static uint32_t s_last_frame;    // readout time of the previous frame
+static uint32_t s_frame_seq;
+static uint64_t s_credit;        // bytes the UART may send, in 1/1e6 units
+static uint32_t s_offered;       // bytes queued at the previous frame
+static bool s_use_mux;
+
+static latency_t s_latency[N_CH];
+static uint32_t s_sent[N_CH];
+static uint32_t s_received[N_CH];
+
+// console text scanner
+static char s_text[32];
+static size_t s_text_len;
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+    sim_config_t config = {
+        .baud = DEFAULT_BAUD,
+        .fps = DEFAULT_FPS,
+        .seconds = DEFAULT_SECONDS,
+        .processing_us = DEFAULT_PROCESSING_US,
+    };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:f:s:p:")) != -1) {
+        switch (opt) {
+        case 'b':
+            config.baud = (uint32_t)atoi(optarg);
+            break;
+        case 'f':
+            config.fps = (uint32_t)atoi(optarg);
+            break;
+        case 's':
+            config.seconds = (uint32_t)atoi(optarg);
+            break;
+        case 'p':
+            config.processing_us = (uint32_t)atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-f fps] [-s seconds] "
+                            "[-p processing_us]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (config.baud < 1000 || config.fps == 0 ||
+        config.processing_us * config.fps >= 1000000) {
+        fprintf(stderr, "%s: bad parameters\n", argv[0]);
+        return 2;
+    }
+
+    printf("%u baud, %u fps, frames of %u..%u bytes, %u us processing per "
+           "frame, %u s\n",
+           config.baud, config.fps, FRAME_MIN, FRAME_MAX,
+           config.processing_us, config.seconds);
+    bool ok = true;
+    config.mux = false;
+    ok &= run(&config);
+    config.mux = true;
+    ok &= run(&config);
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool run(const sim_config_t *config) {
+    uint32_t rate = config->baud / 10;
+    uint32_t end = config->seconds * 1000000;
+    uint32_t next_loop = 0;
+
+    srand(1);
+    s_sink_in = s_sink_out = 0;
+    s_sink_written = 0;
+    s_offered = 0;
+    s_now = 0;
+    s_next_frame = 0;
+    s_next_control = CONTROL_INTERVAL_US;
+    s_busy_until = 0;
+    s_frame_seq = 0;
+    s_credit = 0;
+    s_text_len = 0;
+    s_use_mux = config->mux;
+    memset(s_latency, 0, sizeof(s_latency));
+    memset(s_sent, 0, sizeof(s_sent));
+    memset(s_received, 0, sizeof(s_received));
+
+    tx_pacer_config_t pacer_config;
+    tx_pacer_default_config(&pacer_config, config->baud);
+    tx_pacer_init(&s_pacer, &pacer_config);
+
+    frame_proto_encoder_init(&s_direct, sink_write, 0);
+    uart_mux_config_t mux_config;
+    uart_mux_default_config(&mux_config, config->baud);
+    uart_mux_init(&s_mux, &mux_config, sink_write, 0, clock_us);
+    uart_mux_set_queue(&s_mux, UART_MUX_CONTROL, s_control_q,
+                       sizeof(s_control_q));
+    uart_mux_set_queue(&s_mux, UART_MUX_TELEMETRY, s_telemetry_q,
+                       sizeof(s_telemetry_q));
+    uart_mux_set_queue(&s_mux, UART_MUX_LOG, s_log_q, sizeof(s_log_q));
+    uart_mux_set_queue(&s_mux, UART_MUX_BULK, s_bulk_q, sizeof(s_bulk_q));
+
+    frame_proto_decoder_init(&s_rx, s_rx_buf, sizeof(s_rx_buf), on_message,
+                             0);
+    frame_proto_decoder_set_reassembly(&s_rx, s_reasm_buf,
+                                       sizeof(s_reasm_buf));
+
+    for (s_now = 0; s_now < end; s_now += STEP_US) {
+        // The superloop runs every LOOP_US, except while a frame is
+        // processed
+        if (s_now >= s_busy_until && s_now >= next_loop) {
+            produce(config, s_now);
+            next_loop = s_now + LOOP_US;
+        }
+        drain(s_now, rate);
+    }
+
+    // Let the link finish what was queued
+    for (; s_now < end + 2000000; s_now += STEP_US) {
+        if (config->mux) {
+            uart_mux_pump(&s_mux, sink_pending());
+        }
+        drain(s_now, rate);
+    }
+
+    printf("\n%s:\n", config->mux ? "multiplexed" : "in order");
+    printf("channel     messages  received   mean ms    max ms\n");
+    for (int c = 0; c < N_CH; c++) {
+        const latency_t *l = &s_latency[c];
+        printf("%-10s %9u %9u %9.2f %9.2f\n", s_names[c], s_sent[c],
+               s_received[c], l->count ? l->sum_us / 1000.0 / l->count : 0.0,
+               l->max_us / 1000.0);
+    }
+    printf("frames: %u full, %u skipped\n", s_pacer.counts[TX_PACER_FULL],
+           s_pacer.counts[TX_PACER_SKIP]);
+    if (config->mux) {
+        printf("measured by the multiplexer, max ms:");
+        for (int c = 0; c < N_CH; c++) {
+            printf(" %s %.2f", s_names[c],
+                   s_mux.queues[c].stats.max_latency_us / 1000.0);
+        }
+        printf("\n");
+    }
+
+    bool ok = s_rx.stats.crc_errors == 0 && s_rx.stats.lost == 0 &&
+              s_rx.stats.fragment_errors == 0;
+    for (int c = 0; c < N_CH; c++) {
+        ok &= s_received[c] == s_sent[c];
+    }
+    if (!ok) {
+        printf("FAIL: %u CRC errors, %u lost, %u fragment errors\n",
+               s_rx.stats.crc_errors, s_rx.stats.lost,
+               s_rx.stats.fragment_errors);
+    }
+    return ok;
+}
+
+static void produce(const sim_config_t *config, uint32_t now) {
+    if (now >= s_next_control) {
+        frame_proto_encoder_t *enc =
+            config->mux ? uart_mux_encoder(&s_mux, UART_MUX_CONTROL)
+                        : &s_direct;
+        send_stamped(enc, FRAME_PROTO_TYPE_LINK, 5, now);
+        s_sent[CH_CONTROL]++;
+        s_next_control += CONTROL_INTERVAL_US;
+    }
+    if (now >= s_next_frame) {
+        produce_frame(config, now);
+        s_next_frame += 1000000 / config->fps;
+        s_busy_until = now + config->processing_us;
+    }
+    if (config->mux) {
+        uart_mux_pump(&s_mux, sink_pending());
+    }
+}
+
+static void produce_frame(const sim_config_t *config, uint32_t now) {
+    uint32_t length = FRAME_MIN + rand() % (FRAME_MAX - FRAME_MIN + 1);
+    frame_proto_encoder_t *bulk = &s_direct;
+    uint32_t pending = sink_pending();
+    uint32_t free = SINK_SIZE - 1 - pending;
+    uint32_t size = FRAME_PROTO_MESSAGE_SIZE(length);
+    uint32_t offered = s_sink_written;
+
+    if (config->mux) {
+        bulk = uart_mux_encoder(&s_mux, UART_MUX_BULK);
+        pending += uart_mux_pending(&s_mux);
+        free = uart_mux_free(&s_mux, UART_MUX_BULK);
+        size = uart_mux_cost(&s_mux, UART_MUX_BULK, length);
+        // as app.c: what the multiplexer accepted, on every channel
+        offered = 0;
+        for (int i = 0; i < UART_MUX_N_CHANNELS; i++) {
+            offered += s_mux.queues[i].stats.queued;
+        }
+    }
+    tx_pacer_sent(&s_pacer, offered - s_offered);
+    s_offered = offered;
+    tx_pacer_update(&s_pacer, s_frame_seq > 0 ? now - s_last_frame : 0,
+                    pending);
+    s_last_frame = now;
+    if (tx_pacer_decide(&s_pacer, size, 0, free) == TX_PACER_FULL) {
+        frame_proto_set_tag(bulk, s_frame_seq);
+        send_stamped(bulk, FRAME_PROTO_TYPE_FRAME_CODEC, length, now);
+        s_sent[CH_BULK]++;
+    }
+    s_frame_seq++;
+
+    // The frame's telemetry, and a line of console text
+    send_stamped(config->mux ? uart_mux_encoder(&s_mux, UART_MUX_TELEMETRY)
+                             : &s_direct,
+                 FRAME_PROTO_TYPE_TELEMETRY, FRAME_PROTO_TELEMETRY_SIZE, now);
+    s_sent[CH_TELEMETRY]++;
+    send_text(now);
+    s_sent[CH_LOG]++;
+}
+
+static void send_stamped(frame_proto_encoder_t *enc, uint8_t type,
+                         uint32_t length, uint32_t now) {
+    memset(s_payload, 0x55, length);
+    put_u32(s_payload, now);
+    frame_proto_send(enc, type, 0, s_payload, length);
+}
+
+static void send_text(uint32_t now) {
+    char text[80];
+    int n = snprintf(text, sizeof(text),
+                     "# t=%08x frame %u, exposure 300, gain 16\r\n", now,
+                     s_frame_seq);
+    if (s_use_mux) {
+        uart_mux_write_text(&s_mux, text, (size_t)n);
+    } else {
+        sink_write(text, (size_t)n, 0);
+    }
+}
+
+static void drain(uint32_t now, uint32_t rate) {
+    (void)now;
+    s_credit += (uint64_t)rate * STEP_US;
+    while (s_credit >= 1000000 && s_sink_out != s_sink_in) {
+        uint8_t byte = s_sink[s_sink_out];
+        s_sink_out = (s_sink_out + 1) % SINK_SIZE;
+        s_credit -= 1000000;
+        frame_proto_decode(&s_rx, &byte, 1);
+        if (!s_use_mux) {
+            scan_text(byte);
+        }
+    }
+    if (s_sink_out == s_sink_in) {
+        // an idle UART doesn't bank time
+        s_credit = 0;
+    }
+}
+
+static size_t sink_write(const void *data, size_t n, uintptr_t context) {
+    (void)context;
+    const uint8_t *p = data;
+    size_t i;
+    for (i = 0; i < n && sink_pending() < SINK_SIZE - 1; i++) {
+        s_sink[s_sink_in] = p[i];
+        s_sink_in = (s_sink_in + 1) % SINK_SIZE;
+    }
+    s_sink_written += i;
+    return i;
+}
+
+static uint32_t sink_pending(void) {
+    return (s_sink_in + SINK_SIZE - s_sink_out) % SINK_SIZE;
+}
+
+static uint32_t clock_us(void) { return s_now; }
+
+static void on_message(const frame_proto_msg_t *msg, uintptr_t context) {
+    (void)context;
+    if (msg->type == FRAME_PROTO_TYPE_LOG) {
+        for (uint32_t i = 0; i < msg->length; i++) {
+            scan_text(msg->payload[i]);
+        }
+        return;
+    }
+    if (msg->length < 4) {
+        return;
+    }
+    uint32_t produced = get_u32(msg->payload);
+    switch (msg->type) {
+    case FRAME_PROTO_TYPE_LINK:
+        record(CH_CONTROL, produced);
+        break;
+    case FRAME_PROTO_TYPE_TELEMETRY:
+        record(CH_TELEMETRY, produced);
+        break;
+    case FRAME_PROTO_TYPE_FRAME_CODEC:
+        record(CH_BULK, produced);
+        break;
+    default:
+        break;
+    }
+}
+
+static void scan_text(uint8_t byte) {
+    static const char prefix[] = "# t=";
+    size_t prefix_len = sizeof(prefix) - 1;
+
+    if (s_text_len < prefix_len) {
+        if (byte == (uint8_t)prefix[s_text_len]) {
+            s_text[s_text_len++] = (char)byte;
+        } else {
+            s_text_len = byte == (uint8_t)prefix[0] ? 1 : 0;
+        }
+        return;
+    }
+    s_text[s_text_len++] = (char)byte;
+    if (s_text_len == prefix_len + 8) {
+        s_text[s_text_len] = '\0';
+        record(CH_LOG, (uint32_t)strtoul(s_text + prefix_len, NULL, 16));
+        s_text_len = 0;
+    }
+}
+
+static void record(channel_t channel, uint32_t produced) {
+    // Latency to the last byte of the message; text is stamped at its start
+    latency_t *l = &s_latency[channel];
+    uint32_t us = s_now - produced;
+    l->count++;
+    l->sum_us += us;
+    if (us > l->max_us) {
+        l->max_us = us;
+    }
+    s_received[channel]++;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
@@ -0,0 +1,181 @@
+/**
+ * @file yuv_codec_bench.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host benchmark and round trip check for the firmware's lossless
+ * frame codec (firmware/src/yuv_codec.c).
+ *
+ * Reads a 96 x 96 YUYV frame in the hex text format printed by the firmware
+ * (e.g. yuv_test.txt), then reports the compression ratio and encode /
+ * decode throughput for:
+ * - a key frame (no reference),
+ * - a static scene (the same frame against itself),
+ * - a changing scene (the frame against a copy with a moving patch and
+ *   sensor noise added).
+ * Every encoded frame is decoded and compared with the original.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o yuv_codec_bench yuv_codec_bench.c \
+ *       ../firmware/src/yuv_codec.c
+ *   ./yuv_codec_bench yuv_test.txt
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "yuv_codec.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define IMAGE_WIDTH 96
+#define IMAGE_HEIGHT 96
+#define FRAME_SIZE (IMAGE_WIDTH * IMAGE_HEIGHT * 2)
+#define ENCODED_SIZE YUV_CODEC_MAX_OUTPUT(IMAGE_WIDTH, IMAGE_HEIGHT)
+
+// Repeat each measurement this many times for a stable timing
+#define ITERATIONS 200
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Read whitespace separated hex bytes.  Returns the number read.
+ */
+static size_t load_hex(const char *filename, uint8_t *buf, size_t size);
+
+/**
+ * @brief Encode frame against ref, check the round trip and print a line of
+ * results.  Returns false if the round trip fails.
+ */
+static bool bench(const char *name, const uint8_t *frame, const uint8_t *ref);
+
+static double seconds(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static uint8_t s_frame[FRAME_SIZE];
+static uint8_t s_moved[FRAME_SIZE];
+static uint8_t s_encoded[ENCODED_SIZE];
+static uint8_t s_decoded[FRAME_SIZE];
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+    const char *filename = argc > 1 ? argv[1] : "yuv_test.txt";
+    size_t n = load_hex(filename, s_frame, FRAME_SIZE);
+
+    if (n != FRAME_SIZE) {
+        fprintf(stderr, "%s: expected %d bytes, read %zu\n", filename,
+                FRAME_SIZE, n);
+        return 1;
+    }
+
+    // The next frame: a 16 x 16 patch moves and every Y sample has +/-1 noise
+    memcpy(s_moved, s_frame, FRAME_SIZE);
+    srand(1);
+    for (size_t i = 0; i < FRAME_SIZE; i += 2) {
+        int y = s_moved[i] + (rand() % 3) - 1;
+        s_moved[i] = y < 0 ? 0 : y > 255 ? 255 : y;
+    }
+    for (int y = 40; y < 56; y++) {
+        memcpy(&s_moved[(y * IMAGE_WIDTH + 40) * 2],
+               &s_frame[((y - 4) * IMAGE_WIDTH + 36) * 2], 16 * 2);
+    }
+
+    printf("raw frame: %d bytes, %d bytes as hex text\n", FRAME_SIZE,
+           FRAME_SIZE * 3);
+    printf("%-10s %8s %7s %10s %10s\n", "frame", "bytes", "ratio",
+           "enc MB/s", "dec MB/s");
+    bool ok = bench("key", s_frame, NULL);
+    ok = bench("static", s_frame, s_frame) && ok;
+    ok = bench("moving", s_moved, s_frame) && ok;
+    return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t load_hex(const char *filename, uint8_t *buf, size_t size) {
+    FILE *f = fopen(filename, "r");
+    unsigned int byte;
+    size_t n = 0;
+
+    if (f == NULL) {
+        perror(filename);
+        return 0;
+    }
+    while (n < size && fscanf(f, "%x", &byte) == 1) {
+        buf[n++] = byte;
+    }
+    fclose(f);
+    return n;
+}
+
+static bool bench(const char *name, const uint8_t *frame, const uint8_t *ref) {
+    size_t len = 0;
+
+    double start = seconds();
+    for (int i = 0; i < ITERATIONS; i++) {
+        len = yuv_codec_encode(frame, ref, IMAGE_WIDTH, IMAGE_HEIGHT,
+                               s_encoded, sizeof(s_encoded));
+    }
+    double encode_s = (seconds() - start) / ITERATIONS;
+
+    bool ok = true;
+    start = seconds();
+    for (int i = 0; i < ITERATIONS; i++) {
+        ok = yuv_codec_decode(s_encoded, len, ref, s_decoded,
+                              sizeof(s_decoded)) &&
+             ok;
+    }
+    double decode_s = (seconds() - start) / ITERATIONS;
+
+    if (!ok || memcmp(frame, s_decoded, FRAME_SIZE) != 0) {
+        printf("%-10s round trip FAILED\n", name);
+        return false;
+    }
+    printf("%-10s %8zu %6.2fx %10.1f %10.1f\n", name, len,
+           (double)FRAME_SIZE / len, FRAME_SIZE / encode_s / 1e6,
+           FRAME_SIZE / decode_s / 1e6);
+    return true;
+}
+
+static double seconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,206 @@
+/**
+ * @file yuv_convert_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the integer YUYV conversions
+ * (firmware/src/yuv_convert.c) against the floating point code they
+ * replaced.
+ *
+ * For every (Y, U, V) combination, with Y in both pixels of a YUYV pair,
+ * checks that each RGB output format of yuv_convert() holds exactly the
+ * values the original app.c convert_yuv_to_rgb() produced (R, G and B
+ * truncated and clamped through a float), rearranged and scaled as the
+ * format defines, and that GRAY8 is the luma.  The CMSIS intrinsics are the
+ * portable C versions in host/definitions.h.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -Ihost -I../firmware/src -o yuv_convert_test yuv_convert_test.c \
+ *       ../firmware/src/yuv_convert.c
+ *   ./yuv_convert_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "yuv_convert.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// One row holds every Y value in each pixel of a pair
+#define N_PAIRS 256
+#define N_PIXELS (N_PAIRS * 2)
+#define MAX_REPORTS 10
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief The original conversion's clamp, including its float argument.
+ */
+static uint8_t clamp(float v);
+
+/**
+ * @brief The original conversion of one pixel.
+ */
+static void reference(uint8_t y, uint8_t u, uint8_t v, uint8_t rgb[3]);
+
+/**
+ * @brief Compare one converted row against the reference.  Returns the
+ * number of mismatching pixels.
+ */
+static unsigned check_row(yuv_convert_format_t format, uint8_t u, uint8_t v);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const char *const s_format_names[YUV_CONVERT_FORMAT_COUNT] = {
+    "RGB888", "BGR888", "RGB565", "GRAY8",
+    "RGB_PLANAR", "RGB_PLANAR_S8", "RGB_PLANAR_F32",
+};
+
+static uint8_t s_yuyv[N_PIXELS * 2];
+static uint8_t s_ref[N_PIXELS][3];
+static uint8_t s_out[N_PIXELS * 3 * sizeof(float)];
+static unsigned s_reports;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    unsigned mismatches[YUV_CONVERT_FORMAT_COUNT] = {0};
+    bool ok = true;
+
+    for (int u = 0; u < 256; u++) {
+        for (int v = 0; v < 256; v++) {
+            for (int k = 0; k < N_PAIRS; k++) {
+                uint8_t *pair = &s_yuyv[k * 4];
+                pair[0] = k;
+                pair[1] = u;
+                pair[2] = 255 - k;
+                pair[3] = v;
+                reference(pair[0], u, v, s_ref[k * 2]);
+                reference(pair[2], u, v, s_ref[k * 2 + 1]);
+            }
+            for (int f = 0; f < YUV_CONVERT_FORMAT_COUNT; f++) {
+                mismatches[f] += check_row(f, u, v);
+            }
+        }
+    }
+
+    for (int f = 0; f < YUV_CONVERT_FORMAT_COUNT; f++) {
+        printf("%-15s %u mismatches in %u pixels\n", s_format_names[f],
+               mismatches[f], 256u * 256 * N_PIXELS);
+        ok &= mismatches[f] == 0;
+    }
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint8_t clamp(float v) {
+    if (v < 0.0) {
+        return 0;
+    } else if (v > 255.0) {
+        return 255;
+    } else {
+        return v;
+    }
+}
+
+static void reference(uint8_t y, uint8_t u, uint8_t v, uint8_t rgb[3]) {
+    rgb[0] = clamp(y + 1.4075 * (v - 128));
+    rgb[1] = clamp(y - 0.3455 * (u - 128) - (0.7169 * (v - 128)));
+    rgb[2] = clamp(y + 1.7790 * (u - 128));
+}
+
+static unsigned check_row(yuv_convert_format_t format, uint8_t u, uint8_t v) {
+    unsigned bad = 0;
+
+    if (!yuv_convert(format, s_yuyv, s_out, N_PIXELS)) {
+        printf("%s: yuv_convert failed\n", s_format_names[format]);
+        return N_PIXELS;
+    }
+    for (int i = 0; i < N_PIXELS; i++) {
+        const uint8_t *ref = s_ref[i];
+        uint8_t y = s_yuyv[i * 2];
+        bool match;
+        switch (format) {
+        case YUV_CONVERT_RGB888:
+            match = memcmp(&s_out[i * 3], ref, 3) == 0;
+            break;
+        case YUV_CONVERT_BGR888:
+            match = s_out[i * 3] == ref[2] && s_out[i * 3 + 1] == ref[1] &&
+                    s_out[i * 3 + 2] == ref[0];
+            break;
+        case YUV_CONVERT_RGB565: {
+            uint16_t pixel;
+            memcpy(&pixel, &s_out[i * 2], sizeof(pixel));
+            match = pixel == (((ref[0] >> 3) << 11) | ((ref[1] >> 2) << 5) |
+                              (ref[2] >> 3));
+        } break;
+        case YUV_CONVERT_GRAY8:
+            match = s_out[i] == y;
+            break;
+        case YUV_CONVERT_RGB_PLANAR:
+            match = s_out[i] == ref[0] && s_out[N_PIXELS + i] == ref[1] &&
+                    s_out[2 * N_PIXELS + i] == ref[2];
+            break;
+        case YUV_CONVERT_RGB_PLANAR_S8: {
+            const int8_t *chw = (const int8_t *)s_out;
+            match = chw[i] == ref[0] - 128 &&
+                    chw[N_PIXELS + i] == ref[1] - 128 &&
+                    chw[2 * N_PIXELS + i] == ref[2] - 128;
+        } break;
+        default: {
+            float chw[3];
+            for (int c = 0; c < 3; c++) {
+                memcpy(&chw[c], &s_out[(c * N_PIXELS + i) * sizeof(float)],
+                       sizeof(float));
+            }
+            match = chw[0] == ref[0] * (1.0f / 255.0f) &&
+                    chw[1] == ref[1] * (1.0f / 255.0f) &&
+                    chw[2] == ref[2] * (1.0f / 255.0f);
+        } break;
+        }
+        if (!match) {
+            bad++;
+            if (s_reports++ < MAX_REPORTS) {
+                printf("%s: Y %u U %u V %u: expected %u %u %u\n",
+                       s_format_names[format], y, u, v, ref[0], ref[1],
+                       ref[2]);
+            }
+        }
+    }
+    return bad;
+}
@@ -0,0 +1,317 @@
+/**
+ * @file yuv_resize_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the YUYV crop and resize
+ * (firmware/src/yuv_resize.c) against a floating point reference.
+ *
+ * Resizes a textured test image, with and without a region of interest, in
+ * each mode, down and up, and checks that:
+ * - every output sample matches the reference: exactly for
+ *   YUV_RESIZE_NEAREST, rounded for YUV_RESIZE_AREA (the mean over bins
+ *   with whole sample edges, as yuv_resize.h describes) and within 2 for
+ *   YUV_RESIZE_BILINEAR (8 bit weights, rounded after each pass);
+ * - the ROI offsets are honoured, luma per pixel and chroma per pair;
+ * - pushing every source row with yuv_resize_push_row(), including those
+ *   outside the ROI, writes each output row once and gives the same image
+ *   as yuv_resize_frame(), and when upscaling with YUV_RESIZE_NEAREST one
+ *   source row completes several output rows;
+ * - yuv_resize_init() rejects what it documents as out of range.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -I../firmware/src -o yuv_resize_test yuv_resize_test.c \
+ *       ../firmware/src/yuv_resize.c -lm
+ *   ./yuv_resize_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "host/check.h"
+#include "yuv_resize.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_SRC_WIDTH 640
+#define MAX_SRC_HEIGHT 480
+
+typedef struct {
+    const char *name;
+    yuv_resize_mode_t mode;
+    uint16_t src_width;
+    uint16_t src_height;
+    bool use_roi;
+    yuv_resize_roi_t roi;
+    uint16_t dst_width;
+    uint16_t dst_height;
+} test_case_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Fill s_src with a textured width x height image: gradients plus a
+ * pseudo-random pattern, so that neighbouring samples differ.
+ */
+static void make_image(uint16_t width, uint16_t height);
+
+/**
+ * @brief Source sample of channel (0 Y, 1 U, 2 V) at column x (pixels for
+ * Y, pairs for U and V) and row y within the ROI.
+ */
+static double source(const test_case_t *c, const yuv_resize_roi_t *roi,
+                     int channel, int x, int y);
+
+/**
+ * @brief Reference value of output sample (x, y) of channel.
+ */
+static double reference(const test_case_t *c, const yuv_resize_roi_t *roi,
+                        int channel, int x, int y);
+
+/**
+ * @brief Run a case through yuv_resize_frame() and the row by row path.
+ */
+static void run_case(const test_case_t *c);
+
+static void check_rejects(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const test_case_t s_cases[] = {
+    {"nearest down", YUV_RESIZE_NEAREST, 96, 96, false, {0}, 48, 48},
+    {"nearest up", YUV_RESIZE_NEAREST, 96, 96, false, {0}, 224, 224},
+    {"nearest roi", YUV_RESIZE_NEAREST, 96, 96, true, {10, 6, 60, 50}, 20, 16},
+    {"bilinear down", YUV_RESIZE_BILINEAR, 96, 96, false, {0}, 64, 48},
+    {"bilinear up", YUV_RESIZE_BILINEAR, 96, 96, false, {0}, 224, 224},
+    {"bilinear roi", YUV_RESIZE_BILINEAR, 96, 96, true, {10, 6, 60, 50},
+     120, 100},
+    {"bilinear vga", YUV_RESIZE_BILINEAR, 640, 480, false, {0}, 224, 224},
+    {"area down", YUV_RESIZE_AREA, 96, 96, false, {0}, 32, 32},
+    {"area uneven", YUV_RESIZE_AREA, 96, 96, false, {0}, 40, 30},
+    {"area roi", YUV_RESIZE_AREA, 96, 96, true, {10, 6, 60, 50}, 30, 20},
+    {"area vga", YUV_RESIZE_AREA, 640, 480, true, {80, 0, 480, 480}, 96, 96},
+};
+
+static uint8_t s_src[MAX_SRC_WIDTH * MAX_SRC_HEIGHT * 2];
+static uint8_t s_frame_out[YUV_RESIZE_MAX_DST_WIDTH *
+                           YUV_RESIZE_MAX_DST_HEIGHT * 2];
+static uint8_t s_row_out[YUV_RESIZE_MAX_DST_WIDTH *
+                         YUV_RESIZE_MAX_DST_HEIGHT * 2];
+static uint8_t s_written[YUV_RESIZE_MAX_DST_HEIGHT];
+static yuv_resize_t s_rs;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        run_case(&s_cases[i]);
+    }
+    check_rejects();
+
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void make_image(uint16_t width, uint16_t height) {
+    uint32_t seed = 1;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1103515245 + 12345;
+            uint8_t *p = &s_src[(y * width + x) * 2];
+            p[0] = (x * 3 + y * 2 + (seed >> 16) % 64) & 0xff;
+            // U in even pixels, V in odd
+            p[1] = (x & 1) ? (200 - y / 4 + (seed >> 20) % 16) & 0xff
+                           : (40 + x / 4 + (seed >> 24) % 16) & 0xff;
+        }
+    }
+}
+
+static double source(const test_case_t *c, const yuv_resize_roi_t *roi,
+                     int channel, int x, int y) {
+    size_t row = (size_t)(roi->y + y) * c->src_width * 2;
+    if (channel == 0) {
+        return s_src[row + (roi->x + x) * 2];
+    }
+    return s_src[row + (roi->x + 2 * x) * 2 + (channel == 1 ? 1 : 3)];
+}
+
+static double reference(const test_case_t *c, const yuv_resize_roi_t *roi,
+                        int channel, int x, int y) {
+    int src_w = channel == 0 ? roi->width : roi->width / 2;
+    int dst_w = channel == 0 ? c->dst_width : c->dst_width / 2;
+    int src_h = roi->height;
+    int dst_h = c->dst_height;
+
+    switch (c->mode) {
+    case YUV_RESIZE_NEAREST: {
+        int sx = (int)floor((x + 0.5) * src_w / dst_w);
+        int sy = (int)floor((y + 0.5) * src_h / dst_h);
+        return source(c, roi, channel, sx < src_w ? sx : src_w - 1,
+                      sy < src_h ? sy : src_h - 1);
+    }
+
+    case YUV_RESIZE_BILINEAR: {
+        double px = fmax((x + 0.5) * src_w / dst_w - 0.5, 0);
+        double py = fmax((y + 0.5) * src_h / dst_h - 0.5, 0);
+        int x0 = (int)px;
+        int y0 = (int)py;
+        int x1 = x0 + 1 < src_w ? x0 + 1 : src_w - 1;
+        int y1 = y0 + 1 < src_h ? y0 + 1 : src_h - 1;
+        double fx = x0 < src_w - 1 ? px - x0 : 0;
+        double fy = y0 < src_h - 1 ? py - y0 : 0;
+        x0 = x0 < src_w ? x0 : src_w - 1;
+        y0 = y0 < src_h ? y0 : src_h - 1;
+        double top = source(c, roi, channel, x0, y0) * (1 - fx) +
+                     source(c, roi, channel, x1, y0) * fx;
+        double bottom = source(c, roi, channel, x0, y1) * (1 - fx) +
+                        source(c, roi, channel, x1, y1) * fx;
+        return top * (1 - fy) + bottom * fy;
+    }
+
+    case YUV_RESIZE_AREA: {
+        double sum = 0;
+        int n = 0;
+        for (int sy = y * src_h / dst_h; sy < (y + 1) * src_h / dst_h; sy++) {
+            for (int sx = x * src_w / dst_w; sx < (x + 1) * src_w / dst_w;
+                 sx++) {
+                sum += source(c, roi, channel, sx, sy);
+                n++;
+            }
+        }
+        return sum / n;
+    }
+    }
+    return 0;
+}
+
+static void run_case(const test_case_t *c) {
+    yuv_resize_roi_t full = {0, 0, c->src_width, c->src_height};
+    const yuv_resize_roi_t *roi = c->use_roi ? &c->roi : &full;
+    double tolerance = c->mode == YUV_RESIZE_NEAREST ? 0
+                       : c->mode == YUV_RESIZE_AREA  ? 0.5
+                                                     : 2;
+    size_t dst_size = (size_t)c->dst_width * c->dst_height * 2;
+    char what[128];
+
+    make_image(c->src_width, c->src_height);
+    if (!yuv_resize_init(&s_rs, c->mode, c->src_width, c->src_height,
+                         c->use_roi ? &c->roi : NULL, c->dst_width,
+                         c->dst_height)) {
+        snprintf(what, sizeof(what), "%s: init", c->name);
+        check(false, what);
+        return;
+    }
+
+    // the whole frame against the reference
+    memset(s_frame_out, 0, sizeof(s_frame_out));
+    yuv_resize_frame(&s_rs, s_src, s_frame_out);
+    double worst = 0;
+    for (int y = 0; y < c->dst_height; y++) {
+        const uint8_t *row = &s_frame_out[(size_t)y * c->dst_width * 2];
+        for (int x = 0; x < c->dst_width; x++) {
+            double d = fabs(row[2 * x] - reference(c, roi, 0, x, y));
+            worst = d > worst ? d : worst;
+        }
+        for (int j = 0; j < c->dst_width / 2; j++) {
+            double du = fabs(row[4 * j + 1] - reference(c, roi, 1, j, y));
+            double dv = fabs(row[4 * j + 3] - reference(c, roi, 2, j, y));
+            worst = du > worst ? du : worst;
+            worst = dv > worst ? dv : worst;
+        }
+    }
+    printf("# %-14s %3dx%-3d -> %3dx%-3d  worst error %.2f\n", c->name,
+           roi->width, roi->height, c->dst_width, c->dst_height, worst);
+    snprintf(what, sizeof(what), "%s: matches the reference", c->name);
+    check(worst <= tolerance, what);
+    snprintf(what, sizeof(what), "%s: done after the frame", c->name);
+    check(yuv_resize_is_done(&s_rs), what);
+
+    // row by row, every source row, as read from the camera
+    memset(s_row_out, 0, sizeof(s_row_out));
+    memset(s_written, 0, sizeof(s_written));
+    yuv_resize_start(&s_rs);
+    size_t total = 0;
+    size_t most = 0;
+    for (int r = 0; r < c->src_height; r++) {
+        uint16_t first = s_rs.dst_row;
+        size_t n = yuv_resize_push_row(
+            &s_rs, &s_src[(size_t)r * c->src_width * 2], s_row_out);
+        for (size_t k = 0; k < n && first + k < YUV_RESIZE_MAX_DST_HEIGHT;
+             k++) {
+            s_written[first + k]++;
+        }
+        total += n;
+        most = n > most ? n : most;
+    }
+    bool once = true;
+    for (int y = 0; y < c->dst_height; y++) {
+        once &= s_written[y] == 1;
+    }
+    snprintf(what, sizeof(what), "%s: each row written once", c->name);
+    check(total == c->dst_height && once && yuv_resize_is_done(&s_rs), what);
+    snprintf(what, sizeof(what), "%s: rows match the frame", c->name);
+    check(memcmp(s_row_out, s_frame_out, dst_size) == 0, what);
+    if (c->mode == YUV_RESIZE_NEAREST && c->dst_height > roi->height) {
+        snprintf(what, sizeof(what), "%s: a row completes several", c->name);
+        check(most > 1, what);
+    }
+}
+
+static void check_rejects(void) {
+    yuv_resize_roi_t odd_x = {1, 0, 40, 40};
+    yuv_resize_roi_t odd_width = {0, 0, 41, 40};
+    yuv_resize_roi_t outside = {60, 60, 40, 40};
+
+    check(!yuv_resize_init(&s_rs, YUV_RESIZE_NEAREST, 96, 96, &odd_x, 20, 20),
+          "odd ROI x rejected");
+    check(!yuv_resize_init(&s_rs, YUV_RESIZE_NEAREST, 96, 96, &odd_width, 20,
+                           20),
+          "odd ROI width rejected");
+    check(!yuv_resize_init(&s_rs, YUV_RESIZE_NEAREST, 96, 96, &outside, 20,
+                           20),
+          "ROI outside the source rejected");
+    check(!yuv_resize_init(&s_rs, YUV_RESIZE_NEAREST, 96, 96, NULL, 21, 20),
+          "odd output width rejected");
+    check(!yuv_resize_init(&s_rs, YUV_RESIZE_BILINEAR, 96, 96, NULL,
+                           YUV_RESIZE_MAX_DST_WIDTH + 2, 20),
+          "oversized output rejected");
+    check(!yuv_resize_init(&s_rs, YUV_RESIZE_AREA, 96, 96, NULL, 128, 96),
+          "area upscaling rejected");
+}
+
+// *****************************************************************************
+// End of file
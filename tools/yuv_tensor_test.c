@@ -0,0 +1,278 @@
+/**
+ * @file yuv_tensor_test.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2023 BrainChip, Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host test of the fused YUYV to model input preprocessing
+ * (firmware/src/yuv_tensor.c) against a floating point quantizer.
+ *
+ * For uint8 and int8 tensors, RGB and grayscale, checks that:
+ * - each channel's lookup table holds round(((v - mean) / std) / scale) +
+ *   zero_point, computed in double, saturated to the tensor type, for every
+ *   pixel value v: the mean, std, scale and zero point are all folded in,
+ *   and values beyond the type's range are clamped at both ends;
+ * - yuv_tensor_run() writes that quantization of each pixel's RGB (as
+ *   yuv_convert_to_rgb888() gives it, itself checked by yuv_convert_test.c)
+ *   or luma, interleaved per pixel for NHWC, one plane per channel for
+ *   NCHW, and one channel either way for grayscale, from a source that
+ *   isn't word aligned, and nothing past yuv_tensor_size();
+ * - yuv_tensor_init() rejects a scale or a std that isn't positive, except
+ *   for the channels grayscale doesn't use.
+ * Where the double value lies within 1e-3 of a rounding tie, the float
+ * arithmetic of the tables may round the other way; such entries may differ
+ * by 1 and are counted.  The CMSIS intrinsics are the portable C versions in
+ * host/definitions.h.
+ *
+ * Build and run from this directory:
+ *   cc -O2 -Ihost -I../firmware/src -o yuv_tensor_test yuv_tensor_test.c \
+ *       ../firmware/src/yuv_tensor.c ../firmware/src/yuv_convert.c -lm
+ *   ./yuv_tensor_test
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "host/check.h"
+#include "yuv_convert.h"
+#include "yuv_tensor.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// Every Y value in each pixel of a pair, for a spread of U and V
+#define N_PAIRS 256
+#define N_PIXELS (N_PAIRS * 2)
+#define UV_STEP 15
+
+#define TIE_MARGIN 1e-3
+
+// Written past the tensor, to catch overruns
+#define GUARD 0xa5
+
+typedef struct {
+    const char *name;
+    yuv_tensor_layout_t layout;
+    yuv_tensor_type_t type;
+    bool grayscale;
+    float mean[YUV_TENSOR_MAX_CHANNELS];
+    float std[YUV_TENSOR_MAX_CHANNELS];
+    float scale;
+    int32_t zero_point;
+} test_case_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief The reference quantization of value v for channel c.  Sets *tie if
+ * the unrounded value is within TIE_MARGIN of a rounding tie.
+ */
+static int32_t quantize(const test_case_t *t, int c, int v, bool *tie);
+
+/**
+ * @brief Compare a tensor element (stored byte) against the reference.
+ * Returns false on a mismatch that a near tie doesn't explain.
+ */
+static bool matches(const test_case_t *t, int c, int v, uint8_t got);
+
+/**
+ * @brief Check the tables and the run of one config.
+ */
+static void run_case(const test_case_t *t);
+
+static void check_rejects(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const test_case_t s_cases[] = {
+    {"uint8 nhwc raw", YUV_TENSOR_NHWC, YUV_TENSOR_UINT8, false,
+     {0, 0, 0}, {1, 1, 1}, 1.0f, 0},
+    // ImageNet normalization into a typical uint8 input quantization
+    {"uint8 nhwc imagenet", YUV_TENSOR_NHWC, YUV_TENSOR_UINT8, false,
+     {123.675f, 116.28f, 103.53f}, {58.395f, 57.12f, 57.375f}, 0.0186584f,
+     114},
+    {"uint8 nchw imagenet", YUV_TENSOR_NCHW, YUV_TENSOR_UINT8, false,
+     {123.675f, 116.28f, 103.53f}, {58.395f, 57.12f, 57.375f}, 0.0186584f,
+     114},
+    // [-1, 1] inputs: the top of the range clamps at 127
+    {"int8 nchw [-1,1]", YUV_TENSOR_NCHW, YUV_TENSOR_INT8, false,
+     {127.5f, 127.5f, 127.5f}, {127.5f, 127.5f, 127.5f}, 1.0f / 128, 0},
+    {"int8 nhwc per channel", YUV_TENSOR_NHWC, YUV_TENSOR_INT8, false,
+     {10, 128, 240}, {20, 40, 80}, 0.05f, -20},
+    {"int8 gray shifted", YUV_TENSOR_NHWC, YUV_TENSOR_INT8, true,
+     {0, 0, 0}, {1, 0, 0}, 1.0f, -128},
+    // clamps at both ends
+    {"uint8 gray narrow", YUV_TENSOR_NCHW, YUV_TENSOR_UINT8, true,
+     {100, 0, 0}, {10, 0, 0}, 0.05f, 128},
+};
+
+static uint8_t s_yuyv[N_PIXELS * 2 + 1];
+static uint8_t s_rgb[N_PIXELS * 3];
+static uint8_t s_out[N_PIXELS * YUV_TENSOR_MAX_CHANNELS + 16];
+static yuv_tensor_t s_tensor;
+static unsigned s_ties;
+
+// *****************************************************************************
+// Public code
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        run_case(&s_cases[i]);
+    }
+    check_rejects();
+
+    printf("# %u table entries rounded the other way at a near tie\n",
+           s_ties);
+    return check_result();
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static int32_t quantize(const test_case_t *t, int c, int v, bool *tie) {
+    int32_t q_min = t->type == YUV_TENSOR_INT8 ? INT8_MIN : 0;
+    int32_t q_max = t->type == YUV_TENSOR_INT8 ? INT8_MAX : UINT8_MAX;
+    double x = ((v - (double)t->mean[c]) / t->std[c]) / t->scale;
+
+    *tie = fabs(fabs(x - floor(x)) - 0.5) < TIE_MARGIN;
+    int32_t q = (int32_t)lround(x) + t->zero_point;
+    return q < q_min ? q_min : q > q_max ? q_max : q;
+}
+
+static bool matches(const test_case_t *t, int c, int v, uint8_t got) {
+    bool tie;
+    int32_t want = quantize(t, c, v, &tie);
+    int32_t q = t->type == YUV_TENSOR_INT8 ? (int8_t)got : got;
+    if (q == want) {
+        return true;
+    }
+    return tie && (q == want - 1 || q == want + 1);
+}
+
+static void run_case(const test_case_t *t) {
+    yuv_tensor_config_t config;
+    char what[128];
+    int n_channels = t->grayscale ? 1 : 3;
+
+    yuv_tensor_default_config(&config);
+    config.layout = t->layout;
+    config.type = t->type;
+    config.grayscale = t->grayscale;
+    memcpy(config.mean, t->mean, sizeof(config.mean));
+    memcpy(config.std, t->std, sizeof(config.std));
+    config.scale = t->scale;
+    config.zero_point = t->zero_point;
+    if (!yuv_tensor_init(&s_tensor, &config)) {
+        snprintf(what, sizeof(what), "%s: init", t->name);
+        check(false, what);
+        return;
+    }
+
+    // the folded tables
+    unsigned bad = 0;
+    for (int c = 0; c < n_channels; c++) {
+        for (int v = 0; v < 256; v++) {
+            bool tie;
+            bad += !matches(t, c, v, s_tensor.lut[c][v]);
+            s_ties += quantize(t, c, v, &tie) !=
+                      (t->type == YUV_TENSOR_INT8 ? (int8_t)s_tensor.lut[c][v]
+                                                  : s_tensor.lut[c][v]);
+        }
+    }
+    snprintf(what, sizeof(what), "%s: tables match the quantizer", t->name);
+    check(bad == 0, what);
+
+    size_t size = yuv_tensor_size(&s_tensor, N_PIXELS);
+    snprintf(what, sizeof(what), "%s: tensor size", t->name);
+    check(size == (size_t)N_PIXELS * n_channels, what);
+
+    // the tensor, for every Y against a spread of U and V
+    bad = 0;
+    bool overrun = false;
+    uint8_t *yuyv = s_yuyv + 1; // not word aligned
+    for (int u = 0; u < 256; u += UV_STEP) {
+        for (int v = 0; v < 256; v += UV_STEP) {
+            for (int k = 0; k < N_PAIRS; k++) {
+                uint8_t *pair = &yuyv[k * 4];
+                pair[0] = k;
+                pair[1] = u;
+                pair[2] = 255 - k;
+                pair[3] = v;
+            }
+            yuv_convert_to_rgb888(yuyv, s_rgb, N_PIXELS);
+            memset(s_out, GUARD, sizeof(s_out));
+            yuv_tensor_run(&s_tensor, yuyv, s_out, N_PIXELS);
+            for (size_t i = size; i < sizeof(s_out); i++) {
+                overrun |= s_out[i] != GUARD;
+            }
+
+            for (int p = 0; p < N_PIXELS; p++) {
+                for (int c = 0; c < n_channels; c++) {
+                    int value = t->grayscale ? yuyv[p * 2] : s_rgb[p * 3 + c];
+                    size_t at = t->layout == YUV_TENSOR_NHWC
+                                    ? (size_t)p * n_channels + c
+                                    : (size_t)c * N_PIXELS + p;
+                    bad += !matches(t, c, value, s_out[at]);
+                }
+            }
+        }
+    }
+    printf("# %-22s %u mismatches\n", t->name, bad);
+    snprintf(what, sizeof(what), "%s: tensor matches the quantizer", t->name);
+    check(bad == 0, what);
+    snprintf(what, sizeof(what), "%s: nothing written past the tensor",
+             t->name);
+    check(!overrun, what);
+}
+
+static void check_rejects(void) {
+    yuv_tensor_config_t config;
+
+    yuv_tensor_default_config(&config);
+    config.scale = 0;
+    check(!yuv_tensor_init(&s_tensor, &config), "zero scale rejected");
+
+    yuv_tensor_default_config(&config);
+    config.std[2] = -1;
+    check(!yuv_tensor_init(&s_tensor, &config), "negative std rejected");
+
+    yuv_tensor_default_config(&config);
+    config.std[1] = 0;
+    check(!yuv_tensor_init(&s_tensor, &config), "zero std rejected");
+
+    config.grayscale = true;
+    check(yuv_tensor_init(&s_tensor, &config),
+          "grayscale ignores the std of other channels");
+}
+
+// *****************************************************************************
+// End of file